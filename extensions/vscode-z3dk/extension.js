@@ -2232,13 +2232,13 @@ class Z3dkRomMapProvider {
       return;
     }
     try {
-      const blocks = await activeClient.sendRequest('workspace/executeCommand', {
+      const usage = await activeClient.sendRequest('workspace/executeCommand', {
         command: 'z3dk.getBankUsage',
-        arguments: []
+        arguments: [{ blocks: true }]
       });
       this.view.webview.postMessage({
         command: 'data',
-        blocks: blocks || []
+        usage: usage || {}
       });
       this.view.webview.postMessage({
         command: 'status',
@@ -2489,7 +2489,8 @@ function buildRomMapHtml(context) {
         const selectRomBtn = document.getElementById('selectRom');
         const openMainAsmBtn = document.getElementById('openMainAsm');
         let selectedBank = 0;
-        let bankBlocks = new Map();
+        let bankSize = 32768;
+        let bankStats = new Map();
         let allBlocks = [];
 
         // Generate 64 banks (standard 2MB LoROM)
@@ -2524,55 +2525,59 @@ function buildRomMapHtml(context) {
           statusEl.className = 'status ' + (state === 'ready' ? 'ok' : 'warn');
         }
 
-        function rebuildIndex(blocks) {
-          bankBlocks = new Map();
-          blocks.forEach(block => {
-            const bank = (block.snes >>> 16) & 0x3F;
-            if (!bankBlocks.has(bank)) {
-              bankBlocks.set(bank, []);
-            }
-            bankBlocks.get(bank).push(block);
+        // z3lsp keeps the occupancy per 32 KiB bank of the ROM file, with
+        // overlapping blocks counted once
+        function rebuildIndex(usage) {
+          bankSize = usage.bankSize || 32768;
+          bankStats = new Map();
+          allBlocks = [];
+          (Array.isArray(usage.banks) ? usage.banks : []).forEach(stats => {
+            bankStats.set(stats.bank, stats);
+            (stats.blocks || []).forEach(block => {
+              if (Math.floor(block.pc / bankSize) === stats.bank) {
+                allBlocks.push(block);
+              }
+            });
           });
         }
 
         function updateSummary() {
           let total = 0;
-          bankBlocks.forEach(entries => {
-            entries.forEach(block => {
-              total += block.size || 0;
-            });
+          bankStats.forEach(stats => {
+            total += stats.used || 0;
           });
           summaryEl.textContent = allBlocks.length
             ? ('Blocks: ' + allBlocks.length + ' • Used: ' + total + ' bytes')
             : 'No blocks yet. Build or open a main ASM file.';
         }
 
-        function updateGrid(blocks) {
-          const usageMap = new Array(64).fill(0);
-          blocks.forEach(block => {
-            const bank = (block.snes >>> 16) & 0x3F;
-            usageMap[bank] += block.size || 0;
-          });
-          usageMap.forEach((used, i) => {
+        function updateGrid() {
+          for (let i = 0; i < 64; i++) {
+            const stats = bankStats.get(i);
+            const used = stats ? stats.used : 0;
             const el = document.getElementById('bank-' + i);
             const bar = el.querySelector('.bank-usage');
-            const percent = Math.min(100, (used / 32768) * 100);
+            const percent = Math.min(100, (used / bankSize) * 100);
             bar.style.height = percent + '%';
             el.dataset.used = String(used);
-          });
+            el.dataset.largestFree = String(stats ? stats.largestFree : bankSize);
+            el.dataset.freeRuns = String(stats ? stats.freeRuns : 1);
+          }
         }
 
         function renderDetails(bank) {
-          const blocks = bankBlocks.get(bank) || [];
-          let total = 0;
-          blocks.forEach(block => {
-            total += block.size || 0;
-          });
-          const percent = Math.min(100, (total / 32768) * 100);
+          const stats = bankStats.get(bank);
+          const blocks = stats && stats.blocks ? stats.blocks : [];
+          const total = stats ? stats.used : 0;
+          const percent = Math.min(100, (total / bankSize) * 100);
           const bankHex = bank.toString(16).toUpperCase().padStart(2, '0');
           let html = '<h3>Bank $' + bankHex + '</h3>';
           html += '<div class="meta">Blocks: ' + blocks.length + ' • Used: ' + total +
                   ' bytes (' + percent.toFixed(1) + '%)</div>';
+          if (stats) {
+            html += '<div class="meta">Largest free run: ' + stats.largestFree +
+                    ' bytes • Free runs: ' + stats.freeRuns + '</div>';
+          }
           if (!blocks.length) {
             html += '<div class="meta">No blocks recorded for this bank.</div>';
           } else {
@@ -2608,20 +2613,21 @@ function buildRomMapHtml(context) {
             setStatus(state, text);
           }
           if (message.command === 'data') {
-            allBlocks = Array.isArray(message.blocks) ? message.blocks : [];
-            rebuildIndex(allBlocks);
-            updateGrid(allBlocks);
+            rebuildIndex(message.usage || {});
+            updateGrid();
             updateSummary();
             setStatus('ready');
             for (let i = 0; i < 64; i++) {
               const el = document.getElementById('bank-' + i);
               if (!el) continue;
               const used = Number(el.dataset.used || 0);
-              const percent = Math.min(100, (used / 32768) * 100);
+              const percent = Math.min(100, (used / bankSize) * 100);
               el.onmouseenter = () => {
                 tooltip.style.display = 'block';
                 tooltip.innerHTML = '<strong>Bank ' + i.toString(16).toUpperCase().padStart(2, '0') + '</strong><br/>' + 
-                                    used + ' / 32768 bytes (' + percent.toFixed(1) + '%)';
+                                    used + ' / ' + bankSize + ' bytes (' + percent.toFixed(1) + '%)<br/>' +
+                                    'Largest free: ' + el.dataset.largestFree + ' bytes in ' +
+                                    el.dataset.freeRuns + ' runs';
               };
               el.onclick = () => selectBank(i);
             }
@@ -131,7 +131,11 @@ const struct definedata * (*asar_getalldefines)(int * count);
 double (*asar_math)(const char * math_, const char ** error);
 const struct writtenblockdata * (*asar_getwrittenblocks)(int * count);
 enum mappertype (*asar_getmapper)(void);
+const char * const * (*asar_getinputfiles)(int * count);
+const struct signaturedata * (*asar_getmacros)(int * count);
+const struct signaturedata * (*asar_getfunctions)(int * count);
 const char * (*asar_getsymbolsfile)(const char* type);
+void (*asar_setnestinglimits)(int max_includes, int max_macros);
 
 #define require(b) if (!(b)) { asardll=NULL; return false; }
 
@@ -156,7 +160,11 @@ static bool asar_init_shared(void)
 	loadraw("asar_math", asar_math);
 	loadraw("asar_getwrittenblocks", asar_getwrittenblocks);
 	loadraw("asar_getmapper", asar_getmapper);
+	loadraw("asar_getinputfiles", asar_getinputfiles);
+	loadraw("asar_getmacros", asar_getmacros);
+	loadraw("asar_getfunctions", asar_getfunctions);
 	loadraw("asar_getsymbolsfile", asar_getsymbolsfile);
+	loadraw("asar_setnestinglimits", asar_setnestinglimits);
 	if (asar_apiversion() < expectedapiversion || (asar_apiversion() / 100) > (expectedapiversion / 100)) return false;
 	require(asar_i_init());
 	return true;
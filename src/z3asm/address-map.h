@@ -0,0 +1,223 @@
+#pragma once
+
+// SNES <-> PC address translation. snestopc_slow and pctosnes_slow spell
+// out every mapper's layout; address_map flattens one mapper into tables
+// of 32 KiB half banks, so a translation is one lookup and an OR. asar
+// keeps one address_map for the current mapper (see set_mapper in
+// libsmw.h), z3dk_core builds its own from the same functions.
+
+enum mapper_t {
+	invalid_mapper,
+	lorom,
+	hirom,
+	sa1rom,
+	bigsa1rom,
+	sfxrom,
+	exlorom,
+	exhirom,
+	norom
+};
+
+inline int snestopc_slow(int addr, mapper_t mapper, const int sa1banks[8])
+{
+	if (addr<0 || addr>0xFFFFFF) return -1;//not 24bit
+	if (mapper==lorom)
+	{
+		// randomdude999: The low pages ($0000-$7FFF) of banks 70-7D are used
+		// for SRAM, the high pages are available for ROM data though
+		if ((addr&0xFE0000)==0x7E0000 ||//wram
+			(addr&0x408000)==0x000000 ||//hardware regs, ram mirrors, other strange junk
+			(addr&0x708000)==0x700000)//sram (low parts of banks 70-7D)
+				return -1;
+		addr=((addr&0x7F0000)>>1|(addr&0x7FFF));
+		return addr;
+	}
+	if (mapper==hirom)
+	{
+		if ((addr&0xFE0000)==0x7E0000 ||//wram
+			(addr&0x408000)==0x000000)//hardware regs, ram mirrors, other strange junk
+				return -1;
+		return addr&0x3FFFFF;
+	}
+	if (mapper==exlorom)
+	{
+		if ((addr&0xF00000)==0x700000 ||//wram, sram
+			(addr&0x408000)==0x000000)//area that shouldn't be used in lorom
+				return -1;
+		if (addr&0x800000)
+		{
+			addr=((addr&0x7F0000)>>1|(addr&0x7FFF));
+		}
+		else
+		{
+			addr=((addr&0x7F0000)>>1|(addr&0x7FFF))+0x400000;
+		}
+		return addr;
+	}
+	if (mapper==exhirom)
+	{
+		if ((addr&0xFE0000)==0x7E0000 ||//wram
+			(addr&0x408000)==0x000000)//hardware regs, ram mirrors, other strange junk
+			return -1;
+		if ((addr&0x800000)==0x000000) return (addr&0x3FFFFF)|0x400000;
+		return addr&0x3FFFFF;
+	}
+	if (mapper==sfxrom)
+	{
+		// Asar emulates GSU1, because apparently emulators don't support the extra ROM data from GSU2
+		if ((addr&0x600000)==0x600000 ||//wram, sram, open bus
+			(addr&0x408000)==0x000000 ||//hardware regs, ram mirrors, rom mirrors, other strange junk
+			(addr&0x800000)==0x800000)//fastrom isn't valid either in superfx
+				return -1;
+		if (addr&0x400000) return addr&0x3FFFFF;
+		else return (addr&0x7F0000)>>1|(addr&0x7FFF);
+	}
+	if (mapper==sa1rom)
+	{
+		if ((addr&0x408000)==0x008000)
+		{
+			return sa1banks[(addr&0xE00000)>>21]|((addr&0x1F0000)>>1)|(addr&0x007FFF);
+		}
+		if ((addr&0xC00000)==0xC00000)
+		{
+			return sa1banks[((addr&0x100000)>>20)|((addr&0x200000)>>19)]|(addr&0x0FFFFF);
+		}
+		return -1;
+	}
+	if (mapper==bigsa1rom)
+	{
+		if ((addr&0xC00000)==0xC00000)//hirom
+		{
+			return (addr&0x3FFFFF)|0x400000;
+		}
+		if ((addr&0xC00000)==0x000000 || (addr&0xC00000)==0x800000)//lorom
+		{
+			if ((addr&0x008000)==0x000000) return -1;
+			return (addr&0x800000)>>2 | (addr&0x3F0000)>>1 | (addr&0x7FFF);
+		}
+		return -1;
+	}
+	if (mapper==norom)
+	{
+		return addr;
+	}
+	return -1;
+}
+
+inline int pctosnes_slow(int addr, mapper_t mapper, const int sa1banks[8])
+{
+	if (addr<0) return -1;
+	if (mapper==lorom)
+	{
+		if (addr>=0x400000) return -1;
+		addr=((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
+		return addr|0x800000;
+	}
+	if (mapper==hirom)
+	{
+		if (addr>=0x400000) return -1;
+		return addr|0xC00000;
+	}
+	if (mapper == exlorom)
+	{
+		if (addr>=0x800000) return -1;
+		if (addr&0x400000)
+		{
+			addr-=0x400000;
+			addr=((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
+			return addr;
+		}
+		else
+		{
+			addr=((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
+			return addr|0x800000;
+		}
+	}
+	if (mapper == exhirom)
+	{
+		if (addr>=0x800000) return -1;
+		if (addr&0x400000) return addr;
+		return addr|0xC00000;
+	}
+	if (mapper==sa1rom)
+	{
+		for (int i=0;i<8;i++)
+		{
+			if (sa1banks[i]==(addr&0x700000)){ return 0x008000|(i<<21)|((addr&0x0F8000)<<1)|(addr&0x7FFF);}
+		}
+		return -1;
+	}
+	if (mapper==bigsa1rom)
+	{
+		if (addr>=0x800000) return -1;
+		if ((addr&0x400000)==0x400000)
+		{
+			return addr|0xC00000;
+		}
+		if ((addr&0x600000)==0x000000)
+		{
+			return ((addr<<1)&0x3F0000)|0x8000|(addr&0x7FFF);
+		}
+		if ((addr&0x600000)==0x200000)
+		{
+			return 0x800000|((addr<<1)&0x3F0000)|0x8000|(addr&0x7FFF);
+		}
+		return -1;
+	}
+	if (mapper==sfxrom)
+	{
+		if (addr>=0x200000) return -1;
+		return ((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
+	}
+	if (mapper==norom)
+	{
+		return addr;
+	}
+	return -1;
+}
+
+// Every mapper is linear inside a 32 KiB half bank ($xx0000-$xx7FFF,
+// $xx8000-$xxFFFF) and inside a 32 KiB chunk of ROM, and the bases always
+// have their low 15 bits clear, so both directions are base | offset.
+struct address_map {
+	// pc offset of each half bank (bank*2 + high half), -1 if it isn't ROM
+	int pc_base[512];
+	// snes address of each 32 KiB chunk of the first 16 MiB of ROM, -1 if unmapped
+	int snes_base[512];
+	// what pctosnes does past 16 MiB: norom maps every offset to itself,
+	// sa1rom only looks at bits 15-22 so it repeats, the rest give up
+	bool pc_identity;
+	bool pc_repeats;
+
+	int snestopc(int addr) const
+	{
+		if (addr<0 || addr>0xFFFFFF) return -1;
+		int base = pc_base[addr>>15];
+		return base<0 ? -1 : base|(addr&0x7FFF);
+	}
+
+	int pctosnes(int addr) const
+	{
+		if (addr<0) return -1;
+		int chunk = addr>>15;
+		if (chunk>=512)
+		{
+			if (pc_identity) return addr;
+			if (!pc_repeats) return -1;
+			chunk &= 511;
+		}
+		int base = snes_base[chunk];
+		return base<0 ? -1 : base|(addr&0x7FFF);
+	}
+};
+
+inline void build_address_map(address_map& map, mapper_t mapper, const int sa1banks[8])
+{
+	for (int i=0;i<512;i++)
+	{
+		map.pc_base[i] = snestopc_slow(i<<15, mapper, sa1banks);
+		map.snes_base[i] = pctosnes_slow(i<<15, mapper, sa1banks);
+	}
+	map.pc_identity = mapper==norom;
+	map.pc_repeats = mapper==sa1rom;
+}
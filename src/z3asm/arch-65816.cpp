@@ -1,6 +1,8 @@
 #include "asar.h"
 #include "assembleblock.h"
 #include "asar_math.h"
+#include "opcodes-65816.h"
+#include <algorithm>
 
 #define write1 write1_pick
 
@@ -189,6 +191,10 @@ int get_real_len(int min_len, int max_len, insn_context& ctx, const parse_result
 		}
 		// todo warn about widening when dpbase != 0
 		out_len = std::max(arg_min_len, min_len);
+		if(pass == 2 && relax_active() && parsed.kind != addr_kind::imm) {
+			int unrelaxed_len = std::min(std::max(getlen_unrelaxed(parsed.arg), min_len), max_len);
+			if(unrelaxed_len > out_len) relax_record_shrink(unrelaxed_len - out_len);
+		}
 	}
 	ctx.written_len = out_len;
 	return out_len;
@@ -217,52 +223,92 @@ void opcode3(insn_context& ctx, uint8_t opcode, int num) {
 	write3(num);
 }
 
-template<int base, bool allow_imm = true>
-void the8(insn_context& ctx) {
+using addr_mode = opcodes_65816::mode;
+
+// handlers are instantiated per mnemonic, so a typo here fails to compile
+consteval int mnemonic(const char* name) {
+	int id = opcodes_65816::mnemonic_id(name);
+	if(id < 0) throw "not a 65816 mnemonic";
+	return id;
+}
+
+// opcode a mnemonic has in a given mode; only for modes it's known to have
+consteval uint8_t opcode_for(int mn, addr_mode mode) {
+	int opcode = opcodes_65816::encode(mn, mode);
+	if(opcode < 0) throw "mnemonic has no encoding in this mode";
+	return opcode;
+}
+
+// the addressing mode an operand kind becomes at a given operand length
+constexpr addr_mode mode_for(int mn, addr_kind kind, int len) {
 	using K = addr_kind;
-	auto parsed = parse_addr_kind<K::xind, K::s, K::abs, K::lind, K::imm, K::indy, K::ind, K::sy, K::x, K::y, K::lindy>(ctx);
-	addr_kind kind = parsed.kind;
-	int min_len = 0, max_len = 4;
-	if(kind == K::xind || kind == K::s || kind == K::sy || kind == K::indy || kind == K::ind || kind == K::lind || kind == K::lindy) min_len = max_len = 1;
-	else if(kind == K::abs) min_len = 1, max_len = 3;
-	else if(kind == K::x) min_len = 1, max_len = 3;
-	else if(kind == K::y) min_len = max_len = 2;
-	else if(kind == K::imm) min_len = 1, max_len = 2;
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
-	int real_len = get_real_len(min_len, max_len, ctx, parsed);
-	int opcode_offset = 0;
-	if(real_len == 1) {
-		if(kind == K::xind) opcode_offset = 0x1;
-		if(kind == K::s) opcode_offset = 0x3;
-		if(kind == K::abs) opcode_offset = 0x5;
-		if(kind == K::lind) opcode_offset = 0x7;
-		if(kind == K::imm) opcode_offset = 0x9;
-		if(kind == K::indy) opcode_offset = 0x11;
-		if(kind == K::ind) opcode_offset = 0x12;
-		if(kind == K::sy) opcode_offset = 0x13;
-		if(kind == K::x) opcode_offset = 0x15;
-		if(kind == K::lindy) opcode_offset = 0x17;
-		opcode1(ctx, base + opcode_offset, the_num);
-	} else if(real_len == 2) {
-		if(kind == K::imm) opcode_offset = 0x9;
-		if(kind == K::abs) opcode_offset = 0xd;
-		if(kind == K::y) opcode_offset = 0x19;
-		if(kind == K::x) opcode_offset = 0x1d;
-		opcode2(ctx, base + opcode_offset, the_num);
-	} else if(real_len == 3) {
-		if(kind == K::abs) opcode_offset = 0xf;
-		if(kind == K::x) opcode_offset = 0x1f;
-		opcode3(ctx, base + opcode_offset, the_num);
+	using M = addr_mode;
+	switch(kind) {
+		case K::abs: return len == 1 ? M::DirectPage : len == 2 ? M::Absolute : M::AbsoluteLong;
+		case K::x: return len == 1 ? M::DirectPageX : len == 2 ? M::AbsoluteX : M::AbsoluteLongX;
+		case K::y: return len == 1 ? M::DirectPageY : len == 2 ? M::AbsoluteY : M::count;
+		case K::ind: return len == 1 ? M::DirectPageIndirect : len == 2 ? M::AbsoluteIndirect : M::count;
+		case K::xind: return len == 1 ? M::DirectPageIndexedIndirect : len == 2 ? M::AbsoluteIndexedIndirect : M::count;
+		case K::lind: return len == 1 ? M::DirectPageIndirectLong : len == 2 ? M::AbsoluteIndirectLong : M::count;
+		case K::indy: return len == 1 ? M::DirectPageIndirectIndexedY : M::count;
+		case K::lindy: return len == 1 ? M::DirectPageIndirectLongY : M::count;
+		case K::s: return len == 1 ? M::StackRelative : M::count;
+		case K::sy: return len == 1 ? M::StackRelativeIndirectY : M::count;
+		case K::imm: return opcodes_65816::immediate_mode(mn);
+		case K::imp: case K::a: return M::Implied;
+	}
+	return M::count;
+}
+
+// range of operand lengths the mnemonic has an encoding for with this kind
+// of operand. false if it has none, i.e. the address mode is invalid.
+constexpr bool operand_lengths(int mn, addr_kind kind, int& min_len, int& max_len) {
+	min_len = 4;
+	max_len = 0;
+	for(int len = 1; len <= 3; len++) {
+		addr_mode mode = mode_for(mn, kind, len);
+		if(mode == addr_mode::count || opcodes_65816::encode(mn, mode) < 0) continue;
+		min_len = std::min(min_len, opcodes_65816::min_operand_len(mode));
+		max_len = std::max(max_len, opcodes_65816::max_operand_len(mode));
 	}
+	return min_len <= max_len;
 }
 
-template<int base, int accum_opc, bool is_bit = false>
+void encode_operand(insn_context& ctx, int mn, const parse_result& parsed) {
+	int min_len, max_len;
+	if(!operand_lengths(mn, parsed.kind, min_len, max_len)) asar_throw_error(1, error_type_block, error_id_bad_addr_mode);
+	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
+	// an explicit width with no encoding only errors on pass 2; earlier
+	// passes still need a width the mnemonic has
+	int real_len = std::clamp(get_real_len(min_len, max_len, ctx, parsed), min_len, max_len);
+	int opcode = opcodes_65816::encode(mn, mode_for(mn, parsed.kind, real_len));
+	if(opcode < 0) asar_throw_error(2, error_type_block, error_id_bad_access_width, format_valid_widths(min_len, max_len), real_len*8);
+	if(real_len == 1) opcode1(ctx, opcode, the_num);
+	else if(real_len == 2) opcode2(ctx, opcode, the_num);
+	else if(real_len == 3) opcode3(ctx, opcode, the_num);
+}
+
+// most instructions: parse the operand, then the table decides which of the
+// allowed kinds and widths actually exist
+template<int mn, addr_kind... allowed_kinds>
+void table_insn(insn_context& ctx) {
+	encode_operand(ctx, mn, parse_addr_kind<allowed_kinds...>(ctx));
+}
+
+template<int mn>
+void the8(insn_context& ctx) {
+	using K = addr_kind;
+	table_insn<mn, K::xind, K::s, K::abs, K::lind, K::imm, K::indy, K::ind, K::sy, K::x, K::y, K::lindy>(ctx);
+}
+
+template<int mn, bool is_bit = false>
 void thenext8(insn_context& ctx) {
 	using K = addr_kind;
 	parse_result parsed;
 	if constexpr(is_bit) {
 		parsed = parse_addr_kind<K::x, K::abs, K::imm>(ctx);
 	} else {
+		constexpr uint8_t accum_opc = opcode_for(mn, addr_mode::Implied);
 		parsed = parse_addr_kind<K::x, K::abs, K::imm, K::a, K::imp>(ctx);
 		// todo: some checks on ctx.modifier here
 		if(parsed.kind == K::imm) return handle_implicit_rep(parsed.arg, accum_opc);
@@ -271,36 +317,15 @@ void thenext8(insn_context& ctx) {
 			return;
 		}
 	}
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
-	int real_len = get_real_len(1, 2, ctx, parsed);
-	int opcode = 0;
-	if(parsed.kind == K::imm) {
-		opcode = accum_opc;
-	}
-	if(real_len == 1) {
-		if(parsed.kind == K::abs) opcode = base+0x6;
-		if(parsed.kind == K::x) opcode = base+0x16;
-		opcode1(ctx, opcode, the_num);
-	} else if(real_len == 2) {
-		if(parsed.kind == K::abs) opcode = base+0xe;
-		if(parsed.kind == K::x) opcode = base+0x1e;
-		opcode2(ctx, opcode, the_num);
-	}
-}
-
-template<int base>
-void tsb_trb(insn_context& ctx) {
-	using K = addr_kind;
-	auto parsed = parse_addr_kind<K::abs>(ctx);
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
-	int real_len = get_real_len(1, 2, ctx, parsed);
-	if(real_len == 1) opcode1(ctx, base + 0x04, the_num);
-	else opcode2(ctx, base + 0x0c, the_num);
+	encode_operand(ctx, mn, parsed);
 }
 
-template<int opc, int width = 1>
+template<int mn>
 void branch(insn_context& ctx) {
 	using K = addr_kind;
+	constexpr bool is_long = opcodes_65816::encode(mn, addr_mode::Relative16) >= 0;
+	constexpr int width = is_long ? 2 : 1;
+	constexpr uint8_t opc = opcode_for(mn, is_long ? addr_mode::Relative16 : addr_mode::Relative8);
 	auto parsed = parse_addr_kind<K::abs>(ctx);
 	int64_t num = 0;
 	if(pass == 2) {
@@ -334,18 +359,19 @@ void branch(insn_context& ctx) {
 	else if(width == 2) opcode2(ctx, opc, num);
 }
 
-template<int opc>
+template<int mn>
 void implied(insn_context& ctx) {
 	if(ctx.arg != "") {
 		// todo: some kind of "this instruction doesn't take an argument" message?
 		asar_throw_error(0, error_type_block, error_id_bad_addr_mode);
 	}
-	opcode0(ctx, opc);
+	opcode0(ctx, opcode_for(mn, addr_mode::Implied));
 }
 
-template<int opc>
+template<int mn>
 void implied_rep(insn_context& ctx) {
 	using K = addr_kind;
+	constexpr uint8_t opc = opcode_for(mn, addr_mode::Implied);
 	auto parsed = parse_addr_kind<K::imm, K::imp>(ctx);
 	if(parsed.kind == K::imp) {
 		opcode0(ctx, opc);
@@ -354,36 +380,10 @@ void implied_rep(insn_context& ctx) {
 	}
 }
 
-template<int base, char op, char xy>
-void xy_ops(insn_context& ctx) {
-	using K = addr_kind;
-	parse_result parsed;
-	if(op == 'S') { // stx
-		parsed = parse_addr_kind<K::abs, (xy == 'X' ? K::y : K::x)>(ctx);
-	} else if(op == 'L') { // ldx
-		parsed = parse_addr_kind<K::abs, K::imm, (xy == 'X' ? K::y : K::x)>(ctx);
-	} else { // cpx
-		parsed = parse_addr_kind<K::abs, K::imm>(ctx);
-	}
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
-	int real_len = get_real_len(1, 2, ctx, parsed);
-	int opcode = 0;
-	if(parsed.kind == K::imm) {
-		opcode = base;
-	} else if(parsed.kind == K::abs) {
-		if(real_len == 1) opcode = base + 0x4;
-		else opcode = base + 0xc;
-	} else { // ,x or ,y
-		if(real_len == 1) opcode = base + 0x14;
-		else opcode = base + 0x1c;
-	}
-	if(real_len == 1) opcode1(ctx, opcode, the_num);
-	else if(real_len == 2) opcode2(ctx, opcode, the_num);
-}
-
-template<int opc>
+template<int mn>
 void interrupt(insn_context& ctx) {
 	using K = addr_kind;
+	constexpr uint8_t opc = opcode_for(mn, addr_mode::Immediate8);
 	auto parsed = parse_addr_kind<K::imm, K::imp>(ctx);
 	if(parsed.kind == K::imp) {
 		opcode1(ctx, opc, 0);
@@ -395,38 +395,10 @@ void interrupt(insn_context& ctx) {
 	}
 }
 
-template<int opc, addr_kind k, int width>
-void oneoff(insn_context& ctx) {
-	auto parsed = parse_addr_kind<k>(ctx);
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
-	// only for error checking, we know the answer anyways
-	get_real_len(width, width, ctx, parsed);
-	if(width == 1) opcode1(ctx, opc, the_num);
-	else if(width == 2) opcode2(ctx, opc, the_num);
-	else if(width == 3) opcode3(ctx, opc, the_num);
-}
-
-void stz(insn_context& ctx) {
-	using K = addr_kind;
-	auto parsed = parse_addr_kind<K::abs, K::x>(ctx);
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
-	int real_len = get_real_len(1, 2, ctx, parsed);
-	if(real_len == 1) {
-		if(parsed.kind == K::abs) opcode1(ctx, 0x64, the_num);
-		else if(parsed.kind == K::x) opcode1(ctx, 0x74, the_num);
-	} else {
-		if(parsed.kind == K::abs) opcode2(ctx, 0x9c, the_num);
-		else if(parsed.kind == K::x) opcode2(ctx, 0x9e, the_num);
-	}
-}
-
-template<char which>
+template<int mn, addr_kind... allowed_kinds>
 void jmp_jsr_jml(insn_context& ctx) {
 	using K = addr_kind;
-	auto parsed = which == 'R' ? parse_addr_kind<K::abs, K::xind>(ctx)
-		: which == 'P' ? parse_addr_kind<K::abs, K::xind, K::ind, K::lind>(ctx)
-			: /* 'L' */ parse_addr_kind<K::abs, K::lind>(ctx);
-	int64_t the_num = pass == 2 ? getnum(parsed.arg) : 0;
+	auto parsed = parse_addr_kind<allowed_kinds...>(ctx);
 	// set optimizeforbank to -1 (i.e. auto, assume DBR = current bank)
 	// because jmp and jsr's arguments are relative to the program bank anyways
 	int old_optimize = optimizeforbank;
@@ -437,31 +409,17 @@ void jmp_jsr_jml(insn_context& ctx) {
 		// the rest use bank K
 		optimizeforbank = -1;
 	}
-	int the_width = 2;
-	if(which == 'L' && parsed.kind == K::abs) the_width = 3;
-	get_real_len(the_width, the_width, ctx, parsed);
+	encode_operand(ctx, mn, parsed);
 	optimizeforbank = old_optimize;
-	if(which == 'R') {
-		if(parsed.kind == K::abs) opcode2(ctx, 0x20, the_num);
-		else if(parsed.kind == K::xind) opcode2(ctx, 0xfc, the_num);
-	} else if(which == 'L') {
-		if(parsed.kind == K::abs) opcode3(ctx, 0x5c, the_num);
-		else if(parsed.kind == K::lind) opcode2(ctx, 0xdc, the_num);
-	} else {
-		if(parsed.kind == K::abs) opcode2(ctx, 0x4c, the_num);
-		else if(parsed.kind == K::ind) opcode2(ctx, 0x6c, the_num);
-		else if(parsed.kind == K::xind) opcode2(ctx, 0x7c, the_num);
-		else if(parsed.kind == K::lind) opcode2(ctx, 0xdc, the_num);
-	}
 }
 
-template<int opc>
+template<int mn>
 void mvn_mvp(insn_context& ctx) {
 	int count = 0;
 	autoptr<char**> parts = qpsplit(ctx.arg.raw(), ',', &count);
 	if(count != 2) asar_throw_error(2, error_type_block, error_id_bad_addr_mode);
 	// todo length checks ???
-	opcode0(ctx, opc);
+	opcode0(ctx, opcode_for(mn, addr_mode::BlockMove));
 	if(pass == 2) {
 		write1(getnum(parts[0]));
 		write1(getnum(parts[1]));
@@ -470,102 +428,103 @@ void mvn_mvp(insn_context& ctx) {
 	}
 }
 
+using K = addr_kind;
+
 assocarr<void(*)(insn_context&)> mnemonics = {
-	{ "ora", the8<0x00> },
-	{ "and", the8<0x20> },
-	{ "eor", the8<0x40> },
-	{ "adc", the8<0x60> },
-	{ "sta", the8<0x80, false> },
-	{ "lda", the8<0xa0> },
-	{ "cmp", the8<0xc0> },
-	{ "sbc", the8<0xe0> },
-	{ "asl", thenext8<0x00, 0x0a> },
-	{ "bit", thenext8<0x1e, 0x89, true> },
-	{ "rol", thenext8<0x20, 0x2a> },
-	{ "lsr", thenext8<0x40, 0x4a> },
-	{ "ror", thenext8<0x60, 0x6a> },
-	{ "dec", thenext8<0xc0, 0x3a> },
-	{ "inc", thenext8<0xe0, 0x1a> },
-	{ "bcc", branch<0x90> },
-	{ "bcs", branch<0xb0> },
-	{ "beq", branch<0xf0> },
-	{ "bmi", branch<0x30> },
-	{ "bne", branch<0xd0> },
-	{ "bpl", branch<0x10> },
-	{ "bra", branch<0x80> },
-	{ "bvc", branch<0x50> },
-	{ "bvs", branch<0x70> },
-	{ "brl", branch<0x82, 2> },
-	{ "clc", implied<0x18> },
-	{ "cld", implied<0xd8> },
-	{ "cli", implied<0x58> },
-	{ "clv", implied<0xb8> },
-	{ "dex", implied_rep<0xca> },
-	{ "dey", implied_rep<0x88> },
-	{ "inx", implied_rep<0xe8> },
-	{ "iny", implied_rep<0xc8> },
-	{ "nop", implied_rep<0xea> },
-	{ "pha", implied<0x48> },
-	{ "phb", implied<0x8b> },
-	{ "phd", implied<0x0b> },
-	{ "phk", implied<0x4b> },
-	{ "php", implied<0x08> },
-	{ "phx", implied<0xda> },
-	{ "phy", implied<0x5a> },
-	{ "pla", implied<0x68> },
-	{ "plb", implied<0xab> },
-	{ "pld", implied<0x2b> },
-	{ "plp", implied<0x28> },
-	{ "plx", implied<0xfa> },
-	{ "ply", implied<0x7a> },
-	{ "rti", implied<0x40> },
-	{ "rtl", implied<0x6b> },
-	{ "rts", implied<0x60> },
-	{ "sec", implied<0x38> },
-	{ "sed", implied<0xf8> },
-	{ "sei", implied<0x78> },
-	{ "stp", implied<0xdb> },
-	{ "tax", implied<0xaa> },
-	{ "tay", implied<0xa8> },
-	{ "tcd", implied<0x5b> },
-	{ "tcs", implied<0x1b> },
-	{ "tdc", implied<0x7b> },
-	{ "tsc", implied<0x3b> },
-	{ "tsx", implied<0xba> },
-	{ "txa", implied<0x8a> },
-	{ "txs", implied<0x9a> },
-	{ "txy", implied<0x9b> },
-	{ "tya", implied<0x98> },
-	{ "tyx", implied<0xbb> },
-	{ "wai", implied<0xcb> },
-	{ "xba", implied<0xeb> },
-	{ "xce", implied<0xfb> },
-	{ "ldy", xy_ops<0xa0, 'L', 'Y'> },
-	{ "ldx", xy_ops<0xa2, 'L', 'X'> },
-	{ "cpy", xy_ops<0xc0, 'C', 'Y'> },
-	{ "cpx", xy_ops<0xe0, 'C', 'X'> },
-	{ "stx", xy_ops<0x82, 'S', 'X'> },
-	{ "sty", xy_ops<0x80, 'S', 'Y'> },
-	{ "cop", interrupt<0x02> },
-	{ "wdm", interrupt<0x42> },
-	{ "brk", interrupt<0x00> },
-	{ "tsb", tsb_trb<0x00> },
-	{ "trb", tsb_trb<0x10> },
-	{ "rep", oneoff<0xc2, addr_kind::imm, 1> },
-	{ "sep", oneoff<0xe2, addr_kind::imm, 1> },
-	{ "pei", oneoff<0xd4, addr_kind::ind, 1> },
-	{ "pea", oneoff<0xf4, addr_kind::abs, 2> },
-	{ "mvn", mvn_mvp<0x54> },
-	{ "mvp", mvn_mvp<0x44> },
-	{ "jsl", oneoff<0x22, addr_kind::abs, 3> },
-	{ "per", branch<0x62, 2> },
-	{ "stz", stz },
-	{ "jmp", jmp_jsr_jml<'P'> },
-	{ "jsr", jmp_jsr_jml<'R'> },
-	{ "jml", jmp_jsr_jml<'L'> },
+	{ "ora", the8<mnemonic("ora")> },
+	{ "and", the8<mnemonic("and")> },
+	{ "eor", the8<mnemonic("eor")> },
+	{ "adc", the8<mnemonic("adc")> },
+	{ "sta", the8<mnemonic("sta")> },
+	{ "lda", the8<mnemonic("lda")> },
+	{ "cmp", the8<mnemonic("cmp")> },
+	{ "sbc", the8<mnemonic("sbc")> },
+	{ "asl", thenext8<mnemonic("asl")> },
+	{ "bit", thenext8<mnemonic("bit"), true> },
+	{ "rol", thenext8<mnemonic("rol")> },
+	{ "lsr", thenext8<mnemonic("lsr")> },
+	{ "ror", thenext8<mnemonic("ror")> },
+	{ "dec", thenext8<mnemonic("dec")> },
+	{ "inc", thenext8<mnemonic("inc")> },
+	{ "bcc", branch<mnemonic("bcc")> },
+	{ "bcs", branch<mnemonic("bcs")> },
+	{ "beq", branch<mnemonic("beq")> },
+	{ "bmi", branch<mnemonic("bmi")> },
+	{ "bne", branch<mnemonic("bne")> },
+	{ "bpl", branch<mnemonic("bpl")> },
+	{ "bra", branch<mnemonic("bra")> },
+	{ "bvc", branch<mnemonic("bvc")> },
+	{ "bvs", branch<mnemonic("bvs")> },
+	{ "brl", branch<mnemonic("brl")> },
+	{ "clc", implied<mnemonic("clc")> },
+	{ "cld", implied<mnemonic("cld")> },
+	{ "cli", implied<mnemonic("cli")> },
+	{ "clv", implied<mnemonic("clv")> },
+	{ "dex", implied_rep<mnemonic("dex")> },
+	{ "dey", implied_rep<mnemonic("dey")> },
+	{ "inx", implied_rep<mnemonic("inx")> },
+	{ "iny", implied_rep<mnemonic("iny")> },
+	{ "nop", implied_rep<mnemonic("nop")> },
+	{ "pha", implied<mnemonic("pha")> },
+	{ "phb", implied<mnemonic("phb")> },
+	{ "phd", implied<mnemonic("phd")> },
+	{ "phk", implied<mnemonic("phk")> },
+	{ "php", implied<mnemonic("php")> },
+	{ "phx", implied<mnemonic("phx")> },
+	{ "phy", implied<mnemonic("phy")> },
+	{ "pla", implied<mnemonic("pla")> },
+	{ "plb", implied<mnemonic("plb")> },
+	{ "pld", implied<mnemonic("pld")> },
+	{ "plp", implied<mnemonic("plp")> },
+	{ "plx", implied<mnemonic("plx")> },
+	{ "ply", implied<mnemonic("ply")> },
+	{ "rti", implied<mnemonic("rti")> },
+	{ "rtl", implied<mnemonic("rtl")> },
+	{ "rts", implied<mnemonic("rts")> },
+	{ "sec", implied<mnemonic("sec")> },
+	{ "sed", implied<mnemonic("sed")> },
+	{ "sei", implied<mnemonic("sei")> },
+	{ "stp", implied<mnemonic("stp")> },
+	{ "tax", implied<mnemonic("tax")> },
+	{ "tay", implied<mnemonic("tay")> },
+	{ "tcd", implied<mnemonic("tcd")> },
+	{ "tcs", implied<mnemonic("tcs")> },
+	{ "tdc", implied<mnemonic("tdc")> },
+	{ "tsc", implied<mnemonic("tsc")> },
+	{ "tsx", implied<mnemonic("tsx")> },
+	{ "txa", implied<mnemonic("txa")> },
+	{ "txs", implied<mnemonic("txs")> },
+	{ "txy", implied<mnemonic("txy")> },
+	{ "tya", implied<mnemonic("tya")> },
+	{ "tyx", implied<mnemonic("tyx")> },
+	{ "wai", implied<mnemonic("wai")> },
+	{ "xba", implied<mnemonic("xba")> },
+	{ "xce", implied<mnemonic("xce")> },
+	{ "ldy", table_insn<mnemonic("ldy"), K::abs, K::imm, K::x> },
+	{ "ldx", table_insn<mnemonic("ldx"), K::abs, K::imm, K::y> },
+	{ "cpy", table_insn<mnemonic("cpy"), K::abs, K::imm> },
+	{ "cpx", table_insn<mnemonic("cpx"), K::abs, K::imm> },
+	{ "stx", table_insn<mnemonic("stx"), K::abs, K::y> },
+	{ "sty", table_insn<mnemonic("sty"), K::abs, K::x> },
+	{ "cop", interrupt<mnemonic("cop")> },
+	{ "wdm", interrupt<mnemonic("wdm")> },
+	{ "brk", interrupt<mnemonic("brk")> },
+	{ "tsb", table_insn<mnemonic("tsb"), K::abs> },
+	{ "trb", table_insn<mnemonic("trb"), K::abs> },
+	{ "rep", table_insn<mnemonic("rep"), K::imm> },
+	{ "sep", table_insn<mnemonic("sep"), K::imm> },
+	{ "pei", table_insn<mnemonic("pei"), K::ind> },
+	{ "pea", table_insn<mnemonic("pea"), K::abs> },
+	{ "mvn", mvn_mvp<mnemonic("mvn")> },
+	{ "mvp", mvn_mvp<mnemonic("mvp")> },
+	{ "jsl", table_insn<mnemonic("jsl"), K::abs> },
+	{ "per", branch<mnemonic("per")> },
+	{ "stz", table_insn<mnemonic("stz"), K::abs, K::x> },
+	{ "jmp", jmp_jsr_jml<mnemonic("jmp"), K::abs, K::xind, K::ind, K::lind> },
+	{ "jsr", jmp_jsr_jml<mnemonic("jsr"), K::abs, K::xind> },
+	{ "jml", jmp_jsr_jml<mnemonic("jml"), K::abs, K::lind> },
 };
 
-
 bool asblock_65816(char** word, int numwords)
 {
 	if(word[0][0] == '\'') return false;
@@ -592,6 +551,11 @@ bool asblock_65816(char** word, int numwords)
 	ctx.orig_insn[0] = opc[0];
 	ctx.orig_insn[1] = opc[1];
 	ctx.orig_insn[2] = opc[2];
+	if(pass == 1 && (opc == "jsl" || opc == "jml" || opc == "jsr" || opc == "jmp")) {
+		// input for optimize placement. done before assembling, since a jsr
+		// into another freespace doesn't assemble until its bank is known.
+		placement_note_call(par, opc == "jsl" || opc == "jml");
+	}
 	mnemonics.find(opc.data())(ctx);
 	if(autoclean && pass > 0) {
 		// should be changed to "can't use autoclean on this instruction"?
@@ -26,6 +26,8 @@ inline void verify_paren(autoptr<char **> &ptr)
 }
 
 int getlen(const char * str, bool optimizebankextraction=false);
+// what getlen would return without addressing relaxation
+int getlen_unrelaxed(const char * str, bool optimizebankextraction=false);
 bool is_hex_constant(const char * str);
 
 bool validatedefinename(const char * name);
@@ -44,9 +46,6 @@ int get_version_int();
 bool setmapper();
 
 void assemblefile(const char * filename);
-void assembleline(const char * fname, int linenum, const char * line, int& single_line_for_tracker);
-
-bool do_line_logic(const char* line, const char* filename, int lineno);
 
 bool file_included_once(const char* file);
 
@@ -69,7 +68,7 @@ public:
 	recurseblock()
 	{
 		recursioncount++;
-#if !defined(_WIN32) && defined(NO_USE_THREADS)
+#if !defined(_WIN32)
 		if(recursioncount > 500)
 #else
 		if(!have_enough_stack_left() || recursioncount > 5000)
@@ -125,7 +124,11 @@ namespace optimize_address_flag {
 
 extern int optimize_address;
 
+extern bool optimize_relax;
+
 extern bool errored;
+// like errored, but ignores errors that are only reported in a later pass
+extern bool errored_in_pass;
 
 extern assocarr<string> clidefines;
 
@@ -194,12 +197,58 @@ const char* get_current_block();
 
 void get_full_printable_callstack(autoarray<printable_callstack_entry>* out, int indentation, bool add_lines);
 
-#if !defined(NO_USE_THREADS) && !defined(RUN_VIA_THREAD)
-// RPG Hacker: This is currently disabled for debug builds, because it causes random crashes
-// when used in combination with -fsanitize=address.
-#  if defined(_WIN32) && defined(NDEBUG)
-#    define RUN_VIA_FIBER
-#  else
-#    define RUN_VIA_THREAD
-#  endif
-#endif
+// A line partway through its blocks: one of them called a macro or included
+// a file, which runs before the rest of the line does.
+struct pending_line {
+	bool pending;
+	string current_line;
+	int lineno;
+	int prevnumif;
+	int single_line_for_tracker;
+	string out;
+	char ** blocks;
+	int block;
+	// the block that stopped the line, for the callstack when it carries on
+	string blocktext;
+	// the macro call ended in an error, which counts against its block
+	bool block_failed;
+	bool moreonlinetmp;
+};
+
+// incsrc and macro calls don't recurse into assembling their lines. Each
+// file or macro call is a frame on a heap stack that run_frames() assembles
+// a line at a time, so how deep they nest is up to max_include_depth and
+// max_macro_depth rather than the native stack.
+class source_frame {
+public:
+	source_frame();
+	virtual ~source_frame();
+	// pushes the frame's callstack entries, right before its first line
+	virtual void enter() = 0;
+	// nullptr after the last line
+	virtual const char * nextline(int& lineno) = 0;
+	virtual void endline(bool was_loop_end) = 0;
+	// runs after the last line, before the callstack entries are popped
+	virtual void leave() = 0;
+
+	pending_line line;
+	// the LINE and BLOCK entries of the line that pushed this frame, which
+	// are gone from the callstack by the time the frame runs
+	autoarray<callstack_entry> caller_callstack;
+	int callstack_base;
+	int line_callstack_base;
+};
+
+void assembleline(pending_line& line);
+
+bool do_line_logic(pending_line& state, const char* line, int lineno);
+
+// the frame runs once the block that pushed it returns
+void push_frame(source_frame* frame);
+int num_frames();
+// runs frames until only `base` are left
+void run_frames(int base);
+
+#define default_nesting_limit 512
+extern int max_include_depth;
+extern int max_macro_depth;
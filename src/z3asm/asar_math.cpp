@@ -124,34 +124,39 @@ void closecachedfiles()
 
 static int struct_size(const char *name)
 {
-       if(pass && !structs.exists(name)) asar_throw_error(2, error_type_block, error_id_struct_not_found, name);
-       else if(!structs.exists(name)) return 0;
-       return structs.find(name).struct_size;
+       const snes_struct * found = scopes.find_struct(name);
+       if(pass && !found) asar_throw_error(2, error_type_block, error_id_struct_not_found, name);
+       else if(!found) return 0;
+       return found->struct_size;
 }
 
 static int object_size(const char *name)
 {
-       if(pass && !structs.exists(name)) asar_throw_error(2, error_type_block, error_id_struct_not_found, name);
-       else if(!structs.exists(name)) return 0;
-       return structs.find(name).object_size;
+       const snes_struct * found = scopes.find_struct(name);
+       if(pass && !found) asar_throw_error(2, error_type_block, error_id_struct_not_found, name);
+       else if(!found) return 0;
+       return found->object_size;
 }
 
 static int data_size(const char *name)
 {
 	int label;
-	if(!labels.exists(name)) asar_throw_error(2, error_type_block, error_id_label_not_found, name);
+	const snes_label * found = scopes.find_label(scope_tree::root, name);
+	if(!found) asar_throw_error(2, error_type_block, error_id_label_not_found, name);
 	foundlabel = true;
-	snes_label label_data = labels.find(name);
+	snes_label label_data = *found;
 	foundlabel_static &= label_data.is_static;
 	label = label_data.id;
 	snes_label selected_label;
 	selected_label.id = 0xFFFFFF;
 	selected_label.pos = 0xFFFFFF;
-	labels.each([&selected_label, label](const char *key, snes_label current_label){
+	auto select_next = [&selected_label, label](const snes_label & current_label){
 		if(label < current_label.id && current_label.id < selected_label.id){
 			selected_label = current_label;
 		}
-	});
+	};
+	labels.each([&](const char *key, snes_label & current_label){ select_next(current_label); });
+	anonlabels.each([&](const anon_label_key & key, snes_label & current_label){ select_next(current_label); });
 	if(selected_label.id == 0xFFFFFF) asar_throw_warning(2, warning_id_datasize_last_label, name);
 	if(selected_label.pos-label_data.pos > 0xFFFF) asar_throw_warning(2, warning_id_datasize_exceeds_size, name);
 	return selected_label.pos-label_data.pos;
@@ -739,6 +744,13 @@ void createuserfunc(const char * name, const char * arguments, const char * cont
 	functions[name] = asar_call_user_function;
 }
 
+void each_user_function(void (*func)(const char * name, const char * const * arguments, int numargs))
+{
+	user_functions.each([func](const char * name, funcdat & user_function) {
+		func(name, (const char * const *)(char **)user_function.arguments, user_function.numargs);
+	});
+}
+
 inline const long hextable[] = {
         -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
         -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
@@ -918,18 +930,18 @@ template<asar_error_id errid> static double oper_wrapped_throw()
 
 static double eval(int depth)
 {
-	const char* posneglabel = str;
-	string posnegname = posneglabelname(&posneglabel, false);
+	const char* posneglabelend = str;
+	anon_label_key posnegkey;
 
-	if (posnegname.length() > 0)
+	if (posneglabel(&posneglabelend, false, &posnegkey))
 	{
-		if (*posneglabel != '\0' && *posneglabel != ')') goto notposneglabel;
+		if (*posneglabelend != '\0' && *posneglabelend != ')') goto notposneglabel;
 
-		str = posneglabel;
+		str = posneglabelend;
 
 		foundlabel=true;
-		if (*(posneglabel-1) == '+') forwardlabel=true;
-		snes_label label_data = labelval(posnegname);
+		if (*(posneglabelend-1) == '+') forwardlabel=true;
+		snes_label label_data = labelval(posnegkey);
 		foundlabel_static &= label_data.is_static;
 		return label_data.pos & 0xFFFFFF;
 	}
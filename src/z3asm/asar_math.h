@@ -7,6 +7,8 @@ int64_t getnum(const char * str);
 double getnumdouble(const char * str);
 
 void createuserfunc(const char * name, const char * arguments, const char * content);
+// calls func(name, arguments, numargs) for every function defined with the function command
+void each_user_function(void (*func)(const char * name, const char * const * arguments, int numargs));
 
 void closecachedfiles();
 
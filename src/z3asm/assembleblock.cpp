@@ -2,11 +2,16 @@
 #include "asar.h"
 #include "assembleblock.h"
 #include "asar_math.h"
+#include "lz2.h"
 #include "macro.h"
+#include "placement.h"
 #include "platform/file-helpers.h"
 #include "table.h"
 #include "unicode.h"
+#include <algorithm>
 #include <cinttypes>
+#include <string>
+#include <unordered_map>
 
 #include "interface-shared.h"
 #include "arch-shared.h"
@@ -35,7 +40,6 @@ static bool in_sub_struct = false;
 static bool static_struct = false;
 static bool in_spcblock = false;
 
-assocarr<snes_struct> structs;
 
 static bool movinglabelspossible = false;
 
@@ -280,6 +284,7 @@ int getlenfromchar(char c)
 }
 
 assocarr<snes_label> labels;
+anon_label_table anonlabels;
 static autoarray<int> poslabels;
 static autoarray<int> neglabels;
 
@@ -318,13 +323,10 @@ bool confirmname(const char * name)
 	return true;
 }
 
-string posneglabelname(const char ** input, bool define)
+bool posneglabel(const char ** input, bool define, anon_label_key * key)
 {
 	const char* label = *input;
 
-	string output;
-
-	int depth = 0;
 	bool ismacro = false;
 
 	if (label[0] == '?')
@@ -332,51 +334,85 @@ string posneglabelname(const char ** input, bool define)
 		ismacro = true;
 		label++;
 	}
-	if (label[0] == '-' || label[0] == '+')
-	{
-		char first = label[0];
-		for (depth = 0; label[0] && label[0] == first; depth++) label++;
+	if (label[0] != '-' && label[0] != '+') return false;
 
-		if (!ismacro)
-		{
-			if (first == '+')
-			{
-				*input = label;
-				output = STR":pos_" + dec(depth) + "_" + dec(poslabels[depth]);
-				if (define) poslabels[depth]++;
-			}
-			else
-			{
-				*input = label;
-				if (define) neglabels[depth]++;
-				output = STR":neg_" + dec(depth) + "_" + dec(neglabels[depth]);
-			}
-		}
-		else
+	char first = label[0];
+	int depth;
+	for (depth = 0; label[0] && label[0] == first; depth++) label++;
+
+	autoarray<int>* counters;
+	if (!ismacro)
+	{
+		key->macro = -1;
+		counters = first == '+' ? &poslabels : &neglabels;
+	}
+	else
+	{
+		if (macrorecursion == 0 || macroposlabels == nullptr || macroneglabels == nullptr)
 		{
-			if (macrorecursion == 0 || macroposlabels == nullptr || macroneglabels == nullptr)
-			{
-				if (!macrorecursion) asar_throw_error(0, error_type_block, error_id_macro_label_outside_of_macro);
-			}
-			else
-			{
-				if (first == '+')
-				{
-					*input = label;
-					output = STR":macro_" + dec(calledmacros) + "_pos_" + dec(depth) + "_" + dec((*macroposlabels)[depth]);
-					if (define) (*macroposlabels)[depth]++;
-				}
-				else
-				{
-					*input = label;
-					if (define) (*macroneglabels)[depth]++;
-					output = STR":macro_" + dec(calledmacros) + "_neg_" + dec(depth) + "_" + dec((*macroneglabels)[depth]);
-				}
-			}
+			if (!macrorecursion) asar_throw_error(0, error_type_block, error_id_macro_label_outside_of_macro);
+			return false;
 		}
+		key->macro = calledmacros;
+		counters = first == '+' ? macroposlabels : macroneglabels;
 	}
 
-	return output;
+	*input = label;
+	key->depth = first == '+' ? depth : -depth;
+	// a + label is the next one to be defined, a - label the last one defined
+	if (first == '+')
+	{
+		key->ordinal = (*counters)[depth];
+		if (define) (*counters)[depth]++;
+	}
+	else
+	{
+		if (define) (*counters)[depth]++;
+		key->ordinal = (*counters)[depth];
+	}
+	return true;
+}
+
+string anon_label_name(const anon_label_key & key)
+{
+	string name = ":";
+	if (key.macro >= 0) name += STR"macro_" + dec(key.macro) + "_";
+	name += key.depth > 0 ? "pos_" : "neg_";
+	return name + dec(key.depth > 0 ? key.depth : -key.depth) + "_" + dec(key.ordinal);
+}
+
+static bool parse_anon_number(const char ** str, int * out)
+{
+	if (!is_digit(**str)) return false;
+	long long value = 0;
+	for (; is_digit(**str); (*str)++)
+	{
+		value = value * 10 + (**str - '0');
+		if (value > 0x7FFFFFFF) return false;
+	}
+	*out = (int)value;
+	return true;
+}
+
+// the reverse of anon_label_name, so `:pos_1_0` still names a label
+static bool parse_anon_label_name(const char * name, anon_label_key * key)
+{
+	if (*name++ != ':') return false;
+	key->macro = -1;
+	if (!strncmp(name, "macro_", 6))
+	{
+		name += 6;
+		if (!parse_anon_number(&name, &key->macro) || *name++ != '_') return false;
+	}
+	int sign;
+	if (!strncmp(name, "pos_", 4)) sign = 1;
+	else if (!strncmp(name, "neg_", 4)) sign = -1;
+	else return false;
+	name += 4;
+	if (!parse_anon_number(&name, &key->depth) || *name++ != '_') return false;
+	if (!parse_anon_number(&name, &key->ordinal) || *name) return false;
+	key->depth *= sign;
+	return key->depth != 0;
 }
 
 static string labelname(const char ** rawname, bool define=false)
@@ -465,31 +501,136 @@ static string labelname(const char ** rawname, bool define=false)
 #undef deref_rawname
 }
 
+// Remembers which label each reference site bound to, so later passes (and
+// later iterations of a loop or macro) skip labelname() and the namespace
+// lookups. Sites are a file and line; the references on a line are told
+// apart by their text. An entry is only trusted if everything the resolution
+// depended on is unchanged: the reference text, the namespace, the parent
+// label of a .sublabel and the set of defined labels. Anything else,
+// including every failed lookup, goes through full resolution, so
+// diagnostics don't change.
+struct label_ref_entry {
+	string text;
+	string ns;
+	string parent;
+	int generation;
+	snes_label * label;
+};
+static std::unordered_map<uint64_t, std::vector<label_ref_entry>> label_ref_cache;
+// bumped whenever a label is added or the label table is reset, since a new
+// label can change what an unqualified name resolves to
+static int label_generation = 0;
+static std::unordered_map<std::string, int> label_ref_files;
+static std::string label_ref_last_file;
+static int label_ref_last_file_id = 0;
+
+void reset_label_ref_cache()
+{
+	label_ref_cache.clear();
+	label_ref_files.clear();
+	label_ref_last_file_id = 0;
+	label_generation++;
+}
+
+static uint64_t label_ref_site()
+{
+	const char * file = get_current_file_name();
+	if (!file) file = "";
+	// the file name's storage moves around, its contents don't
+	if (strcmp(file, label_ref_last_file.c_str()) || !label_ref_last_file_id)
+	{
+		auto it = label_ref_files.emplace(file, (int)label_ref_files.size() + 1).first;
+		label_ref_last_file = file;
+		label_ref_last_file_id = it->second;
+	}
+	return (uint64_t)label_ref_last_file_id << 32 | (uint32_t)get_current_line();
+}
+
+// the parent label a reference with this many leading dots attaches to, or
+// nullptr if it isn't a sublabel reference
+static const char * label_ref_parent(const char * text)
+{
+	int depth = 0;
+	while (text[depth] == '.') depth++;
+	if (!depth) return nullptr;
+	if (depth > sublabels.count) return "";
+	return sublabels[depth - 1];
+}
+
+static bool label_ref_matches(const label_ref_entry & entry, const char * text)
+{
+	size_t len = (size_t)entry.text.length();
+	if (strncmp(text, entry.text.data(), len)) return false;
+	// labelname() would keep going, so this is a longer name
+	char next = text[len];
+	return !is_ualnum(next) && next != '.' && next != '[';
+}
+
+static bool label_ref_valid(const label_ref_entry & entry, const char * text)
+{
+	if (entry.generation != label_generation) return false;
+	if (strcmp(entry.ns.data(), ns.data())) return false;
+	const char * parent = label_ref_parent(text);
+	return !parent || !strcmp(entry.parent.data(), parent);
+}
+
 inline bool labelvalcore(const char ** rawname, snes_label * rval, bool define, bool shouldthrow)
 {
-	string name=labelname(rawname, define);
-	if (ns && labels.exists(ns+name)) {
-		snes_label& lbl = labels.find(ns+name);
-		lbl.used = true;
-		*rval = lbl;
+	// ?labels depend on the macro call and struct members on the struct
+	// being defined, so those always resolve from scratch
+	bool cacheable = pass > 0 && !define && !in_struct && !in_sub_struct && **rawname != '?';
+	label_ref_entry * slot = nullptr;
+	std::vector<label_ref_entry> * line_refs = nullptr;
+	if (cacheable)
+	{
+		line_refs = &label_ref_cache[label_ref_site()];
+		for (auto & entry : *line_refs)
+		{
+			if (label_ref_matches(entry, *rawname))
+			{
+				slot = &entry;
+				break;
+			}
+		}
+		if (slot && label_ref_valid(*slot, *rawname))
+		{
+			slot->label->used = true;
+			*rval = *slot->label;
+			*rawname += slot->text.length();
+			return true;
+		}
 	}
-	else if (labels.exists(name)) {
-		snes_label& lbl = labels.find(name);
-		lbl.used = true;
-		*rval = lbl;
+	const char * start = *rawname;
+	string name=labelname(rawname, define);
+	snes_label * found = scopes.find_label(scopes.namespace_scope(ns), name);
+	anon_label_key anon_key;
+	if (!found && parse_anon_label_name(name, &anon_key) && anonlabels.exists(anon_key))
+	{
+		found = &anonlabels.find(anon_key);
+		// the anonymous table can grow and move its entries
+		cacheable = false;
 	}
-	else
+	if (found)
 	{
-		if (shouldthrow && pass)
+		found->used = true;
+		*rval = *found;
+		if (cacheable)
 		{
-			asar_throw_error(2, error_type_block, error_id_label_not_found, name.data());
+			const char * parent = label_ref_parent(start);
+			label_ref_entry entry{string(start, (int)(*rawname - start)), ns, parent ? parent : "", label_generation, found};
+			if (slot) *slot = entry;
+			else line_refs->push_back(entry);
 		}
-		rval->pos = (unsigned int)-1;
-		rval->freespace_id = 0;
-		rval->is_static = false;
-		return false;
+		return true;
 	}
-	return true;
+	if (shouldthrow && pass)
+	{
+		asar_throw_error(2, error_type_block, error_id_label_not_found, name.data());
+	}
+	rval->pos = (unsigned int)-1;
+	rval->freespace_id = 0;
+	rval->is_static = false;
+	return false;
 }
 
 snes_label labelval(const char ** rawname, bool define)
@@ -518,7 +659,61 @@ bool labelval(string name, snes_label * rval, bool define)
 	return labelvalcore(&str, rval, define, false);
 }
 
-static void setlabel(string name, int loc=-1, bool is_static=false)
+static bool anonlabelvalcore(const anon_label_key & key, snes_label * rval, bool shouldthrow)
+{
+	if (anonlabels.exists(key))
+	{
+		snes_label & found = anonlabels.find(key);
+		found.used = true;
+		*rval = found;
+		return true;
+	}
+	if (shouldthrow && pass)
+	{
+		asar_throw_error(2, error_type_block, error_id_label_not_found, anon_label_name(key).data());
+	}
+	rval->pos = (unsigned int)-1;
+	rval->freespace_id = 0;
+	rval->is_static = false;
+	return false;
+}
+
+snes_label labelval(const anon_label_key & key)
+{
+	snes_label rval;
+	anonlabelvalcore(key, &rval, true);
+	return rval;
+}
+
+bool labelval(const anon_label_key & key, snes_label * rval)
+{
+	return anonlabelvalcore(key, rval, false);
+}
+
+void each_label(void (*func)(const char * name, snes_label & label))
+{
+	// anonymous labels go where their names sort among the named ones, which
+	// is where they were when they lived in `labels`
+	std::vector<std::pair<string, snes_label *>> anon;
+	anon.reserve(anonlabels.count());
+	anonlabels.each([&anon](const anon_label_key & key, snes_label & label) {
+		anon.emplace_back(anon_label_name(key), &label);
+	});
+	std::sort(anon.begin(), anon.end(), [](const std::pair<string, snes_label *> & a, const std::pair<string, snes_label *> & b) {
+		return strcmp(a.first.data(), b.first.data()) < 0;
+	});
+	size_t next = 0;
+	labels.each([&](const char * name, snes_label & label) {
+		for (; next < anon.size() && strcmp(anon[next].first.data(), name) < 0; next++)
+		{
+			func(anon[next].first.data(), *anon[next].second);
+		}
+		func(name, label);
+	});
+	for (; next < anon.size(); next++) func(anon[next].first.data(), *anon[next].second);
+}
+
+static snes_label newlabel(int loc, bool is_static)
 {
 	int lbl_fs_id = 0;
 	if (loc==-1)
@@ -534,8 +729,25 @@ static void setlabel(string name, int loc=-1, bool is_static=false)
 	label_data.pos = (unsigned int)loc;
 	label_data.is_static = is_static;
 	label_data.freespace_id = lbl_fs_id;
+	return label_data;
+}
+
+//all label locations are known in pass 2, add a sanity check
+static void checklabelmoved(const char * name, unsigned int labelpos, int loc)
+{
+	if ((int)labelpos != loc && !movinglabelspossible)
+	{
+		if((unsigned int)loc>>16 != labelpos>>16)  asar_throw_error(2, error_type_block, error_id_label_ambiguous, name);
+		else if(labelpos == (dp_base + 0xFFu))   asar_throw_error(2, error_type_block, error_id_label_ambiguous, name);
+		else if(errored) return;
+		else asar_throw_error(2, error_type_block, error_id_internal_error, "moving label");
+	}
+}
+
+static void setlabel(string name, int loc=-1, bool is_static=false)
+{
+	snes_label label_data = newlabel(loc, is_static);
 
-	unsigned int labelpos;
 	if (pass==0)
 	{
 		if (labels.exists(name))
@@ -543,24 +755,52 @@ static void setlabel(string name, int loc=-1, bool is_static=false)
 			movinglabelspossible=true;
 			asar_throw_error(0, error_type_block, error_id_label_redefined, name.data());
 		}
-		labels.create(name) = label_data;
+		snes_label & created = labels.create(name);
+		created = label_data;
+		scopes.add_label(name, &created);
+		label_generation++;
 	}
 	else if (pass==1)
 	{
-		labels.create(name) = label_data;
+		int count = labels.num;
+		snes_label & created = labels.create(name);
+		created = label_data;
+		if (labels.num != count)
+		{
+			scopes.add_label(name, &created);
+			label_generation++;
+		}
 	}
 	else if (pass==2)
 	{
-		//all label locations are known at this point, add a sanity check
 		if (!labels.exists(name)) asar_throw_error(2, error_type_block, error_id_internal_error, "label created on 3rd pass");
-		labelpos = labels.find(name).pos;
-		if ((int)labelpos != loc && !movinglabelspossible)
+		checklabelmoved(name.raw(), labels.find(name).pos, (int)label_data.pos);
+	}
+}
+
+// anonymous labels can't shadow or be shadowed by a name, so unlike
+// setlabel this leaves label_generation alone
+static void setlabel(const anon_label_key & key, int loc=-1)
+{
+	snes_label label_data = newlabel(loc, false);
+
+	if (pass==0)
+	{
+		if (anonlabels.exists(key))
 		{
-			if((unsigned int)loc>>16 != labelpos>>16)  asar_throw_error(2, error_type_block, error_id_label_ambiguous, name.raw());
-			else if(labelpos == (dp_base + 0xFFu))   asar_throw_error(2, error_type_block, error_id_label_ambiguous, name.raw());
-			else if(errored) return;
-			else asar_throw_error(2, error_type_block, error_id_internal_error, "moving label");
+			movinglabelspossible=true;
+			asar_throw_error(0, error_type_block, error_id_label_redefined, anon_label_name(key).data());
 		}
+		anonlabels.create(key) = label_data;
+	}
+	else if (pass==1)
+	{
+		anonlabels.create(key) = label_data;
+	}
+	else if (pass==2)
+	{
+		if (!anonlabels.exists(key)) asar_throw_error(2, error_type_block, error_id_internal_error, "label created on 3rd pass");
+		checklabelmoved(anon_label_name(key).raw(), anonlabels.find(key).pos, (int)label_data.pos);
 	}
 }
 
@@ -638,17 +878,133 @@ static void adddefine(const string & key, string & value)
 	if (!defines.exists(key)) defines.create(key) = value;
 }
 
+// addressing relaxation state. relax_placement_known is set once the first
+// pass 1 has placed all freespaces; the repeated passes 1 keep that placement
+// and only shrink operands, so every block still fits where it was put.
+static bool relax_requested;
+static bool relax_placement_known;
+static int relax_iterations;
+static const int relax_max_iterations = 16;
+static std::vector<unsigned int> relax_label_snapshot;
+static std::vector<writtenblockdata> relax_writtenblocks_snapshot;
+static int relax_shrunk_operands;
+static int relax_saved_bytes;
+
+bool relax_active()
+{
+	return optimize_relax && relax_placement_known;
+}
+
+static void relax_take_label_snapshot(std::vector<unsigned int>& out)
+{
+	out.clear();
+	labels.each([&out](const char * key, snes_label & val) {
+		out.push_back(val.pos);
+	});
+	anonlabels.each([&out](const anon_label_key & key, snes_label & val) {
+		out.push_back(val.pos);
+	});
+}
+
+bool relax_repeating_pass()
+{
+	return pass == 1 && relax_placement_known;
+}
+
+bool relax_needs_another_pass()
+{
+	if (!relax_requested || errored_in_pass) return false;
+	std::vector<unsigned int> current;
+	relax_take_label_snapshot(current);
+	if (!relax_placement_known)
+	{
+		relax_placement_known = true;
+		relax_iterations = 0;
+		relax_label_snapshot = std::move(current);
+		// errors deferred to pass 2 (a jsr into a freespace whose bank wasn't
+		// known yet, say) are raised again there if they still apply
+		errored = false;
+		return true;
+	}
+	relax_iterations++;
+	if (current == relax_label_snapshot) return false;
+	if (relax_iterations >= relax_max_iterations)
+	{
+		asar_throw_error(1, error_type_null, error_id_relax_not_converged, relax_max_iterations);
+		return false;
+	}
+	relax_label_snapshot = std::move(current);
+	errored = false;
+	return true;
+}
+
+void relax_record_shrink(int bytes_saved)
+{
+	relax_shrunk_operands++;
+	relax_saved_bytes += bytes_saved;
+}
+
+static void relax_begin_pass()
+{
+	if (pass == 0)
+	{
+		relax_requested = false;
+		relax_placement_known = false;
+		relax_iterations = 0;
+		relax_label_snapshot.clear();
+		relax_shrunk_operands = 0;
+		relax_saved_bytes = 0;
+	}
+	else if (pass == 1 && !relax_placement_known)
+	{
+		// pass 1 adds the romwrites of non-freespace code. keep the list from
+		// before that around so shrunk code doesn't leave stale blocks behind.
+		relax_writtenblocks_snapshot.assign((writtenblockdata*)writtenblocks, (writtenblockdata*)writtenblocks + writtenblocks.count);
+	}
+	else if (pass == 1)
+	{
+		writtenblocks.reset();
+		for (size_t i = 0; i < relax_writtenblocks_snapshot.size(); i++) writtenblocks[(int)i] = relax_writtenblocks_snapshot[i];
+	}
+}
+
+void placement_note_call(const string& target, bool is_long)
+{
+	if (!placement_requested || pass != 1 || freespaceid <= 0) return;
+	// only plain label names. anything else either isn't a call into another
+	// freespace or can't be resolved here without raising errors.
+	if (!target.length() || !is_ualnum(target[0]) || is_digit(target[0])) return;
+	for (int i = 1; i < target.length(); i++)
+	{
+		if (!is_ualnum(target[i]) && target[i] != '.') return;
+	}
+	snes_label lbl;
+	if (!labelval(target, &lbl)) return;
+	if (lbl.freespace_id <= 0 || lbl.freespace_id == freespaceid) return;
+	placement_add_call(freespaceid, lbl.freespace_id, is_long);
+}
+
+static void relax_report()
+{
+	if (!relax_placement_known) return;
+	// dp_base is always page aligned, so every operand byte dropped is one
+	// fetch cycle saved, both for long->absolute and absolute->direct page.
+	print(STR "Addressing relaxation: shortened " + dec(relax_shrunk_operands) + " operands in " + dec(relax_iterations) +
+		" extra passes, saved " + dec(relax_saved_bytes) + " bytes and " + dec(relax_saved_bytes) + " cycles.");
+}
+
 void initstuff()
 {
 	if (pass==0)
 	{
 		freespaces.reset();
 		movinglabelspossible = false;
-		found_rats_tags_initialized = false;
-		found_rats_tags.clear();
+		invalidate_rats_tags();
 	}
+	relax_begin_pass();
+	placement_begin_pass();
 	arch=arch_65816;
-	mapper=lorom;
+	set_mapper(lorom);
 	mapper_set = false;
 	calledmacros = 0;
 	reallycalledmacros = 0;
@@ -687,6 +1043,7 @@ void initstuff()
 	optimize_dp = optimize_dp_flag::ALWAYS;
 	dp_base = 0;
 	optimize_address = optimize_address_flag::MIRRORS;
+	optimize_relax = false;
 
 	in_struct = false;
 	in_sub_struct = false;
@@ -716,7 +1073,7 @@ void initstuff()
 	// rest are initialized to false/0/empty string
 
 	callstack.reset();
-#if defined(_WIN32) || !defined(NO_USE_THREADS)
+#if defined(_WIN32)
 	init_stack_use_check();
 #endif
 }
@@ -782,17 +1139,24 @@ void resolve_pinned_freespaces() {
 	for(int i = 1; i < freespaces.count; i++) {
 		freespace_data& fs = freespaces[i];
 		if(fs.pin_target == "") continue;
-		snes_label value;
-		if(fs.pin_target_ns && labels.exists(fs.pin_target_ns + fs.pin_target))
-			value = labels.find(fs.pin_target_ns + fs.pin_target);
-		else if(labels.exists(fs.pin_target))
-			value = labels.find(fs.pin_target);
-		else continue; // the error for this is thrown in the freespace command during pass 2
-		fs.pin_target_id = get_freespace_pin_target(value.freespace_id);
+		snes_label * value = scopes.find_label(scopes.namespace_scope(fs.pin_target_ns), fs.pin_target);
+		if(!value) continue; // the error for this is thrown in the freespace command during pass 2
+		fs.pin_target_id = get_freespace_pin_target(value->freespace_id);
 		fs.len = 0;
 	}
 }
 
+static void relocate_freespace_labels() {
+	// relocate all labels that were in freespace to point them to their real location
+	auto relocate = [](snes_label & val) {
+		if(val.freespace_id != 0) {
+			val.pos += freespaces[val.freespace_id].pos;
+		}
+	};
+	labels.each([&](const char * key, snes_label & val) { relocate(val); });
+	anonlabels.each([&](const anon_label_key & key, snes_label & val) { relocate(val); });
+}
+
 void allocate_freespaces() {
 	// compute real size of all pinned freespace blocks
 	for(int i = 1; i < freespaces.count; i++) {
@@ -804,6 +1168,10 @@ void allocate_freespaces() {
 		target.search_start = std::max(fs.search_start, target.search_start);
 	}
 
+	// with optimize placement, blocks that call each other are put first
+	std::vector<bool> placed;
+	placement_allocate(placed);
+
 	for(int i = 1; i < freespaces.count; i++) {
 		freespace_data& fs = freespaces[i];
 		if(fs.is_static && fs.orgpos > 0) {
@@ -812,6 +1180,7 @@ void allocate_freespaces() {
 		}
 		// if this freespace is pinned to another one, set it later
 		if(fs.pin_target_id != i) continue;
+		if(placed[i]) continue;
 		// TODO: possibly fancier align
 		fs.pos = getsnesfreespace(fs.total_len, fs.bank, true, !fs.allow_bankcross, fs.flag_align, fs.write_rats, fs.search_start);
 		fs.used_len = fs.len;
@@ -825,12 +1194,7 @@ void allocate_freespaces() {
 		tgt.used_len += fs.len;
 	}
 
-	// relocate all labels that were in freespace to point them to their real location
-	labels.each([](const char * key, snes_label & val) {
-		if(val.freespace_id != 0) {
-			val.pos += freespaces[val.freespace_id].pos;
-		}
-	});
+	relocate_freespace_labels();
 }
 
 //void nerf(const string& left, string& right){puts(S left+" = "+right);}
@@ -853,11 +1217,17 @@ void finishpass()
 	deinitmathcore();
 	if(pass == 0) {
 		resolve_pinned_freespaces();
+	} else if(pass == 1 && relax_placement_known) {
+		// repeated pass 1 for addressing relaxation: keep the placement
+		relocate_freespace_labels();
 	} else if(pass == 1) {
 		allocate_freespaces();
 		handle_cleared_rats_tags();
+	} else if(pass == 2) {
+		relax_report();
+		placement_report();
 	}
-#if defined(_WIN32) || !defined(NO_USE_THREADS)
+#if defined(_WIN32)
 	deinit_stack_use_check();
 #endif
 }
@@ -866,14 +1236,14 @@ static bool addlabel(const char * label, int pos=-1, bool global_label = false)
 {
 	if (!label[0] || label[0]==':') return false;//colons are reserved for special labels
 
-	const char* posneglabel = label;
-	string posnegname = posneglabelname(&posneglabel, true);
+	const char* posneglabelend = label;
+	anon_label_key posnegkey;
 
-	if (posnegname.length() > 0)
+	if (posneglabel(&posneglabelend, true, &posnegkey))
 	{
 		if (global_label) return false;
-		if (*posneglabel != '\0' && *posneglabel != ':') asar_throw_error(0, error_type_block, error_id_broken_label_definition);
-		setlabel(posnegname, pos);
+		if (*posneglabelend != '\0' && *posneglabelend != ':') asar_throw_error(0, error_type_block, error_id_broken_label_definition);
+		setlabel(posnegkey, pos);
 		return true;
 	}
 	if (label[strlen(label)-1]==':' || label[0]=='.' || label[0]=='?' || label[0] == '#')
@@ -1623,7 +1993,7 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 		if (numwords > 4) ret_error(error_id_too_many_struct_params);
 		if (!confirmname(word[1])) ret_error(error_id_invalid_struct_name);
 
-		if (structs.exists(word[1]) && pass == 0) ret_error_params(error_id_struct_redefined, word[1]);
+		if (scopes.find_struct(word[1]) && pass == 0) ret_error_params(error_id_struct_redefined, word[1]);
 
 		static_struct = false;
 		old_snespos = snespos;
@@ -1639,7 +2009,7 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 			if (foundlabel && !foundlabel_static) static_struct = false;
 			if (pass > 0) {
 				// foundlabel_static isn't accurate anymore
-				if(structs.exists(word[1])) static_struct &= structs.find(word[1]).is_static;
+				if(const snes_struct * previous = scopes.find_struct(word[1])) static_struct &= previous->is_static;
 			}
 		}
 
@@ -1663,8 +2033,9 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 			if (!confirmname(word[3])) ret_error_cleanup(error_id_struct_invalid_parent_name);
 			string tmp_struct_parent = word[3];
 
-			if (!structs.exists(tmp_struct_parent)) ret_error_params_cleanup(error_id_struct_not_found, tmp_struct_parent.data());
-			snes_struct structure = structs.find(tmp_struct_parent);
+			const snes_struct * parent = scopes.find_struct(tmp_struct_parent);
+			if (!parent) ret_error_params_cleanup(error_id_struct_not_found, tmp_struct_parent.data());
+			snes_struct structure = *parent;
 
 			static_struct = structure.is_static;
 			struct_parent = tmp_struct_parent;
@@ -1709,19 +2080,17 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 
 		if (in_struct)
 		{
-			structs.create(struct_name) = structure;
+			scopes.create_struct(struct_name) = structure;
 		}
 		else if (in_sub_struct)
 		{
-			snes_struct parent;
-			parent = structs.find(struct_parent);
+			// sub-structs are children of their parent's node, found as Parent.Child
+			scopes.create_struct(struct_parent + "." + struct_name) = structure;
+			snes_struct & parent = *scopes.find_struct(struct_parent);
 
 			if (parent.object_size < parent.struct_size + structure.struct_size) {
 				parent.object_size = parent.struct_size + structure.struct_size;
 			}
-
-			structs.create(struct_parent + "." + struct_name) = structure;
-			structs.create(struct_parent) = parent;
 		}
 
 		pop_pc();
@@ -1784,7 +2153,7 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 				asar_throw_error(0, error_type_block, error_id_spcblock_custom_types_incomplete);
 				push_pc();
 				spcblock.old_mapper = mapper;
-				mapper = norom;
+				set_mapper(norom);
 			break;
 			default:
 				asar_throw_error(0, error_type_fatal, error_id_internal_error, "invalid spcblock type");
@@ -1824,7 +2193,7 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 				}
 			break;
 			case spcblock_custom:
-				mapper = spcblock.old_mapper;
+				set_mapper(spcblock.old_mapper);
 				pop_pc();
 			break;
 			default:
@@ -1871,8 +2240,12 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 		string label_name = STR"___z3dk_hook_impl_" + hex(target_addr, 6);
 		setlabel(label_name, -1, true);
 
+		// the hook's code goes in before the return, so run the macro now
+		// instead of after this block
 		string macro_call = string("%") + macro_name.data() + "()";
+		int frames_before = num_frames();
 		assembleblock(macro_call.data(), single_line_for_tracker);
+		run_frames(frames_before);
 
 		if (is_jsl) {
 			string rtl = "rtl";
@@ -1974,6 +2347,35 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 			}
 			asar_throw_error(1, error_type_block, error_id_bad_address_optimize, word[2]);
 		}
+		if (!stricmp(par, "relax"))
+		{
+			if (!stricmp(word[2], "on"))
+			{
+				optimize_relax = true;
+				relax_requested = true;
+				return;
+			}
+			if (!stricmp(word[2], "off"))
+			{
+				optimize_relax = false;
+				return;
+			}
+			asar_throw_error(1, error_type_block, error_id_bad_relax_optimize, word[2]);
+		}
+		if (!stricmp(par, "placement"))
+		{
+			if (!stricmp(word[2], "on"))
+			{
+				placement_requested = true;
+				return;
+			}
+			if (!stricmp(word[2], "off"))
+			{
+				placement_requested = false;
+				return;
+			}
+			asar_throw_error(1, error_type_block, error_id_bad_placement_optimize, word[2]);
+		}
 		asar_throw_error(1, error_type_block, error_id_bad_optimize, par);
 	}
 	else if (is1("bank"))
@@ -2251,10 +2653,12 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 
 		// recompute ns
 		ns = "";
+		int scope = scope_tree::root;
 		for (int i = 0; i < namespace_list.count; i++)
 		{
 			ns += namespace_list[i];
 			ns += "_";
+			scope = scopes.child_namespace(scope, namespace_list[i]);
 		}
 	}
 	else if (is1("incsrc"))
@@ -2269,7 +2673,7 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 		name=safedequote(par);
 		assemblefile(name);
 	}
-	else if (is("incbin"))
+	else if (is("incbin") || is("inclz"))
 	{
 		if (numwords < 2) asar_throw_error(0, error_type_block, error_id_broken_incbin);
 
@@ -2332,7 +2736,19 @@ void assembleblock(const char * block, int& single_line_for_tracker)
 
 		if (start < 0 || end < 0 || start > end || end > len) asar_throw_error(0, error_type_block, error_id_broken_incbin);
 
-		for (int i = start; i < end; i++) write1((unsigned char)data[i]);
+		if (is("inclz"))
+		{
+			const uint8_t * raw = (const uint8_t*)data + start;
+			// every pass writes the real stream: operand sizes picked in pass 1
+			// come from where pass 0 put the labels after it. assemblefile()
+			// has usually started compressing it already.
+			std::vector<uint8_t> packed = lz2_compress_cached(raw, end - start);
+			for (uint8_t byte : packed) write1(byte);
+		}
+		else
+		{
+			for (int i = start; i < end; i++) write1((unsigned char)data[i]);
+		}
 		add_addr_to_line(addrToLinePos);
 	}
 	else if (is("incgfx"))
@@ -2534,35 +2950,35 @@ bool assemblemapper(char** word, int numwords)
 	else if (is0("lorom"))
 	{
 		//this also makes xkas set snespos to $008000 for some reason
-		mapper=lorom;
+		set_mapper(lorom);
 	}
 	else if (is0("hirom"))
 	{
 		//xkas makes this point to $C00000
-		mapper=hirom;
+		set_mapper(hirom);
 	}
 	else if (is0("exlorom"))
 	{
-		mapper = exlorom;
+		set_mapper(exlorom);
 	}
 	else if (is0("exhirom"))
 	{
-		mapper=exhirom;
+		set_mapper(exhirom);
 	}
 	else if (is0("sfxrom"))
 	{
-		mapper=sfxrom;
+		set_mapper(sfxrom);
 	}
 	else if (is0("norom"))
 	{
 		//$000000 would be the best snespos for this, but I don't care
-		mapper=norom;
+		set_mapper(norom);
 		if(!force_checksum_fix)
 			checksum_fix_enabled = false;//we don't know where the header is, so don't set the checksum
 	}
 	else if (is0("fullsa1rom"))
 	{
-		mapper=bigsa1rom;
+		set_mapper(bigsa1rom);
 	}
 	else if (is("sa1rom"))
 	{
@@ -2589,7 +3005,7 @@ bool assemblemapper(char** word, int numwords)
 			sa1banks[4]=2<<20;
 			sa1banks[5]=3<<20;
 		}
-		mapper=sa1rom;
+		set_mapper(sa1rom);
 	}
 	else return false;
 
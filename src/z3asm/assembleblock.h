@@ -1,19 +1,15 @@
 #pragma once
 
+#include <unordered_map>
+#include <vector>
+
+#include "scope.h"
+
 enum { arch_65816, arch_spc700, arch_superfx };
 extern int arch;
 
 bool assemblemapper(char** word, int numwords);
 
-struct snes_struct {
-	string parent;
-	int base_end;
-	int struct_size;
-	int object_size;
-	bool is_static;
-};
-
-extern assocarr<snes_struct> structs;
 extern int label_counter;
 
 
@@ -34,6 +30,58 @@ struct snes_label {
 	}
 };
 
+// +/- labels, and ?+/?- inside a macro, are only ever found by position:
+// the macro call they're in, their direction and depth, and how many of the
+// same kind came before. They're kept out of `labels` under that key and
+// only get their `:pos_1_0` style names for symbol files and errors.
+struct anon_label_key {
+	// calledmacros for ?+/?-, -1 outside of macros
+	int macro;
+	// number of signs, negative for -
+	int depth;
+	int ordinal;
+
+	bool operator==(const anon_label_key & other) const
+	{
+		return macro == other.macro && depth == other.depth && ordinal == other.ordinal;
+	}
+};
+
+class anon_label_table {
+	struct hasher {
+		size_t operator()(const anon_label_key & key) const
+		{
+			unsigned long long h = (unsigned int)key.macro;
+			h = h * 0x9E3779B97F4A7C15ull ^ (unsigned int)key.depth;
+			h = h * 0x9E3779B97F4A7C15ull ^ (unsigned int)key.ordinal;
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+	std::unordered_map<anon_label_key, int, hasher> index;
+	// in definition order, so walking them is deterministic
+	std::vector<std::pair<anon_label_key, snes_label>> entries;
+
+public:
+	bool exists(const anon_label_key & key) const { return index.count(key) != 0; }
+	snes_label & find(const anon_label_key & key) { return entries[index.find(key)->second].second; }
+	snes_label & create(const anon_label_key & key)
+	{
+		auto it = index.emplace(key, (int)entries.size());
+		if (it.second) entries.emplace_back(key, snes_label());
+		return entries[it.first->second].second;
+	}
+	int count() const { return (int)entries.size(); }
+	void reset()
+	{
+		index.clear();
+		entries.clear();
+	}
+	template<typename func_t> void each(func_t func)
+	{
+		for (auto & entry : entries) func(entry.first, entry.second);
+	}
+};
+
 // data necessary for one freespace block
 struct freespace_data {
 	// snespos of the start of the freespace block. set to the found freespace
@@ -79,6 +127,7 @@ struct freespace_data {
 	bool allow_bankcross;
 };
 extern autoarray<freespace_data> freespaces;
+int get_freespace_pin_target(int target_id);
 
 // RPG Hacker: Really the only purpose of this struct is to support pushtable and pulltable
 // Also don't know where else to put this, so putting it in this header
@@ -112,7 +161,9 @@ extern autoarray<whiletracker> whilestatus;
 extern int single_line_for_tracker;
 
 bool confirmname(const char * name);
-string posneglabelname(const char ** input, bool define);
+// parses a +/- label at *input into *key, false if there isn't one
+bool posneglabel(const char ** input, bool define, anon_label_key * key);
+string anon_label_name(const anon_label_key & key);
 
 void write1_pick(unsigned int num);
 void write2(unsigned int num);
@@ -127,6 +178,12 @@ snes_label labelval(const char ** rawname, bool define = false);
 snes_label labelval(string name, bool define = false);
 bool labelval(const char ** rawname, snes_label * rval, bool define = false);
 bool labelval(string name, snes_label * rval, bool define = false);
+snes_label labelval(const anon_label_key & key);
+bool labelval(const anon_label_key & key, snes_label * rval);
+// every label, named and anonymous, in the order of their names
+void each_label(void (*func)(const char * name, snes_label & label));
+// drop cached label references, for when the label table is reset
+void reset_label_ref_cache();
 
 const char * safedequote(char * str);
 
@@ -135,6 +192,19 @@ void checkbankcross();
 void initstuff();
 void finishpass();
 
+// addressing relaxation (optimize relax on): after the first pass 1 has
+// placed all freespaces, pass 1 is repeated with their final banks known
+// until no label moves anymore.
+bool relax_active();
+// true while pass 1 is being repeated; its warnings were already reported
+bool relax_repeating_pass();
+bool relax_needs_another_pass();
+void relax_record_shrink(int bytes_saved);
+
+// records a call or jump to target for optimize placement, if target is a
+// label in another freespace than the current one.
+void placement_note_call(const string& target, bool is_long);
+
 void handle_autoclean(string& arg, int checkbyte, int orgpos);
 
 void assembleblock(const char * block, int& single_line_for_tracker);
@@ -152,6 +222,7 @@ extern int numtrue;
 extern int freespaceid;
 
 extern assocarr<snes_label> labels;
+extern anon_label_table anonlabels;
 
 extern autoarray<int>* macroposlabels;
 extern autoarray<int>* macroneglabels;
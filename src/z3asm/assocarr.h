@@ -29,6 +29,9 @@
 //  non-const function may be called on this structure from inside func(), but it is safe to call const functions of the structure. The function
 //  calls are in the same order as the indexes, in a strict weak ordering.
 //  Complexity: O(n).
+//myarr.each_prefixed("prefix", func)
+//  Like myarr.each(func), but only for the entries whose index starts with prefix.
+//  Complexity: O(log n) plus the number of matching entries.
 //Space usage: O(n).
 //C++ version: C++98 or C++03, not sure which.
 //Serializer support: Yes, if mytype is serializable.
@@ -288,6 +291,24 @@ template<typename t> void each(t func)
 	}
 }
 
+template<typename t> void each_prefixed(const char * prefix, t func)
+{
+	collectgarbage();
+	size_t len=strlen(prefix);
+	int lo=0;
+	int hi=num;
+	while (lo<hi)
+	{
+		int mid=lo+(hi-lo)/2;
+		if (strcmp(indexes[mid], prefix)<0) lo=mid+1;
+		else hi=mid;
+	}
+	for (int i=lo;i<num && !strncmp(indexes[i], prefix, len);i++)
+	{
+		func(indexes[i], ptr[i][0]);
+	}
+}
+
 //void debug(){puts("");for(int i=0;i<num;i++)puts(indexes[i]);}
 
 #ifdef SERIALIZER
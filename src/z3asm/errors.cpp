@@ -13,6 +13,7 @@ static void fmt_error(int whichpass, asar_error_id errid, const char* fmt, va_li
 
 	char error_buffer[1024];
 	vsnprintf(error_buffer, sizeof(error_buffer), fmt, args);
+	if (whichpass <= pass) errored_in_pass = true;
 
 	error_interface((int)errid, whichpass, error_buffer);
 }
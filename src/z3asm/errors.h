@@ -134,7 +134,7 @@
 	ERR(bad_dp_base, "The dp base should be page aligned (i.e. a multiple of 256), got %s") \
 	ERR(bad_dp_optimize, "Bad dp optimize value %s, expected: [none, ram, always]") \
 	ERR(bad_address_optimize, "Bad dp optimize value %s, expected: [default, ram, mirrors]") \
-	ERR(bad_optimize, "Bad optimize value %s, expected: [dp, address]") \
+	ERR(bad_optimize, "Bad optimize value %s, expected: [dp, address, relax, placement]") \
 	ERR(require_parameter, "Missing required function parameter") \
 	ERR(expected_parameter, "Not enough parameters in calling of function %s") \
 	ERR(unexpected_parameter, "Too many parameters in calling of function %s") \
@@ -195,6 +195,9 @@
 	ERR(incgfx_failed, "incgfx failed for file '%s': %s") \
 	ERR(incmsg_too_few_args, "Too few args passed to incmsg.") \
 	ERR(incmsg_failed, "incmsg failed: %s") \
+	ERR(bad_relax_optimize, "Bad relax optimize value %s, expected: [on, off]") \
+	ERR(relax_not_converged, "Addressing relaxation didn't settle after %d passes. Use 'optimize relax off' around the affected code.") \
+	ERR(bad_placement_optimize, "Bad placement optimize value %s, expected: [on, off]") \
 // this line intentionally left blank
 
 enum asar_error_id : int {
@@ -6,7 +6,7 @@
 #include "assembleblock.h"
 #include "asar_math.h"
 #include "unicode.h"
-#include "platform/thread-helpers.h"
+#include "platform/stack-helpers.h"
 
 #if defined(windows)
 #	define NOMINMAX
@@ -565,19 +565,15 @@ int main(int argc, const char * argv[])
 					// RPG Hacker: Necessary, because finishpass() can throws warning and errors.
 					callstack_push cs_push(callstack_entry_type::FILE, filesystem->create_absolute_path(nullptr, asmname));
 					finishpass();
+					// optimize relax: repeat pass 1 until operand widths settle
+					if (pass == 1 && relax_needs_another_pass()) pass--;
 				}
 				return true;
 			} catch(errfatal&) {
 				return false;
 			}
 		};
-#if defined(RUN_VIA_FIBER)
-		run_as_fiber(execute_patch);
-#elif defined(RUN_VIA_THREAD)
-		run_as_thread(execute_patch);
-#else
 		execute_patch();
-#endif
 
 		closecachedfiles(); // this needs the vfs so do it before destroying it
 		new_filesystem.destroy();
@@ -5,7 +5,8 @@
 #include "interface-shared.h"
 #include "assembleblock.h"
 #include "asar_math.h"
-#include "platform/thread-helpers.h"
+#include "macro.h"
+#include "platform/stack-helpers.h"
 
 #if defined(CPPCLI)
 #define EXPORT extern "C"
@@ -22,6 +23,8 @@
 static autoarray<const char *> prints;
 static string symbolsfile;
 static int numprint;
+static autoarray<const char *> inputfiles;
+static int numinputfiles;
 static uint32_t romCrc;
 
 #define APIVERSION 400
@@ -77,6 +80,19 @@ struct definedata {
 	const char * contents;
 };
 
+/* $EXPORTSTRUCT$
+ */
+struct signaturedata {
+	const char * name;
+	// parameter names, null-terminated; a variadic macro's last one is "..."
+	const char * const * arguments;
+	int numargs;
+	bool variadic;
+	// where a macro was defined, null and 0 for functions
+	const char * filename;
+	int line;
+};
+
 /* $EXPORTSTRUCT$
  */
 struct warnsetting {
@@ -157,6 +173,41 @@ static int labelsinldata = 0;
 static autoarray<definedata> ddata;
 static int definesinddata=0;
 
+struct signaturelist {
+	autoarray<signaturedata> data;
+	int count = 0;
+
+	void add(const char * name, const char * const * arguments, int numargs, bool variadic, const char * filename, int line)
+	{
+		signaturedata sig;
+		sig.name = duplicate_string(name);
+		const char ** args = (const char **)malloc(sizeof(const char *) * (numargs + 1));
+		for (int i=0;i<numargs;i++) args[i] = duplicate_string(arguments[i]);
+		args[numargs] = nullptr;
+		sig.arguments = args;
+		sig.numargs = numargs;
+		sig.variadic = variadic;
+		sig.filename = filename ? duplicate_string(filename) : nullptr;
+		sig.line = line;
+		data[count++] = sig;
+	}
+
+	void reset()
+	{
+		for (int i=0;i<count;i++)
+		{
+			free((void*)data[i].name);
+			for (int j=0;j<data[i].numargs;j++) free((void*)data[i].arguments[j]);
+			free((void*)data[i].arguments);
+			free((void*)data[i].filename);
+		}
+		data.reset();
+		count = 0;
+	}
+};
+static signaturelist macrosigs;
+static signaturelist functionsigs;
+
 static void resetdllstuff()
 {
 #define free_and_null(x) free((void*)x); x = nullptr
@@ -167,6 +218,13 @@ static void resetdllstuff()
 	prints.reset();
 	numprint=0;
 
+	for (int i=0;i<numinputfiles;i++)
+	{
+		free_and_null(inputfiles[i]);
+	}
+	inputfiles.reset();
+	numinputfiles=0;
+
 	for (int i=0;i<numerror;i++)
 	{
 		free_and_null(errors[i].filename);
@@ -219,6 +277,9 @@ static void resetdllstuff()
 		free((void*)ldata[i].name);
 	ldata.reset();
 	labelsinldata=0;
+
+	macrosigs.reset();
+	functionsigs.reset();
 #undef free_and_null
 
 	romCrc = 0;
@@ -232,7 +293,7 @@ static void resetdllstuff()
 
 static bool expectsNewAPI = false;
 
-static void addlabel(const string & name, const snes_label & label_data)
+static void addlabel(const char * name, snes_label & label_data)
 {
 	labeldata label;
 	label.name = strdup(name);
@@ -323,6 +384,8 @@ static void asar_patch_main(const char * patchloc)
 			// RPG Hacker: Necessary, because finishpass() can throws warning and errors.
 			callstack_push cs_push(callstack_entry_type::FILE, filesystem->create_absolute_path(nullptr, patchloc));
 			finishpass();
+			// optimize relax: repeat pass 1 until operand widths settle
+			if (pass == 1 && relax_needs_another_pass()) pass--;
 		}
 	}
 	catch (errfatal&) {}
@@ -514,18 +577,16 @@ EXPORT bool asar_patch(const struct patchparams_base *params)
 		// otherwise it will leak memory.
 		closecachedfiles();
 
+		new_filesystem.each_opened_file([](const char* path) {
+			inputfiles[numinputfiles++] = duplicate_string(path);
+		});
+
 		new_filesystem.destroy();
 		filesystem = nullptr;
 
 		return asar_patch_end(paramscurrent.romdata, paramscurrent.buflen, paramscurrent.romlen);
 };
-#if defined(RUN_VIA_FIBER)
-	return run_as_fiber(execute_patch);
-#elif defined(RUN_VIA_THREAD)
-	return run_as_thread(execute_patch);
-#else
 	return execute_patch();
-#endif
 }
 
 /* $EXPORT$
@@ -584,7 +645,7 @@ EXPORT const struct labeldata * asar_getalllabels(int * count)
 {
 	for (int i=0;i<labelsinldata;i++) free((void*)ldata[i].name);
 	labelsinldata=0;
-	labels.each(addlabel);
+	each_label(addlabel);
 	*count=labelsinldata;
 	return ldata;
 }
@@ -701,6 +762,45 @@ EXPORT enum mapper_t asar_getmapper()
 	return mapper;
 }
 
+/* $EXPORT$
+ * Get the paths of all files read from disk by the last patch: the patch,
+ * incsrc'd sources, incbin/inclz data and table files. Memory files are
+ * not included.
+ */
+EXPORT const char * const * asar_getinputfiles(int * count)
+{
+	*count=numinputfiles;
+	return inputfiles;
+}
+
+/* $EXPORT$
+ * Gets the names and parameters of all macros defined by the last patch.
+ */
+EXPORT const struct signaturedata * asar_getmacros(int * count)
+{
+	macrosigs.reset();
+	macros.each([](const char * name, macrodata * macro) {
+		// startline is 0-indexed
+		macrosigs.add(name, macro->arguments, macro->numargs, macro->variadic, macro->fname, macro->startline + 1);
+	});
+	*count = macrosigs.count;
+	return macrosigs.data;
+}
+
+/* $EXPORT$
+ * Gets the names and parameters of all functions defined by the last patch
+ * with the function command. Built-in functions are not included.
+ */
+EXPORT const struct signaturedata * asar_getfunctions(int * count)
+{
+	functionsigs.reset();
+	each_user_function([](const char * name, const char * const * arguments, int numargs) {
+		functionsigs.add(name, arguments, numargs, false, nullptr, 0);
+	});
+	*count = functionsigs.count;
+	return functionsigs.data;
+}
+
 /* $EXPORT$
  * Generates the contents of a symbols file for in a specific format.
  */
@@ -709,6 +809,17 @@ EXPORT const char * asar_getsymbolsfile(const char* type){
 	return symbolsfile;
 }
 
+/* $EXPORT$
+ * Sets how deeply incsrc and macro calls may nest before asar_patch() stops
+ * with a recursion limit error. Values below 1 select the default of 512.
+ * The limits stay in effect until they're set again.
+ */
+EXPORT void asar_setnestinglimits(int max_includes, int max_macros)
+{
+	max_include_depth = max_includes < 1 ? default_nesting_limit : max_includes;
+	max_macro_depth = max_macros < 1 ? default_nesting_limit : max_macros;
+}
+
 #if defined(__clang__)
 #	pragma clang diagnostic pop
 #endif
@@ -37,6 +37,17 @@ struct definedata {
 	const char * contents;
 };
 
+struct signaturedata {
+	const char * name;
+	// parameter names, null-terminated; a variadic macro's last one is "..."
+	const char * const * arguments;
+	int numargs;
+	bool variadic;
+	// where a macro was defined, null and 0 for functions
+	const char * filename;
+	int line;
+};
+
 struct warnsetting {
 	const char * warnid;
 	bool enabled;
@@ -211,10 +222,31 @@ const struct writtenblockdata * asar_getwrittenblocks(int * count);
  */
 enum mappertype asar_getmapper(void);
 
+/* Get the paths of all files read from disk by the last patch: the patch,
+ * incsrc'd sources, incbin/inclz data and table files. Memory files are
+ * not included.
+ */
+const char * const * asar_getinputfiles(int * count);
+
+/* Gets the names and parameters of all macros defined by the last patch.
+ */
+const struct signaturedata * asar_getmacros(int * count);
+
+/* Gets the names and parameters of all functions defined by the last patch
+ * with the function command. Built-in functions are not included.
+ */
+const struct signaturedata * asar_getfunctions(int * count);
+
 /* Generates the contents of a symbols file for in a specific format.
  */
 const char * asar_getsymbolsfile(const char* type);
 
+/* Sets how deeply incsrc and macro calls may nest before asar_patch() stops
+ * with a recursion limit error. Values below 1 select the default of 512.
+ * The limits stay in effect until they're set again.
+ */
+void asar_setnestinglimits(int max_includes, int max_macros);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,17 @@
 
 mapper_t mapper=lorom;
 int sa1banks[8]={0<<20, 1<<20, -1, -1, 2<<20, 3<<20, -1, -1};
+address_map mapper_map = []{
+	address_map map;
+	build_address_map(map, lorom, sa1banks);
+	return map;
+}();
+
+void set_mapper(mapper_t new_mapper)
+{
+	mapper = new_mapper;
+	build_address_map(mapper_map, mapper, sa1banks);
+}
 const unsigned char * romdata= nullptr; // NOTE: Changed into const to prevent direct write access - use writeromdata() functions below
 int romlen;
 static bool header;
@@ -21,6 +32,12 @@ int last_writtenblock_ind = 0;
 autoarray<writtenblockdata> cleared_rats_tag_blocks;
 std::vector<writtenblockdata> found_rats_tags;
 bool found_rats_tags_initialized;
+// pc offsets of every RATS tag header in the rom ("STAR", then the length
+// and its complement), sorted. overlapping headers are all kept, ratsstart
+// wants the closest one. built on first use after a rom load, then the rom
+// writers below keep it in sync so lookups never have to scan the rom.
+static std::vector<int> rats_index;
+static bool rats_index_initialized;
 
 // RPG Hacker: Uses binary search to find the insert position of our ROM write
 static int findromwritepos(int snesoffset, int searchstartpos, int searchendpos)
@@ -125,15 +142,60 @@ void addromwrite(int pcoffset, int numbytes)
 	addromwriteforbank(snesaddr, bytesleft);
 }
 
+static inline bool is_rats_header(int pos)
+{
+	return !strncmp((const char*)romdata+pos, "STAR", 4) &&
+			(romdata[pos+4]^romdata[pos+6])==0xFF &&
+			(romdata[pos+5]^romdata[pos+7])==0xFF;
+}
+
+static void build_rats_index()
+{
+	rats_index.clear();
+	for(int pos = 0; pos < romlen; pos++) {
+		if (is_rats_header(pos)) rats_index.push_back(pos);
+	}
+	rats_index_initialized = true;
+}
+
+// [pcoffset, pcoffset+numbytes) just changed: recheck every header that
+// could overlap it.
+static void update_rats_index(int pcoffset, int numbytes)
+{
+	if(!rats_index_initialized || numbytes <= 0) return;
+	int first = std::max(pcoffset - 7, 0);
+	int last = pcoffset + numbytes;
+	auto lo = std::lower_bound(rats_index.begin(), rats_index.end(), first);
+	auto hi = std::lower_bound(lo, rats_index.end(), last);
+	std::vector<int> found;
+	for(int pos = first; pos < last; pos++) {
+		if (is_rats_header(pos)) found.push_back(pos);
+	}
+	// common case: a plain write that neither had nor makes a tag
+	if(lo == hi && found.empty()) return;
+	auto at = rats_index.erase(lo, hi);
+	rats_index.insert(at, found.begin(), found.end());
+}
+
+void invalidate_rats_tags()
+{
+	found_rats_tags_initialized = false;
+	found_rats_tags.clear();
+	rats_index_initialized = false;
+	rats_index.clear();
+}
+
 void writeromdata(int pcoffset, const void * indata, int numbytes)
 {
 	memcpy(const_cast<unsigned char*>(romdata) + pcoffset, indata, (size_t)numbytes);
+	update_rats_index(pcoffset, numbytes);
 	addromwrite(pcoffset, numbytes);
 }
 
 void writeromdata_byte(int pcoffset, unsigned char indata, bool add_write)
 {
 	memcpy(const_cast<unsigned char*>(romdata) + pcoffset, &indata, 1);
+	update_rats_index(pcoffset, 1);
 	if(add_write)
 		addromwrite(pcoffset, 1);
 }
@@ -141,6 +203,7 @@ void writeromdata_byte(int pcoffset, unsigned char indata, bool add_write)
 void writeromdata_bytes(int pcoffset, unsigned char indata, int numbytes, bool add_write)
 {
 	memset(const_cast<unsigned char*>(romdata) + pcoffset, indata, (size_t)numbytes);
+	update_rats_index(pcoffset, numbytes);
 	if(add_write)
 		addromwrite(pcoffset, numbytes);
 }
@@ -149,16 +212,14 @@ int ratsstart(int snesaddr)
 {
 	int pcaddr=snestopc(snesaddr);
 	if (pcaddr<0x7FFF8) return -1;
-	const unsigned char * start=romdata+pcaddr-0x10000;
-	for (int i=0x10000;i>=0;i--)
-	{
-		if (!strncmp((const char*)start+i, "STAR", 4) &&
-				(start[i+4]^start[i+6])==0xFF && (start[i+5]^start[i+7])==0xFF)
-		{
-			if ((start[i+4]|(start[i+5]<<8))>0x10000-i-8-1) return pctosnes((int)(start-romdata+i));
-			return -1;
-		}
-	}
+	if(!rats_index_initialized) build_rats_index();
+	// the closest tag header at or before pcaddr, at most a bank back.
+	// pcaddr belongs to it only if the tag's data reaches that far.
+	auto tag = std::upper_bound(rats_index.begin(), rats_index.end(), pcaddr);
+	if(tag == rats_index.begin()) return -1;
+	int pos = *--tag;
+	if(pos < pcaddr-0x10000) return -1;
+	if ((romdata[pos+4]|(romdata[pos+5]<<8))>pcaddr-pos-8-1) return pctosnes(pos);
 	return -1;
 }
 
@@ -185,6 +246,7 @@ void removerats(int snesaddr, unsigned char clean_byte)
 	// don't use writeromdata() because this must not go to the writtenblocks list.
 	int len = (romdata[addr+4]|(romdata[addr+5]<<8))+9;
 	memset(const_cast<unsigned char*>(romdata) + addr, clean_byte, len);
+	update_rats_index(addr, len);
 	cleared_rats_tag_blocks[cleared_rats_tag_blocks.count] = writtenblockdata{addr, 0, len};
 }
 
@@ -202,16 +264,15 @@ void find_rats_tags()
 	// TODO: should probably look for overlapping rats tags too, just in case.
 	// note that found_rats_tags must not have overlaps, but we can merge overlapped rats tags into one
 	found_rats_tags.clear();
-	for(int pos = 0; pos < romlen;) {
-		if (!strncmp((const char*)romdata+pos, "STAR", 4) &&
-				(romdata[pos+4]^romdata[pos+6])==0xFF &&
-				(romdata[pos+5]^romdata[pos+7])==0xFF) {
-			int block_len = (romdata[pos+4]|(romdata[pos+5]<<8))+1+8;
-			found_rats_tags.push_back(writtenblockdata{pos, 0, block_len});
-			pos += block_len;
-		} else {
-			pos++;
-		}
+	if(!rats_index_initialized) build_rats_index();
+	// headers inside an earlier tag's data are skipped, like a linear scan would
+	int pos = 0;
+	for(int tag : rats_index) {
+		if(tag < pos) continue;
+		if(tag >= romlen) break;
+		int block_len = (romdata[tag+4]|(romdata[tag+5]<<8))+1+8;
+		found_rats_tags.push_back(writtenblockdata{tag, 0, block_len});
+		pos = tag + block_len;
 	}
 	found_rats_tags_initialized = true;
 }
@@ -340,6 +401,34 @@ static inline int trypcfreespace(int start, int alt_start, int end, int size, in
 	return -1;
 }
 
+// lists the runs of rom in [start, end) that trypcfreespace could hand out:
+// freespace bytes that aren't written to and aren't inside a rats-protected
+// block. runs are [start, end) pairs in ascending order.
+void getpcfreeruns(int start, int end, std::vector<std::pair<int, int>>& runs)
+{
+	runs.clear();
+	if(!found_rats_tags_initialized) find_rats_tags();
+	end = std::min(end, romlen);
+	if (start >= end) return;
+	std::vector<bool> used(end - start, false);
+	auto mark = [&](int pos, int len) {
+		for (int i = std::max(pos, start); i < std::min(pos + len, end); i++) used[i - start] = true;
+	};
+	for (int i = 0; i < writtenblocks.count; i++) mark(writtenblocks[i].pcoffset, writtenblocks[i].numbytes);
+	for (auto& tag : found_rats_tags) mark(tag.pcoffset, tag.numbytes);
+	int run_start = -1;
+	for (int i = start; i <= end; i++)
+	{
+		bool free = i < end && !used[i - start] && romdata[i] == freespacebyte;
+		if (free && run_start < 0) run_start = i;
+		if (!free && run_start >= 0)
+		{
+			runs.push_back(std::make_pair(run_start, i));
+			run_start = -1;
+		}
+	}
+}
+
 //This function finds a block of freespace. -1 means "no freespace found", anything else is a PC address.
 //isforcode=false tells it to favor banks 40+, true tells it to avoid them entirely.
 //It automatically adds a RATS tag.
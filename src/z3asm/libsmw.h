@@ -3,6 +3,7 @@
 
 #include "errors.h"
 #include "autoarray.h"
+#include "address-map.h"
 #include <cstdint>
 
 extern const unsigned char * romdata;
@@ -12,17 +13,7 @@ extern asar_error_id openromerror;
 bool openrom(const char * filename, bool confirm=true);
 uint32_t closerom(bool save = true);
 
-enum mapper_t {
-	invalid_mapper,
-	lorom,
-	hirom,
-	sa1rom,
-	bigsa1rom,
-	sfxrom,
-	exlorom,
-	exhirom,
-	norom
-} extern mapper;
+extern mapper_t mapper;
 
 extern int sa1banks[8];//only 0, 1, 4, 5 are used
 
@@ -43,170 +34,30 @@ extern autoarray<writtenblockdata> writtenblocks;
 extern std::vector<writtenblockdata> found_rats_tags;
 extern bool found_rats_tags_initialized;
 
+// tables for the current mapper and sa1banks
+extern address_map mapper_map;
+// switch mappers; always go through this so the tables stay in sync
+void set_mapper(mapper_t new_mapper);
+
 inline int snestopc(int addr)
 {
-	if (addr<0 || addr>0xFFFFFF) return -1;//not 24bit
-	if (mapper==lorom)
-	{
-		// randomdude999: The low pages ($0000-$7FFF) of banks 70-7D are used
-		// for SRAM, the high pages are available for ROM data though
-		if ((addr&0xFE0000)==0x7E0000 ||//wram
-			(addr&0x408000)==0x000000 ||//hardware regs, ram mirrors, other strange junk
-			(addr&0x708000)==0x700000)//sram (low parts of banks 70-7D)
-				return -1;
-		addr=((addr&0x7F0000)>>1|(addr&0x7FFF));
-		return addr;
-	}
-	if (mapper==hirom)
-	{
-		if ((addr&0xFE0000)==0x7E0000 ||//wram
-			(addr&0x408000)==0x000000)//hardware regs, ram mirrors, other strange junk
-				return -1;
-		return addr&0x3FFFFF;
-	}
-	if (mapper==exlorom)
-	{
-		if ((addr&0xF00000)==0x700000 ||//wram, sram
-			(addr&0x408000)==0x000000)//area that shouldn't be used in lorom
-				return -1;
-		if (addr&0x800000)
-		{
-			addr=((addr&0x7F0000)>>1|(addr&0x7FFF));
-		}
-		else
-		{
-			addr=((addr&0x7F0000)>>1|(addr&0x7FFF))+0x400000;
-		}
-		return addr;
-	}
-	if (mapper==exhirom)
-	{
-		if ((addr&0xFE0000)==0x7E0000 ||//wram
-			(addr&0x408000)==0x000000)//hardware regs, ram mirrors, other strange junk
-			return -1;
-		if ((addr&0x800000)==0x000000) return (addr&0x3FFFFF)|0x400000;
-		return addr&0x3FFFFF;
-	}
-	if (mapper==sfxrom)
-	{
-		// Asar emulates GSU1, because apparently emulators don't support the extra ROM data from GSU2
-		if ((addr&0x600000)==0x600000 ||//wram, sram, open bus
-			(addr&0x408000)==0x000000 ||//hardware regs, ram mirrors, rom mirrors, other strange junk
-			(addr&0x800000)==0x800000)//fastrom isn't valid either in superfx
-				return -1;
-		if (addr&0x400000) return addr&0x3FFFFF;
-		else return (addr&0x7F0000)>>1|(addr&0x7FFF);
-	}
-	if (mapper==sa1rom)
-	{
-		if ((addr&0x408000)==0x008000)
-		{
-			return sa1banks[(addr&0xE00000)>>21]|((addr&0x1F0000)>>1)|(addr&0x007FFF);
-		}
-        if ((addr&0xC00000)==0xC00000)
-        {
-            return sa1banks[((addr&0x100000)>>20)|((addr&0x200000)>>19)]|(addr&0x0FFFFF);
-        }
-		return -1;
-	}
-	if (mapper==bigsa1rom)
-	{
-		if ((addr&0xC00000)==0xC00000)//hirom
-		{
-			return (addr&0x3FFFFF)|0x400000;
-		}
-		if ((addr&0xC00000)==0x000000 || (addr&0xC00000)==0x800000)//lorom
-		{
-			if ((addr&0x008000)==0x000000) return -1;
-			return (addr&0x800000)>>2 | (addr&0x3F0000)>>1 | (addr&0x7FFF);
-		}
-		return -1;
-	}
-	if (mapper==norom)
-	{
-		return addr;
-	}
-	return -1;
+	return mapper_map.snestopc(addr);
 }
 
 inline int pctosnes(int addr)
 {
-	if (addr<0) return -1;
-	if (mapper==lorom)
-	{
-		if (addr>=0x400000) return -1;
-		addr=((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
-		return addr|0x800000;
-	}
-	if (mapper==hirom)
-	{
-		if (addr>=0x400000) return -1;
-		return addr|0xC00000;
-	}
-	if (mapper == exlorom)
-	{
-		if (addr>=0x800000) return -1;
-		if (addr&0x400000)
-		{
-			addr-=0x400000;
-			addr=((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
-			return addr;
-		}
-		else
-		{
-			addr=((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
-			return addr|0x800000;
-		}
-	}
-	if (mapper == exhirom)
-	{
-		if (addr>=0x800000) return -1;
-		if (addr&0x400000) return addr;
-		return addr|0xC00000;
-	}
-	if (mapper==sa1rom)
-	{
-		for (int i=0;i<8;i++)
-		{
-			if (sa1banks[i]==(addr&0x700000)){ return 0x008000|(i<<21)|((addr&0x0F8000)<<1)|(addr&0x7FFF);}
-		}
-		return -1;
-	}
-	if (mapper==bigsa1rom)
-	{
-		if (addr>=0x800000) return -1;
-		if ((addr&0x400000)==0x400000)
-		{
-			return addr|0xC00000;
-		}
-		if ((addr&0x600000)==0x000000)
-		{
-			return ((addr<<1)&0x3F0000)|0x8000|(addr&0x7FFF);
-		}
-		if ((addr&0x600000)==0x200000)
-		{
-			return 0x800000|((addr<<1)&0x3F0000)|0x8000|(addr&0x7FFF);
-		}
-		return -1;
-	}
-	if (mapper==sfxrom)
-	{
-		if (addr>=0x200000) return -1;
-		return ((addr<<1)&0x7F0000)|(addr&0x7FFF)|0x8000;
-	}
-	if (mapper==norom)
-	{
-		return addr;
-	}
-	return -1;
+	return mapper_map.pctosnes(addr);
 }
 
 int getpcfreespace(int size, int target_bank, bool autoexpand=true, bool respectbankborders=true, bool align=false, bool write_rats=true, int search_start=-1);
 int getsnesfreespace(int size, int target_bank, bool autoexpand=true, bool respectbankborders=true, bool align=false, bool write_rats=true, int search_start=-1);
+void getpcfreeruns(int start, int end, std::vector<std::pair<int, int>>& runs);
 
 void removerats(int snesaddr, unsigned char clean_byte);
 void handle_cleared_rats_tags();
 int ratsstart(int pcaddr);
+// forget the rats tag index, e.g. because a different rom was loaded
+void invalidate_rats_tags();
 
 void fixchecksum();
 
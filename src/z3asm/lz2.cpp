@@ -0,0 +1,351 @@
+#include "lz2.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Format summary: each command starts with a header byte CCCLLLLL (length-1
+// in the low 5 bits). If CCC is 7, the header is extended to two bytes:
+// 111CCCLL LLLLLLLL, allowing lengths up to 1024. A header of $FF ends the
+// stream.
+//   0: direct copy      - length bytes follow
+//   1: byte fill        - one byte, repeated
+//   2: word fill        - two bytes, alternated
+//   3: increasing fill  - one byte, incremented after every write
+//   4: repeat           - little-endian absolute offset into the output
+//
+// Compression finds, for every position, the longest run each command could
+// cover, then picks the cheapest sequence of commands with a shortest-path
+// pass over the input (processed back to front). Since a command's cost only
+// depends on whether its length fits in a short header, each step is a
+// range-minimum query over the already solved suffix.
+
+enum lz2_cmd {
+	lz2_direct = 0,
+	lz2_bytefill = 1,
+	lz2_wordfill = 2,
+	lz2_incfill = 3,
+	lz2_repeat = 4,
+};
+
+static const int lz2_max_len = 1024;
+static const int lz2_short_len = 32;
+// repeat offsets are 16-bit, so matches can only start in the first 64 KiB
+static const int lz2_max_offset = 0xFFFF;
+static const int lz2_hash_bits = 16;
+static const int lz2_chain_depth = 256;
+
+namespace {
+
+// segment tree answering "smallest value (and where) in [lo, hi]"
+struct min_tree {
+	int size;
+	std::vector<int> val;
+	std::vector<int> idx;
+
+	explicit min_tree(int n)
+	{
+		size = 1;
+		while (size < n) size <<= 1;
+		val.assign(size * 2, INT32_MAX);
+		idx.assign(size * 2, -1);
+	}
+
+	void set(int i, int v)
+	{
+		int node = i + size;
+		val[node] = v;
+		idx[node] = i;
+		for (node >>= 1; node; node >>= 1)
+		{
+			int l = node * 2;
+			int r = l + 1;
+			int pick = val[r] < val[l] ? r : l;
+			val[node] = val[pick];
+			idx[node] = idx[pick];
+		}
+	}
+
+	// returns INT32_MAX if the range is empty
+	int query(int lo, int hi, int & at) const
+	{
+		int best = INT32_MAX;
+		at = -1;
+		for (lo += size, hi += size + 1; lo < hi; lo >>= 1, hi >>= 1)
+		{
+			if (lo & 1)
+			{
+				if (val[lo] < best) { best = val[lo]; at = idx[lo]; }
+				lo++;
+			}
+			if (hi & 1)
+			{
+				hi--;
+				if (val[hi] < best) { best = val[hi]; at = idx[hi]; }
+			}
+		}
+		return best;
+	}
+};
+
+struct lz2_step {
+	int cmd;
+	int len;
+	int arg;
+};
+
+}
+
+static void lz2_write_header(std::vector<uint8_t> & out, int cmd, int len)
+{
+	int l = len - 1;
+	if (len > lz2_short_len)
+	{
+		out.push_back((uint8_t)(0xE0 | (cmd << 2) | (l >> 8)));
+		out.push_back((uint8_t)(l & 0xFF));
+	}
+	else
+	{
+		out.push_back((uint8_t)((cmd << 5) | l));
+	}
+}
+
+// longest repeat for every position, found with 3-byte hash chains. overlapping
+// matches are fine since the decompressor copies one byte at a time.
+static void lz2_find_matches(const uint8_t * data, int len, std::vector<int> & match_len, std::vector<int> & match_off)
+{
+	match_len.assign(len, 0);
+	match_off.assign(len, 0);
+	if (len < 3) return;
+	std::vector<int> head(1 << lz2_hash_bits, -1);
+	std::vector<int> prev(std::min(len, lz2_max_offset + 1), -1);
+	auto hash3 = [&](int i) {
+		uint32_t h = data[i] | data[i+1] << 8 | data[i+2] << 16;
+		return (int)((h * 2654435761u) >> (32 - lz2_hash_bits));
+	};
+	for (int i = 0; i + 2 < len; i++)
+	{
+		int h = hash3(i);
+		int limit = std::min(lz2_max_len, len - i);
+		int depth = 0;
+		for (int p = head[h]; p >= 0 && depth < lz2_chain_depth; p = prev[p], depth++)
+		{
+			if (data[p + match_len[i]] != data[i + match_len[i]]) continue;
+			int l = 0;
+			while (l < limit && data[p + l] == data[i + l]) l++;
+			if (l > match_len[i])
+			{
+				match_len[i] = l;
+				match_off[i] = p;
+				if (l == limit) break;
+			}
+		}
+		if (i <= lz2_max_offset)
+		{
+			prev[i] = head[h];
+			head[h] = i;
+		}
+	}
+}
+
+std::vector<uint8_t> lz2_compress(const uint8_t * data, int len)
+{
+	std::vector<uint8_t> out;
+	if (len <= 0)
+	{
+		out.push_back(0xFF);
+		return out;
+	}
+
+	std::vector<int> match_len, match_off;
+	lz2_find_matches(data, len, match_len, match_off);
+
+	// run lengths for the fill commands, computed back to front
+	std::vector<int> byte_run(len + 1, 0);
+	std::vector<int> inc_run(len + 1, 0);
+	std::vector<int> alt_run(len + 2, 0); // positions k where data[k] == data[k-2]
+	for (int i = len - 1; i >= 0; i--)
+	{
+		bool next = i + 1 < len;
+		byte_run[i] = next && data[i+1] == data[i] ? byte_run[i+1] + 1 : 1;
+		inc_run[i] = next && data[i+1] == (uint8_t)(data[i] + 1) ? inc_run[i+1] + 1 : 1;
+		alt_run[i] = i >= 2 && data[i] == data[i-2] ? alt_run[i+1] + 1 : 0;
+	}
+
+	// cost[i] = bytes needed to encode data[i..len). literal[i] tracks
+	// cost[i] + i so that a run of direct bytes is a single range query.
+	std::vector<int> cost(len + 1, 0);
+	std::vector<lz2_step> choice(len);
+	min_tree cost_tree(len + 1);
+	min_tree literal_tree(len + 1);
+	cost_tree.set(len, 0);
+	literal_tree.set(len, len);
+
+	for (int i = len - 1; i >= 0; i--)
+	{
+		int best;
+		lz2_step pick;
+
+		// tries every length in [1, maxlen] for a command with the given payload
+		auto consider = [&](int cmd, int maxlen, int payload, int arg) {
+			maxlen = std::min(maxlen, lz2_max_len);
+			int at;
+			int v = cost_tree.query(i + 1, i + std::min(maxlen, lz2_short_len), at);
+			if (v != INT32_MAX && v + 1 + payload < best)
+			{
+				best = v + 1 + payload;
+				pick = { cmd, at - i, arg };
+			}
+			if (maxlen > lz2_short_len)
+			{
+				v = cost_tree.query(i + lz2_short_len + 1, i + maxlen, at);
+				if (v != INT32_MAX && v + 2 + payload < best)
+				{
+					best = v + 2 + payload;
+					pick = { cmd, at - i, arg };
+				}
+			}
+		};
+
+		int direct_max = std::min(lz2_max_len, len - i);
+		int at;
+		int v = literal_tree.query(i + 1, i + std::min(direct_max, lz2_short_len), at);
+		best = v - i + 1;
+		pick = { lz2_direct, at - i, 0 };
+		if (direct_max > lz2_short_len)
+		{
+			v = literal_tree.query(i + lz2_short_len + 1, i + direct_max, at);
+			if (v - i + 2 < best)
+			{
+				best = v - i + 2;
+				pick = { lz2_direct, at - i, 0 };
+			}
+		}
+
+		if (byte_run[i] >= 2) consider(lz2_bytefill, byte_run[i], 1, 0);
+		if (inc_run[i] >= 2) consider(lz2_incfill, inc_run[i], 1, 0);
+		if (i + 2 < len && alt_run[i+2] >= 1) consider(lz2_wordfill, 2 + alt_run[i+2], 2, 0);
+		if (match_len[i] >= 3) consider(lz2_repeat, match_len[i], 2, match_off[i]);
+
+		cost[i] = best;
+		choice[i] = pick;
+		cost_tree.set(i, best);
+		literal_tree.set(i, best + i);
+	}
+
+	out.reserve(cost[0] + 1);
+	for (int i = 0; i < len; )
+	{
+		const lz2_step & s = choice[i];
+		lz2_write_header(out, s.cmd, s.len);
+		switch (s.cmd)
+		{
+			case lz2_direct:
+				out.insert(out.end(), data + i, data + i + s.len);
+				break;
+			case lz2_bytefill:
+			case lz2_incfill:
+				out.push_back(data[i]);
+				break;
+			case lz2_wordfill:
+				out.push_back(data[i]);
+				out.push_back(data[i+1]);
+				break;
+			case lz2_repeat:
+				out.push_back((uint8_t)(s.arg & 0xFF));
+				out.push_back((uint8_t)(s.arg >> 8));
+				break;
+		}
+		i += s.len;
+	}
+	out.push_back(0xFF);
+	return out;
+}
+
+// once inputs totalling this many bytes are cached, finished entries get
+// dropped. keeps long-running hosts (the language server) from growing forever.
+static const size_t lz2_cache_limit = 64 * 1024 * 1024;
+
+namespace {
+
+struct lz2_cache_entry {
+	// kept so a hash collision can't hand back another input's stream
+	std::shared_ptr<const std::vector<uint8_t>> input;
+	std::shared_future<std::vector<uint8_t>> result;
+};
+
+}
+
+static std::mutex lz2_cache_mutex;
+static std::unordered_multimap<uint64_t, lz2_cache_entry> lz2_cache;
+static size_t lz2_cache_bytes = 0;
+
+// FNV-1a, mixed with the length so truncated copies of a file don't collide
+static uint64_t lz2_hash(const uint8_t * data, int len)
+{
+	uint64_t h = 14695981039346656037ull;
+	for (int i = 0; i < len; i++)
+	{
+		h ^= data[i];
+		h *= 1099511628211ull;
+	}
+	return h ^ ((uint64_t)len << 40);
+}
+
+static void lz2_trim_cache()
+{
+	if (lz2_cache_bytes <= lz2_cache_limit) return;
+	lz2_cache_bytes = 0;
+	for (auto it = lz2_cache.begin(); it != lz2_cache.end(); )
+	{
+		if (it->second.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			it = lz2_cache.erase(it);
+		}
+		else
+		{
+			lz2_cache_bytes += it->second.input->size();
+			++it;
+		}
+	}
+}
+
+static std::shared_future<std::vector<uint8_t>> lz2_submit(const uint8_t * data, int len, bool async)
+{
+	uint64_t key = lz2_hash(data, len);
+	std::lock_guard<std::mutex> lock(lz2_cache_mutex);
+	auto range = lz2_cache.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const std::vector<uint8_t> & input = *it->second.input;
+		if ((int)input.size() == len && std::equal(input.begin(), input.end(), data)) return it->second.result;
+	}
+	lz2_trim_cache();
+	auto input = std::make_shared<const std::vector<uint8_t>>(data, data + len);
+	std::shared_future<std::vector<uint8_t>> result = std::async(async ? std::launch::async : std::launch::deferred,
+		[input]() { return lz2_compress(input->data(), (int)input->size()); }).share();
+	lz2_cache.emplace(key, lz2_cache_entry{input, result});
+	lz2_cache_bytes += len;
+	return result;
+}
+
+std::vector<uint8_t> lz2_compress_cached(const uint8_t * data, int len)
+{
+	return lz2_submit(data, len, false).get();
+}
+
+void lz2_prefetch(const uint8_t * data, int len)
+{
+	lz2_submit(data, len, true);
+}
+
+void lz2_clear_cache()
+{
+	std::lock_guard<std::mutex> lock(lz2_cache_mutex);
+	lz2_cache.clear();
+	lz2_cache_bytes = 0;
+}
@@ -0,0 +1,21 @@
+// LC_LZ2 compression, the format ALTTP uses for its graphics and tilemaps
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// compresses len bytes of data into a near-optimal stream (the terminating
+// $FF is included)
+std::vector<uint8_t> lz2_compress(const uint8_t * data, int len);
+
+// same as lz2_compress, but results are cached by the input, so identical
+// assets are only compressed once per process. waits for a prefetch of the
+// same input instead of starting over.
+std::vector<uint8_t> lz2_compress_cached(const uint8_t * data, int len);
+
+// starts compressing data on a worker thread unless it's already cached, so
+// independent assets get compressed in parallel before they're needed.
+void lz2_prefetch(const uint8_t * data, int len);
+
+void lz2_clear_cache();
@@ -121,12 +121,87 @@ void freemacro(macrodata* & macro)
 #undef cfree
 
 
-void callmacro(const char * data)
+// One macro call: the arguments it was called with and what it replaced,
+// which leave() puts back.
+class macro_frame : public source_frame {
+public:
+	string call;
+	// the arguments point into this
+	string parsed;
+	autoptr<const char * const*> args;
+	int numargs;
+	macrodata* macro;
+	int i;
+	int startif;
+	int prev_numvarargs;
+	int old_calledmacros;
+
+	autoarray<int>* oldmacroposlabels;
+	autoarray<int>* oldmacroneglabels;
+	autoarray<string>* oldmacrosublabels;
+
+	autoarray<int> newmacroposlabels;
+	autoarray<int> newmacroneglabels;
+	autoarray<string> newmacrosublabels;
+
+	macrodata* old_macro;
+	const char* const* old_macro_args;
+	int old_numargs;
+
+	void enter() override
+	{
+		callstack.append(callstack_entry(callstack_entry_type::MACRO_CALL, call, -1));
+		callstack.append(callstack_entry(callstack_entry_type::FILE, macro->fname, -1));
+	}
+
+	const char * nextline(int& lineno) override
+	{
+		if (i >= macro->numlines) return nullptr;
+		lineno = macro->startline+i+1;
+		return macro->lines[i];
+	}
+
+	void endline(bool was_loop_end) override
+	{
+		if (was_loop_end && whilestatus[numif].cond)
+			// RPG Hacker: -1 to compensate for the i++, and another -1
+			// because ->lines doesn't include the macro header.
+			i = whilestatus[numif].startline - macro->startline - 2;
+		i++;
+	}
+
+	void leave() override
+	{
+		callstack.remove(callstack.count-1);
+
+		macroposlabels = oldmacroposlabels;
+		macroneglabels = oldmacroneglabels;
+		macrosublabels = oldmacrosublabels;
+
+		current_macro = old_macro;
+		current_macro_args = old_macro_args;
+		current_macro_numargs = old_numargs;
+
+		macrorecursion--;
+		inmacro = macrorecursion;
+		numvarargs = prev_numvarargs;
+		calledmacros = old_calledmacros;
+		if (numif!=startif)
+		{
+			numif=startif;
+			numtrue=startif;
+			asar_throw_error(0, error_type_block, error_id_unclosed_if);
+		}
+	}
+};
+
+// Finds the macro and splits the arguments, which point into frame->parsed.
+static void parsemacrocall(macro_frame* frame, const char * data)
 {
-	int prev_numvarargs = numvarargs;
 	macrodata * thismacro;
-	if (!confirmqpar(data)) asar_throw_error(0, error_type_block, error_id_broken_macro_usage);
-	string line=data;
+	frame->numargs=0;
+	string& line=frame->parsed;
+	line=data;
 	line.qnormalize();
 	char * startpar=(char *)strchr(line.data(), '(');
 	if (!startpar) asar_throw_error(0, error_type_block, error_id_broken_macro_usage);
@@ -139,22 +214,46 @@ void callmacro(const char * data)
 	//confirmqpar requires that all parentheses are matched, and a starting one exists, therefore it is harmless to not check for nullptrs
 	if (*endpar != ')') asar_throw_error(0, error_type_block, error_id_broken_macro_usage);
 	*endpar=0;
-	autoptr<const char * const*> args;
-	int numargs=0;
+	autoptr<const char * const*>& args=frame->args;
 	if (*startpar) {
-		args=(const char* const*)qpsplit(startpar, ',', &numargs);
+		args=(const char* const*)qpsplit(startpar, ',', &frame->numargs);
 		// qpsplit returns a nullptr when the input is broken, e.g. closing paren before opening or whatnot
 		if(args == nullptr) asar_throw_error(0, error_type_block, error_id_broken_macro_usage);
 	}
-	if (numargs != thismacro->numargs && !thismacro->variadic) asar_throw_error(1, error_type_block, error_id_macro_wrong_num_params);
+	if (frame->numargs != thismacro->numargs && !thismacro->variadic) asar_throw_error(1, error_type_block, error_id_macro_wrong_num_params);
 	// RPG Hacker: -1, because the ... is also counted as an argument, yet we want it to be entirely optional.
-	if (numargs < thismacro->numargs - 1 && thismacro->variadic) asar_throw_error(1, error_type_block, error_id_macro_wrong_min_params);
+	if (frame->numargs < thismacro->numargs - 1 && thismacro->variadic) asar_throw_error(1, error_type_block, error_id_macro_wrong_min_params);
+
+	frame->macro = thismacro;
+}
+
+void callmacro(const char * data)
+{
+	if (!confirmqpar(data)) asar_throw_error(0, error_type_block, error_id_broken_macro_usage);
+	if (macrorecursion >= max_macro_depth) asar_throw_error(pass, error_type_fatal, error_id_recursion_limit);
+	macro_frame* frame = new macro_frame;
+	try
+	{
+		parsemacrocall(frame, data);
+	}
+	catch (errblock&)
+	{
+		delete frame;
+		throw;
+	}
+	macrodata * thismacro = frame->macro;
+	autoptr<const char * const*>& args = frame->args;
+	int numargs = frame->numargs;
+
+	frame->call = data;
+	frame->i = 0;
+	frame->prev_numvarargs = numvarargs;
 
 	macrorecursion++;
 	inmacro=true;
-	int old_calledmacros = calledmacros;
+	frame->old_calledmacros = calledmacros;
 	calledmacros = reallycalledmacros++;
-	int startif=numif;
+	frame->startif=numif;
 
 	for (int i = 0; i < numargs; ++i)
 	{
@@ -166,59 +265,23 @@ void callmacro(const char * data)
 	if(thismacro->variadic) numvarargs = numargs-(thismacro->numargs-1);
 	else numvarargs = -1;
 
-	autoarray<int>* oldmacroposlabels = macroposlabels;
-	autoarray<int>* oldmacroneglabels = macroneglabels;
-	autoarray<string>* oldmacrosublabels = macrosublabels;
+	frame->oldmacroposlabels = macroposlabels;
+	frame->oldmacroneglabels = macroneglabels;
+	frame->oldmacrosublabels = macrosublabels;
 
-	autoarray<int> newmacroposlabels;
-	autoarray<int> newmacroneglabels;
-	autoarray<string> newmacrosublabels;
+	macroposlabels = &frame->newmacroposlabels;
+	macroneglabels = &frame->newmacroneglabels;
+	macrosublabels = &frame->newmacrosublabels;
 
-	macroposlabels = &newmacroposlabels;
-	macroneglabels = &newmacroneglabels;
-	macrosublabels = &newmacrosublabels;
-
-	macrodata* old_macro = current_macro;
-	const char* const* old_macro_args = current_macro_args;
-	int old_numargs = current_macro_numargs;
+	frame->old_macro = current_macro;
+	frame->old_macro_args = current_macro_args;
+	frame->old_numargs = current_macro_numargs;
 	current_macro = thismacro;
 	current_macro_args = args;
 	current_macro_numargs = numargs;
 
-	callstack_push cs_push(callstack_entry_type::MACRO_CALL, data);
-
-	{
-		callstack_push cs_push(callstack_entry_type::FILE, thismacro->fname);
-
-		for (int i=0;i<thismacro->numlines;i++)
-		{
-			bool was_loop_end = do_line_logic(thismacro->lines[i], thismacro->fname, thismacro->startline+i+1);
-
-			if (was_loop_end && whilestatus[numif].cond)
-				// RPG Hacker: -1 to compensate for the i++, and another -1
-				// because ->lines doesn't include the macro header.
-				i = whilestatus[numif].startline - thismacro->startline - 2;
-		}
-	}
-
-	macroposlabels = oldmacroposlabels;
-	macroneglabels = oldmacroneglabels;
-	macrosublabels = oldmacrosublabels;
-
-	current_macro = old_macro;
-	current_macro_args = old_macro_args;
-	current_macro_numargs = old_numargs;
-
-	macrorecursion--;
-	inmacro = macrorecursion;
-	numvarargs = prev_numvarargs;
-	calledmacros = old_calledmacros;
-	if (numif!=startif)
-	{
-		numif=startif;
-		numtrue=startif;
-		asar_throw_error(0, error_type_block, error_id_unclosed_if);
-	}
+	// the lines run once the block calling the macro is done
+	push_frame(frame);
 }
 
 string generate_macro_arg_string(const char* named_arg, int depth)
@@ -7,6 +7,7 @@
 #include "assembleblock.h"
 #include "asar_math.h"
 #include "macro.h"
+#include "lz2.h"
 #include <ctime>
 // randomdude999: remember to also update the .rc files (in res/windows/) when changing this.
 // Couldn't find a way to automate this without shoving the version somewhere in the CMake files
@@ -31,10 +32,12 @@ int optimizeforbank=-1;
 int optimize_dp = optimize_dp_flag::ALWAYS;
 int dp_base = 0;
 int optimize_address = optimize_address_flag::MIRRORS;
+bool optimize_relax = false;
 
 autoarray<callstack_entry> callstack;
 
 bool errored=false;
+bool errored_in_pass=false;
 bool ignoretitleerrors=false;
 
 volatile int recursioncount=0;
@@ -55,7 +58,7 @@ bool setmapper()
 	mapper_t maps[]={lorom, hirom, exlorom, exhirom};
 	for (size_t mapid=0;mapid<sizeof(maps)/sizeof(maps[0]);mapid++)
 	{
-		mapper=maps[mapid];
+		set_mapper(maps[mapid]);
 		int score=0;
 		int highbits=0;
 		bool foundnull=false;
@@ -82,14 +85,14 @@ bool setmapper()
 			bestmap=mapper;
 		}
 	}
-	mapper=bestmap;
+	set_mapper(bestmap);
 
 	//detect oddball mappers
 	int mapperbyte=romdata[snestopc(0x00FFD5)];
 	int romtypebyte=romdata[snestopc(0x00FFD6)];
 	if (mapper==lorom)
 	{
-		if (mapperbyte==0x23 && (romtypebyte==0x32 || romtypebyte==0x34 || romtypebyte==0x35)) mapper=sa1rom;
+		if (mapperbyte==0x23 && (romtypebyte==0x32 || romtypebyte==0x34 || romtypebyte==0x35)) set_mapper(sa1rom);
 	}
 	return (maxscore>=0);
 }
@@ -354,19 +357,35 @@ virtual_file_error asar_get_last_io_error()
 }
 
 static bool freespaced;
+// set while measuring what an operand would have cost without relaxation
+static bool relax_suppressed = false;
 static int getlenforlabel(snes_label thislabel, bool exists)
 {
 	unsigned int bank = thislabel.pos>>16;
 	unsigned int word = thislabel.pos&0xFFFF;
 	bool lblfreespace = thislabel.freespace_id > 0;
+	int curfreespace = freespaceid;
+	unsigned int curbank = snespos >> 16;
+	if (relax_active() && !relax_suppressed)
+	{
+		// once freespaces are placed, blocks that can't cross banks have a
+		// known final bank, so treat them like code at a fixed location.
+		if (lblfreespace && !freespaces[thislabel.freespace_id].allow_bankcross) lblfreespace = false;
+		if (freespaceid > 0 && !freespaces[freespaceid].allow_bankcross)
+		{
+			curfreespace = 0;
+			curbank = (unsigned int)freespaces[freespaceid].pos >> 16;
+		}
+	}
+	int lblfreespace_id = lblfreespace ? thislabel.freespace_id : 0;
 	unsigned int relaxed_bank;
 	if(optimizeforbank >= 0) {
 		relaxed_bank = optimizeforbank;
 	} else {
-		if(freespaceid == 0) {
-			relaxed_bank = snespos >> 16;
+		if(curfreespace == 0) {
+			relaxed_bank = curbank;
 		} else {
-			int target_bank = freespaces[freespaceid].bank;
+			int target_bank = freespaces[curfreespace].bank;
 			if(target_bank == -2) relaxed_bank = 0;
 			else if(target_bank == -1) relaxed_bank = 0x40;
 			else relaxed_bank = target_bank;
@@ -408,21 +427,29 @@ static int getlenforlabel(snes_label thislabel, bool exists)
 	{
 		// if optimizing for a specific bank:
 		// if the label is in freespace, never optimize
-		if (thislabel.freespace_id > 0) return 3;
+		if (lblfreespace) return 3;
 		else if (bank==(unsigned int)optimizeforbank) return 2;
 		else return 3;
 	}
-	else if (thislabel.freespace_id > 0 || freespaceid > 0)
+	else if (lblfreespace_id > 0 || curfreespace > 0)
 	{
 		// optimize only if the label is in the same freespace
 		// TODO: check whether they're pinned to the same bank
-		if (thislabel.freespace_id != freespaceid) return 3;
+		if (lblfreespace_id != curfreespace) return 3;
 		else return 2;
 	}
-	else if ((int)bank != snespos >> 16){ return 3; }
+	else if (bank != curbank){ return 3; }
 	else { return 2;}
 }
 
+int getlen_unrelaxed(const char * str, bool optimizebankextraction)
+{
+	relax_suppressed = true;
+	int len = getlen(str, optimizebankextraction);
+	relax_suppressed = false;
+	return len;
+}
+
 
 bool is_hex_constant(const char* str){
 	if (*str=='$')
@@ -443,18 +470,18 @@ int getlen(const char * orgstr, bool optimizebankextraction)
 	const char * str=orgstr;
 	freespaced=false;
 
-	const char* posneglabel = str;
-	string posnegname = posneglabelname(&posneglabel, false);
+	const char* posneglabelend = str;
+	anon_label_key posnegkey;
 
-	if (posnegname.length() > 0)
+	if (posneglabel(&posneglabelend, false, &posnegkey))
 	{
-		if (*posneglabel != '\0') goto notposneglabel;
+		if (*posneglabelend != '\0') goto notposneglabel;
 
 		if (!pass) return 2;
 		snes_label label_data;
 		// RPG Hacker: Umm... what kind of magic constant is this?
 		label_data.pos = 31415926;
-		bool found = labelval(posnegname, &label_data);
+		bool found = labelval(posnegkey, &label_data);
 		return getlenforlabel(label_data, found);
 	}
 notposneglabel:
@@ -522,10 +549,19 @@ struct stricompare {
 	}
 };
 
+// where a false branch that starts on some line ends, see build_skip_table()
+struct condskip {
+	// line of the elseif/else/endif/endwhile/endfor, -1 if it can't be skipped
+	int end;
+	// how many levels of if/while/for the branch nests inside it
+	int nested;
+};
+
 struct sourcefile {
 	char *data;
 	char** contents;
 	int numlines;
+	condskip* skip;
 };
 
 static assocarr<sourcefile> filecontents;
@@ -722,21 +758,54 @@ void resolvedefines(string& out, const char * start)
 bool moreonline;
 bool asarverallowed = false;
 
-void assembleline(const char * fname, int linenum, const char * line, int& single_line_for_tracker)
+int max_include_depth = default_nesting_limit;
+int max_macro_depth = default_nesting_limit;
+
+static autoarray<source_frame*> frames;
+
+source_frame::source_frame()
+{
+	line.pending = false;
+	line.blocks = nullptr;
+	callstack_base = -1;
+	line_callstack_base = 0;
+}
+
+source_frame::~source_frame()
+{
+	free(line.blocks);
+}
+
+// Assembles the blocks of a line from line.block on. A block that calls a
+// macro or includes a file leaves the line pending, to carry on from the
+// next block once that frame is done.
+static void assembleblocks(pending_line& line)
 {
 	recurseblock rec;
-	bool moreonlinetmp=moreonline;
-	// randomdude999: redundant, assemblefile already converted the path to absolute
-	//string absolutepath = filesystem->create_absolute_path("", fname);
-	string absolutepath = fname;
-	single_line_for_tracker = 1;
+	int startframes = frames.count;
 	try
 	{
-		string out=line;
-		autoptr<char**> blocks=qsplitstr(out.temp_raw(), " : ");
-		moreonline=true;
-		for (int block=0;moreonline;block++)
+		if (line.pending)
+		{
+			line.pending = false;
+			moreonline = (line.blocks[line.block+1] != nullptr);
+			if (!line.block_failed)
+			{
+				try
+				{
+					callstack_push cs_push(callstack_entry_type::BLOCK, line.blocktext);
+					checkbankcross();
+				}
+				catch (errblock&) {}
+			}
+			if (line.blocks[line.block][0]!='\0') asarverallowed=false;
+			if(line.single_line_for_tracker == 1) line.single_line_for_tracker = 0;
+			line.block++;
+		}
+		for (;moreonline;line.block++)
 		{
+			char ** blocks = line.blocks;
+			int block = line.block;
 			moreonline=(blocks[block+1] != nullptr);
 			try
 			{
@@ -764,16 +833,140 @@ void assembleline(const char * fname, int linenum, const char * line, int& singl
 
 				callstack_push cs_push(callstack_entry_type::BLOCK, stripped_block.data() + i);
 
-				assembleblock(stripped_block.data() + i, single_line_for_tracker);
+				assembleblock(stripped_block.data() + i, line.single_line_for_tracker);
+				if (frames.count > startframes)
+				{
+					line.pending = true;
+					line.block_failed = false;
+					line.blocktext = stripped_block.data() + i;
+					return;
+				}
 				checkbankcross();
 			}
 			catch (errblock&) {}
 			if (blocks[block][0]!='\0') asarverallowed=false;
-			if(single_line_for_tracker == 1) single_line_for_tracker = 0;
+			if(line.single_line_for_tracker == 1) line.single_line_for_tracker = 0;
 		}
 	}
 	catch (errline&) {}
-	moreonline=moreonlinetmp;
+	moreonline=line.moreonlinetmp;
+	free(line.blocks);
+	line.blocks = nullptr;
+}
+
+void assembleline(pending_line& line)
+{
+	line.moreonlinetmp=moreonline;
+	line.single_line_for_tracker = 1;
+	line.out=line.current_line;
+	line.blocks=qsplitstr(line.out.temp_raw(), " : ");
+	line.block=0;
+	moreonline=true;
+	assembleblocks(line);
+}
+
+// did a loop end on this line
+static bool line_ended_loop(const pending_line& line)
+{
+	return (numif != line.prevnumif || line.single_line_for_tracker == 3)
+		&& (whilestatus[numif].iswhile || whilestatus[numif].is_for);
+}
+
+// carries on with a line once the frame one of its blocks pushed is done
+static bool resumeline(pending_line& line)
+{
+	callstack_push cs_push(callstack_entry_type::LINE, line.current_line, line.lineno);
+	assembleblocks(line);
+	return !line.pending && line_ended_loop(line);
+}
+
+void push_frame(source_frame* frame)
+{
+	if (frames.count)
+	{
+		const source_frame* top = frames[frames.count-1];
+		for (int i = top->line_callstack_base; i < callstack.count; i++)
+		{
+			frame->caller_callstack.append(callstack[i]);
+		}
+	}
+	frames.append(frame);
+}
+
+int num_frames()
+{
+	return frames.count;
+}
+
+static void pop_frame()
+{
+	source_frame* frame = frames[frames.count-1];
+	if (frame->callstack_base >= 0) callstack.reset(frame->callstack_base);
+	frames.remove(frames.count-1);
+	delete frame;
+}
+
+static void leave_frame(int base)
+{
+	bool failed = false;
+	try
+	{
+		frames[frames.count-1]->leave();
+	}
+	catch (errblock&)
+	{
+		failed = true;
+	}
+	pop_frame();
+	if (!failed) return;
+	// the error belongs to the block that pushed the frame
+	if (frames.count > base) frames[frames.count-1]->line.block_failed = true;
+	else throw errblock{};
+}
+
+void run_frames(int base)
+{
+	// a frame that runs right away still has its caller's entries on the callstack
+	if (frames.count > base) frames[base]->caller_callstack.reset();
+	try
+	{
+		while (frames.count > base)
+		{
+			source_frame* frame = frames[frames.count-1];
+			if (frame->callstack_base < 0)
+			{
+				frame->callstack_base = callstack.count;
+				for (int i = 0; i < frame->caller_callstack.count; i++)
+				{
+					callstack.append(frame->caller_callstack[i]);
+				}
+				frame->enter();
+			}
+			frame->line_callstack_base = callstack.count;
+			bool was_loop_end;
+			if (frame->line.pending)
+			{
+				was_loop_end = resumeline(frame->line);
+			}
+			else
+			{
+				int lineno;
+				const char * text = frame->nextline(lineno);
+				if (!text)
+				{
+					leave_frame(base);
+					continue;
+				}
+				was_loop_end = do_line_logic(frame->line, text, lineno);
+			}
+			if (!frame->line.pending) frame->endline(was_loop_end);
+		}
+	}
+	catch (errfatal&)
+	{
+		while (frames.count > base) pop_frame();
+		throw;
+	}
 }
 
 int incsrcdepth=0;
@@ -793,15 +986,280 @@ bool file_included_once(const char* file)
 	return false;
 }
 
+enum skipblock_kind {
+	skipblock_none,
+	skipblock_if,
+	skipblock_while,
+	skipblock_for,
+	skipblock_elseif,
+	skipblock_else,
+	skipblock_endif,
+	skipblock_endwhile,
+	skipblock_endfor,
+	// does something even in a false branch
+	skipblock_unsafe,
+};
+
+// What a block means to if/while/for nesting when it's in a false branch.
+// Trims the block the same way assembleline() does, and only looks at the
+// first word, like the conditional checks at the top of assembleblock().
+static skipblock_kind classify_skipped_block(char * rawblock, bool lastblock)
+{
+	string block = strip_whitespace(rawblock);
+	int i = 0;
+	if(block[i] == ':' && block[i+1] == ' ') {
+		i++;
+		while(block[i] == ' ') i++;
+	}
+	if(block[i] == ':' && block[i+1] == 0) i++;
+	if(lastblock && block.length() >= 2 && block[block.length()-2] == ' ' && block[block.length()-1] == ':') {
+		block.truncate(block.length()-2);
+	}
+	string splitblock = block.data() + i;
+	int numwords;
+	char ** word = qsplit(splitblock.temp_raw(), ' ', &numwords);
+	if (!word) return skipblock_unsafe;
+	autoptr<char **> scope_word = word;
+	if (!word[0] || !word[0][0]) return skipblock_none;
+	// formats its message even when it's skipped, which can throw
+	if (!stricmpwithlower(word[0], "assert")) return skipblock_unsafe;
+	if (!stricmpwithlower(word[0], "if")) return skipblock_if;
+	if (!stricmpwithlower(word[0], "while")) return skipblock_while;
+	if (!stricmpwithlower(word[0], "for")) return skipblock_for;
+	if (!stricmpwithlower(word[0], "elseif")) return skipblock_elseif;
+	if (numwords != 1) return skipblock_none;
+	if (!stricmpwithlower(word[0], "else")) return skipblock_else;
+	if (!stricmpwithlower(word[0], "endif")) return skipblock_endif;
+	if (!stricmpwithlower(word[0], "endwhile")) return skipblock_endwhile;
+	if (!stricmpwithlower(word[0], "endfor")) return skipblock_endfor;
+	return skipblock_none;
+}
+
+// Pairs every line that opens an if/while/for, or starts an elseif/else
+// branch, with the next elseif/else/end at its own depth. Lines in a false
+// branch aren't resolved or assembled, only counted for nesting, so a
+// file_frame can jump from a line that leaves its branch false straight to
+// that end and get the same result. Only lines that are a single block
+// get an end, and a branch that has anything in it that does something even
+// when false (an assert, an else in a loop, an end that doesn't match) gets
+// none.
+static condskip * build_skip_table(char ** contents, int numlines)
+{
+	struct skipframe {
+		skipblock_kind kind;
+		// line the current branch starts on, -1 if it's not skippable
+		int from;
+		int nested;
+		bool unsafe;
+	};
+	condskip * skip = (condskip*)malloc(sizeof(condskip) * (numlines ? numlines : 1));
+	for (int i = 0; i < numlines; i++)
+	{
+		skip[i].end = -1;
+		skip[i].nested = 0;
+	}
+	autoarray<skipframe> frames;
+	int depth = 0;
+	for (int i = 0; contents[i] && i < numlines; i++)
+	{
+		int start = i;
+		string line;
+		i += getconnectedlines<char**>(contents, i, line);
+		int numblocks;
+		autoptr<char**> blocks = qsplitstr(line.temp_raw(), " : ", &numblocks);
+		int from = numblocks == 1 ? start : -1;
+		for (int block = 0; blocks[block]; block++)
+		{
+			skipblock_kind kind = classify_skipped_block(blocks[block], !blocks[block+1]);
+			if (kind == skipblock_none) continue;
+			if (kind == skipblock_unsafe)
+			{
+				for (int f = 0; f < depth; f++) frames[f].unsafe = true;
+				continue;
+			}
+			if (kind == skipblock_if || kind == skipblock_while || kind == skipblock_for)
+			{
+				for (int f = 0; f < depth; f++)
+				{
+					if (frames[f].nested < depth - f) frames[f].nested = depth - f;
+				}
+				skipframe& frame = frames[depth++];
+				frame.kind = kind;
+				frame.from = from;
+				frame.nested = 0;
+				frame.unsafe = false;
+				continue;
+			}
+			// stray elses and ends are errors either way, and end no branch
+			if (!depth) continue;
+			skipframe& frame = frames[depth - 1];
+			if (frame.from >= 0 && !frame.unsafe)
+			{
+				skip[frame.from].end = start;
+				skip[frame.from].nested = frame.nested;
+			}
+			bool errors;
+			if (kind == skipblock_elseif) errors = false;
+			else if (kind == skipblock_else) errors = frame.kind != skipblock_if;
+			else errors = (kind == skipblock_endif) != (frame.kind == skipblock_if) ||
+					(kind == skipblock_endwhile) != (frame.kind == skipblock_while) ||
+					(kind == skipblock_endfor) != (frame.kind == skipblock_for);
+			// a branch around this one would walk into the error
+			if (errors)
+			{
+				for (int f = 0; f < depth - 1; f++) frames[f].unsafe = true;
+			}
+			if (kind == skipblock_elseif || kind == skipblock_else)
+			{
+				frame.from = frame.kind == skipblock_if ? from : -1;
+				frame.nested = 0;
+				frame.unsafe = false;
+			}
+			else depth--;
+		}
+	}
+	return skip;
+}
+
+// pass 0 needs the packed size of every inclz, since everything after it
+// moves with it. Start compressing each inclz of a plain quoted file name as
+// soon as its source file is read, so independent assets are packed in
+// parallel and are usually done by the time their line is assembled. Ranges,
+// defines and the like are left to the directive itself.
+static void prefetch_inclz(char ** contents, const char * absolutepath)
+{
+	for (int i = 0; contents[i]; i++)
+	{
+		if (!*contents[i]) continue;
+		string line = contents[i];
+		int numblocks;
+		autoptr<char**> blocks = qsplitstr(line.temp_raw(), " : ", &numblocks);
+		for (int block = 0; blocks[block]; block++)
+		{
+			char * text = strip_whitespace(blocks[block]);
+			if (!stribegin(text, "inclz ")) continue;
+			char * name = strip_whitespace(text + strlen("inclz "));
+			size_t namelen = strlen(name);
+			if (namelen < 2 || name[0] != '"' || name[namelen - 1] != '"') continue;
+			name[namelen - 1] = '\0';
+			name++;
+			if (strchr(name, '"') || strchr(name, '!') || strchr(name, '<')) continue;
+
+			string path = filesystem->create_absolute_path(absolutepath, name);
+			char * data = nullptr;
+			int len = 0;
+			if (!readfile(path, "", &data, &len)) continue;
+			autoptr<char*> datacopy = data;
+			lz2_prefetch((const uint8_t*)data, len);
+		}
+	}
+}
+
+// Lines in a false branch still look one level up for a loop to go back to,
+// and a for carries on with a status it finds unfinished. Statuses left
+// behind by a loop that broke off on an error can do either, so a branch
+// with one of those within reach has to be stepped through.
+static bool skip_reaches_stale_loop(const condskip& skip)
+{
+	for (int level = 0; level <= skip.nested && numif + level < whilestatus.count; level++)
+	{
+		const whiletracker& status = whilestatus[numif + level];
+		if ((status.iswhile || status.is_for) && status.cond) return true;
+		if (status.is_for && status.for_cur < status.for_end) return true;
+	}
+	return false;
+}
+
 autoarray<string> macro_defs;
 int in_macro_def=0;
 
 autoarray<string> hook_defs;
 int in_hook_def=0;
 
+class file_frame : public source_frame {
+public:
+	sourcefile file;
+	string absolutepath;
+	int startif;
+	int i;
+	// where the line nextline() returned starts, and how many lines were
+	// connected to it
+	int start;
+	int skiplines;
+	string connectedline;
+
+	void enter() override
+	{
+		callstack.append(callstack_entry(callstack_entry_type::FILE, absolutepath, -1));
+		asarverallowed=true;
+	}
+
+	const char * nextline(int& lineno) override
+	{
+		if (!file.contents[i] || i>=file.numlines) return nullptr;
+		connectedline = "";
+		start = i;
+		skiplines = getconnectedlines<char**>(file.contents, i, connectedline);
+		lineno = i;
+		return connectedline;
+	}
+
+	void endline(bool was_loop_end) override
+	{
+		const condskip& skip = file.skip[start];
+		i = start + skiplines;
+
+		// if a loop ended on this line, should it run again?
+		if (was_loop_end && whilestatus[numif].cond)
+			i = whilestatus[numif].startline - 1;
+		// if this line started a false branch, go straight to its end
+		else if (numif==numtrue+1 && skip.end >= 0 && !in_macro_def && !in_hook_def
+				&& !skip_reaches_stale_loop(skip))
+		{
+			// the ifs in the branch would each have left a (false) status
+			// for their level behind
+			for (int level = 0; level < skip.nested; level++)
+			{
+				whiletracker& skipped = whilestatus[numif + level];
+				skipped.iswhile = false;
+				skipped.is_for = false;
+				skipped.cond = false;
+				skipped.for_start = skipped.for_end = skipped.for_cur = 0;
+				skipped.for_has_var_backup = false;
+			}
+			i = skip.end - 1;
+		}
+		i++;
+	}
+
+	void leave() override
+	{
+		while (in_macro_def > 0)
+		{
+			asar_throw_error(0, error_type_null, error_id_unclosed_macro, macro_defs[in_macro_def-1].data());
+			if (!pass && in_macro_def == 1) endmacro(false);
+			in_macro_def--;
+			macro_defs.remove(in_macro_def);
+		}
+		while (in_hook_def > 0)
+		{
+			asar_throw_error(0, error_type_null, error_id_hook_without_endhook);
+			in_hook_def--;
+			hook_defs.remove(in_hook_def);
+		}
+		if (numif!=startif)
+		{
+			numif=startif;
+			numtrue=startif;
+			asar_throw_error(0, error_type_null, error_id_unclosed_if);
+		}
+		incsrcdepth--;
+	}
+};
+
 void assemblefile(const char * filename)
 {
-	incsrcdepth++;
+	bool toplevel = !frames.count;
 	string absolutepath = filesystem->create_absolute_path(get_current_file_name(), filename);
 
 	if (file_included_once(absolutepath))
@@ -809,14 +1267,15 @@ void assemblefile(const char * filename)
 		return;
 	}
 
-	callstack_push cs_push(callstack_entry_type::FILE, absolutepath);
+	if (incsrcdepth >= max_include_depth) asar_throw_error(pass, error_type_fatal, error_id_recursion_limit);
 
 	sourcefile file;
 	file.contents = nullptr;
 	file.numlines = 0;
-	int startif=numif;
+	file.skip = nullptr;
 	if (!filecontents.exists(absolutepath))
 	{
+		callstack_push cs_push(callstack_entry_type::FILE, absolutepath);
 		char * temp = readfile(absolutepath, "");
 		if (!temp)
 		{
@@ -893,56 +1352,37 @@ void assemblefile(const char * filename)
 				newfile.contents[i+j]=nullstr;
 			}
 		}
+		newfile.skip = build_skip_table(newfile.contents, newfile.numlines);
+		prefetch_inclz(newfile.contents, absolutepath);
 		file = newfile;
 	} else { // filecontents.exists(absolutepath)
 		file = filecontents.find(absolutepath);
 	}
-	asarverallowed=true;
-	for (int i=0;file.contents[i] && i<file.numlines;i++)
-	{
-		string connectedline;
-		int skiplines = getconnectedlines<char**>(file.contents, i, connectedline);
-
-		bool was_loop_end = do_line_logic(connectedline, absolutepath, i);
-		i += skiplines;
 
-		// if a loop ended on this line, should it run again?
-		if (was_loop_end && whilestatus[numif].cond)
-			i = whilestatus[numif].startline - 1;
-	}
-	while (in_macro_def > 0)
-	{
-		asar_throw_error(0, error_type_null, error_id_unclosed_macro, macro_defs[in_macro_def-1].data());
-		if (!pass && in_macro_def == 1) endmacro(false);
-		in_macro_def--;
-		macro_defs.remove(in_macro_def);
-	}
-	while (in_hook_def > 0)
-	{
-		asar_throw_error(0, error_type_null, error_id_hook_without_endhook);
-		in_hook_def--;
-		hook_defs.remove(in_hook_def);
-	}
-	if (numif!=startif)
-	{
-		numif=startif;
-		numtrue=startif;
-		asar_throw_error(0, error_type_null, error_id_unclosed_if);
-	}
-	incsrcdepth--;
+	file_frame* frame = new file_frame;
+	frame->file = file;
+	frame->absolutepath = absolutepath;
+	frame->startif = numif;
+	frame->i = 0;
+	incsrcdepth++;
+	push_frame(frame);
+	if (toplevel) run_frames(0);
 }
 
 // RPG Hacker: At some point, this should probably be merged
 // into assembleline(), since the two names just cause
 // confusion otherwise.
-// return value is "did a loop end on this line"
-bool do_line_logic(const char* line, const char* filename, int lineno)
+// return value is "did a loop end on this line", and false while the line is
+// pending on a macro call or incsrc
+bool do_line_logic(pending_line& state, const char* line, int lineno)
 {
-	int prevnumif = numif;
-	int single_line_for_tracker = 1;
+	state.prevnumif = numif;
+	state.single_line_for_tracker = 1;
+	state.lineno = lineno;
 	try
 	{
-		string current_line;
+		string& current_line = state.current_line;
+		current_line = "";
 		if (numif==numtrue || (numtrue+1==numif && stribegin(line, "elseif ")))
 		{
 			callstack_push cs_push(callstack_entry_type::LINE, line, lineno);
@@ -1041,7 +1481,7 @@ bool do_line_logic(const char* line, const char* filename, int lineno)
 		                        sprintf(macro_name, "___z3dk_hook_at_%06X", addr);
 		                        string stripped_args = string(macro_name) + "|$" + hex(addr, 6).data() + "|" + type_str.data();
 		                        string final_cmd = string("hook_internal ") + stripped_args.data();
-		                        assembleblock(final_cmd.data(), single_line_for_tracker);
+		                        assembleblock(final_cmd.data(), state.single_line_for_tracker);
 		                    }
 		                    else tomacro(current_line);
 		                }
@@ -1063,7 +1503,7 @@ bool do_line_logic(const char* line, const char* filename, int lineno)
 		                        sprintf(macro_name, "___z3dk_hook_at_%06X", addr);
 		                        string stripped_args = string(macro_name) + "|$" + hex(addr, 6).data() + "|" + type_str.data();
 		                        string final_cmd = string("hook_internal ") + stripped_args.data();
-		                        assembleblock(final_cmd.data(), single_line_for_tracker);
+		                        assembleblock(final_cmd.data(), state.single_line_for_tracker);
 		                    }
 		                }
 		            }
@@ -1077,12 +1517,11 @@ bool do_line_logic(const char* line, const char* filename, int lineno)
 		}
 		else
 		{
-			assembleline(filename, lineno, current_line, single_line_for_tracker);
+			assembleline(state);
 		}
 	}
 	catch (errline&) {}
-	return (numif != prevnumif || single_line_for_tracker == 3)
-		&& (whilestatus[numif].iswhile || whilestatus[numif].is_for);
+	return !state.pending && line_ended_loop(state);
 }
 
 
@@ -1236,6 +1675,7 @@ static void clearfile(const string & key, sourcefile& filecontent)
 	(void)key;
 	cfree(filecontent.data);
 	cfree(filecontent.contents);
+	cfree(filecontent.skip);
 }
 #undef cfree
 
@@ -1246,13 +1686,13 @@ static void adddefine(const string & key, string & value)
 
 static string symbolfile;
 
-static void printsymbol_wla(const string& key, snes_label& label)
+static void printsymbol_wla(const char * key, snes_label& label)
 {
 	string line = hex((label.pos & 0xFF0000)>>16, 2)+":"+hex(label.pos & 0xFFFF, 4)+" "+key+"\n";
 	symbolfile += line;
 }
 
-static void printsymbol_nocash(const string& key, snes_label& label)
+static void printsymbol_nocash(const char * key, snes_label& label)
 {
 	string line = hex(label.pos & 0xFFFFFF, 8)+" "+key+"\n";
 	symbolfile += line;
@@ -1267,7 +1707,7 @@ string create_symbols_file(string format, uint32_t romCrc){
 		symbolfile += "; generated by asar\n";
 
 		symbolfile += "\n[labels]\n";
-		labels.each(printsymbol_wla);
+		each_label(printsymbol_wla);
 
 		symbolfile += "\n[source files]\n";
 		const autoarray<AddressToLineMapping::FileInfo>& addrToLineFileList = addressToLineMapping.getFileList();
@@ -1311,7 +1751,7 @@ string create_symbols_file(string format, uint32_t romCrc){
 		symbolfile = ";no$sns symbolic information file\n";
 		symbolfile += ";generated by asar\n";
 		symbolfile += "\n";
-		labels.each(printsymbol_nocash);
+		each_label(printsymbol_nocash);
 	}
 	return symbolfile;
 }
@@ -1364,10 +1804,12 @@ void reseteverything()
 {
 	string str;
 	labels.reset();
+	anonlabels.reset();
+	reset_label_ref_cache();
 	defines.reset();
 	builtindefines.each(adddefine);
 	clidefines.each(adddefine);
-	structs.reset();
+	scopes.reset();
 
 	macros.each(clearmacro);
 	macros.reset();
@@ -1381,12 +1823,14 @@ void reseteverything()
 	optimize_dp = optimize_dp_flag::ALWAYS;
 	dp_base = 0;
 	optimize_address = optimize_address_flag::MIRRORS;
+	optimize_relax = false;
 
 	closecachedfiles();
 
 	incsrcdepth=0;
 	label_counter = 0;
 	errored = false;
+	errored_in_pass = false;
 	checksum_fix_enabled = true;
 	force_checksum_fix = false;
 
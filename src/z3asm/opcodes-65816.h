@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+
+// Compile-time 65816 encoding table, built from opcodes-65816.def (the same
+// list z3dk's decoder uses). arch-65816.cpp classifies the operand and then
+// does a single lookup here, instead of adding per-mnemonic offsets to a
+// base opcode.
+namespace opcodes_65816 {
+
+enum class mode : uint8_t {
+	Implied,
+	Immediate8,
+	Immediate16,
+	ImmediateM,
+	ImmediateX,
+	Relative8,
+	Relative16,
+	DirectPage,
+	DirectPageX,
+	DirectPageY,
+	DirectPageIndirect,
+	DirectPageIndexedIndirect,
+	DirectPageIndirectIndexedY,
+	DirectPageIndirectLong,
+	DirectPageIndirectLongY,
+	StackRelative,
+	StackRelativeIndirectY,
+	Absolute,
+	AbsoluteX,
+	AbsoluteY,
+	AbsoluteLong,
+	AbsoluteLongX,
+	AbsoluteIndirect,
+	AbsoluteIndexedIndirect,
+	AbsoluteIndirectLong,
+	BlockMove,
+	count
+};
+
+constexpr int num_modes = (int)mode::count;
+
+// operand length class of a mode: the smallest and largest operand size in
+// bytes (immediates follow the M/X flags, so they span 1..2)
+constexpr int min_operand_len(mode m)
+{
+	switch(m) {
+		case mode::Implied: return 0;
+		case mode::Immediate16: case mode::Relative16: case mode::BlockMove: return 2;
+		case mode::Absolute: case mode::AbsoluteX: case mode::AbsoluteY:
+		case mode::AbsoluteIndirect: case mode::AbsoluteIndexedIndirect: case mode::AbsoluteIndirectLong: return 2;
+		case mode::AbsoluteLong: case mode::AbsoluteLongX: return 3;
+		default: return 1;
+	}
+}
+
+constexpr int max_operand_len(mode m)
+{
+	if(m == mode::ImmediateM || m == mode::ImmediateX) return 2;
+	return min_operand_len(m);
+}
+
+constexpr bool is_immediate(mode m)
+{
+	return m == mode::Immediate8 || m == mode::Immediate16 || m == mode::ImmediateM || m == mode::ImmediateX;
+}
+
+struct opcode_entry {
+	char mnemonic[4];
+	mode addr_mode;
+};
+
+constexpr opcode_entry decode_table[256] = {
+#define OPCODE_65816(op, mn, md) { #mn, mode::md },
+#include "opcodes-65816.def"
+#undef OPCODE_65816
+};
+
+constexpr char upper(char c)
+{
+	return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+// case-insensitive, mnemonics are always three letters
+constexpr bool same_mnemonic(const char* a, const char* b)
+{
+	for(int i = 0; i < 3; i++) {
+		if(upper(a[i]) != upper(b[i])) return false;
+	}
+	return b[3] == '\0';
+}
+
+constexpr int max_mnemonics = 128;
+
+struct mnemonic_list {
+	const char* names[max_mnemonics] = {};
+	int count = 0;
+};
+
+constexpr mnemonic_list build_mnemonic_list()
+{
+	mnemonic_list list;
+	for(int op = 0; op < 256; op++) {
+		bool seen = false;
+		for(int i = 0; i < list.count; i++) {
+			if(same_mnemonic(list.names[i], decode_table[op].mnemonic)) seen = true;
+		}
+		if(!seen) list.names[list.count++] = decode_table[op].mnemonic;
+	}
+	return list;
+}
+
+constexpr mnemonic_list mnemonics = build_mnemonic_list();
+
+// index of a mnemonic in the encoding table, or -1
+constexpr int mnemonic_id(const char* name)
+{
+	for(int i = 0; i < mnemonics.count; i++) {
+		if(same_mnemonic(mnemonics.names[i], name)) return i;
+	}
+	return -1;
+}
+
+// Encodings the decoder never produces, because another mnemonic owns the
+// opcode there: Asar accepts JMP [$1234] as a spelling of JML [$1234].
+struct alias_entry {
+	const char* mnemonic;
+	mode addr_mode;
+	uint8_t opcode;
+};
+
+constexpr alias_entry aliases[] = {
+	{ "JMP", mode::AbsoluteIndirectLong, 0xDC },
+};
+
+struct encode_table {
+	int16_t opcodes[max_mnemonics][num_modes] = {};
+
+	constexpr int lookup(int mnemonic, mode m) const
+	{
+		if(mnemonic < 0 || mnemonic >= max_mnemonics) return -1;
+		if((int)m < 0 || (int)m >= num_modes) return -1;
+		return opcodes[mnemonic][(int)m];
+	}
+};
+
+constexpr encode_table build_encode_table()
+{
+	encode_table table;
+	for(int i = 0; i < max_mnemonics; i++) {
+		for(int m = 0; m < num_modes; m++) table.opcodes[i][m] = -1;
+	}
+	for(int op = 0; op < 256; op++) {
+		const opcode_entry& entry = decode_table[op];
+		table.opcodes[mnemonic_id(entry.mnemonic)][(int)entry.addr_mode] = (int16_t)op;
+	}
+	for(const alias_entry& alias : aliases) {
+		table.opcodes[mnemonic_id(alias.mnemonic)][(int)alias.addr_mode] = alias.opcode;
+	}
+	return table;
+}
+
+constexpr encode_table encoder = build_encode_table();
+
+// opcode for a mnemonic in an addressing mode, or -1 if there is none
+constexpr int encode(int mnemonic, mode m)
+{
+	return encoder.lookup(mnemonic, m);
+}
+
+// the mnemonic's immediate mode (it has at most one), or mode::count
+constexpr mode immediate_mode(int mnemonic)
+{
+	for(mode m : { mode::Immediate8, mode::Immediate16, mode::ImmediateM, mode::ImmediateX }) {
+		if(encode(mnemonic, m) >= 0) return m;
+	}
+	return mode::count;
+}
+
+constexpr bool round_trips()
+{
+	for(int op = 0; op < 256; op++) {
+		const opcode_entry& entry = decode_table[op];
+		if(encode(mnemonic_id(entry.mnemonic), entry.addr_mode) != op) return false;
+	}
+	return true;
+}
+
+static_assert(mnemonics.count <= max_mnemonics, "too many mnemonics for the encoding table");
+static_assert(round_trips(), "every opcode must encode back to itself; two opcodes share a mnemonic and mode");
+
+}
@@ -0,0 +1,479 @@
+#include "asar.h"
+#include "assembleblock.h"
+#include "interface-shared.h"
+#include "libsmw.h"
+#include "placement.h"
+
+#include <algorithm>
+#include <map>
+
+// Freespaces normally get placed first-fit in the order they appear, so a
+// routine and the helpers it calls can easily end up in different banks and
+// have to use jsl/rtl. With placement enabled, pass 1 records every call from
+// one freespace to a label in another one. When the freespaces get allocated,
+// blocks are merged into clusters along their heaviest call edges (as long as
+// the cluster still fits a bank), and every cluster is packed into the first
+// bank whose free runs can hold all of it. Blocks without calls, and clusters
+// that fit nowhere, are left to the regular first-fit allocator.
+//
+// Only lorom and hirom are handled, and only the space the rom already has:
+// the model doesn't try to predict where an expanded rom would have room.
+
+bool placement_requested;
+
+namespace {
+
+struct placement_call {
+	int from;
+	int to;
+	bool is_long;
+};
+
+// the part of the rom a bank= freespace for this bank searches
+struct placement_window {
+	int bank;
+	int start;
+	int end;
+	// false for windows that only exist because a freespace asked for that
+	// bank explicitly. other clusters are never moved there.
+	bool movable;
+	// free [start, end) ranges, lowest first
+	std::vector<std::pair<int, int>> runs;
+	int free_bytes;
+};
+
+struct placement_node {
+	int fs_id;
+	// bytes taken in the rom, including the rats tag
+	int need;
+	// window the freespace is fixed to with bank=, or -1
+	int anchor;
+};
+
+}
+
+static bool placement_active;
+static bool placement_ran;
+static std::vector<placement_call> placement_calls;
+// bank (as rom offset / bank size) each freespace would have gotten from the
+// first-fit order, as far as the model can tell. -1 if it wouldn't have fit,
+// -2 for freespaces the optimizer didn't touch.
+static std::vector<int> placement_baseline_bank;
+static int placement_banks;
+static int placement_placed;
+
+void placement_begin_pass()
+{
+	if (pass == 0)
+	{
+		placement_requested = false;
+		placement_active = false;
+		placement_ran = false;
+		placement_calls.clear();
+		placement_baseline_bank.clear();
+	}
+	else if (pass == 1 && !relax_repeating_pass())
+	{
+		placement_active = placement_requested;
+		placement_calls.clear();
+	}
+}
+
+void placement_add_call(int from_id, int to_id, bool is_long)
+{
+	if (!placement_active || pass != 1 || relax_repeating_pass()) return;
+	placement_calls.push_back({ from_id, to_id, is_long });
+}
+
+static int placement_bank_of_pc(int pc)
+{
+	if (pc < 0) return -1;
+	return mapper == hirom ? pc >> 16 : pc >> 15;
+}
+
+static bool placement_window_for_bank(int bank, placement_window& out)
+{
+	int len;
+	if (mapper == lorom && !(bank & 0x40))
+	{
+		out.start = snestopc(bank << 16 | 0x8000);
+		len = 0x8000;
+	}
+	else if (mapper == hirom)
+	{
+		// same ranges as find_for_fixed_bank in getpcfreespace
+		out.start = (bank & 0x40) ? snestopc(bank << 16) : snestopc(bank << 16 | 0x8000);
+		len = (bank & 0x40) ? 0x10000 : 0x8000;
+	}
+	else return false;
+	if (out.start < 0) return false;
+	out.bank = bank;
+	out.end = std::min(romlen, out.start + len);
+	out.movable = false;
+	out.free_bytes = 0;
+	return out.start < out.end;
+}
+
+// the banks the default allocator would search for code
+static void placement_default_windows(std::vector<placement_window>& windows)
+{
+	placement_window win;
+	if (mapper == lorom)
+	{
+		for (int pc = 0x80000; pc < std::min(romlen, 0x200000); pc += 0x8000)
+		{
+			if (!placement_window_for_bank(pctosnes(pc) >> 16, win)) continue;
+			win.movable = true;
+			windows.push_back(win);
+		}
+	}
+	else if (mapper == hirom)
+	{
+		for (int pc = 0x8000; pc < std::min(romlen, 0x400000); pc += 0x10000)
+		{
+			if (!placement_window_for_bank((pctosnes(pc) >> 16) & ~0x40, win)) continue;
+			win.movable = true;
+			windows.push_back(win);
+		}
+	}
+}
+
+static int placement_find_window(std::vector<placement_window>& windows, int bank)
+{
+	placement_window win;
+	if (!placement_window_for_bank(bank, win)) return -1;
+	for (size_t i = 0; i < windows.size(); i++)
+	{
+		if (windows[i].start == win.start && windows[i].end == win.end) return (int)i;
+	}
+	windows.push_back(win);
+	return (int)windows.size() - 1;
+}
+
+// first-fit of every need into runs, lowest address first. this is what
+// trypcfreespace does when it's limited to one bank.
+static bool placement_fit(std::vector<std::pair<int, int>>& runs, const std::vector<int>& needs)
+{
+	for (int need : needs)
+	{
+		bool found = false;
+		for (auto& run : runs)
+		{
+			if (run.second - run.first < need) continue;
+			run.first += need;
+			found = true;
+			break;
+		}
+		if (!found) return false;
+	}
+	return true;
+}
+
+static int placement_find(std::vector<int>& parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+namespace {
+
+// everything the placement strategies work on. window[i] is where node i
+// ends up, -1 if it fits nowhere (those are left to first-fit).
+struct placement_model {
+	std::vector<placement_node> nodes;
+	std::vector<placement_window> windows;
+	// neighbor node and number of call sites, both directions
+	std::vector<std::vector<std::pair<int, int>>> adj;
+	std::vector<std::pair<std::pair<int, int>, int>> edges;
+};
+
+}
+
+static const int placement_max_rounds = 32;
+
+// first-fit of the given nodes in order, into runs (one list per window)
+static void placement_first_fit(const placement_model& model, const std::vector<int>& order,
+	std::vector<std::vector<std::pair<int, int>>>& runs, std::vector<int>& window)
+{
+	for (int n : order)
+	{
+		const placement_node& node = model.nodes[n];
+		for (size_t w = 0; w < model.windows.size(); w++)
+		{
+			if (node.anchor >= 0 ? (int)w != node.anchor : !model.windows[w].movable) continue;
+			if (!placement_fit(runs[w], { node.need })) continue;
+			window[n] = (int)w;
+			break;
+		}
+	}
+}
+
+// merges nodes along the heaviest edges first (ties in source order) as long
+// as the cluster still fits a bank, then packs every cluster into the first
+// bank that can hold all of it, biggest clusters first.
+static void placement_cluster(const placement_model& model, std::vector<int>& window)
+{
+	int count = (int)model.nodes.size();
+	int max_free = 0;
+	for (const placement_window& win : model.windows)
+	{
+		if (win.movable) max_free = std::max(max_free, win.free_bytes);
+	}
+	std::vector<int> parent(count);
+	std::vector<int> cluster_need(count);
+	std::vector<int> cluster_anchor(count);
+	for (int i = 0; i < count; i++)
+	{
+		parent[i] = i;
+		cluster_need[i] = model.nodes[i].need;
+		cluster_anchor[i] = model.nodes[i].anchor;
+	}
+	for (auto& edge : model.edges)
+	{
+		int a = placement_find(parent, edge.first.first);
+		int b = placement_find(parent, edge.first.second);
+		if (a == b) continue;
+		if (cluster_anchor[a] >= 0 && cluster_anchor[b] >= 0 && cluster_anchor[a] != cluster_anchor[b]) continue;
+		int anchor = cluster_anchor[a] >= 0 ? cluster_anchor[a] : cluster_anchor[b];
+		int capacity = anchor >= 0 ? model.windows[anchor].free_bytes : max_free;
+		if (cluster_need[a] + cluster_need[b] > capacity) continue;
+		if (b < a) std::swap(a, b);
+		parent[b] = a;
+		cluster_need[a] += cluster_need[b];
+		cluster_anchor[a] = anchor;
+	}
+
+	std::vector<std::vector<int>> members(count);
+	for (int i = 0; i < count; i++) members[placement_find(parent, i)].push_back(i);
+	std::vector<int> order;
+	for (int i = 0; i < count; i++)
+	{
+		if (members[i].size() > 1) order.push_back(i);
+	}
+	// clusters with a fixed bank go first
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		bool fixed_a = cluster_anchor[a] >= 0;
+		bool fixed_b = cluster_anchor[b] >= 0;
+		if (fixed_a != fixed_b) return fixed_a;
+		return cluster_need[a] > cluster_need[b];
+	});
+
+	std::vector<std::vector<std::pair<int, int>>> runs;
+	for (const placement_window& win : model.windows) runs.push_back(win.runs);
+	for (int root : order)
+	{
+		std::vector<int> needs;
+		for (int m : members[root]) needs.push_back(model.nodes[m].need);
+		for (size_t w = 0; w < model.windows.size(); w++)
+		{
+			if (cluster_anchor[root] >= 0 ? (int)w != cluster_anchor[root] : !model.windows[w].movable) continue;
+			std::vector<std::pair<int, int>> fitted = runs[w];
+			if (!placement_fit(fitted, needs)) continue;
+			runs[w] = std::move(fitted);
+			for (int m : members[root]) window[m] = (int)w;
+			break;
+		}
+	}
+	// everything else goes where first-fit would put it
+	std::vector<int> rest;
+	for (int i = 0; i < count; i++)
+	{
+		if (window[i] < 0) rest.push_back(i);
+	}
+	placement_first_fit(model, rest, runs, window);
+}
+
+// moves single nodes to the bank most of their calls go to, while that bank
+// has room left, until nothing improves anymore
+static void placement_refine(const placement_model& model, std::vector<int>& window)
+{
+	std::vector<int> used(model.windows.size(), 0);
+	for (size_t n = 0; n < model.nodes.size(); n++)
+	{
+		if (window[n] >= 0) used[window[n]] += model.nodes[n].need;
+	}
+	std::map<int, int> pull;
+	for (int round = 0; round < placement_max_rounds; round++)
+	{
+		bool moved = false;
+		for (size_t n = 0; n < model.nodes.size(); n++)
+		{
+			const placement_node& node = model.nodes[n];
+			int from = window[n];
+			if (node.anchor >= 0 || from < 0) continue;
+			pull.clear();
+			for (auto& next : model.adj[n])
+			{
+				if (window[next.first] >= 0) pull[window[next.first]] += next.second;
+			}
+			int best = pull.count(from) ? pull[from] : 0;
+			int target = -1;
+			for (auto& p : pull)
+			{
+				if (p.second <= best || !model.windows[p.first].movable) continue;
+				if (used[p.first] + node.need > model.windows[p.first].free_bytes) continue;
+				best = p.second;
+				target = p.first;
+			}
+			if (target < 0) continue;
+			used[from] -= node.need;
+			used[target] += node.need;
+			window[n] = target;
+			moved = true;
+		}
+		if (!moved) break;
+	}
+}
+
+// number of call sites that stay within one bank
+static int placement_score(const placement_model& model, const std::vector<int>& window)
+{
+	int score = 0;
+	for (auto& edge : model.edges)
+	{
+		int a = window[edge.first.first];
+		int b = window[edge.first.second];
+		if (a < 0 || b < 0) continue;
+		if (placement_bank_of_pc(model.windows[a].start) == placement_bank_of_pc(model.windows[b].start)) score += edge.second;
+	}
+	return score;
+}
+
+void placement_allocate(std::vector<bool>& placed)
+{
+	placed.assign(freespaces.count, false);
+	placement_baseline_bank.assign(freespaces.count, -2);
+	placement_banks = 0;
+	placement_placed = 0;
+	if (!placement_active || (mapper != lorom && mapper != hirom)) return;
+	placement_ran = true;
+
+	placement_model model;
+	placement_default_windows(model.windows);
+
+	std::vector<int> node_of(freespaces.count, -1);
+	for (int i = 1; i < freespaces.count; i++)
+	{
+		freespace_data& fs = freespaces[i];
+		if (fs.pin_target_id != i) continue;
+		// things the first-fit allocator has to handle itself
+		if ((fs.is_static && fs.orgpos > 0) || fs.flag_align || fs.allow_bankcross || fs.search_start >= 0 || !fs.total_len) continue;
+		int anchor = -1;
+		if (fs.bank >= 0)
+		{
+			anchor = placement_find_window(model.windows, fs.bank);
+			if (anchor < 0) continue;
+		}
+		node_of[i] = (int)model.nodes.size();
+		model.nodes.push_back({ i, fs.total_len + (fs.write_rats ? 8 : 0), anchor });
+	}
+	int count = (int)model.nodes.size();
+
+	// call edges between nodes, weighted by the number of call sites
+	std::map<std::pair<int, int>, int> edge_weight;
+	for (const placement_call& call : placement_calls)
+	{
+		int a = node_of[get_freespace_pin_target(call.from)];
+		int b = node_of[get_freespace_pin_target(call.to)];
+		if (a < 0 || b < 0 || a == b) continue;
+		edge_weight[std::make_pair(std::min(a, b), std::max(a, b))]++;
+	}
+	if (edge_weight.empty()) return;
+	model.edges.assign(edge_weight.begin(), edge_weight.end());
+	std::stable_sort(model.edges.begin(), model.edges.end(), [](const std::pair<std::pair<int, int>, int>& a, const std::pair<std::pair<int, int>, int>& b) {
+		return a.second > b.second;
+	});
+	model.adj.resize(count);
+	for (auto& edge : model.edges)
+	{
+		model.adj[edge.first.first].push_back(std::make_pair(edge.first.second, edge.second));
+		model.adj[edge.first.second].push_back(std::make_pair(edge.first.first, edge.second));
+	}
+
+	for (placement_window& win : model.windows)
+	{
+		getpcfreeruns(win.start, win.end, win.runs);
+		for (auto& run : win.runs) win.free_bytes += run.second - run.first;
+	}
+
+	// what first-fit in source order would do; kept for the report
+	std::vector<int> source_order(count);
+	for (int i = 0; i < count; i++) source_order[i] = i;
+	std::vector<int> first_fit(count, -1);
+	{
+		std::vector<std::vector<std::pair<int, int>>> runs;
+		for (placement_window& win : model.windows) runs.push_back(win.runs);
+		placement_first_fit(model, source_order, runs, first_fit);
+	}
+	for (int i = 0; i < count; i++)
+	{
+		placement_baseline_bank[model.nodes[i].fs_id] = first_fit[i] >= 0 ? placement_bank_of_pc(model.windows[first_fit[i]].start) : -1;
+	}
+
+	// two starting points: clusters built from the call graph, and plain
+	// first-fit (which is hard to beat when calls mostly go to neighbors in
+	// the source). both get refined and the better one wins.
+	std::vector<int> clustered(count, -1);
+	placement_cluster(model, clustered);
+	placement_refine(model, clustered);
+	std::vector<int> refined = first_fit;
+	placement_refine(model, refined);
+	std::vector<int>& window = placement_score(model, clustered) >= placement_score(model, refined) ? clustered : refined;
+
+	// allocate bank by bank, biggest blocks first so the model's first-fit holds
+	std::vector<int> order = source_order;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+		if (window[a] != window[b]) return window[a] < window[b];
+		return model.nodes[a].need > model.nodes[b].need;
+	});
+	int last_window = -1;
+	for (int n : order)
+	{
+		if (window[n] < 0) continue;
+		freespace_data& fs = freespaces[model.nodes[n].fs_id];
+		int pos = getsnesfreespace(fs.total_len, model.windows[window[n]].bank, true, true, false, fs.write_rats, -1);
+		// the model was off; let first-fit have it
+		if (pos < 0) continue;
+		// same address the default allocator hands out for code
+		if (fs.bank == -2 && mapper == hirom) pos &= ~0x400000;
+		fs.pos = pos;
+		fs.used_len = fs.len;
+		placed[model.nodes[n].fs_id] = true;
+		placement_placed++;
+		if (window[n] != last_window) placement_banks++;
+		last_window = window[n];
+	}
+}
+
+void placement_report()
+{
+	if (!placement_ran) return;
+	auto bank_of = [](int id, bool baseline) {
+		id = get_freespace_pin_target(id);
+		if (baseline && placement_baseline_bank[id] != -2) return placement_baseline_bank[id];
+		return placement_bank_of_pc(snestopc(freespaces[id].pos));
+	};
+	int same_bank = 0;
+	int long_cross = 0;
+	int baseline_same_bank = 0;
+	int baseline_long_cross = 0;
+	for (const placement_call& call : placement_calls)
+	{
+		int from = bank_of(call.from, false);
+		bool local = from >= 0 && from == bank_of(call.to, false);
+		int baseline_from = bank_of(call.from, true);
+		bool baseline_local = baseline_from >= 0 && baseline_from == bank_of(call.to, true);
+		if (local) same_bank++;
+		else if (call.is_long) long_cross++;
+		if (baseline_local) baseline_same_bank++;
+		else if (call.is_long) baseline_long_cross++;
+	}
+	print(STR "Freespace placement: " + dec(same_bank) + " of " + dec((int)placement_calls.size()) +
+		" calls between freespaces stay in one bank (first-fit: about " + dec(baseline_same_bank) + "), " +
+		dec(placement_placed) + " freespaces placed in " + dec(placement_banks) + " banks.");
+	print(STR "Freespace placement: cross-bank long calls down from about " + dec(baseline_long_cross) + " to " + dec(long_cross) + ".");
+}
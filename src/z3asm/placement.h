@@ -0,0 +1,18 @@
+// call-locality aware freespace placement (optimize placement on)
+
+#pragma once
+
+#include <vector>
+
+// set by the optimize placement command. the value at the end of pass 0 is
+// the one that counts, since placement is a decision for the whole patch.
+extern bool placement_requested;
+
+void placement_begin_pass();
+// records a jsl/jsr/jml/jmp from freespace from_id to a label in freespace
+// to_id. only does something in the first pass 1 with placement enabled.
+void placement_add_call(int from_id, int to_id, bool is_long);
+// places the freespaces that call each other, before the regular first-fit
+// allocator runs. placed[i] is set for every freespace id that got a spot.
+void placement_allocate(std::vector<bool>& placed);
+void placement_report();
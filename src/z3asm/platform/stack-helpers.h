@@ -0,0 +1,5 @@
+#pragma once
+
+#if defined(windows)
+#	include "windows/stack-helpers-win32.h"
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+char* stack_bottom = nullptr;
+void init_stack_use_check() {
+	MEMORY_BASIC_INFORMATION mbi;
+	char stackvar = 0;
+	VirtualQuery(&stackvar, &mbi, sizeof(mbi));
+	stack_bottom = (char*)mbi.AllocationBase;
+}
+void deinit_stack_use_check() {
+	stack_bottom = nullptr;
+}
+bool have_enough_stack_left() {
+	char stackvar;
+	return stack_bottom == nullptr || (&stackvar - stack_bottom) >= 32768;
+}
+#endif
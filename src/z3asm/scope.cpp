@@ -0,0 +1,129 @@
+#include "asar.h"
+#include "assembleblock.h"
+#include "scope.h"
+
+#include <cstring>
+
+scope_tree scopes;
+
+void scope_tree::reset()
+{
+	nodes.clear();
+	prefixes.clear();
+	names.clear();
+	new_node(store(""));
+	prefixes[nodes[root].prefix] = root;
+	last_prefix.clear();
+	last_scope = root;
+}
+
+std::string_view scope_tree::store(std::string_view name)
+{
+	// deque elements don't move, so views into them stay valid until reset
+	return names.emplace_back(name);
+}
+
+int scope_tree::new_node(std::string_view prefix)
+{
+	nodes.emplace_back();
+	nodes.back().prefix = prefix;
+	return (int)nodes.size() - 1;
+}
+
+int scope_tree::namespace_scope(const char * prefix)
+{
+	if (last_prefix == prefix) return last_scope;
+	int scope;
+	auto found = prefixes.find(prefix);
+	if (found != prefixes.end()) scope = found->second;
+	else
+	{
+		scope = new_node(store(prefix));
+		prefixes[nodes[scope].prefix] = scope;
+		// labels can be defined before the namespace they'd be found from,
+		// e.g. A_Foo outside of any namespace and then used in namespace A
+		size_t len = strlen(prefix);
+		labels.each_prefixed(prefix, [this, scope, len](const char * name, snes_label & label) {
+			if (!name[len]) return;
+			auto known = nodes[root].labels.find(name);
+			if (known != nodes[root].labels.end()) nodes[scope].labels[known->first.substr(len)] = &label;
+		});
+	}
+	last_prefix = prefix;
+	last_scope = scope;
+	return scope;
+}
+
+int scope_tree::child_namespace(int parent, const char * name)
+{
+	auto found = nodes[parent].namespaces.find(name);
+	if (found != nodes[parent].namespaces.end()) return found->second;
+	std::string prefix(nodes[parent].prefix);
+	prefix += name;
+	prefix += '_';
+	// namespace B in A and a namespace called A_B share their labels, so
+	// they share the node too
+	int scope = namespace_scope(prefix.c_str());
+	nodes[parent].namespaces[nodes[scope].prefix.substr(nodes[parent].prefix.size(), strlen(name))] = scope;
+	return scope;
+}
+
+void scope_tree::add_label(const char * name, snes_label * label)
+{
+	std::string_view stored = store(name);
+	nodes[root].labels[stored] = label;
+	for (size_t i = 0; i + 1 < stored.size(); i++)
+	{
+		if (stored[i] != '_') continue;
+		auto found = prefixes.find(stored.substr(0, i + 1));
+		if (found == prefixes.end()) continue;
+		nodes[found->second].labels[stored.substr(i + 1)] = label;
+	}
+}
+
+snes_label * scope_tree::find_label(int scope, const char * name) const
+{
+	std::string_view key(name);
+	if (scope != root)
+	{
+		auto found = nodes[scope].labels.find(key);
+		if (found != nodes[scope].labels.end()) return found->second;
+	}
+	auto found = nodes[root].labels.find(key);
+	return found != nodes[root].labels.end() ? found->second : nullptr;
+}
+
+int scope_tree::struct_node(const char * name, bool create)
+{
+	int current = root;
+	while (true)
+	{
+		const char * dot = strchr(name, '.');
+		std::string_view part = dot ? std::string_view(name, (size_t)(dot - name)) : std::string_view(name);
+		auto found = nodes[current].structs.find(part);
+		if (found != nodes[current].structs.end()) current = found->second;
+		else if (!create) return -1;
+		else
+		{
+			int child = new_node(std::string_view());
+			nodes[current].structs[store(part)] = child;
+			current = child;
+		}
+		if (!dot) return current;
+		name = dot + 1;
+	}
+}
+
+snes_struct * scope_tree::find_struct(const char * name)
+{
+	int found = struct_node(name, false);
+	if (found < 0 || !nodes[found].defined) return nullptr;
+	return &nodes[found].data;
+}
+
+snes_struct & scope_tree::create_struct(const char * name)
+{
+	node & created = nodes[struct_node(name, true)];
+	created.defined = true;
+	return created.data;
+}
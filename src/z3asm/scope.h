@@ -0,0 +1,77 @@
+// namespaces and structs as a tree of symbol tables
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct snes_label;
+
+struct snes_struct {
+	int base_end;
+	int struct_size;
+	int object_size;
+	bool is_static;
+};
+
+// Labels keep their flat names (`A_B_Foo`, `Obj.x`) in `labels`, since that's
+// what symbol files, the dll interface and error messages use. The scope tree
+// indexes the same labels by scope: every namespace prefix gets a node whose
+// table maps the rest of the name to the label, so a lookup is one hash of the
+// name per scope on the chain instead of building `ns+name` and binary
+// searching the sorted label list for it.
+//
+// Lookups only try the current namespace and then the root. asar never looked
+// in the namespaces in between, and `A_Foo` defined outside of any namespace
+// is still `Foo` inside namespace A, because both are the same flat name.
+class scope_tree {
+public:
+	static const int root = 0;
+
+	scope_tree() { reset(); }
+	void reset();
+
+	// the node for the namespace whose labels start with `prefix`, which is
+	// either empty (the root) or ends with _ like ns does
+	int namespace_scope(const char * prefix);
+	// namespace `name` inside scope `parent`
+	int child_namespace(int parent, const char * name);
+
+	// indexes a newly created label in every namespace its name starts with
+	void add_label(const char * name, snes_label * label);
+	// `name` in `scope`, then in the root, or null
+	snes_label * find_label(int scope, const char * name) const;
+
+	// "Obj" or "Obj.Sub", null unless endstruct got to it. The pointer is
+	// only good until the next create_struct.
+	snes_struct * find_struct(const char * name);
+	snes_struct & create_struct(const char * name);
+
+private:
+	struct node {
+		std::string_view prefix;
+		std::unordered_map<std::string_view, snes_label *> labels;
+		std::unordered_map<std::string_view, int> namespaces;
+		std::unordered_map<std::string_view, int> structs;
+		bool defined = false;
+		snes_struct data;
+	};
+
+	std::string_view store(std::string_view name);
+	int new_node(std::string_view prefix);
+	int struct_node(const char * name, bool create);
+
+	// every label name, namespace prefix and struct name, stored once. The
+	// tables all key on views into these, and a namespace's entry for A_B_Foo
+	// is just the B_Foo or Foo at the end of the root's.
+	std::deque<std::string> names;
+	std::vector<node> nodes;
+	std::unordered_map<std::string_view, int> prefixes;
+	std::string last_prefix;
+	int last_scope;
+};
+
+extern scope_tree scopes;
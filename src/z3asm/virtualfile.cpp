@@ -141,6 +141,7 @@ void virtual_filesystem::initialize(const char** include_paths, size_t num_inclu
 
 	m_last_error = vfe_none;
 	m_memory_files.reset();
+	m_opened_files.reset();
 }
 
 void virtual_filesystem::destroy()
@@ -183,6 +184,7 @@ virtual_file_handle virtual_filesystem::open_file(const char* path, const char*
 				return INVALID_VIRTUAL_FILE_HANDLE;
 			}
 
+			m_opened_files.create(absolutepath) = true;
 			return static_cast<virtual_file_handle>(new_file);
 		}
 
@@ -48,6 +48,13 @@ public:
 
 	void add_memory_file(const char* name, const void* buffer, size_t length);
 
+	// Calls func(const char* path) for every physical file opened since
+	// initialize(), so callers can record build dependencies.
+	template<typename F> void each_opened_file(F func)
+	{
+		m_opened_files.each([&](const char* path, bool&) { func(path); });
+	}
+
 	inline virtual_file_error get_last_error()
 	{
 		return m_last_error;
@@ -63,6 +70,7 @@ private:
 	virtual_file_type get_file_type_from_path(const char* path);
 
 	assocarr<memory_buffer> m_memory_files;
+	assocarr<bool> m_opened_files;
 	autoarray<string> m_include_paths;
 	virtual_file_error m_last_error;
 };
@@ -1,6 +1,7 @@
 #include "warnings.h"
 
 #include "asar.h"
+#include "assembleblock.h"
 #include <cassert>
 #include <cstdarg>
 
@@ -17,7 +18,7 @@ static warnings_state main_warnings_state;
 
 void asar_throw_warning_impl(int whichpass, asar_warning_id warnid, const char* fmt, ...)
 {
-	if (pass == whichpass)
+	if (pass == whichpass && !(whichpass == 1 && relax_repeating_pass()))
 	{
 		assert(warnid >= 0 && warnid < warning_id_end);
 
@@ -1,17 +1,28 @@
+#include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "z3dk_core/artifact_cache.h"
 #include "z3dk_core/assembler.h"
+#include "z3dk_core/clone_detector.h"
 #include "z3dk_core/config.h"
+#include "z3dk_core/cpu65816.h"
 #include "z3dk_core/emit.h"
 #include "z3dk_core/lint.h"
+#include "z3dk_core/rom_validator.h"
+#include "z3dk_core/routine_test.h"
 
 #ifdef _WIN32
 #include <io.h>
@@ -41,6 +52,13 @@ const char* kColorBold = "\033[1m";
       kLint,
       kHooks,
       kAnnotations,
+      kTests,
+      kLabelsCsv,
+      kLabelIndex,
+      kWatchJson,
+      kWatchText,
+      kValidation,
+      kClones,
     } kind;
     std::string path;
   };
@@ -60,6 +78,18 @@ struct CliOptions {
   bool lint_warn_branch_outside_bank = true;
   bool lint_warn_org_collision = true;
   bool inject_snes_registers = false;
+  bool run_tests = false;
+  z3dk::RoutineTestOptions test_options;
+  // Artifact cache location (directory or http:// URL); empty = off.
+  std::string cache_location;
+  bool no_cache = false;
+  std::string cache_stats_path;
+  std::string rom_schema_path;
+  // check this ROM against the schema instead of assembling
+  std::string validate_rom_path;
+  // 0 = from the config, or asar's default
+  int max_include_depth = 0;
+  int max_macro_depth = 0;
   bool show_summary = false;
   bool show_help = false;
   bool show_version = false;
@@ -70,7 +100,8 @@ struct CliOptions {
 void PrintUsage(const char* name) {
   std::cout
       << "Usage: " << name << " [options] <asm_file> [rom_file]\n"
-      << "       " << name << " init [project_name]\n\n"
+      << "       " << name << " init [project_name]\n"
+      << "       " << name << " --validate-rom=<rom_file> --rom-schema=<file>\n\n"
       << "Options:\n"
       << "  --config=<path>          Use z3dk.toml config file\n"
       << "  -I<path>, --include <p>  Add include search path\n"
@@ -84,12 +115,30 @@ void PrintUsage(const char* name) {
       << "                                     --emit=lint.json\n"
       << "                                     --emit=hooks.json\n"
       << "                                     --emit=annotations.json\n"
+      << "                                     --emit=tests.json\n"
+      << "                                     --emit=labels.csv\n"
+      << "                                     --emit=label_index.json\n"
+      << "                                     --emit=watch.json\n"
+      << "                                     --emit=validation.json\n"
+      << "                                     --emit=clones.json\n"
       << "  --lint-m-width=<8|16>    Default M width for lint (bytes)\n"
       << "  --lint-x-width=<8|16>    Default X width for lint (bytes)\n"
       << "  --lint-no-unknown-width  Disable M/X unknown width warnings\n"
       << "  --lint-no-branch         Disable branch-outside-bank warnings\n"
       << "  --lint-no-org            Disable ORG collision warnings\n"
       << "  --inject-snes-registers  Pre-define standard SNES hardware registers\n"
+      << "  --run-tests              Run routines with @assert/@test comments\n"
+      << "  --test-jobs=<n>          Worker threads for tests (default: all cores)\n"
+      << "  --test-max-instructions=<n>  Per-test instruction limit\n"
+      << "  --test-max-cycles=<n>    Per-test cycle limit\n"
+      << "  --rom-schema=<file>      Validate the assembled ROM against a JSON schema\n"
+      << "  --validate-rom=<file>    Validate an existing ROM instead of assembling\n"
+      << "  --max-include-depth=<n>  incsrc nesting limit (default: 512)\n"
+      << "  --max-macro-depth=<n>    Macro call nesting limit (default: 512)\n"
+      << "  --cache[=<dir|url>]      Reuse outputs of identical builds (default dir:\n"
+      << "                           .z3dk-cache next to the asm; also Z3DK_CACHE)\n"
+      << "  --no-cache               Ignore the artifact cache\n"
+      << "  --cache-stats=<file>     Accumulate cache hit/miss counts in a JSON file\n"
       << "  --summary                Enable CLI summary output\n"
       << "  --no-summary             Disable CLI summary output\n"
       << "  --version                Show version\n"
@@ -157,6 +206,27 @@ std::optional<EmitTarget::Kind> ParseEmitKind(const std::string& kind,
   if (kind == "annotations") {
     return EmitTarget::Kind::kAnnotations;
   }
+  if (kind == "tests") {
+    return EmitTarget::Kind::kTests;
+  }
+  if (kind == "validation") {
+    return EmitTarget::Kind::kValidation;
+  }
+  if (kind == "clones") {
+    return EmitTarget::Kind::kClones;
+  }
+  if (kind == "watch" || FileExtension(path) == ".watch") {
+    if (FileExtension(path) == ".json") {
+      return EmitTarget::Kind::kWatchJson;
+    }
+    return EmitTarget::Kind::kWatchText;
+  }
+  if (kind == "labels" || kind == "label_index" || kind == "label-index") {
+    if (FileExtension(path) == ".json") {
+      return EmitTarget::Kind::kLabelIndex;
+    }
+    return EmitTarget::Kind::kLabelsCsv;
+  }
   return std::nullopt;
 }
 
@@ -229,6 +299,30 @@ bool ParseArgs(int argc, const char* argv[], CliOptions* options,
       options->symbols_path = arg.substr(std::string("--symbols-path=").size());
       continue;
     }
+    if (arg == "--cache") {
+      options->cache_location = "default";
+      continue;
+    }
+    if (arg.rfind("--cache=", 0) == 0) {
+      options->cache_location = arg.substr(std::string("--cache=").size());
+      continue;
+    }
+    if (arg == "--no-cache") {
+      options->no_cache = true;
+      continue;
+    }
+    if (arg.rfind("--rom-schema=", 0) == 0) {
+      options->rom_schema_path = arg.substr(std::string("--rom-schema=").size());
+      continue;
+    }
+    if (arg.rfind("--validate-rom=", 0) == 0) {
+      options->validate_rom_path = arg.substr(std::string("--validate-rom=").size());
+      continue;
+    }
+    if (arg.rfind("--cache-stats=", 0) == 0) {
+      options->cache_stats_path = arg.substr(std::string("--cache-stats=").size());
+      continue;
+    }
     if (arg.rfind("--emit=", 0) == 0) {
       EmitTarget target;
       std::string emit_error;
@@ -276,6 +370,43 @@ bool ParseArgs(int argc, const char* argv[], CliOptions* options,
       options->inject_snes_registers = true;
       continue;
     }
+    if (arg == "--run-tests") {
+      options->run_tests = true;
+      continue;
+    }
+    if (arg.rfind("--test-jobs=", 0) == 0 ||
+        arg.rfind("--test-max-instructions=", 0) == 0 ||
+        arg.rfind("--test-max-cycles=", 0) == 0 ||
+        arg.rfind("--max-include-depth=", 0) == 0 ||
+        arg.rfind("--max-macro-depth=", 0) == 0) {
+      auto eq = arg.find('=');
+      std::string value = arg.substr(eq + 1);
+      unsigned long long number = 0;
+      try {
+        size_t used = 0;
+        number = std::stoull(value, &used, 0);
+        if (used != value.size()) {
+          throw std::invalid_argument(value);
+        }
+      } catch (...) {
+        if (error) {
+          *error = "Invalid value for " + arg.substr(0, eq) + ": " + value;
+        }
+        return false;
+      }
+      if (arg.rfind("--test-jobs=", 0) == 0) {
+        options->test_options.jobs = static_cast<int>(number);
+      } else if (arg.rfind("--max-include-depth=", 0) == 0) {
+        options->max_include_depth = static_cast<int>(number);
+      } else if (arg.rfind("--max-macro-depth=", 0) == 0) {
+        options->max_macro_depth = static_cast<int>(number);
+      } else if (arg.rfind("--test-max-instructions=", 0) == 0) {
+        options->test_options.max_instructions = number;
+      } else {
+        options->test_options.max_cycles = number;
+      }
+      continue;
+    }
     if (arg == "--summary") {
       options->show_summary = true;
       continue;
@@ -356,22 +487,29 @@ bool ReadFile(const fs::path& path, std::vector<uint8_t>* data,
 
 bool WriteBinaryFile(const fs::path& path, const std::vector<uint8_t>& data,
                      std::string* error) {
-  std::ofstream file(path, std::ios::binary);
-  if (!file.is_open()) {
-    if (error) {
-      *error = "Unable to write file: " + path.string();
-    }
-    return false;
-  }
-  file.write(reinterpret_cast<const char*>(data.data()),
-             static_cast<std::streamsize>(data.size()));
-  if (!file.good()) {
-    if (error) {
-      *error = "Failed to write file: " + path.string();
-    }
-    return false;
+  return z3dk::WriteTextFile(
+      path.string(),
+      std::string_view(reinterpret_cast<const char*>(data.data()), data.size()),
+      error);
+}
+
+// Path of the running z3asm, so the cache key changes with the tool.
+fs::path ExecutablePath(const char* argv0) {
+  std::error_code ec;
+#ifndef _WIN32
+  fs::path self = fs::read_symlink("/proc/self/exe", ec);
+  if (!ec && fs::exists(self, ec)) {
+    return self;
   }
-  return true;
+#endif
+  return fs::absolute(argv0, ec);
+}
+
+bool IsIncrementalEmit(EmitTarget::Kind kind) {
+  return kind == EmitTarget::Kind::kSymbolsWla ||
+         kind == EmitTarget::Kind::kSymbolsMlb ||
+         kind == EmitTarget::Kind::kWatchJson ||
+         kind == EmitTarget::Kind::kWatchText;
 }
 
 std::string DefaultSymbolsPath(const CliOptions& options) {
@@ -426,6 +564,114 @@ std::string ResolveConfigPath(const std::string& path, const fs::path& base_dir)
   return resolved.lexically_normal().string();
 }
 
+// ROM validation diagnostics in compiler error format; *summary gets the
+// totals line.
+std::string FormatValidation(const std::vector<z3dk::Diagnostic>& diagnostics,
+                             std::string* summary, int* errors) {
+  std::ostringstream out;
+  *errors = 0;
+  int warnings = 0;
+  for (const auto& diag : diagnostics) {
+    bool is_error = diag.severity == z3dk::DiagnosticSeverity::kError;
+    (is_error ? *errors : warnings)++;
+    if (!diag.filename.empty()) {
+      out << diag.filename;
+      if (diag.line > 0) {
+        out << ":" << diag.line;
+      }
+      out << ": ";
+    }
+    out << (is_error ? "error" : "warning") << ": " << diag.message << "\n";
+  }
+  *summary = "ROM validation: " + std::to_string(*errors) + " errors, " +
+             std::to_string(warnings) + " warnings\n";
+  return out.str();
+}
+
+// asar's mapper names, as used by `mapper = "..."` in z3dk.toml.
+std::optional<z3dk::RomMapper> ParseMapperName(const std::string& name) {
+  if (name == "lorom") return z3dk::RomMapper::kLoRom;
+  if (name == "hirom") return z3dk::RomMapper::kHiRom;
+  if (name == "sa1rom") return z3dk::RomMapper::kSa1Rom;
+  if (name == "fullsa1rom") return z3dk::RomMapper::kBigSa1Rom;
+  if (name == "sfxrom") return z3dk::RomMapper::kSfxRom;
+  if (name == "exlorom") return z3dk::RomMapper::kExLoRom;
+  if (name == "exhirom") return z3dk::RomMapper::kExHiRom;
+  return std::nullopt;
+}
+
+// --validate-rom: checks a ROM from any tool against the schema without
+// assembling. The schema and mapper come from the command line or
+// z3dk.toml (LoROM by default); diagnostics have no source lines.
+int ValidateRomFile(CliOptions options) {
+  std::string config_path = options.config_path;
+  if (config_path.empty() && fs::exists("z3dk.toml")) {
+    config_path = fs::absolute("z3dk.toml").string();
+  }
+  z3dk::Config config;
+  fs::path config_dir;
+  if (!config_path.empty()) {
+    std::string config_error;
+    config = z3dk::LoadConfigFile(config_path, &config_error);
+    if (!config_error.empty()) {
+      std::cerr << config_error << "\n";
+      return 1;
+    }
+    config_dir = fs::path(config_path).parent_path();
+  }
+  if (options.rom_schema_path.empty() && config.rom_schema.has_value()) {
+    options.rom_schema_path = ResolveConfigPath(*config.rom_schema, config_dir);
+  }
+  if (options.rom_schema_path.empty()) {
+    std::cerr << "--validate-rom needs --rom-schema=<file> or rom_schema in z3dk.toml\n";
+    return 1;
+  }
+  for (const auto& emit : options.emits) {
+    if (emit.kind != EmitTarget::Kind::kValidation) {
+      std::cerr << "--validate-rom can only emit validation.json: " << emit.path << "\n";
+      return 1;
+    }
+  }
+  std::string mapper_name = config.mapper.value_or("lorom");
+  std::optional<z3dk::RomMapper> mapper = ParseMapperName(mapper_name);
+  if (!mapper.has_value()) {
+    std::cerr << "Unsupported mapper: " << mapper_name << "\n";
+    return 1;
+  }
+
+  std::string error;
+  z3dk::RomSchema schema;
+  if (!z3dk::LoadRomSchemaFile(options.rom_schema_path, &schema, &error)) {
+    std::cerr << error << "\n";
+    return 1;
+  }
+  z3dk::AssembleResult rom;
+  if (!ReadFile(options.validate_rom_path, &rom.rom_data, &error)) {
+    std::cerr << error << "\n";
+    return 1;
+  }
+  // drop a copier header, as asar does when patching
+  if (rom.rom_data.size() % 0x8000 == 0x200) {
+    rom.rom_data.erase(rom.rom_data.begin(), rom.rom_data.begin() + 0x200);
+  }
+  rom.mapper = static_cast<int>(*mapper);
+  rom.success = true;
+
+  std::vector<z3dk::Diagnostic> diagnostics = z3dk::ValidateRom(rom, schema);
+  std::string summary;
+  int errors = 0;
+  std::cerr << FormatValidation(diagnostics, &summary, &errors);
+  std::cout << summary;
+  for (const auto& emit : options.emits) {
+    if (!z3dk::WriteTextFile(emit.path, z3dk::DiagnosticsListToJson(diagnostics, errors == 0),
+                             &error)) {
+      std::cerr << error << "\n";
+      return 1;
+    }
+  }
+  return errors == 0 ? 0 : 1;
+}
+
 bool DoInit(const CliOptions& options, std::string* error) {
   fs::path root = fs::current_path();
   if (!options.project_name.empty()) {
@@ -533,6 +779,9 @@ int main(int argc, const char* argv[]) {
     }
   }
 
+  if (!options.validate_rom_path.empty()) {
+    return ValidateRomFile(options);
+  }
   if (options.asm_path.empty()) {
     std::cerr << "Missing asm_file argument\n";
     PrintUsage(argv[0]);
@@ -616,6 +865,19 @@ int main(int argc, const char* argv[]) {
     }
   }
 
+  if (options.rom_schema_path.empty() && config.rom_schema.has_value()) {
+    options.rom_schema_path = ResolveConfigPath(*config.rom_schema, config_dir);
+  }
+  z3dk::RomSchema rom_schema;
+  if (!options.rom_schema_path.empty()) {
+    std::string schema_error;
+    if (!z3dk::LoadRomSchemaFile(options.rom_schema_path, &rom_schema,
+                                 &schema_error)) {
+      std::cerr << schema_error << "\n";
+      return 1;
+    }
+  }
+
   std::vector<std::string> include_paths =
       ResolveIncludePaths(config.include_paths, config_dir);
   include_paths.push_back(asm_dir.string());
@@ -673,6 +935,180 @@ int main(int argc, const char* argv[]) {
   assemble_options.capture_nocash_symbols =
       options.symbols_format == "nocash";
   assemble_options.inject_snes_registers = options.inject_snes_registers;
+  assemble_options.max_include_depth =
+      options.max_include_depth > 0 ? options.max_include_depth
+                                    : config.max_include_depth.value_or(0);
+  assemble_options.max_macro_depth =
+      options.max_macro_depth > 0 ? options.max_macro_depth
+                                  : config.max_macro_depth.value_or(0);
+
+  bool want_tests = options.run_tests;
+  for (const auto& emit : options.emits) {
+    if (emit.kind == EmitTarget::Kind::kTests) {
+      want_tests = true;
+    }
+  }
+
+  // Artifact cache. The primary key covers every input known up front; the
+  // files asar reads (incsrc, incbin, ...) are only known after assembling,
+  // so they're listed in a manifest stored under the primary key and hashed
+  // into the artifact key on lookup. Test runs always assemble.
+  if (options.cache_location.empty()) {
+    if (const char* env = std::getenv("Z3DK_CACHE"); env && *env) {
+      options.cache_location = env;
+    }
+  }
+  if (options.cache_location.empty() && config.cache.has_value()) {
+    options.cache_location = config.cache->rfind("http://", 0) == 0 ||
+                                     config.cache->rfind("https://", 0) == 0
+                                 ? *config.cache
+                                 : ResolveConfigPath(*config.cache, config_dir);
+  }
+  std::unique_ptr<z3dk::CacheBackend> cache;
+  if (!options.no_cache && !options.cache_location.empty() && !want_tests) {
+    std::string location = options.cache_location == "default"
+                               ? (asm_dir / ".z3dk-cache").string()
+                               : options.cache_location;
+    std::string cache_error;
+    cache = z3dk::OpenCacheBackend(location, &cache_error);
+    if (!cache) {
+      std::cerr << "cache: " << cache_error << "\n";
+    }
+  }
+  auto key_path = [&](const std::string& path) {
+    std::string relative = fs::path(path).lexically_relative(asm_dir).generic_string();
+    return relative.empty() ? path : relative;
+  };
+  z3dk::CacheKeyBuilder cache_key;
+  z3dk::CacheStats cache_run;
+  auto report_cache = [&](const std::string& outcome, const std::string& digest) {
+    std::cout << "Cache: " << outcome << " " << digest.substr(0, 12) << " ("
+              << cache->Describe() << ")\n";
+    if (!options.cache_stats_path.empty()) {
+      z3dk::CacheStats totals = z3dk::LoadCacheStats(options.cache_stats_path);
+      totals.hits += cache_run.hits;
+      totals.misses += cache_run.misses;
+      totals.stores += cache_run.stores;
+      totals.errors += cache_run.errors;
+      std::string stats_error;
+      if (!z3dk::SaveCacheStats(options.cache_stats_path, totals, &stats_error)) {
+        std::cerr << stats_error << "\n";
+      }
+      std::cout << "Cache stats: " << totals.hits << " hits, " << totals.misses
+                << " misses\n";
+    }
+  };
+  if (cache) {
+    cache_key.Add("format", "z3asm-cache-1");
+    cache_key.AddFile("tool", ExecutablePath(argv[0]).string());
+    cache_key.Add("patch", key_path(assemble_options.patch_path));
+    cache_key.AddFile("patch", assemble_options.patch_path);
+    if (!config_path.empty()) {
+      cache_key.AddFile("config", config_path);
+    }
+    for (const auto& path : assemble_options.include_paths) {
+      cache_key.Add("include", key_path(path));
+    }
+    for (const auto& [name, value] : assemble_options.defines) {
+      cache_key.Add("define", name + "=" + value);
+    }
+    if (!assemble_options.std_includes_path.empty()) {
+      cache_key.AddFile("std_includes", assemble_options.std_includes_path);
+    }
+    if (!assemble_options.std_defines_path.empty()) {
+      cache_key.AddFile("std_defines", assemble_options.std_defines_path);
+    }
+    if (!options.rom_schema_path.empty()) {
+      cache_key.AddFile("rom_schema", options.rom_schema_path);
+    }
+    cache_key.Add("rom", std::string_view(
+                             reinterpret_cast<const char*>(assemble_options.rom_data.data()),
+                             assemble_options.rom_data.size()));
+    cache_key.Add("rom_path", key_path(options.rom_path));
+    cache_key.Add("symbols", options.symbols_format + "|" +
+                                 key_path(DefaultSymbolsPath(options)));
+    cache_key.Add("inject_snes_registers", options.inject_snes_registers ? "1" : "0");
+    cache_key.Add("nesting", std::to_string(assemble_options.max_include_depth) + "|" +
+                                 std::to_string(assemble_options.max_macro_depth));
+    for (const auto& emit : options.emits) {
+      cache_key.Add("emit", std::to_string(static_cast<int>(emit.kind)) + "|" +
+                                key_path(emit.path));
+    }
+    cache_key.Add("lint", std::to_string(options.lint_m_width_bytes) +
+                              std::to_string(options.lint_x_width_bytes) +
+                              std::to_string(options.lint_warn_unknown_width) +
+                              std::to_string(options.lint_warn_branch_outside_bank) +
+                              std::to_string(options.lint_warn_org_collision));
+
+    z3dk::CacheKeyBuilder manifest_key = cache_key;
+    manifest_key.Add("kind", "manifest");
+    z3dk::CacheKeyBuilder artifact_key = cache_key;
+    artifact_key.Add("kind", "artifacts");
+    std::string manifest;
+    std::string cache_error;
+    std::vector<z3dk::CacheArtifact> artifacts;
+    bool hit = false;
+    if (cache->Get(manifest_key.Digest(), &manifest, &cache_error)) {
+      bool readable = true;
+      std::istringstream inputs(manifest);
+      std::string input;
+      while (readable && std::getline(inputs, input)) {
+        fs::path input_path = fs::path(input).is_absolute() ? fs::path(input)
+                                                            : asm_dir / input;
+        artifact_key.Add("input", input);
+        readable = artifact_key.AddFile("contents", input_path.string());
+      }
+      std::string blob;
+      hit = readable && cache->Get(artifact_key.Digest(), &blob, &cache_error) &&
+            z3dk::UnpackArtifacts(blob, &artifacts);
+    }
+    if (!cache_error.empty()) {
+      std::cerr << "cache: " << cache_error << "\n";
+      ++cache_run.errors;
+    }
+    if (hit) {
+      std::string summary;
+      for (const auto& artifact : artifacts) {
+        bool ok = true;
+        const std::string& data = artifact.data;
+        if (artifact.name == "stdout") {
+          std::cout << data;
+        } else if (artifact.name == "stderr") {
+          std::cerr << data;
+        } else if (artifact.name == "summary") {
+          summary = data;
+        } else if (artifact.name == "rom") {
+          ok = WriteBinaryFile(options.rom_path,
+                               std::vector<uint8_t>(data.begin(), data.end()), &error);
+        } else if (artifact.name == "symbols") {
+          ok = z3dk::WriteTextFileIfChanged(DefaultSymbolsPath(options), data,
+                                            nullptr, &error);
+        } else if (artifact.name.rfind("emit:", 0) == 0) {
+          size_t index = std::stoul(artifact.name.substr(5));
+          if (index < options.emits.size()) {
+            const auto& emit = options.emits[index];
+            ok = IsIncrementalEmit(emit.kind)
+                     ? z3dk::WriteTextFileIfChanged(emit.path, data, nullptr, &error)
+                     : z3dk::WriteTextFile(emit.path, data, &error);
+          }
+        }
+        if (!ok) {
+          std::cerr << error << "\n";
+          return 1;
+        }
+      }
+      ++cache_run.hits;
+      report_cache("hit", artifact_key.Digest());
+      if (options.show_summary) {
+        std::cout << "\nResult: SUCCESS\n" << summary;
+      }
+      return 0;
+    }
+    ++cache_run.misses;
+  }
+  std::vector<z3dk::CacheArtifact> cache_artifacts;
+  std::ostringstream replay_out;
+  std::ostringstream replay_err;
 
   z3dk::Assembler assembler;
   z3dk::AssembleResult result = assembler.Assemble(assemble_options);
@@ -690,6 +1126,7 @@ int main(int argc, const char* argv[]) {
 
     if (!diag.raw.empty()) {
       std::cerr << diag.raw << "\n";
+      replay_err << diag.raw << "\n";
       continue;
     }
 
@@ -715,40 +1152,73 @@ int main(int argc, const char* argv[]) {
       }
       std::cerr << ": " << level << ": " << diag.message << "\n";
     }
+    replay_err << diag.filename;
+    if (diag.line > 0) {
+      replay_err << ":" << diag.line;
+    }
+    replay_err << ": "
+               << (diag.severity == z3dk::DiagnosticSeverity::kError ? "error" : "warning")
+               << ": " << diag.message << "\n";
   }
 
   for (const auto& print : result.prints) {
     std::cout << print << "\n";
+    replay_out << print << "\n";
   }
+  cache_artifacts.push_back({"stdout", replay_out.str()});
+  cache_artifacts.push_back({"stderr", replay_err.str()});
+
+  // Everything from here on only reads `result`, so the ROM, the symbols
+  // and each emit are built and written on their own threads while the
+  // routine tests run. Failures are reported in the usual order once all
+  // of them are done.
+  struct Output {
+    std::string artifact;
+    std::string contents;
+    std::string error;
+  };
+  std::vector<std::future<Output>> outputs;
 
   if (result.success) {
     if (!options.rom_path.empty()) {
-      if (!WriteBinaryFile(options.rom_path, result.rom_data, &error)) {
-        std::cerr << error << "\n";
-        return 1;
-      }
+      outputs.push_back(std::async(std::launch::async, [&] {
+        Output out{"rom", std::string(result.rom_data.begin(), result.rom_data.end()), ""};
+        WriteBinaryFile(options.rom_path, result.rom_data, &out.error);
+        return out;
+      }));
     }
 
     if (!options.symbols_format.empty() && options.symbols_format != "none") {
-      std::string sym_path = DefaultSymbolsPath(options);
-      std::string symbols;
+      const std::string* symbols = nullptr;
       if (options.symbols_format == "wla") {
-        symbols = result.wla_symbols;
+        symbols = &result.wla_symbols;
       } else if (options.symbols_format == "nocash") {
-        symbols = result.nocash_symbols;
+        symbols = &result.nocash_symbols;
       }
-      if (!symbols.empty()) {
-        if (!z3dk::WriteTextFile(sym_path, symbols, &error)) {
-          std::cerr << error << "\n";
-          return 1;
-        }
+      if (symbols && !symbols->empty()) {
+        outputs.push_back(std::async(std::launch::async, [&, symbols] {
+          Output out{"symbols", *symbols, ""};
+          z3dk::WriteTextFileIfChanged(DefaultSymbolsPath(options), *symbols, nullptr,
+                                       &out.error);
+          return out;
+        }));
       } else {
         std::cerr << "No symbols generated.\n";
       }
     }
   }
 
-  std::optional<z3dk::LintResult> lint_result;
+  // The schema checks only read the ROM, so they run alongside everything
+  // else too.
+  std::shared_future<std::vector<z3dk::Diagnostic>> validation;
+  if (result.success && !rom_schema.tables.empty()) {
+    validation = std::async(std::launch::async, [&result, &rom_schema] {
+      return z3dk::ValidateRom(result, rom_schema);
+    }).share();
+  }
+
+  std::vector<z3dk::RoutineTestResult> test_results;
+  std::shared_future<z3dk::LintResult> lint_result;
   auto should_emit = [&](EmitTarget::Kind kind) {
     if (result.success) {
       return true;
@@ -758,57 +1228,206 @@ int main(int argc, const char* argv[]) {
            kind == EmitTarget::Kind::kHooks ||
            kind == EmitTarget::Kind::kAnnotations;
   };
-
-  for (const auto& emit : options.emits) {
-    if (!should_emit(emit.kind)) {
-      continue;
-    }
-    std::string contents;
-    switch (emit.kind) {
+  auto render_emit = [&](EmitTarget::Kind kind) -> std::string {
+    switch (kind) {
       case EmitTarget::Kind::kDiagnostics:
-        contents = z3dk::DiagnosticsToJson(result);
-        break;
+        return z3dk::DiagnosticsToJson(result);
       case EmitTarget::Kind::kSourceMap:
-        contents = z3dk::SourceMapToJson(result.source_map);
-        break;
+        return z3dk::SourceMapToJson(result.source_map);
       case EmitTarget::Kind::kSymbolsWla:
-        contents = result.wla_symbols;
-        break;
+        return result.wla_symbols;
       case EmitTarget::Kind::kSymbolsMlb:
-        contents = z3dk::SymbolsToMlb(result.labels);
-        break;
+        return z3dk::SymbolsToMlb(result.labels);
       case EmitTarget::Kind::kLint: {
-        if (!lint_result.has_value()) {
-          z3dk::LintOptions lint_options;
-          lint_options.default_m_width_bytes = options.lint_m_width_bytes;
-          lint_options.default_x_width_bytes = options.lint_x_width_bytes;
-          lint_options.warn_unknown_width = options.lint_warn_unknown_width;
-          lint_options.warn_branch_outside_bank =
-              options.lint_warn_branch_outside_bank;
-          lint_options.warn_org_collision = options.lint_warn_org_collision;
-          if (config.warn_unused_symbols.has_value()) {
-            lint_options.warn_unused_symbols = *config.warn_unused_symbols;
-          }
-          lint_result = z3dk::RunLint(result, lint_options);
-        }
-        bool lint_success = lint_result->success() && result.success;
-        contents = z3dk::DiagnosticsListToJson(lint_result->diagnostics,
-                                               lint_success);
-        break;
+        const z3dk::LintResult& lint = lint_result.get();
+        return z3dk::DiagnosticsListToJson(lint.diagnostics,
+                                           lint.success() && result.success);
       }
       case EmitTarget::Kind::kHooks:
-        contents = z3dk::HooksToJson(result, options.rom_path);
-        break;
+        return z3dk::HooksToJson(result, options.rom_path);
       case EmitTarget::Kind::kAnnotations:
-        contents = z3dk::AnnotationsToJson(result);
-        break;
+        return z3dk::AnnotationsToJson(result);
+      case EmitTarget::Kind::kTests:
+        return z3dk::RoutineTestsToJson(test_results);
+      case EmitTarget::Kind::kLabelsCsv:
+        return z3dk::LabelIndexToCsv(result);
+      case EmitTarget::Kind::kLabelIndex:
+        return z3dk::LabelIndexToJson(result);
+      case EmitTarget::Kind::kWatchJson:
+        return z3dk::WatchesToJson(result);
+      case EmitTarget::Kind::kWatchText:
+        return z3dk::WatchesToText(result);
+      case EmitTarget::Kind::kValidation: {
+        if (!validation.valid()) {
+          return z3dk::DiagnosticsListToJson({}, true);
+        }
+        const auto& diagnostics = validation.get();
+        bool clean = std::none_of(
+            diagnostics.begin(), diagnostics.end(), [](const z3dk::Diagnostic& diag) {
+              return diag.severity == z3dk::DiagnosticSeverity::kError;
+            });
+        return z3dk::DiagnosticsListToJson(diagnostics, clean);
+      }
+      case EmitTarget::Kind::kClones: {
+        z3dk::CloneOptions clone_options;
+        clone_options.default_m_width_bytes = options.lint_m_width_bytes;
+        clone_options.default_x_width_bytes = options.lint_x_width_bytes;
+        return z3dk::ClonesToJson(z3dk::FindClones(result, clone_options));
+      }
     }
-    if (!z3dk::WriteTextFile(emit.path, contents, &error)) {
-      std::cerr << error << "\n";
-      return 1;
+    return {};
+  };
+  auto launch_emit = [&](size_t emit_index) {
+    const EmitTarget& emit = options.emits[emit_index];
+    return std::async(std::launch::async, [&, emit_index] {
+      Output out{"emit:" + std::to_string(emit_index), render_emit(emit.kind), ""};
+      // Emulators watch these files for changes, so leave them untouched
+      // when the label set (and with it the contents) is the same.
+      if (IsIncrementalEmit(emit.kind)) {
+        z3dk::WriteTextFileIfChanged(emit.path, out.contents, nullptr, &out.error);
+      } else {
+        z3dk::WriteTextFile(emit.path, out.contents, &out.error);
+      }
+      return out;
+    });
+  };
+
+  // tests.json waits for the routine tests, every other emit starts now
+  std::vector<std::future<Output>> emit_outputs(options.emits.size());
+  for (size_t emit_index = 0; emit_index < options.emits.size(); ++emit_index) {
+    EmitTarget::Kind kind = options.emits[emit_index].kind;
+    if (!should_emit(kind) || kind == EmitTarget::Kind::kTests) {
+      continue;
+    }
+    if (kind == EmitTarget::Kind::kLint && !lint_result.valid()) {
+      z3dk::LintOptions lint_options;
+      lint_options.default_m_width_bytes = options.lint_m_width_bytes;
+      lint_options.default_x_width_bytes = options.lint_x_width_bytes;
+      lint_options.warn_unknown_width = options.lint_warn_unknown_width;
+      lint_options.warn_branch_outside_bank =
+          options.lint_warn_branch_outside_bank;
+      lint_options.warn_org_collision = options.lint_warn_org_collision;
+      if (config.warn_unused_symbols.has_value()) {
+        lint_options.warn_unused_symbols = *config.warn_unused_symbols;
+      }
+      lint_result = std::async(std::launch::async, [&result, lint_options] {
+        return z3dk::RunLint(result, lint_options);
+      }).share();
+    }
+    emit_outputs[emit_index] = launch_emit(emit_index);
+  }
+
+  bool tests_failed = false;
+  if (want_tests && result.success) {
+    test_results = z3dk::RunRoutineTests(
+        result, z3dk::CollectRoutineTests(result), options.test_options);
+    int passed = 0;
+    for (const auto& test : test_results) {
+      if (test.passed) {
+        ++passed;
+        continue;
+      }
+      tests_failed = true;
+      for (const auto& failure : test.failures) {
+        std::cerr << failure.filename;
+        if (failure.line > 0) {
+          std::cerr << ":" << failure.line;
+        }
+        std::cerr << ": error: " << test.name << ": " << failure.message << "\n";
+      }
+    }
+    std::cout << "Routine tests: " << passed << " passed, "
+              << (test_results.size() - static_cast<size_t>(passed))
+              << " failed\n";
+  }
+  bool validation_failed = false;
+  if (validation.valid()) {
+    std::string summary;
+    int errors = 0;
+    std::string validation_err = FormatValidation(validation.get(), &summary, &errors);
+    validation_failed = errors > 0;
+    std::cerr << validation_err;
+    std::cout << summary;
+    cache_artifacts.push_back({"stderr", validation_err});
+    cache_artifacts.push_back({"stdout", summary});
+  }
+  for (size_t emit_index = 0; emit_index < options.emits.size(); ++emit_index) {
+    if (options.emits[emit_index].kind == EmitTarget::Kind::kTests &&
+        should_emit(EmitTarget::Kind::kTests)) {
+      emit_outputs[emit_index] = launch_emit(emit_index);
     }
   }
 
+  for (auto& emit_output : emit_outputs) {
+    if (emit_output.valid()) {
+      outputs.push_back(std::move(emit_output));
+    }
+  }
+  bool write_failed = false;
+  for (auto& output : outputs) {
+    Output out = output.get();
+    if (!out.error.empty()) {
+      if (!write_failed) {
+        std::cerr << out.error << "\n";
+      }
+      write_failed = true;
+      continue;
+    }
+    cache_artifacts.push_back({std::move(out.artifact), std::move(out.contents)});
+  }
+  if (write_failed) {
+    return 1;
+  }
+
+  int total_bytes = 0;
+  for (const auto& block : result.written_blocks) {
+    total_bytes += block.num_bytes;
+  }
+
+  if (cache) {
+    std::string outcome = "miss";
+    z3dk::CacheKeyBuilder artifact_key = cache_key;
+    artifact_key.Add("kind", "artifacts");
+    // a build that failed validation has to fail again next time
+    if (result.success && !validation_failed) {
+      std::vector<std::string> inputs;
+      for (const auto& input : result.input_files) {
+        inputs.push_back(key_path(input));
+      }
+      std::sort(inputs.begin(), inputs.end());
+      inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+      bool readable = true;
+      std::string manifest;
+      for (const auto& input : inputs) {
+        fs::path input_path = fs::path(input).is_absolute() ? fs::path(input)
+                                                            : asm_dir / input;
+        artifact_key.Add("input", input);
+        readable = readable && artifact_key.AddFile("contents", input_path.string());
+        manifest += input + "\n";
+      }
+      std::ostringstream summary;
+      summary << "Summary: " << total_errors << " errors, " << total_warnings
+              << " warnings, " << total_bytes << " bytes written.\n";
+      cache_artifacts.push_back({"summary", summary.str()});
+
+      z3dk::CacheKeyBuilder manifest_key = cache_key;
+      manifest_key.Add("kind", "manifest");
+      std::string cache_error;
+      // artifacts first, so a manifest never points at a missing entry
+      if (readable &&
+          cache->Put(artifact_key.Digest(), z3dk::PackArtifacts(cache_artifacts),
+                     &cache_error) &&
+          cache->Put(manifest_key.Digest(), manifest, &cache_error)) {
+        ++cache_run.stores;
+        outcome = "miss, stored";
+      } else if (!cache_error.empty()) {
+        std::cerr << "cache: " << cache_error << "\n";
+        ++cache_run.errors;
+      }
+    }
+    report_cache(outcome, artifact_key.Digest());
+  }
+
   if (interactive_mode) {
     std::cout << "Assembling completed without problems.\n";
   }
@@ -823,15 +1442,10 @@ int main(int argc, const char* argv[]) {
       std::cout << "\nResult: " << (result.success ? "SUCCESS" : "FAILURE") << "\n";
     }
 
-    int total_bytes = 0;
-    for (const auto& block : result.written_blocks) {
-      total_bytes += block.num_bytes;
-    }
-
     std::cout << "Summary: " << total_errors << " errors, " << total_warnings << " warnings, "
               << (out_tty ? kColorCyan : "") << total_bytes << (out_tty ? kColorReset : "")
               << " bytes written.\n";
   }
 
-  return result.success ? 0 : 1;
+  return result.success && !tests_failed && !validation_failed ? 0 : 1;
 }
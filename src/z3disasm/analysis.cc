@@ -0,0 +1,161 @@
+#include "analysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "utils.h"
+#include "z3dk_core/cpu65816.h"
+#include "z3dk_core/opcode_table.h"
+
+namespace z3disasm {
+
+uint32_t BankAnalysis::NextBoundary(uint32_t snes) const {
+  uint32_t next = 0xFFFFFFFF;
+  auto table_it = tables.upper_bound(snes);
+  if (table_it != tables.end()) {
+    next = table_it->first;
+  }
+  auto entry_it = entries.upper_bound(snes);
+  if (entry_it != entries.end()) {
+    next = std::min(next, entry_it->first);
+  }
+  return next;
+}
+
+BankAnalysis AnalyzeBank(const std::vector<uint8_t>& rom, int bank,
+                         int m_width, int x_width, uint64_t budget) {
+  BankAnalysis analysis;
+  uint32_t bank_pc = static_cast<uint32_t>(bank * 0x8000);
+  uint32_t bank_end_pc = std::min<uint32_t>(bank_pc + 0x8000,
+                                            static_cast<uint32_t>(rom.size()));
+  auto read = [&](uint32_t snes) -> int {
+    int pc = z3dk::SnesToRomOffset(snes, z3dk::RomMapper::kLoRom);
+    if (pc < 0 || static_cast<size_t>(pc) >= rom.size()) {
+      return -1;
+    }
+    return rom[static_cast<size_t>(pc)];
+  };
+
+  bool found = true;
+  while (found) {
+    found = false;
+    z3dk::InstructionHistory history;
+    int m = m_width;
+    int x = x_width;
+    for (uint32_t pc = bank_pc; pc < bank_end_pc;) {
+      uint32_t snes = PcToSnesLoRom(pc);
+
+      auto table_it = analysis.tables.upper_bound(snes);
+      if (table_it != analysis.tables.begin()) {
+        const z3dk::JumpTable& table = std::prev(table_it)->second;
+        if (snes < table.end()) {
+          pc += table.end() - snes;
+          history.Clear();
+          continue;
+        }
+      }
+      auto entry_it = analysis.entries.find(snes);
+      if (entry_it != analysis.entries.end()) {
+        m = entry_it->second.first;
+        x = entry_it->second.second;
+        history.Clear();
+      }
+
+      uint8_t opcode = rom[pc];
+      const auto& info = z3dk::GetOpcodeInfo(opcode);
+      int operand_size = z3dk::OperandSizeBytes(info.mode, m, x);
+      if (pc + 1 + operand_size > bank_end_pc) {
+        break;
+      }
+      // an instruction running over a known entry is misaligned data
+      uint32_t boundary = analysis.NextBoundary(snes);
+      if (boundary < snes + 1 + static_cast<uint32_t>(operand_size)) {
+        pc += boundary - snes;
+        history.Clear();
+        continue;
+      }
+      if (analysis.instructions >= budget) {
+        analysis.budget_exhausted = true;
+        return analysis;
+      }
+      ++analysis.instructions;
+
+      z3dk::InstructionRecord record;
+      record.address = snes;
+      record.opcode = opcode;
+      record.operand_size = operand_size;
+      for (int i = operand_size - 1; i >= 0; --i) {
+        record.operand = record.operand << 8 | rom[pc + 1 + static_cast<uint32_t>(i)];
+      }
+      record.m_width = m;
+      record.x_width = x;
+      history.Push(record);
+
+      if (z3dk::IsJumpTableDispatch(opcode)) {
+        auto table = z3dk::RecoverJumpTable(history.records(), read);
+        bool overlaps_dispatch =
+            table.has_value() && table->table < snes + 3 && snes < table->end();
+        if (table.has_value() && !overlaps_dispatch &&
+            !analysis.tables.count(table->table)) {
+          for (const auto& entry : table->entries) {
+            if (entry.in_rom && entry.target != table->table) {
+              analysis.entries.emplace(entry.target,
+                                       std::make_pair(table->m_width, table->x_width));
+            }
+          }
+          analysis.tables.emplace(table->table, std::move(*table));
+          found = true;
+        }
+      }
+
+      std::string mnemonic = info.mnemonic;
+      if (mnemonic == "REP" && operand_size == 1) {
+        if (rom[pc + 1] & 0x20) m = 2;
+        if (rom[pc + 1] & 0x10) x = 2;
+      } else if (mnemonic == "SEP" && operand_size == 1) {
+        if (rom[pc + 1] & 0x20) m = 1;
+        if (rom[pc + 1] & 0x10) x = 1;
+      } else if (mnemonic == "XCE") {
+        m = 1;
+        x = 1;
+      }
+      pc += 1 + static_cast<uint32_t>(operand_size);
+    }
+  }
+  return analysis;
+}
+
+std::vector<BankAnalysis> AnalyzeBanks(const std::vector<uint8_t>& rom,
+                                       int bank_start, int bank_end,
+                                       int m_width, int x_width,
+                                       uint64_t budget, int jobs) {
+  std::vector<BankAnalysis> results;
+  if (bank_end < bank_start) {
+    return results;
+  }
+  results.resize(static_cast<size_t>(bank_end - bank_start + 1));
+  size_t workers = jobs > 0 ? static_cast<size_t>(jobs)
+                            : std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(workers, results.size());
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < results.size(); i = next++) {
+      results[i] = AnalyzeBank(rom, bank_start + static_cast<int>(i), m_width,
+                               x_width, budget);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return results;
+}
+
+}  // namespace z3disasm
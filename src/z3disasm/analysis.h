@@ -0,0 +1,40 @@
+#ifndef Z3DISASM_ANALYSIS_H_
+#define Z3DISASM_ANALYSIS_H_
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "z3dk_core/jump_table.h"
+
+namespace z3disasm {
+
+struct BankAnalysis {
+  // Recovered JMP/JSR (abs,X) tables, keyed by the table address.
+  std::map<uint32_t, z3dk::JumpTable> tables;
+  // Code entry points fed back from the tables, with the M/X widths (bytes)
+  // in effect at the dispatch.
+  std::map<uint32_t, std::pair<int, int>> entries;
+  uint64_t instructions = 0;
+  bool budget_exhausted = false;
+
+  // First table start or entry point after `snes`, or 0xFFFFFFFF.
+  uint32_t NextBoundary(uint32_t snes) const;
+};
+
+// Sweeps a LoROM bank repeatedly, recovering jump tables and resyncing on
+// their entries, until no new table turns up or `budget` instructions have
+// been decoded.
+BankAnalysis AnalyzeBank(const std::vector<uint8_t>& rom, int bank,
+                         int m_width, int x_width, uint64_t budget);
+
+// Runs AnalyzeBank for banks [bank_start, bank_end] on `jobs` threads.
+std::vector<BankAnalysis> AnalyzeBanks(const std::vector<uint8_t>& rom,
+                                       int bank_start, int bank_end,
+                                       int m_width, int x_width,
+                                       uint64_t budget, int jobs);
+
+}  // namespace z3disasm
+
+#endif  // Z3DISASM_ANALYSIS_H_
@@ -0,0 +1,141 @@
+#include "disassembler.h"
+
+#include <string>
+
+#include "formatter.h"
+#include "utils.h"
+#include "z3dk_core/opcode_table.h"
+#include "z3dk_core/snes_knowledge_base.h"
+
+namespace z3disasm {
+
+void DisassembleBank(std::ostream& out, const std::vector<uint8_t>& rom, int bank,
+                     const LabelIndex& labels, const HookMap& hooks,
+                     const BankAnalysis* analysis, int m_width, int x_width) {
+  uint32_t bank_pc = static_cast<uint32_t>(bank * 0x8000);
+  uint32_t bank_end_pc = bank_pc + 0x8000;
+  if (bank_end_pc > rom.size()) {
+    bank_end_pc = static_cast<uint32_t>(rom.size());
+  }
+
+  uint32_t snes_base = PcToSnesLoRom(bank_pc);
+  out << "; bank " << Hex(bank, 2) << "\n";
+  out << "org " << Hex(snes_base, 6) << "\n\n";
+
+  for (uint32_t pc = bank_pc; pc < bank_end_pc;) {
+    uint32_t snes = PcToSnesLoRom(pc);
+
+    auto label_it = labels.labels.find(snes);
+    if (label_it == labels.labels.end()) {
+      label_it = labels.labels.find(snes ^ 0x800000);
+    }
+    if (label_it != labels.labels.end()) {
+      for (const auto& label : label_it->second) {
+        out << label << ":\n";
+      }
+    }
+
+    auto hook_it = hooks.find(snes);
+    if (hook_it == hooks.end()) {
+      hook_it = hooks.find(snes ^ 0x800000);
+    }
+    if (hook_it != hooks.end()) {
+      for (const auto& hook : hook_it->second) {
+        EmitHookComment(out, hook);
+      }
+    }
+
+    if (analysis) {
+      auto table_it = analysis->tables.find(snes);
+      if (table_it != analysis->tables.end()) {
+        pc += EmitJumpTable(out, table_it->second, labels);
+        continue;
+      }
+      auto entry_it = analysis->entries.find(snes);
+      if (entry_it != analysis->entries.end()) {
+        m_width = entry_it->second.first;
+        x_width = entry_it->second.second;
+      }
+    }
+
+    uint8_t opcode = rom[pc];
+    const auto& info = z3dk::GetOpcodeInfo(opcode);
+    int operand_size = z3dk::OperandSizeBytes(info.mode, m_width, x_width);
+    if (pc + 1 + operand_size > bank_end_pc) {
+      out << "  db " << Hex(opcode, 2) << "\n";
+      ++pc;
+      continue;
+    }
+    // bytes that run into a jump table or one of its targets aren't code
+    if (analysis &&
+        analysis->NextBoundary(snes) < snes + 1 + static_cast<uint32_t>(operand_size)) {
+      out << "  db " << Hex(opcode, 2) << "\n";
+      ++pc;
+      continue;
+    }
+
+    std::string operand;
+    if (operand_size > 0) {
+      operand = FormatOperand(info, &rom[pc + 1], snes, m_width, x_width,
+                              labels);
+    }
+
+    out << "  " << info.mnemonic;
+    if (!operand.empty()) {
+      out << " " << operand;
+    }
+
+    // Hardware Register Annotation
+    uint32_t target_addr = 0;
+    bool has_target = false;
+    if (info.mode == z3dk::AddrMode::kAbsolute || 
+        info.mode == z3dk::AddrMode::kAbsoluteX || 
+        info.mode == z3dk::AddrMode::kAbsoluteY) {
+        target_addr = (snes & 0xFF0000) | (rom[pc+1] | (rom[pc+2] << 8));
+        has_target = true;
+    } else if (info.mode == z3dk::AddrMode::kAbsoluteLong ||
+               info.mode == z3dk::AddrMode::kAbsoluteLongX) {
+        target_addr = rom[pc+1] | (rom[pc+2] << 8) | (rom[pc+3] << 16);
+        has_target = true;
+    } else if (info.mode == z3dk::AddrMode::kDirectPage ||
+               info.mode == z3dk::AddrMode::kDirectPageX ||
+               info.mode == z3dk::AddrMode::kDirectPageY) {
+        target_addr = rom[pc+1]; // Assume DP=0 for simple annotation
+        has_target = true;
+    }
+
+    if (has_target) {
+        std::string hw_note = z3dk::SnesKnowledgeBase::GetHardwareAnnotation(target_addr);
+        if (!hw_note.empty()) {
+            out << " " << hw_note;
+        }
+    }
+
+    out << "\n";
+
+    if (std::string(info.mnemonic) == "REP" && operand_size == 1) {
+      uint8_t mask = rom[pc + 1];
+      if (mask & 0x20) {
+        m_width = 2;
+      }
+      if (mask & 0x10) {
+        x_width = 2;
+      }
+    } else if (std::string(info.mnemonic) == "SEP" && operand_size == 1) {
+      uint8_t mask = rom[pc + 1];
+      if (mask & 0x20) {
+        m_width = 1;
+      }
+      if (mask & 0x10) {
+        x_width = 1;
+      }
+    } else if (std::string(info.mnemonic) == "XCE") {
+      m_width = 1;
+      x_width = 1;
+    }
+
+    pc += 1 + operand_size;
+  }
+}
+
+}  // namespace z3disasm
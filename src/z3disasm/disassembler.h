@@ -0,0 +1,24 @@
+#ifndef Z3DISASM_DISASSEMBLER_H_
+#define Z3DISASM_DISASSEMBLER_H_
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "analysis.h"
+#include "hooks.h"
+#include "symbols.h"
+
+namespace z3disasm {
+
+// Writes the listing of one LoROM bank of `rom`, decoding with the given
+// starting M/X widths (bytes) and following REP/SEP/XCE from there. With an
+// `analysis`, recovered jump tables come out as dw lines and their entries
+// reset the widths.
+void DisassembleBank(std::ostream& out, const std::vector<uint8_t>& rom, int bank,
+                     const LabelIndex& labels, const HookMap& hooks,
+                     const BankAnalysis* analysis, int m_width, int x_width);
+
+}  // namespace z3disasm
+
+#endif  // Z3DISASM_DISASSEMBLER_H_
@@ -141,6 +141,9 @@ std::string FormatOperand(const z3dk::OpcodeInfo& info, const uint8_t* data,
     }
     case z3dk::AddrMode::kAbsoluteIndexedIndirect: {
       uint32_t value = data[0] | (data[1] << 8);
+      if (auto label = label_for((snes & 0xFF0000) | value)) {
+        return "(" + *label + ",X)";
+      }
       return "(" + Hex(value, 4) + ",X)";
     }
     case z3dk::AddrMode::kAbsoluteIndirectLong: {
@@ -196,4 +199,25 @@ void EmitHookComment(std::ostream& out, const HookEntry& hook) {
   out << "\n";
 }
 
+uint32_t EmitJumpTable(std::ostream& out, const z3dk::JumpTable& table,
+                       const LabelIndex& labels) {
+  out << "; jump table for " << Hex(table.dispatch, 6) << " ("
+      << table.entries.size() << " entries"
+      << (table.bounded ? "" : ", unbounded index") << ")\n";
+  for (const auto& entry : table.entries) {
+    out << "  dw ";
+    auto it = labels.labels.find(entry.target);
+    if (it == labels.labels.end() || it->second.empty()) {
+      it = labels.labels.find(entry.target ^ 0x800000);
+    }
+    if (entry.in_rom && it != labels.labels.end() && !it->second.empty()) {
+      out << it->second.front();
+    } else {
+      out << Hex(entry.target & 0xFFFF, 4);
+    }
+    out << "\n";
+  }
+  return static_cast<uint32_t>(table.entries.size() * 2);
+}
+
 }  // namespace z3disasm
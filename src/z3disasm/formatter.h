@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include "z3dk_core/jump_table.h"
 #include "z3dk_core/opcode_table.h"
 #include "symbols.h"
 #include "hooks.h"
@@ -15,6 +16,10 @@ std::string FormatOperand(const z3dk::OpcodeInfo& info, const uint8_t* data,
 
 void EmitHookComment(std::ostream& out, const HookEntry& hook);
 
+// Writes a recovered jump table as dw lines and returns its size in bytes.
+uint32_t EmitJumpTable(std::ostream& out, const z3dk::JumpTable& table,
+                       const LabelIndex& labels);
+
 }  // namespace z3disasm
 
 #endif  // Z3DISASM_FORMATTER_H_
@@ -10,8 +10,8 @@
 #include "symbols.h"
 #include "hooks.h"
 #include "formatter.h"
-#include "z3dk_core/opcode_table.h"
-#include "z3dk_core/snes_knowledge_base.h"
+#include "analysis.h"
+#include "disassembler.h"
 
 namespace fs = std::filesystem;
 using namespace z3disasm;
@@ -77,6 +77,35 @@ int main(int argc, const char* argv[]) {
   int bank_end = options.bank_end >= 0 ? options.bank_end : (total_banks - 1);
   bank_end = std::min(bank_end, total_banks - 1);
 
+  std::vector<BankAnalysis> analyses;
+  if (options.jump_tables) {
+    analyses = AnalyzeBanks(rom, bank_start, bank_end,
+                            std::max(1, options.m_width_bytes),
+                            std::max(1, options.x_width_bytes),
+                            options.trace_budget, options.jobs);
+    auto has_label = [&](uint32_t address) {
+      return labels.labels.count(address) || labels.labels.count(address ^ 0x800000);
+    };
+    for (size_t i = 0; i < analyses.size(); ++i) {
+      const BankAnalysis& analysis = analyses[i];
+      if (analysis.budget_exhausted) {
+        std::cerr << "bank " << Hex(bank_start + static_cast<int>(i), 2)
+                  << ": jump table analysis stopped after "
+                  << analysis.instructions << " instructions (--trace-budget)\n";
+      }
+      for (const auto& [address, table] : analysis.tables) {
+        if (!has_label(address)) {
+          AddLabel(&labels, address, "JumpTable_" + Hex(address, 6).substr(1));
+        }
+        for (const auto& entry : table.entries) {
+          if (entry.in_rom && !has_label(entry.target)) {
+            AddLabel(&labels, entry.target, "Code_" + Hex(entry.target, 6).substr(1));
+          }
+        }
+      }
+    }
+  }
+
   for (int bank = bank_start; bank <= bank_end; ++bank) {
     fs::path out_path = options.out_dir / ("bank_" + Hex(bank, 2).substr(1) + ".asm");
     std::ofstream out(out_path);
@@ -85,113 +114,11 @@ int main(int argc, const char* argv[]) {
       return 1;
     }
 
-    uint32_t bank_pc = static_cast<uint32_t>(bank * 0x8000);
-    uint32_t bank_end_pc = bank_pc + 0x8000;
-    if (bank_end_pc > rom.size()) {
-      bank_end_pc = static_cast<uint32_t>(rom.size());
-    }
-
-    uint32_t snes_base = PcToSnesLoRom(bank_pc);
-    out << "; bank " << Hex(bank, 2) << "\n";
-    out << "org " << Hex(snes_base, 6) << "\n\n";
-
-    int m_width = std::max(1, options.m_width_bytes);
-    int x_width = std::max(1, options.x_width_bytes);
-
-    for (uint32_t pc = bank_pc; pc < bank_end_pc;) {
-      uint32_t snes = PcToSnesLoRom(pc);
-
-      auto label_it = labels.labels.find(snes);
-      if (label_it == labels.labels.end()) {
-        label_it = labels.labels.find(snes ^ 0x800000);
-      }
-      if (label_it != labels.labels.end()) {
-        for (const auto& label : label_it->second) {
-          out << label << ":\n";
-        }
-      }
-
-      auto hook_it = hooks.find(snes);
-      if (hook_it == hooks.end()) {
-        hook_it = hooks.find(snes ^ 0x800000);
-      }
-      if (hook_it != hooks.end()) {
-        for (const auto& hook : hook_it->second) {
-          EmitHookComment(out, hook);
-        }
-      }
-
-      uint8_t opcode = rom[pc];
-      const auto& info = z3dk::GetOpcodeInfo(opcode);
-      int operand_size = z3dk::OperandSizeBytes(info.mode, m_width, x_width);
-      if (pc + 1 + operand_size > bank_end_pc) {
-        out << "  db " << Hex(opcode, 2) << "\n";
-        ++pc;
-        continue;
-      }
-
-      std::string operand;
-      if (operand_size > 0) {
-        operand = FormatOperand(info, &rom[pc + 1], snes, m_width, x_width,
-                                labels);
-      }
-
-      out << "  " << info.mnemonic;
-      if (!operand.empty()) {
-        out << " " << operand;
-      }
-
-      // Hardware Register Annotation
-      uint32_t target_addr = 0;
-      bool has_target = false;
-      if (info.mode == z3dk::AddrMode::kAbsolute || 
-          info.mode == z3dk::AddrMode::kAbsoluteX || 
-          info.mode == z3dk::AddrMode::kAbsoluteY) {
-          target_addr = (snes & 0xFF0000) | (rom[pc+1] | (rom[pc+2] << 8));
-          has_target = true;
-      } else if (info.mode == z3dk::AddrMode::kAbsoluteLong ||
-                 info.mode == z3dk::AddrMode::kAbsoluteLongX) {
-          target_addr = rom[pc+1] | (rom[pc+2] << 8) | (rom[pc+3] << 16);
-          has_target = true;
-      } else if (info.mode == z3dk::AddrMode::kDirectPage ||
-                 info.mode == z3dk::AddrMode::kDirectPageX ||
-                 info.mode == z3dk::AddrMode::kDirectPageY) {
-          target_addr = rom[pc+1]; // Assume DP=0 for simple annotation
-          has_target = true;
-      }
-
-      if (has_target) {
-          std::string hw_note = z3dk::SnesKnowledgeBase::GetHardwareAnnotation(target_addr);
-          if (!hw_note.empty()) {
-              out << " " << hw_note;
-          }
-      }
-
-      out << "\n";
-
-      if (std::string(info.mnemonic) == "REP" && operand_size == 1) {
-        uint8_t mask = rom[pc + 1];
-        if (mask & 0x20) {
-          m_width = 2;
-        }
-        if (mask & 0x10) {
-          x_width = 2;
-        }
-      } else if (std::string(info.mnemonic) == "SEP" && operand_size == 1) {
-        uint8_t mask = rom[pc + 1];
-        if (mask & 0x20) {
-          m_width = 1;
-        }
-        if (mask & 0x10) {
-          x_width = 1;
-        }
-      } else if (std::string(info.mnemonic) == "XCE") {
-        m_width = 1;
-        x_width = 1;
-      }
-
-      pc += 1 + operand_size;
-    }
+    const BankAnalysis* analysis =
+        analyses.empty() ? nullptr : &analyses[static_cast<size_t>(bank - bank_start)];
+    DisassembleBank(out, rom, bank, labels, hooks, analysis,
+                    std::max(1, options.m_width_bytes),
+                    std::max(1, options.x_width_bytes));
   }
 
   return 0;
@@ -18,6 +18,9 @@ void PrintUsage(const char* name) {
             << "  --m-width <8|16>     Default M width (bytes inferred via REP/SEP)\n"
             << "  --x-width <8|16>     Default X width (bytes inferred via REP/SEP)\n"
             << "  --mapper <lorom>     Mapper (lorom only for now)\n"
+            << "  --no-jump-tables     Don't recover JMP/JSR (abs,X) tables\n"
+            << "  --trace-budget <n>   Instructions analyzed per bank (default 1000000)\n"
+            << "  --jobs <n>           Banks analyzed in parallel (default: all cores)\n"
             << "  -h, --help           Show help\n";
 }
 
@@ -87,6 +90,24 @@ bool ParseArgs(int argc, const char* argv[], Options* options) {
       }
       continue;
     }
+    if (arg == "--no-jump-tables") {
+      options->jump_tables = false;
+      continue;
+    }
+    if (arg == "--trace-budget" && i + 1 < argc) {
+      auto value = ParseInt(argv[++i]);
+      if (value.has_value() && *value >= 0) {
+        options->trace_budget = static_cast<uint64_t>(*value);
+      }
+      continue;
+    }
+    if (arg == "--jobs" && i + 1 < argc) {
+      auto value = ParseInt(argv[++i]);
+      if (value.has_value()) {
+        options->jobs = *value;
+      }
+      continue;
+    }
     if (arg == "--mapper" && i + 1 < argc) {
       std::string mapper = argv[++i];
       options->lorom = (mapper == "lorom");
@@ -2,6 +2,7 @@
 #define Z3DISASM_OPTIONS_H_
 
 #include <filesystem>
+#include <cstdint>
 #include <string>
 
 namespace z3disasm {
@@ -18,6 +19,10 @@ struct Options {
   int bank_start = 0;
   int bank_end = -1;
   bool lorom = true;
+  bool jump_tables = true;
+  // Instructions the jump-table analysis may decode per bank.
+  uint64_t trace_budget = 1000000;
+  int jobs = 0;
 };
 
 void PrintUsage(const char* name);
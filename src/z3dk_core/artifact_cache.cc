@@ -0,0 +1,506 @@
+#include "z3dk_core/artifact_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <regex>
+#include <sstream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace z3dk {
+namespace {
+
+constexpr uint32_t kSha256Init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+constexpr uint32_t kSha256Rounds[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t Rotr(uint32_t value, int bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+void Sha256Block(uint32_t state[8], const uint8_t block[64]) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = static_cast<uint32_t>(block[i * 4]) << 24 |
+           static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+           static_cast<uint32_t>(block[i * 4 + 2]) << 8 |
+           static_cast<uint32_t>(block[i * 4 + 3]);
+  }
+  for (int i = 16; i < 64; ++i) {
+    uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; ++i) {
+    uint32_t s1 = Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + ch + kSha256Rounds[i] + w[i];
+    uint32_t s0 = Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+bool IsHexKey(const std::string& key) {
+  if (key.empty()) {
+    return false;
+  }
+  for (char c : key) {
+    if (!std::isxdigit(static_cast<unsigned char>(c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReadWholeFile(const std::string& path, std::string* contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  contents->assign((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+void CloseSocket(SocketHandle fd) { closesocket(fd); }
+#else
+using SocketHandle = int;
+constexpr SocketHandle kInvalidSocket = -1;
+void CloseSocket(SocketHandle fd) { close(fd); }
+#endif
+
+}  // namespace
+
+Sha256::Sha256() { std::memcpy(state_, kSha256Init, sizeof(state_)); }
+
+void Sha256::Update(std::string_view data) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  size_t size = data.size();
+  total_bytes_ += size;
+  while (size > 0) {
+    size_t take = std::min(size, sizeof(block_) - block_size_);
+    std::memcpy(block_ + block_size_, bytes, take);
+    block_size_ += take;
+    bytes += take;
+    size -= take;
+    if (block_size_ == sizeof(block_)) {
+      Sha256Block(state_, block_);
+      block_size_ = 0;
+    }
+  }
+}
+
+std::string Sha256::HexDigest() const {
+  uint32_t state[8];
+  std::memcpy(state, state_, sizeof(state));
+  uint8_t block[128] = {};
+  std::memcpy(block, block_, block_size_);
+  size_t size = block_size_;
+  block[size++] = 0x80;
+  size_t padded = size <= 56 ? 64 : 128;
+  uint64_t bits = total_bytes_ * 8;
+  for (int i = 0; i < 8; ++i) {
+    block[padded - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  Sha256Block(state, block);
+  if (padded == 128) {
+    Sha256Block(state, block + 64);
+  }
+  char hex[65];
+  for (int i = 0; i < 8; ++i) {
+    std::snprintf(hex + i * 8, 9, "%08x", state[i]);
+  }
+  return std::string(hex, 64);
+}
+
+void CacheKeyBuilder::Add(std::string_view tag, std::string_view data) {
+  // length-prefix both parts so concatenations can't collide
+  sha_.Update(std::to_string(tag.size()) + ":");
+  sha_.Update(tag);
+  sha_.Update(std::to_string(data.size()) + ":");
+  sha_.Update(data);
+}
+
+bool CacheKeyBuilder::AddFile(std::string_view tag, const std::string& path) {
+  std::string contents;
+  if (!ReadWholeFile(path, &contents)) {
+    return false;
+  }
+  Add(tag, contents);
+  return true;
+}
+
+LocalCacheBackend::LocalCacheBackend(std::string root) : root_(std::move(root)) {}
+
+bool LocalCacheBackend::Get(const std::string& key, std::string* value,
+                            std::string* error) {
+  if (!IsHexKey(key)) {
+    if (error) *error = "Invalid cache key: " + key;
+    return false;
+  }
+  std::filesystem::path path =
+      std::filesystem::path(root_) / key.substr(0, 2) / key;
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) {
+    return false;
+  }
+  if (!ReadWholeFile(path.string(), value)) {
+    if (error) *error = "Unable to read cache entry: " + path.string();
+    return false;
+  }
+  return true;
+}
+
+bool LocalCacheBackend::Put(const std::string& key, std::string_view value,
+                            std::string* error) {
+  if (!IsHexKey(key)) {
+    if (error) *error = "Invalid cache key: " + key;
+    return false;
+  }
+  std::filesystem::path dir = std::filesystem::path(root_) / key.substr(0, 2);
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    if (error) *error = "Unable to create cache directory: " + dir.string();
+    return false;
+  }
+  // concurrent builds may store the same key; rename keeps entries whole
+  std::filesystem::path temp =
+      dir / (key + ".tmp" + std::to_string(std::random_device{}()));
+  {
+    std::ofstream file(temp, std::ios::binary);
+    if (!file.is_open()) {
+      if (error) *error = "Unable to write cache entry: " + temp.string();
+      return false;
+    }
+    file.write(value.data(), static_cast<std::streamsize>(value.size()));
+    if (!file.good()) {
+      if (error) *error = "Failed to write cache entry: " + temp.string();
+      return false;
+    }
+  }
+  std::filesystem::rename(temp, dir / key, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    if (error) *error = "Unable to store cache entry: " + (dir / key).string();
+    return false;
+  }
+  return true;
+}
+
+std::string LocalCacheBackend::Describe() const { return root_; }
+
+HttpCacheBackend::HttpCacheBackend(std::string host, int port, std::string prefix)
+    : host_(std::move(host)), port_(port), prefix_(std::move(prefix)) {
+  while (!prefix_.empty() && prefix_.back() == '/') {
+    prefix_.pop_back();
+  }
+}
+
+bool HttpCacheBackend::Request(const std::string& method, const std::string& key,
+                               std::string_view body, int* status,
+                               std::string* response, std::string* error) {
+#ifdef _WIN32
+  static const bool wsa_ready = [] {
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  }();
+  if (!wsa_ready) {
+    if (error) *error = "Unable to initialize sockets";
+    return false;
+  }
+#endif
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  std::string port = std::to_string(port_);
+  if (getaddrinfo(host_.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    if (error) *error = "Unable to resolve cache host: " + host_;
+    return false;
+  }
+  SocketHandle fd = kInvalidSocket;
+  for (addrinfo* it = addresses; it; it = it->ai_next) {
+    fd = socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+    if (fd == kInvalidSocket) {
+      continue;
+    }
+    if (connect(fd, it->ai_addr, static_cast<int>(it->ai_addrlen)) == 0) {
+      break;
+    }
+    CloseSocket(fd);
+    fd = kInvalidSocket;
+  }
+  freeaddrinfo(addresses);
+  if (fd == kInvalidSocket) {
+    if (error) *error = "Unable to connect to cache " + Describe();
+    return false;
+  }
+#ifndef _WIN32
+  timeval timeout{};
+  timeout.tv_sec = 10;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#endif
+
+  std::ostringstream request;
+  request << method << ' ' << prefix_ << '/' << key << " HTTP/1.1\r\n"
+          << "Host: " << host_ << ':' << port_ << "\r\n"
+          << "Connection: close\r\n"
+          << "Content-Length: " << body.size() << "\r\n";
+  if (method == "PUT") {
+    request << "Content-Type: application/octet-stream\r\n";
+  }
+  request << "\r\n";
+  std::string payload = request.str();
+  payload.append(body.data(), body.size());
+
+  size_t sent = 0;
+  while (sent < payload.size()) {
+    auto n = send(fd, payload.data() + sent,
+                  static_cast<int>(payload.size() - sent), 0);
+    if (n <= 0) {
+      CloseSocket(fd);
+      if (error) *error = "Failed to send cache request to " + Describe();
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+
+  std::string raw;
+  char buffer[16384];
+  for (;;) {
+    auto n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n < 0) {
+      CloseSocket(fd);
+      if (error) *error = "Failed to read cache response from " + Describe();
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    raw.append(buffer, static_cast<size_t>(n));
+  }
+  CloseSocket(fd);
+
+  size_t header_end = raw.find("\r\n\r\n");
+  if (header_end == std::string::npos || raw.compare(0, 5, "HTTP/") != 0) {
+    if (error) *error = "Malformed cache response from " + Describe();
+    return false;
+  }
+  size_t space = raw.find(' ');
+  *status = std::atoi(raw.c_str() + space + 1);
+
+  std::string headers = raw.substr(0, header_end);
+  std::string content = raw.substr(header_end + 4);
+  static const std::regex length_re(R"(\r\ncontent-length:\s*(\d+))",
+                                    std::regex::icase);
+  std::smatch match;
+  if (std::regex_search(headers, match, length_re)) {
+    size_t length = std::stoull(match[1].str());
+    if (content.size() < length) {
+      if (error) *error = "Truncated cache response from " + Describe();
+      return false;
+    }
+    content.resize(length);
+  }
+  if (response) {
+    *response = std::move(content);
+  }
+  return true;
+}
+
+bool HttpCacheBackend::Get(const std::string& key, std::string* value,
+                           std::string* error) {
+  int status = 0;
+  if (!Request("GET", key, {}, &status, value, error)) {
+    return false;
+  }
+  if (status == 200) {
+    return true;
+  }
+  if (status != 404 && error) {
+    *error = "Cache GET returned HTTP " + std::to_string(status);
+  }
+  return false;
+}
+
+bool HttpCacheBackend::Put(const std::string& key, std::string_view value,
+                           std::string* error) {
+  int status = 0;
+  if (!Request("PUT", key, value, &status, nullptr, error)) {
+    return false;
+  }
+  if (status < 200 || status >= 300) {
+    if (error) *error = "Cache PUT returned HTTP " + std::to_string(status);
+    return false;
+  }
+  return true;
+}
+
+std::string HttpCacheBackend::Describe() const {
+  return "http://" + host_ + ":" + std::to_string(port_) + prefix_;
+}
+
+std::unique_ptr<CacheBackend> OpenCacheBackend(const std::string& location,
+                                               std::string* error) {
+  if (location.rfind("https://", 0) == 0) {
+    if (error) *error = "HTTPS cache servers are not supported: " + location;
+    return nullptr;
+  }
+  if (location.rfind("http://", 0) == 0) {
+    std::string rest = location.substr(7);
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    std::string prefix = slash == std::string::npos ? "" : rest.substr(slash);
+    int port = 80;
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos) {
+      port = std::atoi(authority.c_str() + colon + 1);
+      authority.resize(colon);
+    }
+    if (authority.empty() || port <= 0 || port > 65535) {
+      if (error) *error = "Invalid cache URL: " + location;
+      return nullptr;
+    }
+    return std::make_unique<HttpCacheBackend>(authority, port, prefix);
+  }
+  if (location.empty()) {
+    if (error) *error = "Empty cache location";
+    return nullptr;
+  }
+  return std::make_unique<LocalCacheBackend>(location);
+}
+
+std::string PackArtifacts(const std::vector<CacheArtifact>& artifacts) {
+  std::string blob = "Z3DKCACHE1\n";
+  for (const auto& artifact : artifacts) {
+    blob += artifact.name;
+    blob += '\n';
+    blob += std::to_string(artifact.data.size());
+    blob += '\n';
+    blob += artifact.data;
+  }
+  return blob;
+}
+
+bool UnpackArtifacts(std::string_view blob, std::vector<CacheArtifact>* artifacts) {
+  constexpr std::string_view kMagic = "Z3DKCACHE1\n";
+  if (blob.substr(0, kMagic.size()) != kMagic) {
+    return false;
+  }
+  artifacts->clear();
+  size_t pos = kMagic.size();
+  while (pos < blob.size()) {
+    size_t name_end = blob.find('\n', pos);
+    if (name_end == std::string_view::npos) {
+      return false;
+    }
+    size_t size_end = blob.find('\n', name_end + 1);
+    if (size_end == std::string_view::npos) {
+      return false;
+    }
+    std::string size_text(blob.substr(name_end + 1, size_end - name_end - 1));
+    char* end = nullptr;
+    unsigned long long size = std::strtoull(size_text.c_str(), &end, 10);
+    if (size_text.empty() || *end != '\0' || size > blob.size() - size_end - 1) {
+      return false;
+    }
+    CacheArtifact artifact;
+    artifact.name = std::string(blob.substr(pos, name_end - pos));
+    artifact.data = std::string(blob.substr(size_end + 1, size));
+    artifacts->push_back(std::move(artifact));
+    pos = size_end + 1 + size;
+  }
+  return true;
+}
+
+CacheStats LoadCacheStats(const std::string& path) {
+  CacheStats stats;
+  std::string contents;
+  if (!ReadWholeFile(path, &contents)) {
+    return stats;
+  }
+  auto read = [&](const char* name, uint64_t* value) {
+    std::regex re(std::string("\"") + name + R"(\"\s*:\s*(\d+))");
+    std::smatch match;
+    if (std::regex_search(contents, match, re)) {
+      *value = std::stoull(match[1].str());
+    }
+  };
+  read("hits", &stats.hits);
+  read("misses", &stats.misses);
+  read("stores", &stats.stores);
+  read("errors", &stats.errors);
+  return stats;
+}
+
+std::string CacheStatsToJson(const CacheStats& stats) {
+  std::ostringstream out;
+  out << "{\"hits\":" << stats.hits << ",\"misses\":" << stats.misses
+      << ",\"stores\":" << stats.stores << ",\"errors\":" << stats.errors << "}";
+  return out.str();
+}
+
+bool SaveCacheStats(const std::string& path, const CacheStats& stats,
+                    std::string* error) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    if (error) *error = "Unable to write cache stats: " + path;
+    return false;
+  }
+  file << CacheStatsToJson(stats) << "\n";
+  return file.good();
+}
+
+}  // namespace z3dk
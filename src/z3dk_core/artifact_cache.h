@@ -0,0 +1,120 @@
+#ifndef Z3DK_CORE_ARTIFACT_CACHE_H
+#define Z3DK_CORE_ARTIFACT_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace z3dk {
+
+class Sha256 {
+ public:
+  Sha256();
+
+  void Update(std::string_view data);
+  // Lowercase hex digest of everything so far; Update can continue after.
+  std::string HexDigest() const;
+
+ private:
+  uint32_t state_[8];
+  uint8_t block_[64];
+  size_t block_size_ = 0;
+  uint64_t total_bytes_ = 0;
+};
+
+// SHA-256 over tagged inputs, used to build cache keys.
+class CacheKeyBuilder {
+ public:
+  // Tags keep ("a", "bc") and ("ab", "c") from hashing the same.
+  void Add(std::string_view tag, std::string_view data);
+  // Adds the file contents (not its path, so checkouts in different
+  // directories share keys); returns false if it can't be read.
+  bool AddFile(std::string_view tag, const std::string& path);
+  std::string Digest() const { return sha_.HexDigest(); }
+
+ private:
+  Sha256 sha_;
+};
+
+// Where artifacts are stored. Keys are hex digests, values opaque blobs.
+class CacheBackend {
+ public:
+  virtual ~CacheBackend() = default;
+
+  // Returns false on a miss. *error is only set when the lookup failed
+  // (unreachable server, unreadable file), not on a plain miss.
+  virtual bool Get(const std::string& key, std::string* value,
+                   std::string* error) = 0;
+  virtual bool Put(const std::string& key, std::string_view value,
+                   std::string* error) = 0;
+  virtual std::string Describe() const = 0;
+};
+
+// <root>/<key[0:2]>/<key>, written through a temp file and rename.
+class LocalCacheBackend : public CacheBackend {
+ public:
+  explicit LocalCacheBackend(std::string root);
+
+  bool Get(const std::string& key, std::string* value,
+           std::string* error) override;
+  bool Put(const std::string& key, std::string_view value,
+           std::string* error) override;
+  std::string Describe() const override;
+
+ private:
+  std::string root_;
+};
+
+// GET/PUT <url>/<key> over plain HTTP/1.1 (no TLS); 404 is a miss. Works
+// with nginx WebDAV, bazel-remote's /cas-style stores and similar servers.
+class HttpCacheBackend : public CacheBackend {
+ public:
+  HttpCacheBackend(std::string host, int port, std::string prefix);
+
+  bool Get(const std::string& key, std::string* value,
+           std::string* error) override;
+  bool Put(const std::string& key, std::string_view value,
+           std::string* error) override;
+  std::string Describe() const override;
+
+ private:
+  bool Request(const std::string& method, const std::string& key,
+               std::string_view body, int* status, std::string* response,
+               std::string* error);
+
+  std::string host_;
+  int port_ = 80;
+  std::string prefix_;
+};
+
+// "http://host[:port]/prefix" opens an HttpCacheBackend, anything else is a
+// directory for LocalCacheBackend.
+std::unique_ptr<CacheBackend> OpenCacheBackend(const std::string& location,
+                                               std::string* error);
+
+struct CacheArtifact {
+  std::string name;
+  std::string data;
+};
+
+std::string PackArtifacts(const std::vector<CacheArtifact>& artifacts);
+bool UnpackArtifacts(std::string_view blob, std::vector<CacheArtifact>* artifacts);
+
+struct CacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t stores = 0;
+  uint64_t errors = 0;
+};
+
+// Running totals kept in a small JSON file; a missing file reads as zeros.
+CacheStats LoadCacheStats(const std::string& path);
+bool SaveCacheStats(const std::string& path, const CacheStats& stats,
+                    std::string* error);
+std::string CacheStatsToJson(const CacheStats& stats);
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_ARTIFACT_CACHE_H
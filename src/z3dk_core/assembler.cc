@@ -170,6 +170,7 @@ AssembleResult Assembler::Assemble(const AssembleOptions& options) const {
   params.generate_checksum = options.generate_checksum;
   params.full_call_stack = options.full_call_stack;
 
+  asar_setnestinglimits(options.max_include_depth, options.max_macro_depth);
   bool ok = asar_patch(&params);
 
   int error_count = 0;
@@ -235,6 +236,35 @@ AssembleResult Assembler::Assemble(const AssembleOptions& options) const {
 
   result.mapper = static_cast<int>(asar_getmapper());
 
+  int input_count = 0;
+  const char* const* input_files = asar_getinputfiles(&input_count);
+  for (int i = 0; i < input_count; ++i) {
+    if (input_files[i]) {
+      result.input_files.emplace_back(input_files[i]);
+    }
+  }
+
+  auto copy_signatures = [](const signaturedata* sigs, int count,
+                            std::vector<Signature>* out) {
+    for (int i = 0; i < count; ++i) {
+      Signature sig;
+      sig.name = sigs[i].name ? sigs[i].name : "";
+      for (int j = 0; j < sigs[i].numargs; ++j) {
+        sig.parameters.emplace_back(sigs[i].arguments[j]);
+      }
+      sig.variadic = sigs[i].variadic;
+      sig.filename = sigs[i].filename ? sigs[i].filename : "";
+      sig.line = sigs[i].line;
+      out->push_back(std::move(sig));
+    }
+  };
+  int macro_count = 0;
+  const signaturedata* macros = asar_getmacros(&macro_count);
+  copy_signatures(macros, macro_count, &result.macros);
+  int function_count = 0;
+  const signaturedata* functions = asar_getfunctions(&function_count);
+  copy_signatures(functions, function_count, &result.functions);
+
   result.success = ok && error_count == 0;
   if (result.success) {
     if (rom_length < 0 || rom_length > max_size) {
@@ -33,6 +33,17 @@ struct Define {
   std::string value;
 };
 
+// A macro or a function defined with `function`.
+struct Signature {
+  std::string name;
+  // a variadic macro's last parameter is "..."
+  std::vector<std::string> parameters;
+  bool variadic = false;
+  // where a macro was defined; empty for functions
+  std::string filename;
+  int line = 0;
+};
+
 struct WrittenBlock {
   int pc_offset = 0;
   int snes_offset = 0;
@@ -74,6 +85,9 @@ struct AssembleOptions {
   bool generate_checksum = true;
   bool capture_nocash_symbols = false;
   bool inject_snes_registers = false;
+  // How deeply incsrc and macro calls may nest; 0 = asar's default (512).
+  int max_include_depth = 0;
+  int max_macro_depth = 0;
 };
 
 struct AssembleResult {
@@ -89,6 +103,10 @@ struct AssembleResult {
   SourceMap source_map;
   std::string wla_symbols;
   std::string nocash_symbols;
+  // Every file read from disk while assembling (sources, incbin data, ...).
+  std::vector<std::string> input_files;
+  std::vector<Signature> macros;
+  std::vector<Signature> functions;
 };
 
 class Assembler {
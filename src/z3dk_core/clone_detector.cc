@@ -0,0 +1,467 @@
+#include "z3dk_core/clone_detector.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "z3dk_core/cpu65816.h"
+#include "z3dk_core/opcode_table.h"
+#include "z3dk_core/source_index.h"
+
+namespace z3dk {
+namespace {
+
+struct Instruction {
+  int pc = 0;  // ROM offset
+  uint32_t snes = 0;
+  int size = 0;
+  uint8_t opcode = 0;
+  // opcode and operand with ROM addresses masked, and as written
+  uint64_t token = 0;
+  uint64_t bytes = 0;
+};
+
+// A copy of the `count` instructions at `original`, starting at `copy`.
+struct CloneRun {
+  int original = 0;
+  int copy = 0;
+  int count = 0;
+};
+
+constexpr uint64_t kHashBase = 0x100000001B3ULL;
+
+uint64_t Mix(uint64_t value) {
+  value += 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+// Operands that name a ROM address change when the code or what it points
+// at moves, so copies in different banks differ only there.
+bool PointsIntoRom(AddrMode mode, uint32_t operand, uint32_t snes, RomMapper mapper) {
+  uint32_t address = 0;
+  switch (mode) {
+    case AddrMode::kAbsolute:
+    case AddrMode::kAbsoluteX:
+    case AddrMode::kAbsoluteY:
+    case AddrMode::kAbsoluteIndirect:
+    case AddrMode::kAbsoluteIndexedIndirect:
+      address = (snes & 0xFF0000) | (operand & 0xFFFF);
+      break;
+    case AddrMode::kAbsoluteIndirectLong:
+      address = operand & 0xFFFF;
+      break;
+    case AddrMode::kAbsoluteLong:
+    case AddrMode::kAbsoluteLongX:
+      address = operand & 0xFFFFFF;
+      break;
+    default:
+      return false;
+  }
+  return SnesToRomOffset(address, mapper) >= 0;
+}
+
+// RTS, RTL, RTI, JMP, JML, BRA and BRL: nothing after them runs.
+bool EndsFlow(uint8_t opcode) {
+  switch (opcode) {
+    case 0x40:
+    case 0x4C:
+    case 0x5C:
+    case 0x60:
+    case 0x6B:
+    case 0x6C:
+    case 0x7C:
+    case 0x80:
+    case 0x82:
+    case 0xDC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The written bytes as instructions, one region per run of contiguous
+// blocks. Overlapping blocks are merged first so nothing is decoded twice;
+// addresses come from the block that wrote each byte, so they match the org
+// in the source rather than a mirror.
+void Decode(const AssembleResult& result, const CloneOptions& options,
+            std::vector<Instruction>* instructions, std::vector<std::pair<int, int>>* regions) {
+  struct Range {
+    int start = 0;
+    int end = 0;
+    int snes = 0;
+  };
+  std::vector<Range> ranges;
+  ranges.reserve(result.written_blocks.size());
+  for (const auto& block : result.written_blocks) {
+    int end = block.pc_offset + block.num_bytes;
+    if (block.num_bytes <= 0 || block.pc_offset < 0 ||
+        end > static_cast<int>(result.rom_data.size())) {
+      continue;
+    }
+    ranges.push_back({block.pc_offset, end, block.snes_offset});
+  }
+  std::sort(ranges.begin(), ranges.end(),
+            [](const Range& a, const Range& b) { return a.start < b.start; });
+  std::vector<Range> merged;
+  for (const auto& range : ranges) {
+    if (!merged.empty() && range.start <= merged.back().end) {
+      merged.back().end = std::max(merged.back().end, range.end);
+    } else {
+      merged.push_back(range);
+    }
+  }
+
+  const RomMapper mapper = static_cast<RomMapper>(result.mapper);
+  const int default_m = std::max(1, options.default_m_width_bytes);
+  const int default_x = std::max(1, options.default_x_width_bytes);
+  size_t block = 0;
+  for (const auto& range : merged) {
+    int first = static_cast<int>(instructions->size());
+    int m_width = default_m;
+    int x_width = default_x;
+    for (int pc = range.start; pc < range.end;) {
+      uint8_t opcode = result.rom_data[pc];
+      const OpcodeInfo& info = GetOpcodeInfo(opcode);
+      int operand_size = OperandSizeBytes(info.mode, m_width, x_width);
+      if (pc + 1 + operand_size > range.end) {
+        break;
+      }
+      uint32_t operand = 0;
+      for (int i = 0; i < operand_size; ++i) {
+        operand |= static_cast<uint32_t>(result.rom_data[pc + 1 + i]) << (8 * i);
+      }
+      while (block + 1 < ranges.size() && ranges[block + 1].start <= pc) {
+        ++block;
+      }
+      Instruction instruction;
+      instruction.pc = pc;
+      instruction.snes = static_cast<uint32_t>(ranges[block].snes + (pc - ranges[block].start));
+      instruction.size = 1 + operand_size;
+      instruction.opcode = opcode;
+      uint64_t key = opcode | (static_cast<uint64_t>(operand_size) << 8);
+      instruction.bytes = Mix(key | (static_cast<uint64_t>(operand) << 16));
+      if (PointsIntoRom(info.mode, operand, instruction.snes, mapper)) {
+        instruction.token = Mix(key | (1ULL << 12));
+      } else {
+        instruction.token = instruction.bytes;
+      }
+      instructions->push_back(instruction);
+
+      std::string_view mnemonic = info.mnemonic;
+      if (mnemonic == "REP" && operand_size == 1) {
+        if (operand & 0x20) m_width = 2;
+        if (operand & 0x10) x_width = 2;
+      } else if (mnemonic == "SEP" && operand_size == 1) {
+        if (operand & 0x20) m_width = 1;
+        if (operand & 0x10) x_width = 1;
+      } else if (mnemonic == "XCE") {
+        m_width = 1;
+        x_width = 1;
+      } else if (mnemonic == "PLP" || mnemonic == "RTI") {
+        m_width = default_m;
+        x_width = default_x;
+      }
+      pc += 1 + operand_size;
+    }
+    int count = static_cast<int>(instructions->size()) - first;
+    if (count > 0) {
+      regions->emplace_back(first, count);
+    }
+  }
+}
+
+// Pairs every window of `window` instructions with the first window that
+// has the same tokens, then turns runs of consecutive pairs into clones.
+// A window only ends in a return or jump, never runs through one, so clones
+// stop where control leaves the code instead of running into the next
+// routine or the data after it.
+std::vector<CloneRun> MatchWindows(const std::vector<Instruction>& instructions,
+                                   const std::vector<std::pair<int, int>>& regions,
+                                   int window) {
+  std::vector<int> starts;   // first instruction of each window
+  std::vector<int> region_of;
+  for (size_t r = 0; r < regions.size(); ++r) {
+    const auto& [first, count] = regions[r];
+    for (int start = first; start + window <= first + count; ++start) {
+      starts.push_back(start);
+      region_of.push_back(static_cast<int>(r));
+    }
+  }
+  const int windows = static_cast<int>(starts.size());
+  std::vector<int> rep(windows);
+  // last return or jump at or before each instruction, -1 for none
+  std::vector<int> last_exit(instructions.size(), -1);
+  for (size_t i = 0; i < instructions.size(); ++i) {
+    if (EndsFlow(instructions[i].opcode)) {
+      last_exit[i] = static_cast<int>(i);
+    } else if (i > 0) {
+      last_exit[i] = last_exit[i - 1];
+    }
+  }
+
+  uint64_t top_power = 1;
+  for (int i = 1; i < window; ++i) {
+    top_power *= kHashBase;
+  }
+  std::unordered_map<uint64_t, int> first_seen;
+  first_seen.reserve(static_cast<size_t>(windows));
+  uint64_t hash = 0;
+  int same_run = 0;  // equal tokens ending at the window's last instruction
+  for (int w = 0; w < windows; ++w) {
+    int start = starts[w];
+    int last = start + window - 1;
+    if (w == 0 || region_of[w] != region_of[w - 1]) {
+      hash = 0;
+      same_run = 0;
+      for (int i = start; i <= last; ++i) {
+        hash = hash * kHashBase + instructions[i].token;
+        same_run = (i > start && instructions[i].token == instructions[i - 1].token)
+                       ? same_run + 1
+                       : 1;
+      }
+    } else {
+      hash = (hash - instructions[start - 1].token * top_power) * kHashBase +
+             instructions[last].token;
+      same_run = instructions[last].token == instructions[last - 1].token ? same_run + 1 : 1;
+    }
+    rep[w] = w;
+    // fill bytes and other runs of one instruction aren't code worth merging
+    if (same_run >= window || last_exit[last - 1] >= start) {
+      continue;
+    }
+    auto [it, inserted] = first_seen.emplace(hash, w);
+    if (inserted) {
+      continue;
+    }
+    int other = starts[it->second];
+    bool equal = true;
+    for (int i = 0; i < window && equal; ++i) {
+      equal = instructions[start + i].token == instructions[other + i].token;
+    }
+    if (equal) {
+      rep[w] = it->second;
+    }
+  }
+
+  std::vector<CloneRun> runs;
+  for (int w = 0; w < windows;) {
+    int original = rep[w];
+    if (original == w) {
+      ++w;
+      continue;
+    }
+    int length = 1;
+    while (w + length < windows && region_of[w + length] == region_of[w] &&
+           rep[w + length] == original + length &&
+           region_of[original + length] == region_of[original]) {
+      ++length;
+    }
+    CloneRun run;
+    run.original = starts[original];
+    run.copy = starts[w];
+    run.count = length + window - 1;
+    // a pattern that repeats into itself isn't a second copy
+    bool overlaps = region_of[original] == region_of[w] && run.original + run.count > run.copy;
+    if (!overlaps) {
+      runs.push_back(run);
+    }
+    w += length;
+  }
+  return runs;
+}
+
+int SequenceBytes(const std::vector<Instruction>& instructions, int first, int count) {
+  const Instruction& last = instructions[first + count - 1];
+  return last.pc + last.size - instructions[first].pc;
+}
+
+std::string EscapeJson(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  for (char c : text) {
+    switch (c) {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        out.push_back(c);
+        break;
+    }
+  }
+  return out;
+}
+
+const char* KindName(CloneKind kind) {
+  switch (kind) {
+    case CloneKind::kRoutine:
+      return "routine";
+    case CloneKind::kTail:
+      return "tail";
+    case CloneKind::kFragment:
+      return "fragment";
+  }
+  return "fragment";
+}
+
+}  // namespace
+
+CloneReport FindClones(const AssembleResult& result, const CloneOptions& options) {
+  CloneReport report;
+  const int window = std::max(2, options.min_instructions);
+  std::vector<Instruction> instructions;
+  std::vector<std::pair<int, int>> regions;
+  Decode(result, options, &instructions, &regions);
+  std::vector<CloneRun> runs = MatchWindows(instructions, regions, window);
+
+  // copies of the same sequence share a group
+  struct Pending {
+    int original = 0;
+    int count = 0;
+    std::vector<int> copies;
+  };
+  std::vector<Pending> pending;
+  std::unordered_map<uint64_t, size_t> group_of;
+  for (const auto& run : runs) {
+    uint64_t key = (static_cast<uint64_t>(run.original) << 32) | static_cast<uint32_t>(run.count);
+    auto [it, inserted] = group_of.emplace(key, pending.size());
+    if (inserted) {
+      pending.push_back({run.original, run.count, {}});
+    }
+    pending[it->second].copies.push_back(run.copy);
+  }
+
+  // Labels and the source map use whichever mirror the source org'd at,
+  // so both are looked up by ROM offset.
+  const RomMapper mapper = static_cast<RomMapper>(result.mapper);
+  std::unordered_set<int> labels;
+  for (const auto& label : result.labels) {
+    labels.insert(SnesToRomOffset(label.address, mapper));
+  }
+  SourceMap by_offset;
+  by_offset.files = result.source_map.files;
+  std::unordered_map<int, uint32_t> org_address;
+  for (const auto& entry : result.source_map.entries) {
+    int pc = SnesToRomOffset(entry.address, mapper);
+    if (pc >= 0) {
+      by_offset.entries.push_back({static_cast<uint32_t>(pc), entry.file_id, entry.line});
+      org_address.emplace(pc, entry.address);
+    }
+  }
+  SourceIndex sources = BuildSourceIndex(by_offset);
+
+  for (const auto& entry : pending) {
+    int bytes = SequenceBytes(instructions, entry.original, entry.count);
+    if (bytes < options.min_bytes) {
+      continue;
+    }
+    CloneGroup group;
+    group.instructions = entry.count;
+    group.bytes = bytes;
+    std::vector<int> firsts = {entry.original};
+    firsts.insert(firsts.end(), entry.copies.begin(), entry.copies.end());
+
+    bool all_labeled = true;
+    bool cross_bank = false;
+    const uint32_t bank = instructions[entry.original].snes & 0xFF0000;
+    for (int first : firsts) {
+      const Instruction& start = instructions[first];
+      all_labeled = all_labeled && labels.count(start.pc) > 0;
+      cross_bank = cross_bank || (start.snes & 0xFF0000) != bank;
+      for (int i = 0; i < entry.count && group.exact; ++i) {
+        group.exact = instructions[first + i].bytes == instructions[entry.original + i].bytes;
+      }
+      CloneSite site;
+      auto org = org_address.find(start.pc);
+      site.address = org != org_address.end() ? org->second : start.snes;
+      if (const SourceMapEntry* location =
+              FindEntry(sources, static_cast<uint32_t>(start.pc))) {
+        auto file = sources.files.find(location->file_id);
+        if (file != sources.files.end()) {
+          site.filename = file->second;
+        }
+        site.line = location->line;
+      }
+      group.sites.push_back(std::move(site));
+    }
+
+    // a JSR/JMP within the bank, JSL/JML across banks
+    const int call_bytes = cross_bank ? 4 : 3;
+    const int copies = static_cast<int>(entry.copies.size());
+    const bool ends_flow = EndsFlow(instructions[entry.original + entry.count - 1].opcode);
+    if (ends_flow && all_labeled) {
+      group.kind = CloneKind::kRoutine;
+      group.bytes_saved = copies * bytes;
+    } else if (ends_flow) {
+      group.kind = CloneKind::kTail;
+      group.bytes_saved = copies * (bytes - call_bytes);
+    } else {
+      // one copy becomes a subroutine with an RTS, every site calls it
+      group.kind = CloneKind::kFragment;
+      group.bytes_saved = copies * bytes - 1 - (copies + 1) * call_bytes;
+    }
+    if (group.bytes_saved <= 0) {
+      continue;
+    }
+    report.bytes_saved += group.bytes_saved;
+    report.groups.push_back(std::move(group));
+  }
+
+  std::sort(report.groups.begin(), report.groups.end(),
+            [](const CloneGroup& a, const CloneGroup& b) {
+              if (a.bytes_saved != b.bytes_saved) {
+                return a.bytes_saved > b.bytes_saved;
+              }
+              return a.sites.front().address < b.sites.front().address;
+            });
+  return report;
+}
+
+std::string ClonesToJson(const CloneReport& report) {
+  std::ostringstream out;
+  out << "{\"version\":1,\"bytes_saved\":" << report.bytes_saved << ",\"clones\":[";
+  for (size_t i = 0; i < report.groups.size(); ++i) {
+    const CloneGroup& group = report.groups[i];
+    if (i > 0) {
+      out << ',';
+    }
+    out << "{\"kind\":\"" << KindName(group.kind) << "\""
+        << ",\"exact\":" << (group.exact ? "true" : "false")
+        << ",\"instructions\":" << group.instructions
+        << ",\"bytes\":" << group.bytes
+        << ",\"bytes_saved\":" << group.bytes_saved
+        << ",\"sites\":[";
+    for (size_t j = 0; j < group.sites.size(); ++j) {
+      const CloneSite& site = group.sites[j];
+      if (j > 0) {
+        out << ',';
+      }
+      char address[16];
+      std::snprintf(address, sizeof(address), "0x%06X", site.address);
+      out << "{\"address\":\"" << address << "\""
+          << ",\"file\":\"" << EscapeJson(site.filename) << "\""
+          << ",\"line\":" << site.line << "}";
+    }
+    out << "]}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+}  // namespace z3dk
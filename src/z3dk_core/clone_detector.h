@@ -0,0 +1,69 @@
+#ifndef Z3DK_CORE_CLONE_DETECTOR_H
+#define Z3DK_CORE_CLONE_DETECTOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "z3dk_core/assembler.h"
+
+namespace z3dk {
+
+struct CloneOptions {
+  // register widths (bytes) at the start of each written block, as for lint
+  int default_m_width_bytes = 1;
+  int default_x_width_bytes = 1;
+  // shortest clone reported
+  int min_instructions = 8;
+  int min_bytes = 16;
+};
+
+enum class CloneKind {
+  // starts at a label in every copy and ends in a return or jump
+  kRoutine,
+  // ends in a return or jump, so copies can jump into one of them
+  kTail,
+  // anything else; copies would become calls to a shared subroutine
+  kFragment,
+};
+
+struct CloneSite {
+  uint32_t address = 0;  // SNES address of the first instruction
+  std::string filename;
+  int line = 0;
+};
+
+// One instruction sequence and every place it was found, first copy first.
+struct CloneGroup {
+  CloneKind kind = CloneKind::kFragment;
+  // true when the copies are byte for byte the same; false when they only
+  // match once operands pointing into the ROM (calls, jumps, tables) are
+  // left out, so merging them means passing those in somehow
+  bool exact = true;
+  int instructions = 0;
+  int bytes = 0;
+  // rough estimate of what merging the copies would free, after the JSR,
+  // JSL or JMP that replaces them
+  int bytes_saved = 0;
+  std::vector<CloneSite> sites;
+};
+
+struct CloneReport {
+  // most bytes saved first
+  std::vector<CloneGroup> groups;
+  int bytes_saved = 0;
+};
+
+// Finds repeated instruction sequences in what the build wrote. Written
+// blocks are decoded linearly the way RunLint does, each instruction is
+// reduced to its opcode and operand with ROM addresses masked, and windows
+// of min_instructions are matched with a rolling hash. Every copy is then
+// extended against the first occurrence of its window, so the work is
+// linear in the number of bytes written (plus sorting the report).
+CloneReport FindClones(const AssembleResult& result, const CloneOptions& options = {});
+
+std::string ClonesToJson(const CloneReport& report);
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_CLONE_DETECTOR_H
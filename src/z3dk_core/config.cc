@@ -287,22 +287,14 @@ void ApplyArrayKey(Config* config, const std::string& key, std::string_view valu
   }
 }
 
-Config LoadConfigFile(const std::string& path, std::string* error) {
+Config ParseConfig(std::istream& input) {
   Config config;
-  std::ifstream file(path);
-  if (!file.is_open()) {
-    if (error) {
-      *error = "Unable to open config: " + path;
-    }
-    return config;
-  }
-
   std::string line;
   int line_number = 0;
   std::string pending_key;
   std::string pending_value;
   int pending_brackets = 0;
-  while (std::getline(file, line)) {
+  while (std::getline(input, line)) {
     ++line_number;
     std::string stripped = StripComments(line);
     std::string trimmed = Trim(stripped);
@@ -369,10 +361,20 @@ Config LoadConfigFile(const std::string& path, std::string* error) {
       config.symbols_format = ParseStringValue(value);
     } else if (key == "symbols_path") {
       config.symbols_path = ParseStringValue(value);
+    } else if (key == "cache") {
+      config.cache = ParseStringValue(value);
+    } else if (key == "rom_schema") {
+      config.rom_schema = ParseStringValue(value);
+    } else if (key == "max_include_depth") {
+      config.max_include_depth = ParseInt(value);
+    } else if (key == "max_macro_depth") {
+      config.max_macro_depth = ParseInt(value);
     } else if (key == "lsp_log_enabled") {
       config.lsp_log_enabled = ParseBool(value);
     } else if (key == "lsp_log_path") {
       config.lsp_log_path = ParseStringValue(value);
+    } else if (key == "lsp_workers") {
+      config.lsp_workers = ParseInt(value);
     } else if (key == "warn_unused_symbols") {
       config.warn_unused_symbols = ParseBool(value);
     } else if (key == "warn_branch_outside_bank") {
@@ -395,6 +397,17 @@ Config LoadConfigFile(const std::string& path, std::string* error) {
   return config;
 }
 
+Config LoadConfigFile(const std::string& path, std::string* error) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    if (error) {
+      *error = "Unable to open config: " + path;
+    }
+    return Config{};
+  }
+  return ParseConfig(file);
+}
+
 Config LoadConfigIfExists(const std::string& path) {
   std::ifstream file(path);
   if (!file.good()) {
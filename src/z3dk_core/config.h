@@ -2,6 +2,7 @@
 #define Z3DK_CORE_CONFIG_H
 
 #include <cstdint>
+#include <istream>
 #include <optional>
 #include <string>
 #include <vector>
@@ -27,9 +28,16 @@ struct Config {
   std::optional<int> rom_size;
   std::optional<std::string> symbols_format;
   std::optional<std::string> symbols_path;
+  std::optional<std::string> cache;
+  // JSON schema the assembled ROM is validated against after each build
+  std::optional<std::string> rom_schema;
+  // incsrc and macro nesting limits, see AssembleOptions
+  std::optional<int> max_include_depth;
+  std::optional<int> max_macro_depth;
   std::vector<MemoryRange> prohibited_memory_ranges;
   std::optional<bool> lsp_log_enabled;
   std::optional<std::string> lsp_log_path;
+  std::optional<int> lsp_workers;
   std::optional<bool> warn_unused_symbols;
   std::optional<bool> warn_branch_outside_bank;
   std::optional<bool> warn_unknown_width;
@@ -37,6 +45,8 @@ struct Config {
   std::optional<bool> warn_unauthorized_hook;
 };
 
+// Parses z3dk.toml text. Unknown keys and lines without a key are skipped.
+Config ParseConfig(std::istream& input);
 Config LoadConfigFile(const std::string& path, std::string* error);
 Config LoadConfigIfExists(const std::string& path);
 
@@ -0,0 +1,1011 @@
+#include "z3dk_core/cpu65816.h"
+
+#include <string_view>
+#include <utility>
+
+#include "address-map.h"
+
+namespace z3dk {
+namespace {
+
+enum class Op : uint8_t {
+  kAdc, kAnd, kAsl, kBcc, kBcs, kBeq, kBit, kBmi, kBne, kBpl, kBra, kBrk,
+  kBrl, kBvc, kBvs, kClc, kCld, kCli, kClv, kCmp, kCop, kCpx, kCpy, kDec,
+  kDex, kDey, kEor, kInc, kInx, kIny, kJml, kJmp, kJsl, kJsr, kLda, kLdx,
+  kLdy, kLsr, kMvn, kMvp, kNop, kOra, kPea, kPei, kPer, kPha, kPhb, kPhd,
+  kPhk, kPhp, kPhx, kPhy, kPla, kPlb, kPld, kPlp, kPlx, kPly, kRep, kRol,
+  kRor, kRti, kRtl, kRts, kSbc, kSec, kSed, kSei, kSep, kSta, kStp, kStx,
+  kSty, kStz, kTax, kTay, kTcd, kTcs, kTdc, kTrb, kTsb, kTsc, kTsx, kTxa,
+  kTxs, kTxy, kTya, kTyx, kWai, kWdm, kXba, kXce,
+};
+
+constexpr std::pair<std::string_view, Op> kMnemonics[] = {
+  {"ADC", Op::kAdc}, {"AND", Op::kAnd}, {"ASL", Op::kAsl}, {"BCC", Op::kBcc},
+  {"BCS", Op::kBcs}, {"BEQ", Op::kBeq}, {"BIT", Op::kBit}, {"BMI", Op::kBmi},
+  {"BNE", Op::kBne}, {"BPL", Op::kBpl}, {"BRA", Op::kBra}, {"BRK", Op::kBrk},
+  {"BRL", Op::kBrl}, {"BVC", Op::kBvc}, {"BVS", Op::kBvs}, {"CLC", Op::kClc},
+  {"CLD", Op::kCld}, {"CLI", Op::kCli}, {"CLV", Op::kClv}, {"CMP", Op::kCmp},
+  {"COP", Op::kCop}, {"CPX", Op::kCpx}, {"CPY", Op::kCpy}, {"DEC", Op::kDec},
+  {"DEX", Op::kDex}, {"DEY", Op::kDey}, {"EOR", Op::kEor}, {"INC", Op::kInc},
+  {"INX", Op::kInx}, {"INY", Op::kIny}, {"JML", Op::kJml}, {"JMP", Op::kJmp},
+  {"JSL", Op::kJsl}, {"JSR", Op::kJsr}, {"LDA", Op::kLda}, {"LDX", Op::kLdx},
+  {"LDY", Op::kLdy}, {"LSR", Op::kLsr}, {"MVN", Op::kMvn}, {"MVP", Op::kMvp},
+  {"NOP", Op::kNop}, {"ORA", Op::kOra}, {"PEA", Op::kPea}, {"PEI", Op::kPei},
+  {"PER", Op::kPer}, {"PHA", Op::kPha}, {"PHB", Op::kPhb}, {"PHD", Op::kPhd},
+  {"PHK", Op::kPhk}, {"PHP", Op::kPhp}, {"PHX", Op::kPhx}, {"PHY", Op::kPhy},
+  {"PLA", Op::kPla}, {"PLB", Op::kPlb}, {"PLD", Op::kPld}, {"PLP", Op::kPlp},
+  {"PLX", Op::kPlx}, {"PLY", Op::kPly}, {"REP", Op::kRep}, {"ROL", Op::kRol},
+  {"ROR", Op::kRor}, {"RTI", Op::kRti}, {"RTL", Op::kRtl}, {"RTS", Op::kRts},
+  {"SBC", Op::kSbc}, {"SEC", Op::kSec}, {"SED", Op::kSed}, {"SEI", Op::kSei},
+  {"SEP", Op::kSep}, {"STA", Op::kSta}, {"STP", Op::kStp}, {"STX", Op::kStx},
+  {"STY", Op::kSty}, {"STZ", Op::kStz}, {"TAX", Op::kTax}, {"TAY", Op::kTay},
+  {"TCD", Op::kTcd}, {"TCS", Op::kTcs}, {"TDC", Op::kTdc}, {"TRB", Op::kTrb},
+  {"TSB", Op::kTsb}, {"TSC", Op::kTsc}, {"TSX", Op::kTsx}, {"TXA", Op::kTxa},
+  {"TXS", Op::kTxs}, {"TXY", Op::kTxy}, {"TYA", Op::kTya}, {"TYX", Op::kTyx},
+  {"WAI", Op::kWai}, {"WDM", Op::kWdm}, {"XBA", Op::kXba}, {"XCE", Op::kXce},
+};
+
+struct OpTable {
+  Op ops[256];
+
+  OpTable() {
+    for (int i = 0; i < 256; ++i) {
+      std::string_view name = GetOpcodeInfo(static_cast<uint8_t>(i)).mnemonic;
+      ops[i] = Op::kNop;
+      for (const auto& entry : kMnemonics) {
+        if (entry.first == name) {
+          ops[i] = entry.second;
+          break;
+        }
+      }
+    }
+  }
+};
+
+Op OpFor(uint8_t opcode) {
+  static const OpTable table;
+  return table.ops[opcode];
+}
+
+bool IsReadModifyWrite(Op op) {
+  switch (op) {
+    case Op::kAsl:
+    case Op::kLsr:
+    case Op::kRol:
+    case Op::kRor:
+    case Op::kInc:
+    case Op::kDec:
+    case Op::kTsb:
+    case Op::kTrb:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Cycles with 8-bit registers and DL = 0, before any taken branch.
+int BaseCycles(Op op, AddrMode mode) {
+  switch (op) {
+    case Op::kBrk:
+    case Op::kCop:
+    case Op::kJsl:
+      return 8;
+    case Op::kJsr:
+      return mode == AddrMode::kAbsolute ? 6 : 8;
+    case Op::kJmp:
+      if (mode == AddrMode::kAbsolute) return 3;
+      return mode == AddrMode::kAbsoluteIndirect ? 5 : 6;
+    case Op::kJml:
+      return mode == AddrMode::kAbsoluteLong ? 4 : 6;
+    case Op::kRts:
+    case Op::kRtl:
+      return 6;
+    case Op::kRti:
+      return 7;
+    case Op::kBra:
+      return 3;
+    case Op::kBrl:
+      return 4;
+    case Op::kRep:
+    case Op::kSep:
+    case Op::kXba:
+    case Op::kStp:
+    case Op::kWai:
+    case Op::kPha:
+    case Op::kPhx:
+    case Op::kPhy:
+    case Op::kPhp:
+    case Op::kPhb:
+    case Op::kPhk:
+      return 3;
+    case Op::kPhd:
+    case Op::kPla:
+    case Op::kPlx:
+    case Op::kPly:
+    case Op::kPlp:
+    case Op::kPlb:
+      return 4;
+    case Op::kPld:
+    case Op::kPea:
+      return 5;
+    case Op::kPei:
+    case Op::kPer:
+      return 6;
+    case Op::kMvn:
+    case Op::kMvp:
+      return 7;
+    default:
+      break;
+  }
+  int extra = IsReadModifyWrite(op) ? 2 : 0;
+  switch (mode) {
+    case AddrMode::kImplied:
+    case AddrMode::kImmediate8:
+    case AddrMode::kImmediate16:
+    case AddrMode::kImmediateM:
+    case AddrMode::kImmediateX:
+    case AddrMode::kRelative8:
+    case AddrMode::kRelative16:
+      return 2;
+    case AddrMode::kDirectPage:
+      return 3 + extra;
+    case AddrMode::kDirectPageX:
+    case AddrMode::kDirectPageY:
+    case AddrMode::kStackRelative:
+      return 4 + extra;
+    case AddrMode::kAbsolute:
+      return 4 + extra;
+    case AddrMode::kAbsoluteX:
+      return 4 + (extra ? 3 : 0);
+    case AddrMode::kAbsoluteY:
+      return 4;
+    case AddrMode::kDirectPageIndirect:
+    case AddrMode::kDirectPageIndirectIndexedY:
+    case AddrMode::kAbsoluteLong:
+    case AddrMode::kAbsoluteLongX:
+      return 5;
+    case AddrMode::kDirectPageIndexedIndirect:
+    case AddrMode::kDirectPageIndirectLong:
+    case AddrMode::kDirectPageIndirectLongY:
+      return 6;
+    case AddrMode::kStackRelativeIndirectY:
+      return 7;
+    default:
+      return 2;
+  }
+}
+
+bool IsDirectPageMode(AddrMode mode) {
+  switch (mode) {
+    case AddrMode::kDirectPage:
+    case AddrMode::kDirectPageX:
+    case AddrMode::kDirectPageY:
+    case AddrMode::kDirectPageIndirect:
+    case AddrMode::kDirectPageIndexedIndirect:
+    case AddrMode::kDirectPageIndirectIndexedY:
+    case AddrMode::kDirectPageIndirectLong:
+    case AddrMode::kDirectPageIndirectLongY:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Default SA-1 bank registers (CXB..FXB = 0..3).
+constexpr int kSa1Banks[8] = {0 << 20, 1 << 20, -1, -1, 2 << 20, 3 << 20, -1, -1};
+
+// Translation tables for every mapper, built the same way as the
+// assembler's.
+const address_map& MapperTables(RomMapper mapper) {
+  static const std::array<address_map, 9> maps = [] {
+    std::array<address_map, 9> built{};
+    for (size_t i = 0; i < built.size(); ++i) {
+      build_address_map(built[i], static_cast<mapper_t>(i), kSa1Banks);
+    }
+    return built;
+  }();
+  size_t index = static_cast<size_t>(mapper);
+  return maps[index < maps.size() ? index : 0];
+}
+
+}  // namespace
+
+int SnesToRomOffset(uint32_t address, RomMapper mapper) {
+  if (address > 0xFFFFFF) {
+    return -1;
+  }
+  return MapperTables(mapper).snestopc(static_cast<int>(address));
+}
+
+int RomOffsetToSnes(int offset, RomMapper mapper) {
+  return MapperTables(mapper).pctosnes(offset);
+}
+
+SparseMemory::SparseMemory(std::shared_ptr<const std::vector<uint8_t>> rom,
+                           RomMapper mapper)
+    : rom_(std::move(rom)), mapper_(mapper) {}
+
+uint32_t SparseMemory::Canonical(uint32_t address) {
+  address &= 0xFFFFFF;
+  uint32_t bank = address >> 16;
+  uint32_t offset = address & 0xFFFF;
+  bool system_bank = bank < 0x40 || (bank >= 0x80 && bank < 0xC0);
+  if (system_bank && offset < 0x2000) {
+    return 0x7E0000 | offset;
+  }
+  if (system_bank && offset < 0x6000) {
+    return offset;
+  }
+  return address;
+}
+
+uint8_t SparseMemory::Read(uint32_t address) const {
+  uint32_t canonical = Canonical(address);
+  auto it = pages_.find(canonical >> 8);
+  if (it != pages_.end()) {
+    return (*it->second)[canonical & 0xFF];
+  }
+  if ((canonical & 0xFE0000) != 0x7E0000 && canonical >= 0x6000 && rom_) {
+    int offset = SnesToRomOffset(canonical, mapper_);
+    if (offset >= 0 && static_cast<size_t>(offset) < rom_->size()) {
+      return (*rom_)[static_cast<size_t>(offset)];
+    }
+  }
+  return 0;
+}
+
+void SparseMemory::Poke(uint32_t address, uint8_t value) {
+  auto& page = pages_[address >> 8];
+  if (!page) {
+    page = std::make_unique<Page>();
+  }
+  (*page)[address & 0xFF] = value;
+}
+
+void SparseMemory::Write(uint32_t address, uint8_t value) {
+  uint32_t canonical = Canonical(address);
+  if ((canonical & 0xFE0000) != 0x7E0000 && canonical >= 0x6000 &&
+      SnesToRomOffset(canonical, mapper_) >= 0) {
+    return;
+  }
+  Poke(canonical, value);
+  if (canonical == 0x4203) {
+    uint16_t product = static_cast<uint16_t>(Read(0x4202) * value);
+    Poke(0x4216, static_cast<uint8_t>(product));
+    Poke(0x4217, static_cast<uint8_t>(product >> 8));
+  } else if (canonical == 0x4206) {
+    uint16_t dividend = static_cast<uint16_t>(Read(0x4204) | Read(0x4205) << 8);
+    uint16_t quotient = 0xFFFF;
+    uint16_t remainder = dividend;
+    if (value != 0) {
+      quotient = static_cast<uint16_t>(dividend / value);
+      remainder = static_cast<uint16_t>(dividend % value);
+    }
+    Poke(0x4214, static_cast<uint8_t>(quotient));
+    Poke(0x4215, static_cast<uint8_t>(quotient >> 8));
+    Poke(0x4216, static_cast<uint8_t>(remainder));
+    Poke(0x4217, static_cast<uint8_t>(remainder >> 8));
+  }
+}
+
+uint8_t Cpu65816::Read8(uint32_t address) const {
+  return memory_->Read(address & 0xFFFFFF);
+}
+
+uint16_t Cpu65816::Read16(uint32_t address) const {
+  return static_cast<uint16_t>(Read8(address) | Read8(address + 1) << 8);
+}
+
+uint16_t Cpu65816::ReadBank0_16(uint16_t address) const {
+  return static_cast<uint16_t>(
+      Read8(address) | Read8(static_cast<uint16_t>(address + 1)) << 8);
+}
+
+void Cpu65816::Write8(uint32_t address, uint8_t value) {
+  memory_->Write(address & 0xFFFFFF, value);
+}
+
+void Cpu65816::Write16(uint32_t address, uint16_t value) {
+  Write8(address, static_cast<uint8_t>(value));
+  Write8(address + 1, static_cast<uint8_t>(value >> 8));
+}
+
+uint8_t Cpu65816::Fetch8() {
+  uint8_t value = Read8(static_cast<uint32_t>(regs_.pb) << 16 | regs_.pc);
+  regs_.pc = static_cast<uint16_t>(regs_.pc + 1);
+  return value;
+}
+
+uint16_t Cpu65816::Fetch16() {
+  uint16_t low = Fetch8();
+  return static_cast<uint16_t>(low | Fetch8() << 8);
+}
+
+uint32_t Cpu65816::Fetch24() {
+  uint32_t low = Fetch16();
+  return low | static_cast<uint32_t>(Fetch8()) << 16;
+}
+
+void Cpu65816::Push8(uint8_t value) {
+  Write8(regs_.s, value);
+  regs_.s = static_cast<uint16_t>(regs_.s - 1);
+  if (regs_.emulation) {
+    regs_.s = static_cast<uint16_t>(0x0100 | (regs_.s & 0xFF));
+  }
+}
+
+void Cpu65816::Push16(uint16_t value) {
+  Push8(static_cast<uint8_t>(value >> 8));
+  Push8(static_cast<uint8_t>(value));
+}
+
+uint8_t Cpu65816::Pull8() {
+  regs_.s = static_cast<uint16_t>(regs_.s + 1);
+  if (regs_.emulation) {
+    regs_.s = static_cast<uint16_t>(0x0100 | (regs_.s & 0xFF));
+  }
+  return Read8(regs_.s);
+}
+
+uint16_t Cpu65816::Pull16() {
+  uint16_t low = Pull8();
+  return static_cast<uint16_t>(low | Pull8() << 8);
+}
+
+void Cpu65816::SetNZ(uint16_t value, bool wide) {
+  regs_.p &= static_cast<uint8_t>(~(kFlagN | kFlagZ));
+  if (wide) {
+    if (value == 0) regs_.p |= kFlagZ;
+    if (value & 0x8000) regs_.p |= kFlagN;
+  } else {
+    if ((value & 0xFF) == 0) regs_.p |= kFlagZ;
+    if (value & 0x80) regs_.p |= kFlagN;
+  }
+}
+
+void Cpu65816::SetP(uint8_t value) {
+  regs_.p = value;
+  if (regs_.emulation) {
+    regs_.p |= kFlagM | kFlagX;
+  }
+  if (regs_.p & kFlagX) {
+    regs_.x &= 0xFF;
+    regs_.y &= 0xFF;
+  }
+}
+
+// Binary and BCD add, digit by digit like the hardware so the flags match
+// for invalid BCD operands too.
+void Cpu65816::Adc(uint16_t operand) {
+  bool wide = MemoryWide();
+  int digits = wide ? 4 : 2;
+  int a = wide ? regs_.a : (regs_.a & 0xFF);
+  int v = operand;
+  int sign = wide ? 0x8000 : 0x80;
+  int carry = regs_.p & kFlagC;
+  int result = 0;
+  int overflow = 0;
+  if (!(regs_.p & kFlagD)) {
+    result = a + v + carry;
+    overflow = ~(a ^ v) & (a ^ result) & sign;
+  } else {
+    for (int i = 0; i < digits; ++i) {
+      int shift = 4 * i;
+      int nibble = 0xF << shift;
+      int low = (1 << shift) - 1;
+      result = (a & nibble) + (v & nibble) + (carry << shift) + (result & low);
+      if (i == digits - 1) {
+        overflow = ~(a ^ v) & (a ^ result) & sign;
+      }
+      if (result > (0xA << shift) - 1) {
+        result += 6 << shift;
+      }
+      carry = result > (0x10 << shift) - 1 ? 1 : 0;
+    }
+  }
+  int mask = wide ? 0xFFFF : 0xFF;
+  regs_.p &= static_cast<uint8_t>(~(kFlagC | kFlagV));
+  if (result > mask) regs_.p |= kFlagC;
+  if (overflow) regs_.p |= kFlagV;
+  if (wide) {
+    regs_.a = static_cast<uint16_t>(result);
+  } else {
+    regs_.a = static_cast<uint16_t>((regs_.a & 0xFF00) | (result & 0xFF));
+  }
+  SetNZ(regs_.a, wide);
+}
+
+void Cpu65816::Sbc(uint16_t operand) {
+  bool wide = MemoryWide();
+  int mask = wide ? 0xFFFF : 0xFF;
+  int digits = wide ? 4 : 2;
+  int a = wide ? regs_.a : (regs_.a & 0xFF);
+  int v = ~operand & mask;
+  int sign = wide ? 0x8000 : 0x80;
+  int carry = regs_.p & kFlagC;
+  int result = 0;
+  int overflow = 0;
+  if (!(regs_.p & kFlagD)) {
+    result = a + v + carry;
+    overflow = ~(a ^ v) & (a ^ result) & sign;
+  } else {
+    for (int i = 0; i < digits; ++i) {
+      int shift = 4 * i;
+      int nibble = 0xF << shift;
+      int low = (1 << shift) - 1;
+      int limit = (0x10 << shift) - 1;
+      result = (a & nibble) + (v & nibble) + (carry << shift) + (result & low);
+      if (i == digits - 1) {
+        overflow = ~(a ^ v) & (a ^ result) & sign;
+      }
+      if (result <= limit) {
+        result -= 6 << shift;
+      }
+      carry = result > limit ? 1 : 0;
+    }
+  }
+  regs_.p &= static_cast<uint8_t>(~(kFlagC | kFlagV));
+  if (result > mask) regs_.p |= kFlagC;
+  if (overflow) regs_.p |= kFlagV;
+  if (wide) {
+    regs_.a = static_cast<uint16_t>(result);
+  } else {
+    regs_.a = static_cast<uint16_t>((regs_.a & 0xFF00) | (result & 0xFF));
+  }
+  SetNZ(regs_.a, wide);
+}
+
+void Cpu65816::Compare(uint16_t reg, uint16_t operand, bool wide) {
+  int mask = wide ? 0xFFFF : 0xFF;
+  int r = reg & mask;
+  int v = operand & mask;
+  regs_.p &= static_cast<uint8_t>(~kFlagC);
+  if (r >= v) regs_.p |= kFlagC;
+  SetNZ(static_cast<uint16_t>((r - v) & mask), wide);
+}
+
+uint32_t Cpu65816::OperandAddress(AddrMode mode, int* cycles) {
+  uint32_t db = static_cast<uint32_t>(regs_.db) << 16;
+  if (IsDirectPageMode(mode) && (regs_.d & 0xFF) != 0) {
+    ++*cycles;
+  }
+  switch (mode) {
+    case AddrMode::kDirectPage:
+      return static_cast<uint16_t>(regs_.d + Fetch8());
+    case AddrMode::kDirectPageX:
+      return static_cast<uint16_t>(regs_.d + Fetch8() + regs_.x);
+    case AddrMode::kDirectPageY:
+      return static_cast<uint16_t>(regs_.d + Fetch8() + regs_.y);
+    case AddrMode::kDirectPageIndirect:
+      return db | ReadBank0_16(static_cast<uint16_t>(regs_.d + Fetch8()));
+    case AddrMode::kDirectPageIndexedIndirect:
+      return db | ReadBank0_16(static_cast<uint16_t>(regs_.d + Fetch8() + regs_.x));
+    case AddrMode::kDirectPageIndirectIndexedY:
+      return ((db | ReadBank0_16(static_cast<uint16_t>(regs_.d + Fetch8()))) +
+              regs_.y) & 0xFFFFFF;
+    case AddrMode::kDirectPageIndirectLong:
+    case AddrMode::kDirectPageIndirectLongY: {
+      uint16_t pointer = static_cast<uint16_t>(regs_.d + Fetch8());
+      uint32_t target = ReadBank0_16(pointer) |
+                        static_cast<uint32_t>(Read8(static_cast<uint16_t>(pointer + 2))) << 16;
+      if (mode == AddrMode::kDirectPageIndirectLongY) {
+        target += regs_.y;
+      }
+      return target & 0xFFFFFF;
+    }
+    case AddrMode::kStackRelative:
+      return static_cast<uint16_t>(regs_.s + Fetch8());
+    case AddrMode::kStackRelativeIndirectY:
+      return ((db | ReadBank0_16(static_cast<uint16_t>(regs_.s + Fetch8()))) +
+              regs_.y) & 0xFFFFFF;
+    case AddrMode::kAbsolute:
+      return db | Fetch16();
+    case AddrMode::kAbsoluteX:
+      return ((db | Fetch16()) + regs_.x) & 0xFFFFFF;
+    case AddrMode::kAbsoluteY:
+      return ((db | Fetch16()) + regs_.y) & 0xFFFFFF;
+    case AddrMode::kAbsoluteLong:
+      return Fetch24();
+    case AddrMode::kAbsoluteLongX:
+      return (Fetch24() + regs_.x) & 0xFFFFFF;
+    default:
+      return 0;
+  }
+}
+
+int Cpu65816::Step() {
+  if (halt_ != CpuHalt::kNone) {
+    return 0;
+  }
+  uint8_t opcode = Fetch8();
+  last_opcode_ = opcode;
+  const OpcodeInfo& info = GetOpcodeInfo(opcode);
+  const AddrMode mode = info.mode;
+  const Op op = OpFor(opcode);
+  const bool m16 = MemoryWide();
+  const bool x16 = IndexWide();
+  int cycles = BaseCycles(op, mode);
+
+  auto set_a = [&](uint16_t value) {
+    if (m16) {
+      regs_.a = value;
+    } else {
+      regs_.a = static_cast<uint16_t>((regs_.a & 0xFF00) | (value & 0xFF));
+    }
+  };
+  auto set_index = [&](uint16_t* reg, uint16_t value) {
+    *reg = x16 ? value : static_cast<uint16_t>(value & 0xFF);
+    SetNZ(*reg, x16);
+  };
+  auto read_m = [&]() -> uint16_t {
+    if (m16) ++cycles;
+    if (mode == AddrMode::kImmediateM) {
+      return m16 ? Fetch16() : Fetch8();
+    }
+    uint32_t address = OperandAddress(mode, &cycles);
+    return m16 ? Read16(address) : Read8(address);
+  };
+  auto read_x = [&]() -> uint16_t {
+    if (x16) ++cycles;
+    if (mode == AddrMode::kImmediateX) {
+      return x16 ? Fetch16() : Fetch8();
+    }
+    uint32_t address = OperandAddress(mode, &cycles);
+    return x16 ? Read16(address) : Read8(address);
+  };
+  auto store = [&](uint16_t value, bool wide) {
+    if (wide) ++cycles;
+    uint32_t address = OperandAddress(mode, &cycles);
+    if (wide) {
+      Write16(address, value);
+    } else {
+      Write8(address, static_cast<uint8_t>(value));
+    }
+  };
+  // Runs fn over the accumulator or a memory operand at the M width.
+  auto modify = [&](auto fn) {
+    if (mode == AddrMode::kImplied) {
+      uint16_t value = m16 ? regs_.a : static_cast<uint16_t>(regs_.a & 0xFF);
+      set_a(fn(value));
+      return;
+    }
+    if (m16) cycles += 2;
+    uint32_t address = OperandAddress(mode, &cycles);
+    uint16_t value = m16 ? Read16(address) : Read8(address);
+    uint16_t result = fn(value);
+    if (m16) {
+      Write16(address, result);
+    } else {
+      Write8(address, static_cast<uint8_t>(result));
+    }
+  };
+  auto branch = [&](bool taken) {
+    int8_t offset = static_cast<int8_t>(Fetch8());
+    if (taken) {
+      ++cycles;
+      regs_.pc = static_cast<uint16_t>(regs_.pc + offset);
+    }
+  };
+  const uint16_t sign = m16 ? 0x8000 : 0x80;
+  const uint16_t mask = m16 ? 0xFFFF : 0xFF;
+  const uint16_t index_mask = x16 ? 0xFFFF : 0xFF;
+
+  switch (op) {
+    case Op::kAdc:
+      Adc(read_m());
+      break;
+    case Op::kSbc:
+      Sbc(read_m());
+      break;
+    case Op::kAnd:
+      set_a(regs_.a & read_m());
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kOra:
+      set_a(regs_.a | read_m());
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kEor:
+      set_a(regs_.a ^ read_m());
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kLda:
+      set_a(read_m());
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kLdx:
+      set_index(&regs_.x, read_x());
+      break;
+    case Op::kLdy:
+      set_index(&regs_.y, read_x());
+      break;
+    case Op::kCmp:
+      Compare(regs_.a, read_m(), m16);
+      break;
+    case Op::kCpx:
+      Compare(regs_.x, read_x(), x16);
+      break;
+    case Op::kCpy:
+      Compare(regs_.y, read_x(), x16);
+      break;
+    case Op::kBit: {
+      uint16_t value = read_m();
+      regs_.p &= static_cast<uint8_t>(~kFlagZ);
+      if ((regs_.a & value & mask) == 0) regs_.p |= kFlagZ;
+      if (mode != AddrMode::kImmediateM) {
+        regs_.p &= static_cast<uint8_t>(~(kFlagN | kFlagV));
+        if (value & sign) regs_.p |= kFlagN;
+        if (value & (sign >> 1)) regs_.p |= kFlagV;
+      }
+      break;
+    }
+    case Op::kSta:
+      store(regs_.a, m16);
+      break;
+    case Op::kStz:
+      store(0, m16);
+      break;
+    case Op::kStx:
+      store(regs_.x, x16);
+      break;
+    case Op::kSty:
+      store(regs_.y, x16);
+      break;
+    case Op::kAsl:
+      modify([&](uint16_t v) {
+        regs_.p = static_cast<uint8_t>((regs_.p & ~kFlagC) | ((v & sign) ? kFlagC : 0));
+        uint16_t r = static_cast<uint16_t>((v << 1) & mask);
+        SetNZ(r, m16);
+        return r;
+      });
+      break;
+    case Op::kLsr:
+      modify([&](uint16_t v) {
+        regs_.p = static_cast<uint8_t>((regs_.p & ~kFlagC) | (v & 1));
+        uint16_t r = static_cast<uint16_t>(v >> 1);
+        SetNZ(r, m16);
+        return r;
+      });
+      break;
+    case Op::kRol:
+      modify([&](uint16_t v) {
+        uint16_t carry_in = regs_.p & kFlagC;
+        regs_.p = static_cast<uint8_t>((regs_.p & ~kFlagC) | ((v & sign) ? kFlagC : 0));
+        uint16_t r = static_cast<uint16_t>(((v << 1) | carry_in) & mask);
+        SetNZ(r, m16);
+        return r;
+      });
+      break;
+    case Op::kRor:
+      modify([&](uint16_t v) {
+        uint16_t carry_in = (regs_.p & kFlagC) ? sign : 0;
+        regs_.p = static_cast<uint8_t>((regs_.p & ~kFlagC) | (v & 1));
+        uint16_t r = static_cast<uint16_t>((v >> 1) | carry_in);
+        SetNZ(r, m16);
+        return r;
+      });
+      break;
+    case Op::kInc:
+      modify([&](uint16_t v) {
+        uint16_t r = static_cast<uint16_t>((v + 1) & mask);
+        SetNZ(r, m16);
+        return r;
+      });
+      break;
+    case Op::kDec:
+      modify([&](uint16_t v) {
+        uint16_t r = static_cast<uint16_t>((v - 1) & mask);
+        SetNZ(r, m16);
+        return r;
+      });
+      break;
+    case Op::kTsb:
+      modify([&](uint16_t v) {
+        regs_.p &= static_cast<uint8_t>(~kFlagZ);
+        if ((v & regs_.a & mask) == 0) regs_.p |= kFlagZ;
+        return static_cast<uint16_t>((v | regs_.a) & mask);
+      });
+      break;
+    case Op::kTrb:
+      modify([&](uint16_t v) {
+        regs_.p &= static_cast<uint8_t>(~kFlagZ);
+        if ((v & regs_.a & mask) == 0) regs_.p |= kFlagZ;
+        return static_cast<uint16_t>(v & ~regs_.a & mask);
+      });
+      break;
+    case Op::kInx:
+      set_index(&regs_.x, static_cast<uint16_t>(regs_.x + 1));
+      break;
+    case Op::kIny:
+      set_index(&regs_.y, static_cast<uint16_t>(regs_.y + 1));
+      break;
+    case Op::kDex:
+      set_index(&regs_.x, static_cast<uint16_t>(regs_.x - 1));
+      break;
+    case Op::kDey:
+      set_index(&regs_.y, static_cast<uint16_t>(regs_.y - 1));
+      break;
+    case Op::kTax:
+      set_index(&regs_.x, regs_.a);
+      break;
+    case Op::kTay:
+      set_index(&regs_.y, regs_.a);
+      break;
+    case Op::kTxy:
+      set_index(&regs_.y, regs_.x);
+      break;
+    case Op::kTyx:
+      set_index(&regs_.x, regs_.y);
+      break;
+    case Op::kTsx:
+      set_index(&regs_.x, regs_.s);
+      break;
+    case Op::kTxa:
+      set_a(regs_.x);
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kTya:
+      set_a(regs_.y);
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kTxs:
+      regs_.s = regs_.emulation ? static_cast<uint16_t>(0x0100 | (regs_.x & 0xFF))
+                                : regs_.x;
+      break;
+    case Op::kTcs:
+      regs_.s = regs_.emulation ? static_cast<uint16_t>(0x0100 | (regs_.a & 0xFF))
+                                : regs_.a;
+      break;
+    case Op::kTsc:
+      regs_.a = regs_.s;
+      SetNZ(regs_.a, true);
+      break;
+    case Op::kTcd:
+      regs_.d = regs_.a;
+      SetNZ(regs_.d, true);
+      break;
+    case Op::kTdc:
+      regs_.a = regs_.d;
+      SetNZ(regs_.a, true);
+      break;
+    case Op::kXba:
+      regs_.a = static_cast<uint16_t>((regs_.a >> 8) | (regs_.a << 8));
+      SetNZ(regs_.a & 0xFF, false);
+      break;
+    case Op::kPha:
+      if (m16) {
+        ++cycles;
+        Push16(regs_.a);
+      } else {
+        Push8(static_cast<uint8_t>(regs_.a));
+      }
+      break;
+    case Op::kPhx:
+    case Op::kPhy: {
+      uint16_t value = op == Op::kPhx ? regs_.x : regs_.y;
+      if (x16) {
+        ++cycles;
+        Push16(value);
+      } else {
+        Push8(static_cast<uint8_t>(value));
+      }
+      break;
+    }
+    case Op::kPla:
+      if (m16) {
+        ++cycles;
+        regs_.a = Pull16();
+      } else {
+        set_a(Pull8());
+      }
+      SetNZ(regs_.a, m16);
+      break;
+    case Op::kPlx:
+      if (x16) ++cycles;
+      set_index(&regs_.x, x16 ? Pull16() : Pull8());
+      break;
+    case Op::kPly:
+      if (x16) ++cycles;
+      set_index(&regs_.y, x16 ? Pull16() : Pull8());
+      break;
+    case Op::kPhp:
+      Push8(regs_.p);
+      break;
+    case Op::kPlp:
+      SetP(Pull8());
+      break;
+    case Op::kPhb:
+      Push8(regs_.db);
+      break;
+    case Op::kPlb:
+      regs_.db = Pull8();
+      SetNZ(regs_.db, false);
+      break;
+    case Op::kPhk:
+      Push8(regs_.pb);
+      break;
+    case Op::kPhd:
+      Push16(regs_.d);
+      break;
+    case Op::kPld:
+      regs_.d = Pull16();
+      SetNZ(regs_.d, true);
+      break;
+    case Op::kPea:
+      Push16(Fetch16());
+      break;
+    case Op::kPei: {
+      uint32_t address = OperandAddress(AddrMode::kDirectPage, &cycles);
+      Push16(ReadBank0_16(static_cast<uint16_t>(address)));
+      break;
+    }
+    case Op::kPer: {
+      uint16_t offset = Fetch16();
+      Push16(static_cast<uint16_t>(regs_.pc + offset));
+      break;
+    }
+    case Op::kBpl:
+      branch(!(regs_.p & kFlagN));
+      break;
+    case Op::kBmi:
+      branch(regs_.p & kFlagN);
+      break;
+    case Op::kBvc:
+      branch(!(regs_.p & kFlagV));
+      break;
+    case Op::kBvs:
+      branch(regs_.p & kFlagV);
+      break;
+    case Op::kBcc:
+      branch(!(regs_.p & kFlagC));
+      break;
+    case Op::kBcs:
+      branch(regs_.p & kFlagC);
+      break;
+    case Op::kBne:
+      branch(!(regs_.p & kFlagZ));
+      break;
+    case Op::kBeq:
+      branch(regs_.p & kFlagZ);
+      break;
+    case Op::kBra: {
+      int8_t offset = static_cast<int8_t>(Fetch8());
+      regs_.pc = static_cast<uint16_t>(regs_.pc + offset);
+      break;
+    }
+    case Op::kBrl: {
+      uint16_t offset = Fetch16();
+      regs_.pc = static_cast<uint16_t>(regs_.pc + offset);
+      break;
+    }
+    case Op::kJmp:
+      if (mode == AddrMode::kAbsolute) {
+        regs_.pc = Fetch16();
+      } else if (mode == AddrMode::kAbsoluteIndirect) {
+        regs_.pc = ReadBank0_16(Fetch16());
+      } else {
+        uint16_t pointer = static_cast<uint16_t>(Fetch16() + regs_.x);
+        regs_.pc = Read16(static_cast<uint32_t>(regs_.pb) << 16 | pointer);
+      }
+      break;
+    case Op::kJml:
+      if (mode == AddrMode::kAbsoluteLong) {
+        uint32_t target = Fetch24();
+        regs_.pb = static_cast<uint8_t>(target >> 16);
+        regs_.pc = static_cast<uint16_t>(target);
+      } else {
+        uint16_t pointer = Fetch16();
+        regs_.pc = ReadBank0_16(pointer);
+        regs_.pb = Read8(static_cast<uint16_t>(pointer + 2));
+      }
+      break;
+    case Op::kJsr:
+      if (mode == AddrMode::kAbsolute) {
+        uint16_t target = Fetch16();
+        Push16(static_cast<uint16_t>(regs_.pc - 1));
+        regs_.pc = target;
+      } else {
+        uint16_t pointer = static_cast<uint16_t>(Fetch16() + regs_.x);
+        Push16(static_cast<uint16_t>(regs_.pc - 1));
+        regs_.pc = Read16(static_cast<uint32_t>(regs_.pb) << 16 | pointer);
+      }
+      break;
+    case Op::kJsl: {
+      uint32_t target = Fetch24();
+      Push8(regs_.pb);
+      Push16(static_cast<uint16_t>(regs_.pc - 1));
+      regs_.pb = static_cast<uint8_t>(target >> 16);
+      regs_.pc = static_cast<uint16_t>(target);
+      break;
+    }
+    case Op::kRts:
+      regs_.pc = static_cast<uint16_t>(Pull16() + 1);
+      break;
+    case Op::kRtl:
+      regs_.pc = static_cast<uint16_t>(Pull16() + 1);
+      regs_.pb = Pull8();
+      break;
+    case Op::kRti:
+      SetP(Pull8());
+      regs_.pc = Pull16();
+      if (!regs_.emulation) {
+        regs_.pb = Pull8();
+      }
+      break;
+    case Op::kClc:
+      regs_.p &= static_cast<uint8_t>(~kFlagC);
+      break;
+    case Op::kSec:
+      regs_.p |= kFlagC;
+      break;
+    case Op::kCli:
+      regs_.p &= static_cast<uint8_t>(~kFlagI);
+      break;
+    case Op::kSei:
+      regs_.p |= kFlagI;
+      break;
+    case Op::kCld:
+      regs_.p &= static_cast<uint8_t>(~kFlagD);
+      break;
+    case Op::kSed:
+      regs_.p |= kFlagD;
+      break;
+    case Op::kClv:
+      regs_.p &= static_cast<uint8_t>(~kFlagV);
+      break;
+    case Op::kRep:
+      SetP(static_cast<uint8_t>(regs_.p & ~Fetch8()));
+      break;
+    case Op::kSep:
+      SetP(static_cast<uint8_t>(regs_.p | Fetch8()));
+      break;
+    case Op::kXce: {
+      bool carry = regs_.p & kFlagC;
+      regs_.p = static_cast<uint8_t>((regs_.p & ~kFlagC) | (regs_.emulation ? kFlagC : 0));
+      regs_.emulation = carry;
+      if (regs_.emulation) {
+        regs_.s = static_cast<uint16_t>(0x0100 | (regs_.s & 0xFF));
+        SetP(regs_.p);
+      }
+      break;
+    }
+    case Op::kMvn:
+    case Op::kMvp: {
+      uint8_t dest = Fetch8();
+      uint8_t source = Fetch8();
+      regs_.db = dest;
+      Write8(static_cast<uint32_t>(dest) << 16 | regs_.y,
+             Read8(static_cast<uint32_t>(source) << 16 | regs_.x));
+      int step = op == Op::kMvn ? 1 : -1;
+      regs_.x = static_cast<uint16_t>((regs_.x + step) & index_mask);
+      regs_.y = static_cast<uint16_t>((regs_.y + step) & index_mask);
+      regs_.a = static_cast<uint16_t>(regs_.a - 1);
+      if (regs_.a != 0xFFFF) {
+        regs_.pc = static_cast<uint16_t>(regs_.pc - 3);
+      }
+      break;
+    }
+    case Op::kBrk:
+    case Op::kCop:
+      Fetch8();
+      halt_ = CpuHalt::kBreak;
+      break;
+    case Op::kStp:
+      halt_ = CpuHalt::kStop;
+      break;
+    case Op::kWai:
+      halt_ = CpuHalt::kWait;
+      break;
+    case Op::kWdm:
+      Fetch8();
+      break;
+    case Op::kNop:
+      break;
+  }
+
+  cycles_ += static_cast<uint64_t>(cycles);
+  ++instructions_;
+  return cycles;
+}
+
+}  // namespace z3dk
@@ -0,0 +1,149 @@
+#ifndef Z3DK_CORE_CPU65816_H
+#define Z3DK_CORE_CPU65816_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "z3dk_core/opcode_table.h"
+
+namespace z3dk {
+
+// Mapper values match AssembleResult::mapper (asar's mapper_t).
+enum class RomMapper {
+  kInvalid = 0,
+  kLoRom = 1,
+  kHiRom = 2,
+  kSa1Rom = 3,
+  kBigSa1Rom = 4,
+  kSfxRom = 5,
+  kExLoRom = 6,
+  kExHiRom = 7,
+  kNoRom = 8,
+};
+
+// Returns the ROM offset for a SNES address, or -1 when the address is not
+// backed by ROM (WRAM, SRAM, I/O, open bus).
+int SnesToRomOffset(uint32_t address, RomMapper mapper);
+
+// Returns the SNES address asar would use for a ROM offset, or -1 when the
+// mapper doesn't map it.
+int RomOffsetToSnes(int offset, RomMapper mapper);
+
+// Sparse copy-on-write view of the SNES address space. Reads fall through to
+// a ROM image shared between instances; writes land in private 256 byte
+// pages, so a fresh instance costs next to nothing. ROM writes are dropped
+// like on hardware, WRAM mirrors in the system banks alias $7E, and the
+// multiply/divide registers at $4202-$4206 produce their results.
+class SparseMemory {
+ public:
+  SparseMemory(std::shared_ptr<const std::vector<uint8_t>> rom,
+               RomMapper mapper);
+
+  uint8_t Read(uint32_t address) const;
+  void Write(uint32_t address, uint8_t value);
+
+  // Number of private pages written so far.
+  size_t dirty_pages() const { return pages_.size(); }
+
+ private:
+  using Page = std::array<uint8_t, 256>;
+
+  static uint32_t Canonical(uint32_t address);
+  void Poke(uint32_t address, uint8_t value);
+
+  std::shared_ptr<const std::vector<uint8_t>> rom_;
+  RomMapper mapper_;
+  std::unordered_map<uint32_t, std::unique_ptr<Page>> pages_;
+};
+
+struct CpuRegisters {
+  uint16_t a = 0;
+  uint16_t x = 0;
+  uint16_t y = 0;
+  uint16_t s = 0x01FF;
+  uint16_t d = 0;
+  uint16_t pc = 0;
+  uint8_t db = 0;
+  uint8_t pb = 0;
+  uint8_t p = 0x34;
+  bool emulation = false;
+};
+
+enum class CpuHalt {
+  kNone,
+  kBreak,  // BRK or COP
+  kStop,   // STP
+  kWait,   // WAI
+};
+
+// Interpreter for the 65816 instruction set. Cycle counts follow the data
+// sheet (width, direct page and branch penalties) but ignore memory speed
+// and page crossings, which is close enough to budget a routine.
+class Cpu65816 {
+ public:
+  static constexpr uint8_t kFlagC = 0x01;
+  static constexpr uint8_t kFlagZ = 0x02;
+  static constexpr uint8_t kFlagI = 0x04;
+  static constexpr uint8_t kFlagD = 0x08;
+  static constexpr uint8_t kFlagX = 0x10;
+  static constexpr uint8_t kFlagM = 0x20;
+  static constexpr uint8_t kFlagV = 0x40;
+  static constexpr uint8_t kFlagN = 0x80;
+
+  explicit Cpu65816(SparseMemory* memory) : memory_(memory) {}
+
+  CpuRegisters& registers() { return regs_; }
+  const CpuRegisters& registers() const { return regs_; }
+
+  // Executes one instruction and returns its cycle count. Does nothing once
+  // the CPU halted.
+  int Step();
+
+  CpuHalt halt() const { return halt_; }
+  uint8_t last_opcode() const { return last_opcode_; }
+  uint64_t cycles() const { return cycles_; }
+  uint64_t instructions() const { return instructions_; }
+
+ private:
+  bool MemoryWide() const { return !(regs_.p & kFlagM); }
+  bool IndexWide() const { return !(regs_.p & kFlagX); }
+
+  // Resolves the operand of a memory instruction to a 24-bit address and
+  // adds the direct page penalty to *cycles.
+  uint32_t OperandAddress(AddrMode mode, int* cycles);
+
+  uint8_t Read8(uint32_t address) const;
+  uint16_t Read16(uint32_t address) const;
+  uint16_t ReadBank0_16(uint16_t address) const;
+  void Write8(uint32_t address, uint8_t value);
+  void Write16(uint32_t address, uint16_t value);
+  uint8_t Fetch8();
+  uint16_t Fetch16();
+  uint32_t Fetch24();
+
+  void Push8(uint8_t value);
+  void Push16(uint16_t value);
+  uint8_t Pull8();
+  uint16_t Pull16();
+
+  void SetNZ(uint16_t value, bool wide);
+  void SetP(uint8_t value);
+
+  void Adc(uint16_t operand);
+  void Sbc(uint16_t operand);
+  void Compare(uint16_t reg, uint16_t operand, bool wide);
+
+  SparseMemory* memory_;
+  CpuRegisters regs_;
+  CpuHalt halt_ = CpuHalt::kNone;
+  uint8_t last_opcode_ = 0;
+  uint64_t cycles_ = 0;
+  uint64_t instructions_ = 0;
+};
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_CPU65816_H
@@ -2,8 +2,12 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <optional>
+#include <random>
 #include <regex>
 #include <sstream>
 #include <unordered_map>
@@ -269,6 +273,164 @@ void AppendDiagnosticJson(const Diagnostic& diag, std::ostringstream* out) {
   *out << "}";
 }
 
+struct WatchEntry {
+  std::string label;
+  std::optional<uint32_t> address;
+  std::string format;
+  std::string note;
+};
+
+std::unordered_map<std::string, uint32_t> BuildLabelAddressIndex(
+    const AssembleResult& result) {
+  std::unordered_map<std::string, uint32_t> label_index;
+  label_index.reserve(result.labels.size());
+  for (const auto& label : result.labels) {
+    if (label.name.empty()) {
+      continue;
+    }
+    if (label_index.find(label.name) == label_index.end()) {
+      label_index[label.name] = label.address;
+    }
+  }
+  return label_index;
+}
+
+std::unordered_map<int, std::vector<std::string>> ReadSourceFiles(
+    const AssembleResult& result) {
+  std::unordered_map<int, std::vector<std::string>> file_lines;
+  for (const auto& file : result.source_map.files) {
+    std::ifstream in(file.path);
+    if (!in.is_open()) {
+      continue;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+      lines.push_back(line);
+    }
+    file_lines[file.id] = std::move(lines);
+  }
+  return file_lines;
+}
+
+// `line` carries a @watch tag in `comment`; the watched symbol is the
+// equate or label defined on the same line.
+WatchEntry ParseWatchLine(const std::string& line, const std::string& comment,
+                          const std::unordered_map<std::string, uint32_t>& label_index) {
+  static const std::regex define_re(R"(^\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*(\$[0-9A-Fa-f]{4,6}))");
+  static const std::regex label_re(R"(^\s*([A-Za-z_][A-Za-z0-9_.]*)\s*:)");
+  static const std::regex fmt_re(R"(fmt=([a-zA-Z]+))");
+
+  WatchEntry watch;
+  watch.note = comment;
+  std::smatch match;
+  if (std::regex_search(line, match, define_re) && match.size() >= 3) {
+    watch.label = match[1].str();
+    auto parsed = ParseInt(match[2].str());
+    if (parsed.has_value()) {
+      watch.address = static_cast<uint32_t>(*parsed);
+    }
+  } else if (std::regex_search(line, match, label_re) && match.size() >= 2) {
+    watch.label = match[1].str();
+    auto label_it = label_index.find(watch.label);
+    if (label_it != label_index.end()) {
+      watch.address = label_it->second;
+    }
+  }
+  if (std::regex_search(comment, match, fmt_re) && match.size() >= 2) {
+    watch.format = match[1].str();
+  }
+  return watch;
+}
+
+// Resolved @watch entries in source order, one per address.
+std::vector<WatchEntry> CollectWatches(const AssembleResult& result) {
+  auto label_index = BuildLabelAddressIndex(result);
+  auto file_lines = ReadSourceFiles(result);
+  std::vector<WatchEntry> watches;
+  std::unordered_map<uint32_t, bool> seen;
+  for (const auto& file : result.source_map.files) {
+    auto it = file_lines.find(file.id);
+    if (it == file_lines.end()) {
+      continue;
+    }
+    for (const std::string& line : it->second) {
+      auto semicolon = line.find(';');
+      if (semicolon == std::string::npos) {
+        continue;
+      }
+      std::string comment = Trim(line.substr(semicolon + 1));
+      if (comment.find("@watch") == std::string::npos) {
+        continue;
+      }
+      WatchEntry watch = ParseWatchLine(line, comment, label_index);
+      if (!watch.address.has_value() || seen[*watch.address]) {
+        continue;
+      }
+      seen[*watch.address] = true;
+      watches.push_back(std::move(watch));
+    }
+  }
+  return watches;
+}
+
+struct LabelIndexRow {
+  const Label* label = nullptr;
+  const std::string* file = nullptr;
+  int line = 0;
+};
+
+std::vector<LabelIndexRow> BuildLabelIndex(const AssembleResult& result) {
+  std::unordered_map<int, const std::string*> files;
+  for (const auto& file : result.source_map.files) {
+    files[file.id] = &file.path;
+  }
+  // the first entry at an address is the line right after the label
+  std::unordered_map<uint32_t, const SourceMapEntry*> first_entry;
+  for (const auto& entry : result.source_map.entries) {
+    first_entry.emplace(entry.address, &entry);
+  }
+
+  std::vector<LabelIndexRow> rows;
+  rows.reserve(result.labels.size());
+  for (const auto& label : result.labels) {
+    LabelIndexRow row;
+    row.label = &label;
+    auto it = first_entry.find(label.address);
+    if (it != first_entry.end()) {
+      auto file_it = files.find(it->second->file_id);
+      if (file_it != files.end()) {
+        row.file = file_it->second;
+        row.line = it->second->line;
+      }
+    }
+    rows.push_back(row);
+  }
+  std::sort(rows.begin(), rows.end(),
+            [](const LabelIndexRow& a, const LabelIndexRow& b) {
+              if (a.label->address != b.label->address) {
+                return a.label->address < b.label->address;
+              }
+              return a.label->name < b.label->name;
+            });
+  return rows;
+}
+
+std::string EscapeCsv(std::string_view text) {
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+    return std::string(text);
+  }
+  std::string out = "\"";
+  for (char c : text) {
+    if (c == '"') {
+      out.push_back('"');
+    }
+    out.push_back(c);
+  }
+  out.push_back('"');
+  return out;
+}
+
 }  // namespace
 
 std::string DiagnosticsToJson(const AssembleResult& result) {
@@ -345,34 +507,8 @@ std::string DiagnosticsListToJson(const std::vector<Diagnostic>& diagnostics,
 }
 
 std::string AnnotationsToJson(const AssembleResult& result) {
-  std::unordered_map<std::string, uint32_t> label_index;
-  label_index.reserve(result.labels.size());
-  for (const auto& label : result.labels) {
-    if (label.name.empty()) {
-      continue;
-    }
-    if (label_index.find(label.name) == label_index.end()) {
-      label_index[label.name] = label.address;
-    }
-  }
-
-  std::unordered_map<int, std::vector<std::string>> file_lines;
-  for (const auto& file : result.source_map.files) {
-    std::ifstream in(file.path);
-    if (!in.is_open()) {
-      continue;
-    }
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(in, line)) {
-      lines.push_back(line);
-    }
-    file_lines[file.id] = std::move(lines);
-  }
-
-  const std::regex define_re(R"(^\s*([A-Za-z_][A-Za-z0-9_]*)\s*=\s*(\$[0-9A-Fa-f]{4,6}))");
-  const std::regex label_re(R"(^\s*([A-Za-z_][A-Za-z0-9_.]*)\s*:)");
-  const std::regex fmt_re(R"(fmt=([a-zA-Z]+))");
+  auto label_index = BuildLabelAddressIndex(result);
+  auto file_lines = ReadSourceFiles(result);
 
   std::ostringstream out;
   out << "{\"version\":1,\"annotations\":[";
@@ -438,28 +574,8 @@ std::string AnnotationsToJson(const AssembleResult& result) {
       };
 
       if (has_watch) {
-        std::string label;
-        std::optional<uint32_t> addr;
-        std::smatch match;
-        if (std::regex_search(line, match, define_re) && match.size() >= 3) {
-          label = match[1].str();
-          auto parsed = ParseInt(match[2].str());
-          if (parsed.has_value()) {
-            addr = static_cast<uint32_t>(*parsed);
-          }
-        } else if (std::regex_search(line, match, label_re) && match.size() >= 2) {
-          label = match[1].str();
-          auto label_it = label_index.find(label);
-          if (label_it != label_index.end()) {
-            addr = label_it->second;
-          }
-        }
-
-        std::string format;
-        if (std::regex_search(comment, match, fmt_re) && match.size() >= 2) {
-          format = match[1].str();
-        }
-        emit_entry("watch", label, addr, format, comment, "");
+        WatchEntry watch = ParseWatchLine(line, comment, label_index);
+        emit_entry("watch", watch.label, watch.address, watch.format, comment, "");
       }
 
       if (has_assert) {
@@ -712,22 +828,140 @@ std::string SymbolsToMlb(const std::vector<Label>& labels) {
   return out.str();
 }
 
+std::string LabelIndexToCsv(const AssembleResult& result) {
+  // address comes first so z3disasm --labels can read the file as-is
+  std::ostringstream out;
+  out << "address,label,file,line,used\n";
+  char address[16];
+  for (const auto& row : BuildLabelIndex(result)) {
+    std::snprintf(address, sizeof(address), "$%02X:%04X",
+                  (row.label->address >> 16) & 0xFF, row.label->address & 0xFFFF);
+    out << address << ',' << EscapeCsv(row.label->name) << ',';
+    if (row.file) {
+      out << EscapeCsv(*row.file) << ',' << row.line;
+    } else {
+      out << ',';
+    }
+    out << ',' << (row.label->used ? "1" : "0") << "\n";
+  }
+  return out.str();
+}
+
+std::string LabelIndexToJson(const AssembleResult& result) {
+  std::ostringstream out;
+  out << "{\"version\":1,\"labels\":[";
+  bool first = true;
+  char address[16];
+  for (const auto& row : BuildLabelIndex(result)) {
+    if (!first) {
+      out << ',';
+    }
+    first = false;
+    std::snprintf(address, sizeof(address), "0x%06X", row.label->address & 0xFFFFFF);
+    out << "{\"name\":\"" << EscapeJson(row.label->name) << "\",\"address\":\""
+        << address << "\"";
+    if (row.file) {
+      out << ",\"file\":\"" << EscapeJson(*row.file) << "\",\"line\":" << row.line;
+    }
+    out << ",\"used\":" << (row.label->used ? "true" : "false") << "}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+std::string WatchesToJson(const AssembleResult& result) {
+  std::ostringstream out;
+  out << "{\"version\":1,\"watches\":[";
+  bool first = true;
+  char address[16];
+  for (const auto& watch : CollectWatches(result)) {
+    if (!first) {
+      out << ',';
+    }
+    first = false;
+    std::snprintf(address, sizeof(address), "%06X", *watch.address & 0xFFFFFF);
+    out << "{\"label\":\"" << EscapeJson(watch.label) << "\",\"address\":\"0x"
+        << address << "\",\"expression\":\"[$" << address << "]\"";
+    if (!watch.format.empty()) {
+      out << ",\"format\":\"" << EscapeJson(watch.format) << "\"";
+    }
+    out << "}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+std::string WatchesToText(const AssembleResult& result) {
+  std::ostringstream out;
+  char address[16];
+  for (const auto& watch : CollectWatches(result)) {
+    std::snprintf(address, sizeof(address), "$%06X", *watch.address & 0xFFFFFF);
+    out << address << ' ' << watch.label;
+    if (watch.format == "hex" || watch.format == "dec" || watch.format == "bin") {
+      out << ' ' << watch.format;
+    }
+    out << "\n";
+  }
+  return out.str();
+}
+
 bool WriteTextFile(const std::string& path, std::string_view contents,
                    std::string* error) {
-  std::ofstream file(path, std::ios::binary);
-  if (!file.is_open()) {
+  // emulators and build watchers pick these files up as soon as they
+  // change; writing a temp file and renaming it over the target means
+  // they only ever see the old contents or the new ones
+  std::string temp = path + ".tmp" + std::to_string(std::random_device{}());
+  {
+    std::ofstream file(temp, std::ios::binary);
+    if (!file.is_open()) {
+      if (error) {
+        *error = "Unable to write file: " + path;
+      }
+      return false;
+    }
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!file.good()) {
+      file.close();
+      std::error_code ec;
+      std::filesystem::remove(temp, ec);
+      if (error) {
+        *error = "Failed to write file: " + path;
+      }
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
     if (error) {
       *error = "Unable to write file: " + path;
     }
     return false;
   }
-  file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
-  if (!file.good()) {
-    if (error) {
-      *error = "Failed to write file: " + path;
+  return true;
+}
+
+bool WriteTextFileIfChanged(const std::string& path, std::string_view contents,
+                            bool* written, std::string* error) {
+  if (written) {
+    *written = false;
+  }
+  std::ifstream existing(path, std::ios::binary);
+  if (existing.is_open()) {
+    std::string current((std::istreambuf_iterator<char>(existing)),
+                        std::istreambuf_iterator<char>());
+    if (current == contents) {
+      return true;
     }
+  }
+  existing.close();
+  if (!WriteTextFile(path, contents, error)) {
     return false;
   }
+  if (written) {
+    *written = true;
+  }
   return true;
 }
 
@@ -16,9 +16,25 @@ std::string HooksToJson(const AssembleResult& result, const std::string& rom_pat
 std::string AnnotationsToJson(const AssembleResult& result);
 std::string SourceMapToJson(const SourceMap& map);
 std::string SymbolsToMlb(const std::vector<Label>& labels);
+// Label -> source index built from result.labels and result.source_map. A
+// label's location is the first line that emitted code at its address, so
+// labels that never precede code (RAM equates, empty regions) have none.
+std::string LabelIndexToCsv(const AssembleResult& result);
+std::string LabelIndexToJson(const AssembleResult& result);
+// `; @watch fmt=hex` entries as JSON, and as the "$7E0010 Label hex" lines
+// the Mesen2 watch import (and scripts/generate_watch.py) use.
+std::string WatchesToJson(const AssembleResult& result);
+std::string WatchesToText(const AssembleResult& result);
 
+// Writes through a temp file renamed over `path`, so readers never see a
+// partial file. Safe to call from several threads for different paths.
 bool WriteTextFile(const std::string& path, std::string_view contents,
                    std::string* error);
+// Writes `contents` only when the file on disk differs, so
+// unchanged symbol/watch files keep their mtime and don't trigger emulator
+// reloads. *written reports whether the file was rewritten.
+bool WriteTextFileIfChanged(const std::string& path, std::string_view contents,
+                            bool* written, std::string* error);
 
 }  // namespace z3dk
 
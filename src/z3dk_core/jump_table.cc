@@ -0,0 +1,240 @@
+#include "z3dk_core/jump_table.h"
+
+#include <algorithm>
+#include <string_view>
+
+#include "z3dk_core/opcode_table.h"
+
+namespace z3dk {
+namespace {
+
+bool EndsStraightLine(uint8_t opcode) {
+  switch (opcode) {
+    case 0x00:  // BRK
+    case 0x40:  // RTI
+    case 0x4C:  // JMP abs
+    case 0x5C:  // JML long
+    case 0x60:  // RTS
+    case 0x6B:  // RTL
+    case 0x6C:  // JMP (abs)
+    case 0x7C:  // JMP (abs,X)
+    case 0x80:  // BRA
+    case 0x82:  // BRL
+    case 0xDB:  // STP
+    case 0xDC:  // JML [abs]
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ChangesCarry(std::string_view mnemonic) {
+  static constexpr std::string_view kCarry[] = {
+      "ADC", "SBC", "CMP", "CPX", "CPY", "ASL", "LSR", "ROL", "ROR",
+      "CLC", "SEC", "REP", "SEP", "PLP", "XCE", "RTI"};
+  return std::find(std::begin(kCarry), std::end(kCarry), mnemonic) !=
+         std::end(kCarry);
+}
+
+bool WritesA(std::string_view mnemonic, AddrMode mode) {
+  static constexpr std::string_view kAlways[] = {
+      "ADC", "SBC", "ORA", "EOR", "AND", "LDA", "PLA", "XBA", "TDC", "TSC",
+      "TXA", "TYA", "JSR", "JSL", "MVN", "MVP"};
+  if (std::find(std::begin(kAlways), std::end(kAlways), mnemonic) !=
+      std::end(kAlways)) {
+    return true;
+  }
+  static constexpr std::string_view kAccumulator[] = {"ASL", "LSR", "ROL",
+                                                      "ROR", "INC", "DEC"};
+  return mode == AddrMode::kImplied &&
+         std::find(std::begin(kAccumulator), std::end(kAccumulator), mnemonic) !=
+             std::end(kAccumulator);
+}
+
+bool WritesX(std::string_view mnemonic) {
+  static constexpr std::string_view kWrites[] = {
+      "LDX", "TAX", "TYX", "TSX", "PLX", "INX", "DEX", "JSR", "JSL", "MVN",
+      "MVP"};
+  return std::find(std::begin(kWrites), std::end(kWrites), mnemonic) !=
+         std::end(kWrites);
+}
+
+std::optional<uint32_t> Min(std::optional<uint32_t> bound, uint32_t value) {
+  return bound.has_value() ? std::min(*bound, value) : value;
+}
+
+}  // namespace
+
+void InstructionHistory::Push(const InstructionRecord& record) {
+  if (reset_next_) {
+    records_.clear();
+  }
+  records_.push_back(record);
+  if (records_.size() > kMaxRecords) {
+    records_.erase(records_.begin());
+  }
+  reset_next_ = EndsStraightLine(record.opcode);
+}
+
+bool IsJumpTableDispatch(uint8_t opcode) {
+  return opcode == 0x7C || opcode == 0xFC;
+}
+
+std::optional<uint32_t> InferIndexBound(
+    const std::vector<InstructionRecord>& history) {
+  std::optional<uint32_t> a;
+  std::optional<uint32_t> x;
+  enum class Compared { kNone, kA, kX } compared = Compared::kNone;
+  uint32_t compared_value = 0;
+
+  size_t count = history.empty() ? 0 : history.size() - 1;
+  for (size_t i = 0; i < count; ++i) {
+    const InstructionRecord& record = history[i];
+    const OpcodeInfo& info = GetOpcodeInfo(record.opcode);
+    std::string_view mnemonic = info.mnemonic;
+    const bool immediate = info.mode == AddrMode::kImmediateM ||
+                           info.mode == AddrMode::kImmediateX;
+    const uint32_t a_mask = record.m_width == 2 ? 0xFFFF : 0xFF;
+    const uint32_t x_mask = record.x_width == 2 ? 0xFFFF : 0xFF;
+
+    if (mnemonic == "BCS") {
+      // falling through means the compared register was below the operand
+      if (compared == Compared::kA && compared_value > 0) {
+        a = Min(a, compared_value - 1);
+      } else if (compared == Compared::kX && compared_value > 0) {
+        x = Min(x, compared_value - 1);
+      }
+      compared = Compared::kNone;
+      continue;
+    }
+    if (mnemonic == "CMP" && immediate) {
+      compared = Compared::kA;
+      compared_value = record.operand & a_mask;
+      continue;
+    }
+    if (mnemonic == "CPX" && immediate) {
+      compared = Compared::kX;
+      compared_value = record.operand & x_mask;
+      continue;
+    }
+    if (ChangesCarry(mnemonic)) {
+      compared = Compared::kNone;
+    }
+
+    if (WritesA(mnemonic, info.mode)) {
+      if (compared == Compared::kA) {
+        compared = Compared::kNone;
+      }
+      if (mnemonic == "LDA" && immediate) {
+        a = record.operand & a_mask;
+      } else if (mnemonic == "AND") {
+        // A & anything never exceeds A, and never exceeds an immediate mask
+        if (immediate) {
+          a = Min(a, record.operand & a_mask);
+        }
+      } else if (mnemonic == "ASL") {
+        if (a.has_value() && *a * 2 <= a_mask) {
+          a = *a * 2;
+        } else {
+          a.reset();
+        }
+      } else if (mnemonic == "LSR") {
+        if (a.has_value()) {
+          a = *a / 2;
+        }
+      } else if (mnemonic == "TXA") {
+        a = x;
+      } else {
+        a.reset();
+      }
+    }
+    if (WritesX(mnemonic)) {
+      if (compared == Compared::kX) {
+        compared = Compared::kNone;
+      }
+      if (mnemonic == "LDX" && immediate) {
+        x = record.operand & x_mask;
+      } else if (mnemonic == "TAX") {
+        x = a.has_value() ? std::optional<uint32_t>(*a & x_mask) : std::nullopt;
+      } else if (mnemonic == "INX" && x.has_value() && *x < x_mask) {
+        x = *x + 1;
+      } else {
+        x.reset();
+      }
+    }
+  }
+  return x;
+}
+
+std::optional<JumpTable> RecoverJumpTable(
+    const std::vector<InstructionRecord>& history, const RomByteReader& read,
+    const JumpTableOptions& options) {
+  if (history.empty() || !IsJumpTableDispatch(history.back().opcode)) {
+    return std::nullopt;
+  }
+  const InstructionRecord& dispatch = history.back();
+  const uint32_t bank = dispatch.address & 0xFF0000;
+
+  JumpTable table;
+  table.dispatch = dispatch.address;
+  table.table = bank | (dispatch.operand & 0xFFFF);
+  table.m_width = dispatch.m_width;
+  table.x_width = dispatch.x_width;
+
+  int count = options.max_entries;
+  std::optional<uint32_t> bound = InferIndexBound(history);
+  if (bound.has_value() && static_cast<int>(*bound / 2 + 1) <= options.max_entries) {
+    table.bounded = true;
+    count = static_cast<int>(*bound / 2 + 1);
+  }
+
+  auto inside_history = [&](uint32_t address) {
+    for (const auto& record : history) {
+      if (address + 1 >= record.address &&
+          address < record.address + 1 + static_cast<uint32_t>(record.operand_size)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  uint32_t first_code = 0xFFFFFFFF;
+  for (int i = 0; i < count; ++i) {
+    uint32_t address = table.table + static_cast<uint32_t>(i) * 2;
+    if ((address & 0xFFFF) > 0xFFFE || (address & 0xFF0000) != bank) {
+      break;
+    }
+    int lo = read(address);
+    int hi = read(address + 1);
+    if (lo < 0 || hi < 0) {
+      break;
+    }
+    JumpTableEntry entry;
+    entry.target = bank | static_cast<uint32_t>(lo | hi << 8);
+    int first_opcode = read(entry.target);
+    entry.in_rom = first_opcode >= 0;
+    if (!table.bounded) {
+      // stop once the entries run into code (often the first target) or stop
+      // looking like pointers to routines
+      if (address >= first_code || inside_history(address)) {
+        break;
+      }
+      if (!entry.in_rom || first_opcode == 0x00 || first_opcode == 0xFF) {
+        break;
+      }
+      if (entry.target >= table.table && entry.target < address + 2) {
+        break;
+      }
+    }
+    if (entry.target > table.table) {
+      first_code = std::min(first_code, entry.target);
+    }
+    table.entries.push_back(entry);
+  }
+  if (table.entries.empty()) {
+    return std::nullopt;
+  }
+  return table;
+}
+
+}  // namespace z3dk
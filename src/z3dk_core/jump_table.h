@@ -0,0 +1,82 @@
+#ifndef Z3DK_CORE_JUMP_TABLE_H
+#define Z3DK_CORE_JUMP_TABLE_H
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace z3dk {
+
+// One decoded instruction, as seen by a linear decoder.
+struct InstructionRecord {
+  uint32_t address = 0;  // SNES address
+  uint8_t opcode = 0;
+  uint32_t operand = 0;  // little-endian operand value
+  int operand_size = 0;
+  int m_width = 1;  // bytes, at the time the instruction ran
+  int x_width = 1;
+};
+
+// The straight-line instructions leading up to the current one. Control
+// flow that doesn't fall through (RTS, JMP, BRA, ...) starts a new window.
+class InstructionHistory {
+ public:
+  static constexpr size_t kMaxRecords = 16;
+
+  void Push(const InstructionRecord& record);
+  void Clear() {
+    records_.clear();
+    reset_next_ = false;
+  }
+  const std::vector<InstructionRecord>& records() const { return records_; }
+
+ private:
+  std::vector<InstructionRecord> records_;
+  bool reset_next_ = false;
+};
+
+struct JumpTableEntry {
+  uint32_t target = 0;  // SNES address in the dispatch bank
+  bool in_rom = false;
+};
+
+// A pointer table used by JMP (abs,X) or JSR (abs,X).
+struct JumpTable {
+  uint32_t dispatch = 0;  // address of the JMP/JSR
+  uint32_t table = 0;     // address of the first entry
+  // True when the entry count comes from a CMP/AND/ASL bound on the index
+  // rather than from scanning until the entries stop looking like code.
+  bool bounded = false;
+  int m_width = 1;  // register widths at the dispatch, inherited by entries
+  int x_width = 1;
+  std::vector<JumpTableEntry> entries;
+
+  uint32_t end() const {
+    return table + static_cast<uint32_t>(entries.size()) * 2;
+  }
+};
+
+struct JumpTableOptions {
+  // Cap for tables whose index can't be bounded (and for absurd bounds).
+  int max_entries = 256;
+};
+
+// Returns a ROM byte for a SNES address, or -1 when it isn't ROM.
+using RomByteReader = std::function<int(uint32_t)>;
+
+bool IsJumpTableDispatch(uint8_t opcode);
+
+// Upper bound of X at the end of `history`, derived from LDX/TAX and the
+// LDA/AND/ASL/CMP+BCS/CPX+BCS instructions before it.
+std::optional<uint32_t> InferIndexBound(
+    const std::vector<InstructionRecord>& history);
+
+// Recovers the table behind history.back(), which must be a JMP/JSR (abs,X).
+std::optional<JumpTable> RecoverJumpTable(
+    const std::vector<InstructionRecord>& history, const RomByteReader& read,
+    const JumpTableOptions& options = {});
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_JUMP_TABLE_H
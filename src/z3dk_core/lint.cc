@@ -3,11 +3,15 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstdio>
+#include <map>
 #include <optional>
 #include <string>
 #include <unordered_map>
 
+#include "z3dk_core/cpu65816.h"
+#include "z3dk_core/jump_table.h"
 #include "z3dk_core/opcode_table.h"
+#include "z3dk_core/source_index.h"
 
 namespace z3dk {
 namespace {
@@ -19,57 +23,13 @@ struct WidthState {
   bool x_known = true;
 };
 
-struct SourceIndex {
-  std::unordered_map<int, std::string> files;
-  std::vector<SourceMapEntry> entries;
-};
-
-SourceIndex BuildSourceIndex(const SourceMap& map) {
-  SourceIndex index;
-  for (const auto& file : map.files) {
-    index.files[file.id] = file.path;
-  }
-  index.entries = map.entries;
-  std::sort(index.entries.begin(), index.entries.end(),
-            [](const SourceMapEntry& a, const SourceMapEntry& b) {
-              if (a.address != b.address) {
-                return a.address < b.address;
-              }
-              return a.line < b.line;
-            });
-  return index;
-}
-
-const SourceMapEntry* FindEntry(const SourceIndex& index, uint32_t address) {
-  if (index.entries.empty()) {
-    return nullptr;
-  }
-  auto it = std::upper_bound(index.entries.begin(), index.entries.end(), address,
-                             [](uint32_t addr, const SourceMapEntry& entry) {
-                               return addr < entry.address;
-                             });
-  if (it == index.entries.begin()) {
-    return nullptr;
-  }
-  --it;
-  return &(*it);
-}
-
 void AddDiagnostic(LintResult* out, DiagnosticSeverity severity,
                    const std::string& message, uint32_t address,
                    const SourceIndex& sources) {
   Diagnostic diag;
   diag.severity = severity;
   diag.message = message;
-  const SourceMapEntry* entry = FindEntry(sources, address);
-  if (entry) {
-    auto it = sources.files.find(entry->file_id);
-    if (it != sources.files.end()) {
-      diag.filename = it->second;
-    }
-    diag.line = entry->line;
-    diag.column = 1;
-  }
+  LocateDiagnostic(sources, address, &diag);
   out->diagnostics.push_back(std::move(diag));
 }
 
@@ -204,10 +164,24 @@ LintResult RunLint(const AssembleResult& result, const LintOptions& options) {
     }
   }
 
+  // Jump tables found so far; their bytes aren't decoded and their entries
+  // start with the register widths of the dispatch.
+  const RomMapper mapper = static_cast<RomMapper>(result.mapper);
+  RomByteReader read_rom = [&](uint32_t address) {
+    int offset = SnesToRomOffset(address, mapper);
+    if (offset < 0 || offset >= static_cast<int>(result.rom_data.size())) {
+      return -1;
+    }
+    return static_cast<int>(result.rom_data[offset]);
+  };
+  std::map<uint32_t, JumpTable> jump_tables;
+  std::map<uint32_t, std::pair<int, int>> jump_entries;
+
   for (const auto& block : result.written_blocks) {
     if (block.num_bytes <= 0) {
       continue;
     }
+    InstructionHistory history;
     int pc = block.pc_offset;
     int end = block.pc_offset + block.num_bytes;
     if (pc < 0 || end > static_cast<int>(result.rom_data.size())) {
@@ -222,6 +196,23 @@ LintResult RunLint(const AssembleResult& result, const LintOptions& options) {
     widths.x_known = options.default_x_width_bytes > 0;
 
     while (pc < end) {
+      auto table_it = jump_tables.find(snes);
+      if (table_it != jump_tables.end()) {
+        uint32_t size = table_it->second.end() - table_it->second.table;
+        pc += static_cast<int>(size);
+        snes += size;
+        history.Clear();
+        continue;
+      }
+      auto entry_it = jump_entries.find(snes);
+      if (entry_it != jump_entries.end()) {
+        widths.m_width = entry_it->second.first;
+        widths.x_width = entry_it->second.second;
+        widths.m_known = true;
+        widths.x_known = true;
+        history.Clear();
+      }
+
       uint8_t opcode = result.rom_data[pc];
       
       // Apply state overrides
@@ -284,6 +275,37 @@ LintResult RunLint(const AssembleResult& result, const LintOptions& options) {
         }
       }
 
+      InstructionRecord record;
+      record.address = snes;
+      record.opcode = opcode;
+      record.operand_size = operand_size;
+      for (int i = 0; i < operand_size; ++i) {
+        record.operand |= static_cast<uint32_t>(result.rom_data[pc + 1 + i]) << (8 * i);
+      }
+      record.m_width = m_width;
+      record.x_width = x_width;
+      history.Push(record);
+      if (IsJumpTableDispatch(opcode)) {
+        auto table = RecoverJumpTable(history.records(), read_rom);
+        if (table.has_value() && !jump_tables.count(table->table)) {
+          for (size_t i = 0; i < table->entries.size(); ++i) {
+            const JumpTableEntry& entry = table->entries[i];
+            if (entry.in_rom) {
+              jump_entries.emplace(entry.target,
+                                   std::make_pair(table->m_width, table->x_width));
+            } else if (options.warn_jump_table && table->bounded) {
+              char buffer[96];
+              std::snprintf(buffer, sizeof(buffer),
+                            "Jump table at $%06X entry %zu points outside ROM ($%04X)",
+                            table->table, i, entry.target & 0xFFFF);
+              AddDiagnostic(&out, DiagnosticSeverity::kWarning, buffer, snes,
+                            sources);
+            }
+          }
+          jump_tables.emplace(table->table, *table);
+        }
+      }
+
       if (info.mnemonic == std::string("REP") && operand_size == 1) {
         uint8_t mask = result.rom_data[pc + 1];
         if (mask & 0x20) {
@@ -22,6 +22,8 @@ struct LintOptions {
   bool warn_org_collision = true;
   bool warn_unused_symbols = true;
   bool warn_unauthorized_hook = true;
+  // Bounded JMP/JSR (abs,X) tables with entries outside ROM.
+  bool warn_jump_table = true;
   int warn_bank_full_percent = 0; // e.g. 95 for 95%
   std::vector<Hook> known_hooks;
   std::vector<MemoryRange> prohibited_memory_ranges;
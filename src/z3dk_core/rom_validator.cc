@@ -0,0 +1,704 @@
+#include "z3dk_core/rom_validator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "nlohmann/json.hpp"
+#include "z3dk_core/cpu65816.h"
+#include "z3dk_core/source_index.h"
+
+namespace z3dk {
+namespace {
+
+using json = nlohmann::json;
+
+// entries per work item; small enough to spread one big table over every
+// worker, big enough that the bookkeeping doesn't show
+constexpr int kChunkEntries = 64;
+// blank record indices listed in the summary warning
+constexpr size_t kBlankSample = 10;
+
+std::string Hex(uint32_t value, int digits) {
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "%0*X", digits, value);
+  return buffer;
+}
+
+bool ParseNumber(const json& value, int64_t* out) {
+  if (value.is_number_integer()) {
+    *out = value.get<int64_t>();
+    return true;
+  }
+  if (!value.is_string()) {
+    return false;
+  }
+  std::string text = value.get<std::string>();
+  int base = 10;
+  size_t start = 0;
+  if (!text.empty() && text[0] == '$') {
+    base = 16;
+    start = 1;
+  } else if (text.rfind("0x", 0) == 0 || text.rfind("0X", 0) == 0) {
+    base = 16;
+    start = 2;
+  }
+  if (start >= text.size()) {
+    return false;
+  }
+  size_t used = 0;
+  try {
+    *out = std::stoll(text.substr(start), &used, base);
+  } catch (...) {
+    return false;
+  }
+  return start + used == text.size();
+}
+
+// Reads object[key] into *out when present. Fails on a value that isn't a
+// number in [min, max].
+template <typename T>
+bool ReadNumber(const json& object, const char* key, int64_t min, int64_t max,
+                T* out, const std::string& where, std::string* error) {
+  auto it = object.find(key);
+  if (it == object.end()) {
+    return true;
+  }
+  int64_t value = 0;
+  if (!ParseNumber(*it, &value) || value < min || value > max) {
+    *error = where + ": bad " + key;
+    return false;
+  }
+  *out = static_cast<T>(value);
+  return true;
+}
+
+bool ReadBytes(const json& object, const char* key,
+               std::vector<uint8_t>* out, const std::string& where,
+               std::string* error) {
+  auto it = object.find(key);
+  if (it == object.end()) {
+    return true;
+  }
+  if (!it->is_array() || it->empty()) {
+    *error = where + ": " + key + " must be a list of bytes";
+    return false;
+  }
+  out->clear();
+  for (const auto& item : *it) {
+    int64_t value = 0;
+    if (!ParseNumber(item, &value) || value < 0 || value > 0xFF) {
+      *error = where + ": " + key + " must be a list of bytes";
+      return false;
+    }
+    out->push_back(static_cast<uint8_t>(value));
+  }
+  return true;
+}
+
+bool CheckKeys(const json& object, std::initializer_list<const char*> keys,
+               const std::string& where, std::string* error) {
+  if (!object.is_object()) {
+    *error = where + ": expected an object";
+    return false;
+  }
+  for (const auto& [key, value] : object.items()) {
+    if (std::find_if(keys.begin(), keys.end(), [&](const char* known) {
+          return key == known;
+        }) == keys.end()) {
+      *error = where + ": unknown key '" + key + "'";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParseSeverity(const json& object, DiagnosticSeverity* severity,
+                   const std::string& where, std::string* error) {
+  auto it = object.find("severity");
+  if (it == object.end()) {
+    return true;
+  }
+  if (*it == "error") {
+    *severity = DiagnosticSeverity::kError;
+  } else if (*it == "warning") {
+    *severity = DiagnosticSeverity::kWarning;
+  } else {
+    *error = where + ": severity must be \"error\" or \"warning\"";
+    return false;
+  }
+  return true;
+}
+
+bool ParseStream(const json& object, RomStreamSchema* stream,
+                 const std::string& where, std::string* error) {
+  if (!CheckKeys(object,
+                 {"skip", "element_size", "terminator", "terminators",
+                  "markers", "max_bytes"},
+                 where, error) ||
+      !ReadNumber(object, "skip", 0, 0xFFFF, &stream->skip, where, error) ||
+      !ReadNumber(object, "element_size", 1, 0xFF, &stream->element_size,
+                  where, error) ||
+      !ReadBytes(object, "terminator", &stream->terminator, where, error) ||
+      !ReadNumber(object, "terminators", 1, 0xFF, &stream->terminators, where,
+                  error) ||
+      !ReadNumber(object, "max_bytes", 0, 0x1000000, &stream->max_bytes,
+                  where, error)) {
+    return false;
+  }
+  if (stream->terminator.empty()) {
+    *error = where + ": a stream needs a terminator";
+    return false;
+  }
+  auto markers = object.find("markers");
+  if (markers == object.end()) {
+    return true;
+  }
+  if (!markers->is_array()) {
+    *error = where + ": markers must be a list";
+    return false;
+  }
+  for (const auto& item : *markers) {
+    RomStreamMarker marker;
+    std::string marker_where = where + " marker";
+    if (!CheckKeys(item, {"bytes", "element_size"}, marker_where, error) ||
+        !ReadBytes(item, "bytes", &marker.bytes, marker_where, error) ||
+        !ReadNumber(item, "element_size", 1, 0xFF, &marker.element_size,
+                    marker_where, error)) {
+      return false;
+    }
+    if (marker.bytes.empty() || marker.element_size == 0) {
+      *error = marker_where + ": needs bytes and element_size";
+      return false;
+    }
+    stream->markers.push_back(std::move(marker));
+  }
+  return true;
+}
+
+bool ParseTable(const json& object, size_t index, RomTableSchema* table,
+                std::string* error) {
+  std::string where = "table " + std::to_string(index);
+  if (!object.is_object()) {
+    *error = where + ": expected an object";
+    return false;
+  }
+  if (auto it = object.find("name"); it != object.end() && it->is_string()) {
+    table->name = it->get<std::string>();
+    where = table->name;
+  } else {
+    *error = where + ": missing name";
+    return false;
+  }
+  if (!CheckKeys(object,
+                 {"name", "address", "pointer", "count", "size", "stride",
+                  "entry_pointer", "bank", "bank_address", "min_bank",
+                  "max_bank", "record_size", "fields", "stream", "warn_blank"},
+                 where, error)) {
+    return false;
+  }
+  bool has_address = object.contains("address");
+  bool has_pointer = object.contains("pointer");
+  if (has_address == has_pointer) {
+    *error = where + ": needs exactly one of address and pointer";
+    return false;
+  }
+  table->indirect = has_pointer;
+  int size = 0;
+  uint32_t bank_address = 0;
+  if (!ReadNumber(object, has_pointer ? "pointer" : "address", 0, 0xFFFFFF,
+                  &table->address, where, error) ||
+      !ReadNumber(object, "count", 0, 0x1000000, &table->count, where, error) ||
+      !ReadNumber(object, "size", 0, 0x1000000, &size, where, error) ||
+      !ReadNumber(object, "stride", 1, 0xFFFF, &table->stride, where, error) ||
+      !ReadNumber(object, "entry_pointer", 0, 3, &table->entry_pointer, where,
+                  error) ||
+      !ReadNumber(object, "bank", 0, 0xFF, &table->bank, where, error) ||
+      !ReadNumber(object, "bank_address", 0, 0xFFFFFF, &bank_address, where,
+                  error) ||
+      !ReadNumber(object, "min_bank", 0, 0xFF, &table->min_bank, where,
+                  error) ||
+      !ReadNumber(object, "max_bank", 0, 0xFF, &table->max_bank, where,
+                  error) ||
+      !ReadNumber(object, "record_size", 0, 0x1000000, &table->record_size,
+                  where, error)) {
+    return false;
+  }
+  if (object.contains("bank_address")) {
+    table->bank_address = bank_address;
+  }
+  if (table->entry_pointer == 1) {
+    *error = where + ": entry_pointer must be 0, 2 or 3";
+    return false;
+  }
+  if (!object.contains("stride") && table->entry_pointer > 0) {
+    table->stride = table->entry_pointer;
+  }
+  if (table->count == 0 && size > 0) {
+    table->count = size / table->stride;
+  }
+  if (table->entry_pointer == 2 && table->bank < 0 && !table->bank_address) {
+    *error = where + ": 2 byte entry pointers need bank or bank_address";
+    return false;
+  }
+  if (auto it = object.find("warn_blank"); it != object.end()) {
+    if (!it->is_boolean()) {
+      *error = where + ": warn_blank must be true or false";
+      return false;
+    }
+    table->warn_blank = it->get<bool>();
+  }
+  if (auto fields = object.find("fields"); fields != object.end()) {
+    if (!fields->is_array()) {
+      *error = where + ": fields must be a list";
+      return false;
+    }
+    for (const auto& item : *fields) {
+      RomFieldCheck field;
+      std::string field_where = where + " field";
+      if (!CheckKeys(item, {"offset", "mask", "message", "severity"},
+                     field_where, error) ||
+          !ReadNumber(item, "offset", 0, 0xFFFF, &field.offset, field_where,
+                      error) ||
+          !ReadNumber(item, "mask", 0, 0xFF, &field.mask, field_where, error) ||
+          !ParseSeverity(item, &field.severity, field_where, error)) {
+        return false;
+      }
+      if (auto message = item.find("message");
+          message != item.end() && message->is_string()) {
+        field.message = message->get<std::string>();
+      } else {
+        field.message = "byte " + std::to_string(field.offset) +
+                        " has bits outside $" + Hex(~field.mask & 0xFF, 2);
+      }
+      table->fields.push_back(std::move(field));
+    }
+  }
+  if (auto stream = object.find("stream"); stream != object.end()) {
+    RomStreamSchema parsed;
+    if (!ParseStream(*stream, &parsed, where + " stream", error)) {
+      return false;
+    }
+    table->stream = std::move(parsed);
+  }
+  return true;
+}
+
+// Everything a chunk of entries needs, worked out once per table.
+struct ResolvedTable {
+  const RomTableSchema* schema = nullptr;
+  bool ok = false;
+  int base_pc = 0;
+  int bank = 0;
+  // bytes each record must have in the ROM
+  int record_size = 0;
+};
+
+struct Finding {
+  DiagnosticSeverity severity;
+  std::string message;
+  int pc;
+};
+
+struct ChunkResult {
+  std::vector<Finding> findings;
+  std::vector<int> blank;
+};
+
+class RomReader {
+ public:
+  RomReader(const std::vector<uint8_t>& rom, RomMapper mapper)
+      : rom_(rom), mapper_(mapper) {}
+
+  int size() const { return static_cast<int>(rom_.size()); }
+  bool Has(int pc, int length) const {
+    return pc >= 0 && length >= 0 && pc <= size() - length;
+  }
+  uint8_t Byte(int pc) const { return rom_[pc]; }
+  uint32_t Value(int pc, int length) const {
+    uint32_t value = 0;
+    for (int i = length - 1; i >= 0; --i) {
+      value = (value << 8) | rom_[pc + i];
+    }
+    return value;
+  }
+  bool Matches(int pc, const std::vector<uint8_t>& bytes) const {
+    return Has(pc, static_cast<int>(bytes.size())) &&
+           std::equal(bytes.begin(), bytes.end(), rom_.begin() + pc);
+  }
+  int ToPc(uint32_t snes) const { return SnesToRomOffset(snes, mapper_); }
+  std::string Describe(int pc) const {
+    int snes = RomOffsetToSnes(pc, mapper_);
+    return snes < 0 ? "PC 0x" + Hex(pc, 6) : "$" + Hex(snes, 6);
+  }
+
+ private:
+  const std::vector<uint8_t>& rom_;
+  RomMapper mapper_;
+};
+
+ResolvedTable ResolveTable(const RomTableSchema& table, const RomReader& rom,
+                           std::vector<Finding>* findings) {
+  ResolvedTable resolved;
+  resolved.schema = &table;
+  auto fail = [&](const std::string& message, int pc) {
+    findings->push_back(
+        {DiagnosticSeverity::kError, table.name + ": " + message, pc});
+    return resolved;
+  };
+
+  uint32_t start = table.address;
+  if (table.indirect) {
+    int pointer_pc = rom.ToPc(table.address);
+    if (!rom.Has(pointer_pc, 3)) {
+      return fail("table pointer $" + Hex(table.address, 6) + " is not in the ROM", -1);
+    }
+    start = rom.Value(pointer_pc, 3);
+    resolved.base_pc = rom.ToPc(start);
+    if (resolved.base_pc < 0) {
+      return fail("table pointer at $" + Hex(table.address, 6) +
+                      " points outside the ROM ($" + Hex(start, 6) + ")",
+                  pointer_pc);
+    }
+  } else {
+    resolved.base_pc = rom.ToPc(start);
+    if (resolved.base_pc < 0) {
+      return fail("table address $" + Hex(start, 6) + " is not in the ROM", -1);
+    }
+  }
+  int64_t table_end =
+      resolved.base_pc + static_cast<int64_t>(table.count) * table.stride;
+  if (table_end > rom.size()) {
+    return fail("table runs past the end of the ROM (" +
+                    std::to_string(table.count) + " entries of " +
+                    std::to_string(table.stride) + " bytes)",
+                resolved.base_pc);
+  }
+
+  if (table.entry_pointer == 2) {
+    resolved.bank = table.bank;
+    if (table.bank_address) {
+      int bank_pc = rom.ToPc(*table.bank_address);
+      if (!rom.Has(bank_pc, 1)) {
+        return fail("bank byte $" + Hex(*table.bank_address, 6) +
+                        " is not in the ROM",
+                    -1);
+      }
+      resolved.bank = rom.Byte(bank_pc);
+    }
+  }
+
+  int needed = std::max(table.record_size, table.entry_pointer == 0 ? table.stride : 1);
+  for (const auto& field : table.fields) {
+    needed = std::max(needed, field.offset + 1);
+  }
+  if (table.stream) {
+    needed = std::max(needed, table.stream->skip);
+  }
+  resolved.record_size = needed;
+  resolved.ok = true;
+  return resolved;
+}
+
+template <typename Label>
+void CheckStream(const RomStreamSchema& stream, const RomReader& rom,
+                 const Label& label, int record_pc,
+                 std::vector<Finding>* findings) {
+  int pc = record_pc + stream.skip;
+  int read = stream.skip;
+  int element_size = stream.element_size;
+  int seen = 0;
+  const int terminator_size = static_cast<int>(stream.terminator.size());
+  bool truncated = false;
+  while (stream.max_bytes == 0 || read < stream.max_bytes) {
+    if (!rom.Has(pc, terminator_size)) {
+      truncated = true;
+      break;
+    }
+    if (rom.Matches(pc, stream.terminator)) {
+      pc += terminator_size;
+      read += terminator_size;
+      element_size = stream.element_size;
+      if (++seen == stream.terminators) {
+        break;
+      }
+      continue;
+    }
+    auto marker = std::find_if(
+        stream.markers.begin(), stream.markers.end(),
+        [&](const RomStreamMarker& m) { return rom.Matches(pc, m.bytes); });
+    if (marker != stream.markers.end()) {
+      pc += static_cast<int>(marker->bytes.size());
+      read += static_cast<int>(marker->bytes.size());
+      element_size = marker->element_size;
+      continue;
+    }
+    if (!rom.Has(pc, element_size)) {
+      truncated = true;
+      break;
+    }
+    pc += element_size;
+    read += element_size;
+  }
+  if (truncated) {
+    findings->push_back({DiagnosticSeverity::kError,
+                         label() + ": data runs past the end of the ROM at " +
+                             rom.Describe(std::min(pc, rom.size() - 1)),
+                         record_pc});
+  } else if (seen < stream.terminators) {
+    if (stream.max_bytes > 0 && read >= stream.max_bytes) {
+      findings->push_back({DiagnosticSeverity::kWarning,
+                           label() + ": no terminator within " +
+                               std::to_string(stream.max_bytes) + " bytes (" +
+                               std::to_string(seen) + " of " +
+                               std::to_string(stream.terminators) + " found)",
+                           record_pc});
+    }
+  }
+}
+
+ChunkResult CheckChunk(const ResolvedTable& table, const RomReader& rom,
+                       int first, int last) {
+  ChunkResult out;
+  const RomTableSchema& schema = *table.schema;
+  for (int index = first; index < last; ++index) {
+    const int entry_pc = table.base_pc + index * schema.stride;
+    // only built for entries that have something to report
+    auto label = [&] { return schema.name + "[" + Hex(index, 3) + "]"; };
+    int record_pc = entry_pc;
+    if (schema.entry_pointer > 0) {
+      uint32_t target = rom.Value(entry_pc, schema.entry_pointer);
+      if (schema.entry_pointer == 2) {
+        target |= static_cast<uint32_t>(table.bank) << 16;
+      }
+      int bank = static_cast<int>(target >> 16);
+      if (bank < schema.min_bank || bank > schema.max_bank) {
+        out.findings.push_back(
+            {DiagnosticSeverity::kError,
+             label() + ": points to $" + Hex(target, 6) + ", outside banks $" +
+                 Hex(schema.min_bank, 2) + "-$" + Hex(schema.max_bank, 2),
+             entry_pc});
+        continue;
+      }
+      record_pc = rom.ToPc(target);
+      if (!rom.Has(record_pc, table.record_size)) {
+        out.findings.push_back({DiagnosticSeverity::kError,
+                                label() + ": record $" + Hex(target, 6) +
+                                    " is outside the ROM",
+                                entry_pc});
+        continue;
+      }
+    }
+
+    for (const auto& field : schema.fields) {
+      uint8_t value = rom.Byte(record_pc + field.offset);
+      if (value & field.mask) {
+        out.findings.push_back({field.severity,
+                                label() + ": " + field.message + " ($" +
+                                    Hex(value, 2) + ")",
+                                record_pc + field.offset});
+      }
+    }
+    if (schema.stream) {
+      CheckStream(*schema.stream, rom, label, record_pc, &out.findings);
+    }
+    if (schema.warn_blank) {
+      const int size = schema.entry_pointer > 0 ? table.record_size : schema.stride;
+      uint8_t first_byte = rom.Byte(record_pc);
+      if (first_byte == 0x00 || first_byte == 0xFF) {
+        bool same = true;
+        for (int i = 1; i < size && same; ++i) {
+          same = rom.Byte(record_pc + i) == first_byte;
+        }
+        if (same) {
+          out.blank.push_back(index);
+        }
+      }
+    }
+  }
+  return out;
+}
+
+// Maps a ROM offset to the line that assembled it. The source map has the
+// address each line was org'd at, which can be any mirror of the byte, so
+// it's indexed by ROM offset instead. Bytes nothing assembled (the base ROM)
+// have no line, rather than the nearest one before them.
+class SourceLocator {
+ public:
+  explicit SourceLocator(const AssembleResult& result)
+      : blocks_(result.written_blocks) {
+    RomMapper mapper = static_cast<RomMapper>(result.mapper);
+    SourceMap by_offset;
+    by_offset.files = result.source_map.files;
+    for (const auto& entry : result.source_map.entries) {
+      int pc = SnesToRomOffset(entry.address, mapper);
+      if (pc >= 0) {
+        by_offset.entries.push_back(
+            {static_cast<uint32_t>(pc), entry.file_id, entry.line});
+      }
+    }
+    sources_ = BuildSourceIndex(by_offset);
+    std::sort(blocks_.begin(), blocks_.end(),
+              [](const WrittenBlock& a, const WrittenBlock& b) {
+                return a.pc_offset < b.pc_offset;
+              });
+  }
+
+  void Locate(int pc, Diagnostic* diag) const {
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), pc,
+                               [](int offset, const WrittenBlock& block) {
+                                 return offset < block.pc_offset;
+                               });
+    if (pc < 0 || it == blocks_.begin()) {
+      return;
+    }
+    --it;
+    if (pc >= it->pc_offset + it->num_bytes) {
+      return;
+    }
+    LocateDiagnostic(sources_, static_cast<uint32_t>(pc), diag);
+  }
+
+ private:
+  SourceIndex sources_;
+  std::vector<WrittenBlock> blocks_;
+};
+
+}  // namespace
+
+bool ParseRomSchema(const std::string& text, RomSchema* schema,
+                    std::string* error) {
+  json root = json::parse(text, nullptr, false);
+  if (root.is_discarded()) {
+    *error = "schema is not valid JSON";
+    return false;
+  }
+  if (!CheckKeys(root, {"tables"}, "schema", error)) {
+    return false;
+  }
+  auto tables = root.find("tables");
+  if (tables == root.end() || !tables->is_array()) {
+    *error = "schema: tables must be a list";
+    return false;
+  }
+  schema->tables.clear();
+  for (size_t i = 0; i < tables->size(); ++i) {
+    RomTableSchema table;
+    if (!ParseTable((*tables)[i], i, &table, error)) {
+      return false;
+    }
+    schema->tables.push_back(std::move(table));
+  }
+  return true;
+}
+
+bool LoadRomSchemaFile(const std::string& path, RomSchema* schema,
+                       std::string* error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    *error = "Unable to open ROM schema: " + path;
+    return false;
+  }
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  if (!ParseRomSchema(contents.str(), schema, error)) {
+    *error = path + ": " + *error;
+    return false;
+  }
+  return true;
+}
+
+std::vector<Diagnostic> ValidateRom(const AssembleResult& result,
+                                    const RomSchema& schema,
+                                    const RomValidateOptions& options) {
+  std::vector<Diagnostic> diagnostics;
+  if (result.rom_data.empty() || schema.tables.empty()) {
+    return diagnostics;
+  }
+  RomReader rom(result.rom_data, static_cast<RomMapper>(result.mapper));
+
+  // Resolving a table reads a pointer or two, so it happens up front; the
+  // entries are what's worth spreading over threads.
+  std::vector<ResolvedTable> tables;
+  std::vector<std::vector<Finding>> setup(schema.tables.size());
+  struct Item {
+    size_t table;
+    int first;
+    int last;
+  };
+  std::vector<Item> items;
+  for (size_t t = 0; t < schema.tables.size(); ++t) {
+    tables.push_back(ResolveTable(schema.tables[t], rom, &setup[t]));
+    if (!tables.back().ok) {
+      continue;
+    }
+    for (int first = 0; first < schema.tables[t].count; first += kChunkEntries) {
+      items.push_back({t, first, std::min(first + kChunkEntries, schema.tables[t].count)});
+    }
+  }
+
+  std::vector<ChunkResult> chunks(items.size());
+  size_t jobs = options.jobs > 0 ? static_cast<size_t>(options.jobs)
+                                 : std::max(1u, std::thread::hardware_concurrency());
+  jobs = std::min(jobs, items.size());
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < items.size(); i = next++) {
+      chunks[i] = CheckChunk(tables[items[i].table], rom, items[i].first,
+                             items[i].last);
+    }
+  };
+  if (jobs <= 1) {
+    worker();
+  } else {
+    std::vector<std::thread> threads;
+    threads.reserve(jobs);
+    for (size_t i = 0; i < jobs; ++i) {
+      threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  SourceLocator locator(result);
+  auto add = [&](const Finding& finding) {
+    Diagnostic diag;
+    diag.severity = finding.severity;
+    diag.message = finding.message;
+    locator.Locate(finding.pc, &diag);
+    diagnostics.push_back(std::move(diag));
+  };
+  size_t item = 0;
+  for (size_t t = 0; t < schema.tables.size(); ++t) {
+    for (const auto& finding : setup[t]) {
+      add(finding);
+    }
+    std::vector<int> blank;
+    for (; item < items.size() && items[item].table == t; ++item) {
+      for (const auto& finding : chunks[item].findings) {
+        add(finding);
+      }
+      blank.insert(blank.end(), chunks[item].blank.begin(), chunks[item].blank.end());
+    }
+    if (!blank.empty()) {
+      std::string sample;
+      for (size_t i = 0; i < blank.size() && i < kBlankSample; ++i) {
+        sample += (i ? ", " : "") + Hex(blank[i], 3);
+      }
+      if (blank.size() > kBlankSample) {
+        sample += ", ...";
+      }
+      add({DiagnosticSeverity::kWarning,
+           schema.tables[t].name + ": " + std::to_string(blank.size()) +
+               " blank entries (" + sample + ")",
+           tables[t].base_pc});
+    }
+  }
+  return diagnostics;
+}
+
+}  // namespace z3dk
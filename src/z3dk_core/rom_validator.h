@@ -0,0 +1,96 @@
+#ifndef Z3DK_CORE_ROM_VALIDATOR_H
+#define Z3DK_CORE_ROM_VALIDATOR_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "z3dk_core/assembler.h"
+
+namespace z3dk {
+
+// Warns (or fails) when `byte & mask` is nonzero at `offset` into a record.
+struct RomFieldCheck {
+  int offset = 0;
+  uint8_t mask = 0;
+  std::string message;
+  DiagnosticSeverity severity = DiagnosticSeverity::kWarning;
+};
+
+// A byte sequence inside a stream that switches the element size until the
+// next terminator, like the door marker in room object data.
+struct RomStreamMarker {
+  std::vector<uint8_t> bytes;
+  int element_size = 0;
+};
+
+// Records that are a run of fixed size elements ended by terminators.
+struct RomStreamSchema {
+  // header bytes before the first element
+  int skip = 0;
+  int element_size = 1;
+  std::vector<uint8_t> terminator;
+  // how many terminators end the record
+  int terminators = 1;
+  std::vector<RomStreamMarker> markers;
+  // give up (with a warning) after this many bytes, 0 = until the ROM ends
+  int max_bytes = 0;
+};
+
+// One table of `count` entries, `stride` bytes apart. An entry is either the
+// record itself or a pointer to it; records then get their bounds, fields
+// and stream checked. All addresses are SNES addresses and go through the
+// ROM's own mapper.
+struct RomTableSchema {
+  std::string name;
+  // where the table starts, or where the long pointer to it is stored
+  uint32_t address = 0;
+  bool indirect = false;
+  int count = 0;
+  int stride = 1;
+  // 0: entries are the records. 2 or 3: entries point at them, and 2 byte
+  // pointers take their bank from `bank` or from the byte at `bank_address`.
+  int entry_pointer = 0;
+  int bank = -1;
+  std::optional<uint32_t> bank_address;
+  // banks the records may live in
+  int min_bank = 0x00;
+  int max_bank = 0xFF;
+  // bytes every record needs inside the ROM; 0 = whatever the checks read
+  int record_size = 0;
+  std::vector<RomFieldCheck> fields;
+  std::optional<RomStreamSchema> stream;
+  // one warning counting the records that are all $00 or all $FF
+  bool warn_blank = false;
+};
+
+struct RomSchema {
+  std::vector<RomTableSchema> tables;
+};
+
+// Reads a JSON schema:
+//   {"tables": [{"name": "tile16", "address": "$3D8000", "size": "0x8000",
+//                "stride": 8, "warn_blank": true}, ...]}
+// Numbers may be JSON numbers or "$1234"/"0x1234"/"1234" strings.
+bool ParseRomSchema(const std::string& text, RomSchema* schema,
+                    std::string* error);
+bool LoadRomSchemaFile(const std::string& path, RomSchema* schema,
+                       std::string* error);
+
+struct RomValidateOptions {
+  // worker threads; 0 = one per core
+  int jobs = 0;
+};
+
+// Checks result.rom_data against `schema`. Tables are split into chunks of
+// entries that are checked in parallel; the diagnostics come back in table
+// and entry order either way, pointing at the line that assembled the byte
+// when the byte was assembled at all.
+std::vector<Diagnostic> ValidateRom(const AssembleResult& result,
+                                    const RomSchema& schema,
+                                    const RomValidateOptions& options = {});
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_ROM_VALIDATOR_H
@@ -0,0 +1,886 @@
+#include "z3dk_core/routine_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "z3dk_core/cpu65816.h"
+
+namespace z3dk {
+namespace {
+
+std::string Trim(std::string_view text) {
+  size_t start = 0;
+  while (start < text.size() && std::isspace(static_cast<unsigned char>(text[start]))) {
+    ++start;
+  }
+  size_t end = text.size();
+  while (end > start && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+    --end;
+  }
+  return std::string(text.substr(start, end - start));
+}
+
+std::string EscapeJson(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  for (char c : text) {
+    switch (c) {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        out.push_back(c);
+        break;
+    }
+  }
+  return out;
+}
+
+std::string Hex(int64_t value) {
+  char buffer[32];
+  if (value < 0) {
+    std::snprintf(buffer, sizeof(buffer), "-$%llX",
+                  static_cast<unsigned long long>(-value));
+  } else {
+    std::snprintf(buffer, sizeof(buffer), "$%02llX",
+                  static_cast<unsigned long long>(value));
+  }
+  return buffer;
+}
+
+// Parses $hex, %binary, 0x hex and decimal numbers.
+std::optional<int64_t> ParseNumber(std::string_view text) {
+  std::string token = Trim(text);
+  int base = 10;
+  size_t start = 0;
+  if (!token.empty() && token[0] == '$') {
+    base = 16;
+    start = 1;
+  } else if (!token.empty() && token[0] == '%') {
+    base = 2;
+    start = 1;
+  } else if (token.size() > 2 && token[0] == '0' &&
+             (token[1] == 'x' || token[1] == 'X')) {
+    base = 16;
+    start = 2;
+  }
+  if (start >= token.size()) {
+    return std::nullopt;
+  }
+  int64_t value = 0;
+  for (size_t i = start; i < token.size(); ++i) {
+    int digit = -1;
+    char c = static_cast<char>(std::tolower(static_cast<unsigned char>(token[i])));
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    }
+    if (digit < 0 || digit >= base) {
+      return std::nullopt;
+    }
+    value = value * base + digit;
+  }
+  return value;
+}
+
+// State an expression is evaluated against.
+struct EvalContext {
+  const CpuRegisters* regs = nullptr;
+  const SparseMemory* memory = nullptr;
+};
+
+struct Symbols {
+  std::unordered_map<std::string, uint32_t> labels;
+  std::unordered_map<std::string, std::string> defines;
+};
+
+// Expression tree for @assert and @test values. Nodes live in a flat vector
+// and refer to their operands by index.
+struct ExprNode {
+  enum class Kind { kNumber, kRegister, kMemory, kUnary, kBinary } kind =
+      Kind::kNumber;
+  int64_t value = 0;
+  std::string name;  // register name or operator
+  int width = 1;     // memory reads
+  int lhs = -1;
+  int rhs = -1;
+};
+
+class Expression {
+ public:
+  bool Parse(std::string_view text, const Symbols& symbols, std::string* error) {
+    text_ = std::string(text);
+    pos_ = 0;
+    symbols_ = &symbols;
+    error_.clear();
+    nodes_.clear();
+    root_ = ParseBinary(0);
+    SkipSpace();
+    if (error_.empty() && pos_ < text_.size()) {
+      error_ = "unexpected '" + text_.substr(pos_) + "'";
+    }
+    if (!error_.empty()) {
+      if (error) *error = error_;
+      return false;
+    }
+    return true;
+  }
+
+  int64_t Evaluate(const EvalContext& context) const {
+    return Eval(root_, context);
+  }
+
+  // For a failed top level comparison, describes both sides.
+  std::string Explain(const EvalContext& context) const {
+    const ExprNode& node = nodes_[root_];
+    if (node.kind != ExprNode::Kind::kBinary) {
+      return "value " + Hex(Eval(root_, context));
+    }
+    static const char* kComparisons[] = {"==", "!=", "<", "<=", ">", ">="};
+    for (const char* op : kComparisons) {
+      if (node.name == op) {
+        return "left " + Hex(Eval(node.lhs, context)) + ", right " +
+               Hex(Eval(node.rhs, context));
+      }
+    }
+    return "value " + Hex(Eval(root_, context));
+  }
+
+  // Memory node at the root, for `[addr]=value` in @test.
+  bool IsMemory() const { return nodes_[root_].kind == ExprNode::Kind::kMemory; }
+  int MemoryWidth() const { return nodes_[root_].width; }
+  int64_t MemoryAddress(const EvalContext& context) const {
+    return Eval(nodes_[root_].lhs, context);
+  }
+
+ private:
+  void SkipSpace() {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+      ++pos_;
+    }
+  }
+
+  bool Accept(std::string_view token) {
+    SkipSpace();
+    if (text_.compare(pos_, token.size(), token) == 0) {
+      pos_ += token.size();
+      return true;
+    }
+    return false;
+  }
+
+  int Add(ExprNode node) {
+    nodes_.push_back(std::move(node));
+    return static_cast<int>(nodes_.size() - 1);
+  }
+
+  int Number(int64_t value) {
+    ExprNode node;
+    node.value = value;
+    return Add(node);
+  }
+
+  static int Precedence(const std::string& op) {
+    if (op == "||") return 1;
+    if (op == "&&") return 2;
+    if (op == "|") return 3;
+    if (op == "^") return 4;
+    if (op == "&") return 5;
+    if (op == "==" || op == "!=") return 6;
+    if (op == "<" || op == "<=" || op == ">" || op == ">=") return 7;
+    if (op == "<<" || op == ">>") return 8;
+    if (op == "+" || op == "-") return 9;
+    if (op == "*" || op == "/" || op == "%") return 10;
+    return 0;
+  }
+
+  std::string PeekOperator() {
+    SkipSpace();
+    static const char* kOperators[] = {"||", "&&", "==", "!=", "<=", ">=", "<<",
+                                       ">>", "|",  "^",  "&",  "<",  ">",  "+",
+                                       "-",  "*",  "/",  "%"};
+    for (const char* op : kOperators) {
+      if (text_.compare(pos_, std::char_traits<char>::length(op), op) == 0) {
+        return op;
+      }
+    }
+    return "";
+  }
+
+  int ParseBinary(int min_precedence) {
+    int lhs = ParseUnary();
+    while (error_.empty()) {
+      std::string op = PeekOperator();
+      int precedence = Precedence(op);
+      if (op.empty() || precedence <= min_precedence) {
+        break;
+      }
+      pos_ += op.size();
+      int rhs = ParseBinary(precedence);
+      ExprNode node;
+      node.kind = ExprNode::Kind::kBinary;
+      node.name = op;
+      node.lhs = lhs;
+      node.rhs = rhs;
+      lhs = Add(node);
+    }
+    return lhs;
+  }
+
+  int ParseUnary() {
+    SkipSpace();
+    if (pos_ < text_.size()) {
+      char c = text_[pos_];
+      // !name is a define, like in asar; ! before anything else is a not
+      bool define = c == '!' && pos_ + 1 < text_.size() &&
+                    (std::isalpha(static_cast<unsigned char>(text_[pos_ + 1])) ||
+                     text_[pos_ + 1] == '_');
+      if (c == '-' || c == '~' || (c == '!' && !define)) {
+        ++pos_;
+        ExprNode node;
+        node.kind = ExprNode::Kind::kUnary;
+        node.name = std::string(1, c);
+        node.lhs = ParseUnary();
+        return Add(node);
+      }
+      if (c == '&') {
+        // &Label is the address itself rather than the byte stored there.
+        ++pos_;
+        SkipSpace();
+        std::string name = ReadIdentifier();
+        auto it = symbols_->labels.find(name);
+        if (it == symbols_->labels.end()) {
+          Fail("unknown label '" + name + "'");
+          return Number(0);
+        }
+        return Number(it->second);
+      }
+    }
+    return ParsePrimary();
+  }
+
+  std::string ReadIdentifier() {
+    size_t start = pos_;
+    while (pos_ < text_.size() &&
+           (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '_' || text_[pos_] == '.')) {
+      ++pos_;
+    }
+    return text_.substr(start, pos_ - start);
+  }
+
+  int ReadWidthSuffix(std::string* name) {
+    if (name->size() > 2 && (*name)[name->size() - 2] == '.') {
+      char suffix = static_cast<char>(std::tolower(static_cast<unsigned char>(name->back())));
+      int width = suffix == 'b' ? 1 : suffix == 'w' ? 2 : suffix == 'l' ? 3 : 0;
+      if (width != 0 && symbols_->labels.find(*name) == symbols_->labels.end()) {
+        name->resize(name->size() - 2);
+        return width;
+      }
+    }
+    return 1;
+  }
+
+  int ParsePrimary() {
+    SkipSpace();
+    if (pos_ >= text_.size()) {
+      Fail("unexpected end of expression");
+      return Number(0);
+    }
+    char c = text_[pos_];
+    if (Accept("(")) {
+      int inner = ParseBinary(0);
+      if (!Accept(")")) {
+        Fail("missing ')'");
+      }
+      return inner;
+    }
+    if (Accept("[")) {
+      int address = ParseBinary(0);
+      if (!Accept("]")) {
+        Fail("missing ']'");
+      }
+      ExprNode node;
+      node.kind = ExprNode::Kind::kMemory;
+      node.lhs = address;
+      if (Accept(".w")) {
+        node.width = 2;
+      } else if (Accept(".l")) {
+        node.width = 3;
+      } else {
+        Accept(".b");
+      }
+      return Add(node);
+    }
+    if (c == '$' || c == '%' || std::isdigit(static_cast<unsigned char>(c))) {
+      size_t start = pos_++;
+      while (pos_ < text_.size() && std::isalnum(static_cast<unsigned char>(text_[pos_]))) {
+        ++pos_;
+      }
+      auto value = ParseNumber(text_.substr(start, pos_ - start));
+      if (!value.has_value()) {
+        Fail("bad number '" + text_.substr(start, pos_ - start) + "'");
+        return Number(0);
+      }
+      return Number(*value);
+    }
+    if (c == '!') {
+      ++pos_;
+      std::string name = ReadIdentifier();
+      auto it = symbols_->defines.find(name);
+      if (it == symbols_->defines.end()) {
+        Fail("unknown define '!" + name + "'");
+        return Number(0);
+      }
+      auto value = ParseNumber(it->second);
+      if (!value.has_value()) {
+        Fail("define '!" + name + "' is not a number");
+        return Number(0);
+      }
+      return Number(*value);
+    }
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      std::string name = ReadIdentifier();
+      std::string upper = name;
+      for (auto& ch : upper) {
+        ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+      }
+      static const char* kRegisters[] = {"A", "X", "Y", "S", "D", "DB", "PB", "P"};
+      for (const char* reg : kRegisters) {
+        if (upper == reg) {
+          ExprNode node;
+          node.kind = ExprNode::Kind::kRegister;
+          node.name = upper;
+          return Add(node);
+        }
+      }
+      int width = ReadWidthSuffix(&name);
+      auto it = symbols_->labels.find(name);
+      if (it == symbols_->labels.end()) {
+        Fail("unknown label '" + name + "'");
+        return Number(0);
+      }
+      ExprNode node;
+      node.kind = ExprNode::Kind::kMemory;
+      node.width = width;
+      node.lhs = Number(it->second);
+      return Add(node);
+    }
+    Fail(std::string("unexpected '") + c + "'");
+    return Number(0);
+  }
+
+  void Fail(const std::string& message) {
+    if (error_.empty()) {
+      error_ = message;
+    }
+    pos_ = text_.size();
+  }
+
+  int64_t Eval(int index, const EvalContext& context) const {
+    const ExprNode& node = nodes_[index];
+    switch (node.kind) {
+      case ExprNode::Kind::kNumber:
+        return node.value;
+      case ExprNode::Kind::kRegister: {
+        const CpuRegisters& regs = *context.regs;
+        if (node.name == "A") return regs.a;
+        if (node.name == "X") return regs.x;
+        if (node.name == "Y") return regs.y;
+        if (node.name == "S") return regs.s;
+        if (node.name == "D") return regs.d;
+        if (node.name == "DB") return regs.db;
+        if (node.name == "PB") return regs.pb;
+        return regs.p;
+      }
+      case ExprNode::Kind::kMemory: {
+        uint32_t address = static_cast<uint32_t>(Eval(node.lhs, context));
+        int64_t value = 0;
+        for (int i = node.width - 1; i >= 0; --i) {
+          value = value << 8 | context.memory->Read(address + static_cast<uint32_t>(i));
+        }
+        return value;
+      }
+      case ExprNode::Kind::kUnary: {
+        int64_t value = Eval(node.lhs, context);
+        if (node.name == "-") return -value;
+        if (node.name == "!") return value == 0;
+        return ~value;
+      }
+      case ExprNode::Kind::kBinary:
+        break;
+    }
+    int64_t lhs = Eval(node.lhs, context);
+    const std::string& op = node.name;
+    if (op == "&&") return lhs && Eval(node.rhs, context);
+    if (op == "||") return lhs || Eval(node.rhs, context);
+    int64_t rhs = Eval(node.rhs, context);
+    if (op == "==") return lhs == rhs;
+    if (op == "!=") return lhs != rhs;
+    if (op == "<") return lhs < rhs;
+    if (op == "<=") return lhs <= rhs;
+    if (op == ">") return lhs > rhs;
+    if (op == ">=") return lhs >= rhs;
+    if (op == "+") return lhs + rhs;
+    if (op == "-") return lhs - rhs;
+    if (op == "*") return lhs * rhs;
+    if (op == "/") return rhs == 0 ? 0 : lhs / rhs;
+    if (op == "%") return rhs == 0 ? 0 : lhs % rhs;
+    if (op == "<<") return lhs << (rhs & 63);
+    if (op == ">>") return lhs >> (rhs & 63);
+    if (op == "&") return lhs & rhs;
+    if (op == "|") return lhs | rhs;
+    return lhs ^ rhs;
+  }
+
+  std::string text_;
+  size_t pos_ = 0;
+  const Symbols* symbols_ = nullptr;
+  std::string error_;
+  std::vector<ExprNode> nodes_;
+  int root_ = 0;
+};
+
+Diagnostic MakeFailure(const std::string& filename, int line,
+                       const std::string& message) {
+  Diagnostic diag;
+  diag.severity = DiagnosticSeverity::kError;
+  diag.filename = filename;
+  diag.line = line;
+  diag.column = 1;
+  diag.message = message;
+  return diag;
+}
+
+// Applies `; @test` settings. Flags go first so register values aren't
+// truncated by a later m/x setting.
+bool ApplySetup(const RoutineTest& test, const Symbols& symbols, Cpu65816* cpu,
+                SparseMemory* memory, std::string* error) {
+  CpuRegisters& regs = cpu->registers();
+  std::istringstream in(test.setup);
+  std::string item;
+  std::vector<std::pair<std::string, std::string>> registers;
+  std::vector<std::pair<std::string, std::string>> writes;
+  while (in >> item) {
+    auto eq = item.rfind('=');
+    if (eq == std::string::npos || eq == 0 || eq + 1 == item.size()) {
+      *error = "bad @test setting '" + item + "'";
+      return false;
+    }
+    std::string key = item.substr(0, eq);
+    std::string value = item.substr(eq + 1);
+    if (key == "m" || key == "x") {
+      if (value != "8" && value != "16") {
+        *error = "@test " + key + "= must be 8 or 16";
+        return false;
+      }
+      uint8_t flag = key == "m" ? Cpu65816::kFlagM : Cpu65816::kFlagX;
+      if (value == "16") {
+        regs.p &= static_cast<uint8_t>(~flag);
+      } else {
+        regs.p |= flag;
+      }
+    } else if (key == "P") {
+      auto parsed = ParseNumber(value);
+      if (!parsed.has_value()) {
+        *error = "bad @test value '" + item + "'";
+        return false;
+      }
+      regs.p = static_cast<uint8_t>(*parsed);
+    } else if (key == "A" || key == "X" || key == "Y" || key == "S" ||
+               key == "D" || key == "DB") {
+      registers.emplace_back(key, value);
+    } else {
+      writes.emplace_back(key, value);
+    }
+  }
+
+  EvalContext context{&regs, memory};
+  for (const auto& [key, text] : registers) {
+    Expression expr;
+    if (!expr.Parse(text, symbols, error)) {
+      return false;
+    }
+    uint16_t value = static_cast<uint16_t>(expr.Evaluate(context));
+    if (key == "A") {
+      regs.a = value;
+    } else if (key == "X") {
+      regs.x = value;
+    } else if (key == "Y") {
+      regs.y = value;
+    } else if (key == "S") {
+      regs.s = value;
+    } else if (key == "D") {
+      regs.d = value;
+    } else {
+      regs.db = static_cast<uint8_t>(value);
+    }
+  }
+  if (regs.p & Cpu65816::kFlagX) {
+    regs.x &= 0xFF;
+    regs.y &= 0xFF;
+  }
+  for (const auto& [key, text] : writes) {
+    Expression target;
+    Expression expr;
+    if (!target.Parse(key, symbols, error) || !expr.Parse(text, symbols, error)) {
+      return false;
+    }
+    if (!target.IsMemory()) {
+      *error = "bad @test setting '" + key + "'";
+      return false;
+    }
+    uint32_t address = static_cast<uint32_t>(target.MemoryAddress(context));
+    int64_t value = expr.Evaluate(context);
+    for (int i = 0; i < target.MemoryWidth(); ++i) {
+      memory->Write(address + static_cast<uint32_t>(i),
+                    static_cast<uint8_t>(value >> (8 * i)));
+    }
+  }
+  return true;
+}
+
+RoutineTestResult RunOne(const RoutineTest& test,
+                         const std::shared_ptr<const std::vector<uint8_t>>& rom,
+                         RomMapper mapper, const Symbols& symbols,
+                         const RoutineTestOptions& options) {
+  RoutineTestResult out;
+  out.name = test.name;
+  out.address = test.address;
+  out.filename = test.filename;
+  out.line = test.line;
+
+  std::vector<Expression> exprs(test.asserts.size());
+  std::unordered_map<uint32_t, std::vector<size_t>> by_address;
+  std::vector<size_t> on_return;
+  for (size_t i = 0; i < test.asserts.size(); ++i) {
+    const RoutineAssert& assertion = test.asserts[i];
+    std::string error;
+    if (!exprs[i].Parse(assertion.expr, symbols, &error)) {
+      out.failures.push_back(MakeFailure(assertion.filename, assertion.line,
+                                         "bad @assert '" + assertion.expr +
+                                             "': " + error));
+      continue;
+    }
+    if (assertion.address.has_value()) {
+      by_address[*assertion.address].push_back(i);
+    } else {
+      on_return.push_back(i);
+    }
+  }
+  if (!out.failures.empty()) {
+    out.stop_reason = "setup_error";
+    return out;
+  }
+
+  SparseMemory memory(rom, mapper);
+  Cpu65816 cpu(&memory);
+  CpuRegisters& regs = cpu.registers();
+  regs.pb = static_cast<uint8_t>(test.address >> 16);
+  regs.pc = static_cast<uint16_t>(test.address);
+  regs.db = regs.pb;
+  std::string setup_error;
+  if (!ApplySetup(test, symbols, &cpu, &memory, &setup_error)) {
+    out.failures.push_back(MakeFailure(test.filename, test.setup_line, setup_error));
+    out.stop_reason = "setup_error";
+    return out;
+  }
+  const uint16_t entry_s = regs.s;
+
+  std::vector<bool> reached(test.asserts.size(), false);
+  std::vector<bool> failed(test.asserts.size(), false);
+  EvalContext context{&regs, &memory};
+  auto check = [&](size_t index) {
+    reached[index] = true;
+    if (failed[index] || exprs[index].Evaluate(context) != 0) {
+      return;
+    }
+    failed[index] = true;
+    const RoutineAssert& assertion = test.asserts[index];
+    char where[16];
+    std::snprintf(where, sizeof(where), "$%02X:%04X", regs.pb, regs.pc);
+    out.failures.push_back(MakeFailure(
+        assertion.filename, assertion.line,
+        "assert failed at " + std::string(where) + ": " + assertion.expr +
+            " (" + exprs[index].Explain(context) + ")"));
+  };
+
+  while (true) {
+    if (!by_address.empty()) {
+      auto it = by_address.find(static_cast<uint32_t>(regs.pb) << 16 | regs.pc);
+      if (it != by_address.end()) {
+        for (size_t index : it->second) {
+          check(index);
+        }
+      }
+    }
+    if (cpu.instructions() >= options.max_instructions) {
+      out.stop_reason = "instruction_limit";
+      break;
+    }
+    if (cpu.cycles() >= options.max_cycles) {
+      out.stop_reason = "cycle_limit";
+      break;
+    }
+    cpu.Step();
+    if (cpu.halt() != CpuHalt::kNone) {
+      out.stop_reason = cpu.halt() == CpuHalt::kBreak  ? "brk"
+                        : cpu.halt() == CpuHalt::kStop ? "stp"
+                                                       : "wai";
+      break;
+    }
+    uint8_t opcode = cpu.last_opcode();
+    if ((opcode == 0x60 || opcode == 0x6B || opcode == 0x40) && regs.s > entry_s) {
+      out.stop_reason = "returned";
+      break;
+    }
+  }
+
+  out.instructions = cpu.instructions();
+  out.cycles = cpu.cycles();
+  if (out.stop_reason == "returned") {
+    for (size_t index : on_return) {
+      check(index);
+    }
+  } else {
+    std::string message = "routine did not return: ";
+    if (out.stop_reason == "instruction_limit") {
+      message += "instruction limit (" + std::to_string(options.max_instructions) + ") reached";
+    } else if (out.stop_reason == "cycle_limit") {
+      message += "cycle limit (" + std::to_string(options.max_cycles) + ") reached";
+    } else {
+      char where[48];
+      std::snprintf(where, sizeof(where), "%s at $%02X:%04X",
+                    out.stop_reason == "brk"   ? "BRK/COP"
+                    : out.stop_reason == "stp" ? "STP"
+                                               : "WAI",
+                    regs.pb, static_cast<uint16_t>(regs.pc - 1));
+      message += where;
+    }
+    out.failures.push_back(MakeFailure(test.filename, test.line, message));
+  }
+  for (size_t i = 0; i < reached.size(); ++i) {
+    if (reached[i]) {
+      ++out.asserts_checked;
+    } else {
+      ++out.asserts_unreached;
+    }
+  }
+  out.passed = out.failures.empty();
+  return out;
+}
+
+}  // namespace
+
+std::vector<RoutineTest> CollectRoutineTests(const AssembleResult& result) {
+  std::unordered_map<std::string, uint32_t> label_index;
+  for (const auto& label : result.labels) {
+    label_index.emplace(label.name, label.address);
+  }
+  // Lowest address emitted for each (file, line).
+  std::map<std::pair<int, int>, uint32_t> line_addresses;
+  for (const auto& entry : result.source_map.entries) {
+    auto key = std::make_pair(entry.file_id, entry.line);
+    auto it = line_addresses.find(key);
+    if (it == line_addresses.end() || entry.address < it->second) {
+      line_addresses[key] = entry.address;
+    }
+  }
+
+  // no space before the colon, so `INC : INC` isn't taken for a label
+  const std::regex label_re(R"(^\s*([A-Za-z_][A-Za-z0-9_]*):)");
+  std::vector<RoutineTest> tests;
+  for (const auto& file : result.source_map.files) {
+    std::ifstream in(file.path);
+    if (!in.is_open()) {
+      continue;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+      lines.push_back(line);
+    }
+
+    auto address_at_or_after = [&](size_t from, size_t end) -> std::optional<uint32_t> {
+      auto it = line_addresses.lower_bound({file.id, static_cast<int>(from + 1)});
+      if (it == line_addresses.end() || it->first.first != file.id ||
+          it->first.second > static_cast<int>(end)) {
+        return std::nullopt;
+      }
+      return it->second;
+    };
+
+    std::optional<RoutineTest> current;
+    size_t current_end = 0;
+    auto flush = [&]() {
+      if (current.has_value() &&
+          (!current->asserts.empty() || current->setup_line != 0)) {
+        tests.push_back(std::move(*current));
+      }
+      current.reset();
+    };
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+      const std::string& text = lines[i];
+      auto semicolon = text.find(';');
+      std::string code = text.substr(0, semicolon);
+      std::smatch match;
+      if (std::regex_search(code, match, label_re)) {
+        flush();
+        // the routine runs up to the next global label in this file
+        size_t end = i + 1;
+        while (end < lines.size()) {
+          std::string next = lines[end].substr(0, lines[end].find(';'));
+          if (std::regex_search(next, label_re)) {
+            break;
+          }
+          ++end;
+        }
+        current_end = end;
+        std::string name = match[1].str();
+        std::optional<uint32_t> address;
+        auto label_it = label_index.find(name);
+        if (label_it != label_index.end()) {
+          address = label_it->second;
+        } else {
+          address = address_at_or_after(i, current_end);
+        }
+        if (address.has_value()) {
+          current = RoutineTest();
+          current->name = name;
+          current->address = *address;
+          current->filename = file.path;
+          current->line = static_cast<int>(i + 1);
+        }
+      }
+      if (!current.has_value() || semicolon == std::string::npos) {
+        continue;
+      }
+      std::string comment = text.substr(semicolon + 1);
+      auto assert_pos = comment.find("@assert");
+      if (assert_pos != std::string::npos) {
+        RoutineAssert assertion;
+        assertion.expr = Trim(comment.substr(assert_pos + 7));
+        assertion.filename = file.path;
+        assertion.line = static_cast<int>(i + 1);
+        assertion.address = address_at_or_after(i, current_end);
+        current->asserts.push_back(std::move(assertion));
+      }
+      auto test_pos = comment.find("@test");
+      if (test_pos != std::string::npos) {
+        current->setup = Trim(comment.substr(test_pos + 5));
+        current->setup_line = static_cast<int>(i + 1);
+      }
+    }
+    flush();
+  }
+  return tests;
+}
+
+std::vector<RoutineTestResult> RunRoutineTests(
+    const AssembleResult& result, const std::vector<RoutineTest>& tests,
+    const RoutineTestOptions& options) {
+  std::vector<RoutineTestResult> results(tests.size());
+  if (tests.empty()) {
+    return results;
+  }
+  auto rom = std::make_shared<const std::vector<uint8_t>>(result.rom_data);
+  RomMapper mapper = static_cast<RomMapper>(result.mapper);
+  Symbols symbols;
+  for (const auto& label : result.labels) {
+    symbols.labels.emplace(label.name, label.address);
+  }
+  for (const auto& define : result.defines) {
+    symbols.defines.emplace(define.name, define.value);
+  }
+
+  size_t jobs = options.jobs > 0 ? static_cast<size_t>(options.jobs)
+                                 : std::max(1u, std::thread::hardware_concurrency());
+  jobs = std::min(jobs, tests.size());
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < tests.size(); i = next++) {
+      results[i] = RunOne(tests[i], rom, mapper, symbols, options);
+    }
+  };
+  if (jobs <= 1) {
+    worker();
+    return results;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(jobs);
+  for (size_t i = 0; i < jobs; ++i) {
+    threads.emplace_back(worker);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return results;
+}
+
+std::string RoutineTestsToJson(const std::vector<RoutineTestResult>& results) {
+  int passed = 0;
+  for (const auto& result : results) {
+    if (result.passed) {
+      ++passed;
+    }
+  }
+  std::ostringstream out;
+  out << "{\"version\":1,\"passed\":" << passed
+      << ",\"failed\":" << (results.size() - static_cast<size_t>(passed))
+      << ",\"tests\":[";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    if (i > 0) {
+      out << ',';
+    }
+    char address[16];
+    std::snprintf(address, sizeof(address), "0x%06X", result.address);
+    out << "{\"name\":\"" << EscapeJson(result.name) << "\""
+        << ",\"address\":\"" << address << "\""
+        << ",\"source\":\"" << EscapeJson(result.filename) << ":" << result.line << "\""
+        << ",\"passed\":" << (result.passed ? "true" : "false")
+        << ",\"stop\":\"" << result.stop_reason << "\""
+        << ",\"instructions\":" << result.instructions
+        << ",\"cycles\":" << result.cycles
+        << ",\"asserts_checked\":" << result.asserts_checked
+        << ",\"asserts_unreached\":" << result.asserts_unreached
+        << ",\"failures\":[";
+    for (size_t j = 0; j < result.failures.size(); ++j) {
+      const auto& failure = result.failures[j];
+      if (j > 0) {
+        out << ',';
+      }
+      out << "{\"file\":\"" << EscapeJson(failure.filename) << "\""
+          << ",\"line\":" << failure.line
+          << ",\"message\":\"" << EscapeJson(failure.message) << "\"}";
+    }
+    out << "]}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+}  // namespace z3dk
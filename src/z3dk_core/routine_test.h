@@ -0,0 +1,71 @@
+#ifndef Z3DK_CORE_ROUTINE_TEST_H
+#define Z3DK_CORE_ROUTINE_TEST_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "z3dk_core/assembler.h"
+
+namespace z3dk {
+
+struct RoutineAssert {
+  std::string expr;
+  std::string filename;
+  int line = 0;
+  // Checked every time execution reaches this address. Asserts below the
+  // last instruction of a routine have no address and are checked once the
+  // routine returns.
+  std::optional<uint32_t> address;
+};
+
+// A global label whose body carries `; @assert` or `; @test` comments.
+struct RoutineTest {
+  std::string name;
+  uint32_t address = 0;
+  std::string filename;
+  int line = 0;
+  // Initial state from `; @test`, e.g. "A=$10 X=2 m=16 [$7E0010]=$07".
+  std::string setup;
+  int setup_line = 0;
+  std::vector<RoutineAssert> asserts;
+};
+
+struct RoutineTestOptions {
+  uint64_t max_instructions = 1000000;
+  uint64_t max_cycles = 10000000;
+  // Worker threads for RunRoutineTests; 0 uses every core.
+  int jobs = 0;
+};
+
+struct RoutineTestResult {
+  std::string name;
+  uint32_t address = 0;
+  std::string filename;
+  int line = 0;
+  bool passed = false;
+  // returned, instruction_limit, cycle_limit, brk, stp, wai or setup_error.
+  std::string stop_reason;
+  uint64_t instructions = 0;
+  uint64_t cycles = 0;
+  int asserts_checked = 0;
+  int asserts_unreached = 0;
+  std::vector<Diagnostic> failures;
+};
+
+// Scans the sources in result.source_map for routines with @assert/@test
+// comments. Files that can't be read are skipped, like AnnotationsToJson.
+std::vector<RoutineTest> CollectRoutineTests(const AssembleResult& result);
+
+// Runs every test against its own copy-on-write view of result.rom_data,
+// spread over options.jobs threads. Results keep the order of tests.
+std::vector<RoutineTestResult> RunRoutineTests(
+    const AssembleResult& result, const std::vector<RoutineTest>& tests,
+    const RoutineTestOptions& options);
+
+std::string RoutineTestsToJson(const std::vector<RoutineTestResult>& results);
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_ROUTINE_TEST_H
@@ -0,0 +1,52 @@
+#include "z3dk_core/source_index.h"
+
+#include <algorithm>
+
+namespace z3dk {
+
+SourceIndex BuildSourceIndex(const SourceMap& map) {
+  SourceIndex index;
+  for (const auto& file : map.files) {
+    index.files[file.id] = file.path;
+  }
+  index.entries = map.entries;
+  std::sort(index.entries.begin(), index.entries.end(),
+            [](const SourceMapEntry& a, const SourceMapEntry& b) {
+              if (a.address != b.address) {
+                return a.address < b.address;
+              }
+              return a.line < b.line;
+            });
+  return index;
+}
+
+const SourceMapEntry* FindEntry(const SourceIndex& index, uint32_t address) {
+  if (index.entries.empty()) {
+    return nullptr;
+  }
+  auto it = std::upper_bound(index.entries.begin(), index.entries.end(), address,
+                             [](uint32_t addr, const SourceMapEntry& entry) {
+                               return addr < entry.address;
+                             });
+  if (it == index.entries.begin()) {
+    return nullptr;
+  }
+  --it;
+  return &(*it);
+}
+
+void LocateDiagnostic(const SourceIndex& index, uint32_t address,
+                      Diagnostic* diag) {
+  const SourceMapEntry* entry = FindEntry(index, address);
+  if (!entry) {
+    return;
+  }
+  auto it = index.files.find(entry->file_id);
+  if (it != index.files.end()) {
+    diag->filename = it->second;
+  }
+  diag->line = entry->line;
+  diag->column = 1;
+}
+
+}  // namespace z3dk
@@ -0,0 +1,31 @@
+#ifndef Z3DK_CORE_SOURCE_INDEX_H
+#define Z3DK_CORE_SOURCE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "z3dk_core/assembler.h"
+
+namespace z3dk {
+
+// A source map sorted by address, for pointing diagnostics about ROM bytes
+// back at the line that assembled them.
+struct SourceIndex {
+  std::unordered_map<int, std::string> files;
+  std::vector<SourceMapEntry> entries;
+};
+
+SourceIndex BuildSourceIndex(const SourceMap& map);
+
+// The last entry at or before `address`, or null.
+const SourceMapEntry* FindEntry(const SourceIndex& index, uint32_t address);
+
+// Fills in diag's filename/line from the entry for `address`, if any.
+void LocateDiagnostic(const SourceIndex& index, uint32_t address,
+                      Diagnostic* diag);
+
+}  // namespace z3dk
+
+#endif  // Z3DK_CORE_SOURCE_INDEX_H
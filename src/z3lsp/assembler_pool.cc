@@ -0,0 +1,785 @@
+#include "assembler_pool.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include "logging.h"
+
+namespace fs = std::filesystem;
+
+namespace z3lsp {
+
+AssemblerPool g_assembler_pool;
+
+namespace {
+
+// Descriptors a worker inherits across exec.
+constexpr int kWorkerRequestFd = 3;
+constexpr int kWorkerResponseFd = 4;
+constexpr int kWorkerRomFd = 5;
+// Parent-side descriptors are moved above this so the child's dup2 calls
+// onto 3..5 can't clobber one another.
+constexpr int kMinParentFd = 10;
+
+constexpr uint32_t kMaxFrameSize = 256u * 1024u * 1024u;
+
+enum class RomLocation : uint8_t {
+  kNone = 0,
+  kBuffer = 1,
+  kInline = 2,
+};
+
+class Writer {
+ public:
+  void U8(uint8_t value) { out_.push_back(static_cast<char>(value)); }
+  void U32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      U8(static_cast<uint8_t>(value >> (i * 8)));
+    }
+  }
+  void I32(int value) { U32(static_cast<uint32_t>(value)); }
+  void Bool(bool value) { U8(value ? 1 : 0); }
+  void Str(std::string_view value) {
+    U32(static_cast<uint32_t>(value.size()));
+    out_.append(value.data(), value.size());
+  }
+  void Rom(const std::vector<uint8_t>& rom, uint8_t* buffer, size_t capacity) {
+    if (rom.empty()) {
+      U8(static_cast<uint8_t>(RomLocation::kNone));
+    } else if (buffer != nullptr && rom.size() <= capacity) {
+      U8(static_cast<uint8_t>(RomLocation::kBuffer));
+      U32(static_cast<uint32_t>(rom.size()));
+      std::memcpy(buffer, rom.data(), rom.size());
+    } else {
+      U8(static_cast<uint8_t>(RomLocation::kInline));
+      Str(std::string_view(reinterpret_cast<const char*>(rom.data()), rom.size()));
+    }
+  }
+  std::string Take() { return std::move(out_); }
+
+ private:
+  std::string out_;
+};
+
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  uint8_t U8() {
+    if (!Need(1)) {
+      return 0;
+    }
+    return static_cast<uint8_t>(data_[pos_++]);
+  }
+  uint32_t U32() {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= static_cast<uint32_t>(U8()) << (i * 8);
+    }
+    return value;
+  }
+  int I32() { return static_cast<int>(U32()); }
+  bool Bool() { return U8() != 0; }
+  std::string Str() {
+    uint32_t size = U32();
+    if (!Need(size)) {
+      return {};
+    }
+    std::string value(data_.substr(pos_, size));
+    pos_ += size;
+    return value;
+  }
+  // Element counts are checked against the remaining bytes so a corrupt
+  // frame can't ask for a huge allocation.
+  uint32_t Count() {
+    uint32_t count = U32();
+    if (count > data_.size() - pos_) {
+      ok_ = false;
+      return 0;
+    }
+    return count;
+  }
+  std::vector<uint8_t> Rom(const uint8_t* buffer, size_t capacity) {
+    auto location = static_cast<RomLocation>(U8());
+    if (location == RomLocation::kBuffer) {
+      uint32_t size = U32();
+      if (buffer == nullptr || size > capacity) {
+        ok_ = false;
+        return {};
+      }
+      return std::vector<uint8_t>(buffer, buffer + size);
+    }
+    if (location == RomLocation::kInline) {
+      std::string bytes = Str();
+      return std::vector<uint8_t>(bytes.begin(), bytes.end());
+    }
+    if (location != RomLocation::kNone) {
+      ok_ = false;
+    }
+    return {};
+  }
+  bool ok() const { return ok_ && pos_ == data_.size(); }
+
+ private:
+  bool Need(size_t size) {
+    if (!ok_ || size > data_.size() - pos_) {
+      ok_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  std::string_view data_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+bool WriteAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+// Reads exactly `size` bytes. With a deadline, gives up (setting *timed_out)
+// once it passes.
+bool ReadAll(int fd, char* data, size_t size,
+             const std::chrono::steady_clock::time_point* deadline, bool* timed_out) {
+  while (size > 0) {
+    if (deadline != nullptr) {
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+          *deadline - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0) {
+        *timed_out = true;
+        return false;
+      }
+      pollfd pfd{fd, POLLIN, 0};
+      int ready = poll(&pfd, 1, static_cast<int>(remaining.count()));
+      if (ready < 0 && errno != EINTR) {
+        return false;
+      }
+      if (ready <= 0) {
+        continue;
+      }
+    }
+    ssize_t got = read(fd, data, size);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (got == 0) {
+      return false;
+    }
+    data += got;
+    size -= static_cast<size_t>(got);
+  }
+  return true;
+}
+
+bool WriteFrame(int fd, const std::string& payload) {
+  char header[4];
+  uint32_t size = static_cast<uint32_t>(payload.size());
+  for (int i = 0; i < 4; ++i) {
+    header[i] = static_cast<char>(size >> (i * 8));
+  }
+  return WriteAll(fd, header, sizeof(header)) &&
+         WriteAll(fd, payload.data(), payload.size());
+}
+
+bool ReadFrame(int fd, std::string* payload,
+               const std::chrono::steady_clock::time_point* deadline = nullptr,
+               bool* timed_out = nullptr) {
+  unsigned char header[4];
+  if (!ReadAll(fd, reinterpret_cast<char*>(header), sizeof(header), deadline, timed_out)) {
+    return false;
+  }
+  uint32_t size = static_cast<uint32_t>(header[0]) | static_cast<uint32_t>(header[1]) << 8 |
+                  static_cast<uint32_t>(header[2]) << 16 |
+                  static_cast<uint32_t>(header[3]) << 24;
+  if (size > kMaxFrameSize) {
+    return false;
+  }
+  payload->resize(size);
+  return ReadAll(fd, payload->data(), size, deadline, timed_out);
+}
+
+int MoveAbove(int fd) {
+  if (fd < 0) {
+    return fd;
+  }
+  int moved = fcntl(fd, F_DUPFD_CLOEXEC, kMinParentFd);
+  close(fd);
+  return moved;
+}
+
+std::string DescribeExit(int status) {
+  if (WIFSIGNALED(status)) {
+    return "crashed (signal " + std::to_string(WTERMSIG(status)) + ")";
+  }
+  if (WIFEXITED(status)) {
+    return "exited with code " + std::to_string(WEXITSTATUS(status));
+  }
+  return "stopped";
+}
+
+z3dk::AssembleResult FailedResult(const z3dk::AssembleOptions& options,
+                                  const std::string& message) {
+  z3dk::AssembleResult result;
+  result.success = false;
+  z3dk::Diagnostic diag;
+  diag.severity = z3dk::DiagnosticSeverity::kError;
+  diag.message = message;
+  diag.filename = options.patch_path;
+  result.diagnostics.push_back(std::move(diag));
+  return result;
+}
+
+}  // namespace
+
+std::string EncodeAssembleOptions(const z3dk::AssembleOptions& options,
+                                  uint8_t* rom_buffer, size_t rom_capacity) {
+  Writer w;
+  w.Str(options.patch_path);
+  w.Rom(options.rom_data, rom_buffer, rom_capacity);
+  w.U32(static_cast<uint32_t>(options.include_paths.size()));
+  for (const auto& path : options.include_paths) {
+    w.Str(path);
+  }
+  w.U32(static_cast<uint32_t>(options.defines.size()));
+  for (const auto& [name, value] : options.defines) {
+    w.Str(name);
+    w.Str(value);
+  }
+  w.Str(options.std_includes_path);
+  w.Str(options.std_defines_path);
+  w.U32(static_cast<uint32_t>(options.memory_files.size()));
+  for (const auto& file : options.memory_files) {
+    w.Str(file.path);
+    w.Str(file.contents);
+  }
+  w.Bool(options.full_call_stack);
+  w.Bool(options.override_checksum);
+  w.Bool(options.generate_checksum);
+  w.Bool(options.capture_nocash_symbols);
+  w.Bool(options.inject_snes_registers);
+  w.I32(options.max_include_depth);
+  w.I32(options.max_macro_depth);
+  return w.Take();
+}
+
+bool DecodeAssembleOptions(std::string_view data, const uint8_t* rom_buffer,
+                           size_t rom_capacity, z3dk::AssembleOptions* options) {
+  Reader r(data);
+  options->patch_path = r.Str();
+  options->rom_data = r.Rom(rom_buffer, rom_capacity);
+  options->include_paths.resize(r.Count());
+  for (auto& path : options->include_paths) {
+    path = r.Str();
+  }
+  options->defines.resize(r.Count());
+  for (auto& [name, value] : options->defines) {
+    name = r.Str();
+    value = r.Str();
+  }
+  options->std_includes_path = r.Str();
+  options->std_defines_path = r.Str();
+  options->memory_files.resize(r.Count());
+  for (auto& file : options->memory_files) {
+    file.path = r.Str();
+    file.contents = r.Str();
+  }
+  options->full_call_stack = r.Bool();
+  options->override_checksum = r.Bool();
+  options->generate_checksum = r.Bool();
+  options->capture_nocash_symbols = r.Bool();
+  options->inject_snes_registers = r.Bool();
+  options->max_include_depth = r.I32();
+  options->max_macro_depth = r.I32();
+  return r.ok();
+}
+
+std::string EncodeAssembleResult(const z3dk::AssembleResult& result,
+                                 uint8_t* rom_buffer, size_t rom_capacity) {
+  Writer w;
+  w.Bool(result.success);
+  w.U32(static_cast<uint32_t>(result.diagnostics.size()));
+  for (const auto& diag : result.diagnostics) {
+    w.U8(diag.severity == z3dk::DiagnosticSeverity::kError ? 0 : 1);
+    w.Str(diag.message);
+    w.Str(diag.filename);
+    w.I32(diag.line);
+    w.I32(diag.column);
+    w.Str(diag.raw);
+  }
+  w.U32(static_cast<uint32_t>(result.prints.size()));
+  for (const auto& print : result.prints) {
+    w.Str(print);
+  }
+  w.U32(static_cast<uint32_t>(result.labels.size()));
+  for (const auto& label : result.labels) {
+    w.Str(label.name);
+    w.U32(label.address);
+    w.Bool(label.used);
+  }
+  w.U32(static_cast<uint32_t>(result.defines.size()));
+  for (const auto& define : result.defines) {
+    w.Str(define.name);
+    w.Str(define.value);
+  }
+  w.U32(static_cast<uint32_t>(result.written_blocks.size()));
+  for (const auto& block : result.written_blocks) {
+    w.I32(block.pc_offset);
+    w.I32(block.snes_offset);
+    w.I32(block.num_bytes);
+  }
+  w.Rom(result.rom_data, rom_buffer, rom_capacity);
+  w.I32(result.rom_size);
+  w.I32(result.mapper);
+  w.U32(static_cast<uint32_t>(result.source_map.files.size()));
+  for (const auto& file : result.source_map.files) {
+    w.I32(file.id);
+    w.U32(file.crc);
+    w.Str(file.path);
+  }
+  w.U32(static_cast<uint32_t>(result.source_map.entries.size()));
+  for (const auto& entry : result.source_map.entries) {
+    w.U32(entry.address);
+    w.I32(entry.file_id);
+    w.I32(entry.line);
+  }
+  w.Str(result.wla_symbols);
+  w.Str(result.nocash_symbols);
+  w.U32(static_cast<uint32_t>(result.input_files.size()));
+  for (const auto& path : result.input_files) {
+    w.Str(path);
+  }
+  for (const auto* sigs : {&result.macros, &result.functions}) {
+    w.U32(static_cast<uint32_t>(sigs->size()));
+    for (const auto& sig : *sigs) {
+      w.Str(sig.name);
+      w.U32(static_cast<uint32_t>(sig.parameters.size()));
+      for (const auto& param : sig.parameters) {
+        w.Str(param);
+      }
+      w.Bool(sig.variadic);
+      w.Str(sig.filename);
+      w.I32(sig.line);
+    }
+  }
+  return w.Take();
+}
+
+bool DecodeAssembleResult(std::string_view data, const uint8_t* rom_buffer,
+                          size_t rom_capacity, z3dk::AssembleResult* result) {
+  Reader r(data);
+  result->success = r.Bool();
+  result->diagnostics.resize(r.Count());
+  for (auto& diag : result->diagnostics) {
+    diag.severity = r.U8() == 0 ? z3dk::DiagnosticSeverity::kError
+                                : z3dk::DiagnosticSeverity::kWarning;
+    diag.message = r.Str();
+    diag.filename = r.Str();
+    diag.line = r.I32();
+    diag.column = r.I32();
+    diag.raw = r.Str();
+  }
+  result->prints.resize(r.Count());
+  for (auto& print : result->prints) {
+    print = r.Str();
+  }
+  result->labels.resize(r.Count());
+  for (auto& label : result->labels) {
+    label.name = r.Str();
+    label.address = r.U32();
+    label.used = r.Bool();
+  }
+  result->defines.resize(r.Count());
+  for (auto& define : result->defines) {
+    define.name = r.Str();
+    define.value = r.Str();
+  }
+  result->written_blocks.resize(r.Count());
+  for (auto& block : result->written_blocks) {
+    block.pc_offset = r.I32();
+    block.snes_offset = r.I32();
+    block.num_bytes = r.I32();
+  }
+  result->rom_data = r.Rom(rom_buffer, rom_capacity);
+  result->rom_size = r.I32();
+  result->mapper = r.I32();
+  result->source_map.files.resize(r.Count());
+  for (auto& file : result->source_map.files) {
+    file.id = r.I32();
+    file.crc = r.U32();
+    file.path = r.Str();
+  }
+  result->source_map.entries.resize(r.Count());
+  for (auto& entry : result->source_map.entries) {
+    entry.address = r.U32();
+    entry.file_id = r.I32();
+    entry.line = r.I32();
+  }
+  result->wla_symbols = r.Str();
+  result->nocash_symbols = r.Str();
+  result->input_files.resize(r.Count());
+  for (auto& path : result->input_files) {
+    path = r.Str();
+  }
+  for (auto* sigs : {&result->macros, &result->functions}) {
+    sigs->resize(r.Count());
+    for (auto& sig : *sigs) {
+      sig.name = r.Str();
+      sig.parameters.resize(r.Count());
+      for (auto& param : sig.parameters) {
+        param = r.Str();
+      }
+      sig.variadic = r.Bool();
+      sig.filename = r.Str();
+      sig.line = r.I32();
+    }
+  }
+  return r.ok();
+}
+
+struct AssemblerPool::Worker {
+  int pid = -1;
+  int request_fd = -1;
+  int response_fd = -1;
+  int rom_fd = -1;
+  uint8_t* rom = nullptr;
+  bool busy = false;
+};
+
+AssemblerPool::AssemblerPool() = default;
+AssemblerPool::~AssemblerPool() { Stop(); }
+
+bool AssemblerPool::Start(const AssemblerPoolOptions& options, std::string* error) {
+  Stop();
+  options_ = options;
+  if (options.workers <= 0) {
+    return true;
+  }
+  // A worker dying mid-write must not take the server down with SIGPIPE.
+  signal(SIGPIPE, SIG_IGN);
+
+  static std::atomic<int> counter{0};
+  for (int i = 0; i < options.workers; ++i) {
+    auto worker = std::make_unique<Worker>();
+    std::string name = "/z3lsp-" + std::to_string(getpid()) + "-" +
+                       std::to_string(counter++);
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd >= 0) {
+      // the descriptor keeps it alive; nothing else needs the name
+      shm_unlink(name.c_str());
+    }
+    worker->rom_fd = MoveAbove(fd);
+    if (worker->rom_fd < 0 ||
+        ftruncate(worker->rom_fd, static_cast<off_t>(options.rom_capacity)) != 0) {
+      if (error) *error = "shm_open failed: " + std::string(std::strerror(errno));
+      if (worker->rom_fd >= 0) close(worker->rom_fd);
+      Stop();
+      return false;
+    }
+    void* mapped = mmap(nullptr, options.rom_capacity, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, worker->rom_fd, 0);
+    if (mapped == MAP_FAILED) {
+      if (error) *error = "mmap failed: " + std::string(std::strerror(errno));
+      close(worker->rom_fd);
+      Stop();
+      return false;
+    }
+    worker->rom = static_cast<uint8_t*>(mapped);
+    if (!Spawn(worker.get(), error)) {
+      munmap(worker->rom, options.rom_capacity);
+      close(worker->rom_fd);
+      Stop();
+      return false;
+    }
+    workers_.push_back(std::move(worker));
+  }
+  return true;
+}
+
+void AssemblerPool::Stop() {
+  for (auto& worker : workers_) {
+    Reap(worker.get(), false);
+    if (worker->rom != nullptr) {
+      munmap(worker->rom, options_.rom_capacity);
+    }
+    if (worker->rom_fd >= 0) {
+      close(worker->rom_fd);
+    }
+  }
+  workers_.clear();
+}
+
+int AssemblerPool::restarts() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return restarts_;
+}
+
+std::vector<int> AssemblerPool::worker_pids() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int> pids;
+  for (const auto& worker : workers_) {
+    pids.push_back(worker->pid);
+  }
+  return pids;
+}
+
+bool AssemblerPool::Spawn(Worker* worker, std::string* error) {
+  // pipe() descriptors aren't close-on-exec until MoveAbove; serializing
+  // spawns keeps one worker from inheriting another's pipe ends (which
+  // would hide that worker's death).
+  static std::mutex spawn_mutex;
+  std::lock_guard<std::mutex> spawn_lock(spawn_mutex);
+  int to_child[2];
+  int from_child[2];
+  if (pipe(to_child) != 0) {
+    if (error) *error = "pipe failed: " + std::string(std::strerror(errno));
+    return false;
+  }
+  if (pipe(from_child) != 0) {
+    if (error) *error = "pipe failed: " + std::string(std::strerror(errno));
+    close(to_child[0]);
+    close(to_child[1]);
+    return false;
+  }
+  int child_request = MoveAbove(to_child[0]);
+  int parent_request = MoveAbove(to_child[1]);
+  int parent_response = MoveAbove(from_child[0]);
+  int child_response = MoveAbove(from_child[1]);
+  int null_fd = MoveAbove(open("/dev/null", O_RDWR));
+
+  // Everything the child touches between fork and exec is prepared here;
+  // the parent may have other threads running.
+  std::string path = options_.worker_path;
+  std::string flag = "--assembler-worker";
+  char* argv[] = {path.data(), flag.data(), nullptr};
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(child_request, kWorkerRequestFd);
+    dup2(child_response, kWorkerResponseFd);
+    dup2(worker->rom_fd, kWorkerRomFd);
+    if (null_fd >= 0) {
+      // stdout is the LSP channel; a stray print must not reach it
+      dup2(null_fd, STDIN_FILENO);
+      dup2(null_fd, STDOUT_FILENO);
+    }
+    execv(argv[0], argv);
+    _exit(127);
+  }
+  close(child_request);
+  close(child_response);
+  if (null_fd >= 0) {
+    close(null_fd);
+  }
+  if (pid < 0) {
+    if (error) *error = "fork failed: " + std::string(std::strerror(errno));
+    close(parent_request);
+    close(parent_response);
+    return false;
+  }
+  worker->pid = pid;
+  worker->request_fd = parent_request;
+  worker->response_fd = parent_response;
+  return true;
+}
+
+void AssemblerPool::Reap(Worker* worker, bool force) {
+  if (worker->request_fd >= 0) {
+    close(worker->request_fd);
+    worker->request_fd = -1;
+  }
+  if (worker->response_fd >= 0) {
+    close(worker->response_fd);
+    worker->response_fd = -1;
+  }
+  if (worker->pid > 0) {
+    // an idle worker exits once its request pipe closes
+    int status = 0;
+    bool exited = false;
+    for (int i = 0; i < 20 && !force; ++i) {
+      if (waitpid(worker->pid, &status, WNOHANG) == worker->pid) {
+        exited = true;
+        break;
+      }
+      usleep(5000);
+    }
+    if (!exited) {
+      kill(worker->pid, SIGKILL);
+      waitpid(worker->pid, &status, 0);
+    }
+  }
+  worker->pid = -1;
+}
+
+AssemblerPool::Worker* AssemblerPool::Acquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  Worker* found = nullptr;
+  idle_.wait(lock, [&] {
+    for (auto& worker : workers_) {
+      if (!worker->busy) {
+        found = worker.get();
+        return true;
+      }
+    }
+    return false;
+  });
+  found->busy = true;
+  return found;
+}
+
+void AssemblerPool::Release(Worker* worker) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    worker->busy = false;
+  }
+  idle_.notify_one();
+}
+
+bool AssemblerPool::RunJob(Worker* worker, const z3dk::AssembleOptions& options,
+                           z3dk::AssembleResult* result, std::string* failure) {
+  std::string request = EncodeAssembleOptions(options, worker->rom, options_.rom_capacity);
+  std::string response;
+  bool timed_out = false;
+  auto deadline = std::chrono::steady_clock::now() + options_.timeout;
+  if (WriteFrame(worker->request_fd, request) &&
+      ReadFrame(worker->response_fd, &response, &deadline, &timed_out)) {
+    if (DecodeAssembleResult(response, worker->rom, options_.rom_capacity, result)) {
+      return true;
+    }
+    *failure = "sent a malformed result";
+    return false;
+  }
+  if (timed_out) {
+    *failure = "timed out after " + std::to_string(options_.timeout.count()) + " ms";
+    return false;
+  }
+  *failure = "closed its pipe";
+  for (int i = 0; i < 20; ++i) {
+    int status = 0;
+    if (waitpid(worker->pid, &status, WNOHANG) == worker->pid) {
+      worker->pid = -1;
+      *failure = DescribeExit(status);
+      break;
+    }
+    usleep(5000);
+  }
+  return false;
+}
+
+z3dk::AssembleResult AssemblerPool::Assemble(const z3dk::AssembleOptions& options) {
+  if (!running()) {
+    std::lock_guard<std::mutex> lock(in_process_mutex_);
+    return z3dk::Assembler().Assemble(options);
+  }
+
+  Worker* worker = Acquire();
+  std::string failure;
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    if (worker->pid < 0) {
+      std::string spawn_error;
+      if (!Spawn(worker, &spawn_error)) {
+        failure = "could not be restarted: " + spawn_error;
+        break;
+      }
+    }
+    z3dk::AssembleResult result;
+    if (RunJob(worker, options, &result, &failure)) {
+      Release(worker);
+      return result;
+    }
+    Log("Assembler worker " + failure + " on " + options.patch_path + "; restarting");
+    Reap(worker, true);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++restarts_;
+    }
+  }
+  Release(worker);
+  return FailedResult(options, "Assembler worker " + failure + " while assembling");
+}
+
+int RunAssemblerWorker() {
+  struct stat info;
+  if (fstat(kWorkerRomFd, &info) != 0) {
+    return 2;
+  }
+  size_t capacity = static_cast<size_t>(info.st_size);
+  uint8_t* rom = nullptr;
+  if (capacity > 0) {
+    void* mapped = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        kWorkerRomFd, 0);
+    if (mapped == MAP_FAILED) {
+      return 2;
+    }
+    rom = static_cast<uint8_t*>(mapped);
+  }
+
+  z3dk::Assembler assembler;
+  std::string request;
+  while (ReadFrame(kWorkerRequestFd, &request)) {
+    z3dk::AssembleOptions options;
+    if (!DecodeAssembleOptions(request, rom, capacity, &options)) {
+      return 2;
+    }
+    z3dk::AssembleResult result = assembler.Assemble(options);
+    if (!WriteFrame(kWorkerResponseFd, EncodeAssembleResult(result, rom, capacity))) {
+      break;
+    }
+  }
+  return 0;
+}
+
+std::string CurrentExecutablePath(const char* argv0) {
+  std::error_code ec;
+  fs::path self = fs::read_symlink("/proc/self/exe", ec);
+  if (!ec && !self.empty()) {
+    return self.string();
+  }
+  if (argv0 == nullptr) {
+    return {};
+  }
+  fs::path path(argv0);
+  if (path.has_parent_path()) {
+    return fs::absolute(path, ec).string();
+  }
+  // bare name: resolve through PATH like execvp would
+  const char* env_path = std::getenv("PATH");
+  std::string dirs = env_path ? env_path : "";
+  size_t start = 0;
+  while (start <= dirs.size()) {
+    size_t end = dirs.find(':', start);
+    if (end == std::string::npos) {
+      end = dirs.size();
+    }
+    fs::path candidate = fs::path(dirs.substr(start, end - start)) / path;
+    if (access(candidate.c_str(), X_OK) == 0) {
+      return fs::absolute(candidate, ec).string();
+    }
+    start = end + 1;
+  }
+  return path.string();
+}
+
+}  // namespace z3lsp
@@ -0,0 +1,92 @@
+#ifndef Z3LSP_ASSEMBLER_POOL_H_
+#define Z3LSP_ASSEMBLER_POOL_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "z3dk_core/assembler.h"
+
+namespace z3lsp {
+
+struct AssemblerPoolOptions {
+  // 0 assembles in-process, one job at a time.
+  int workers = 2;
+  // Executable started as `<worker_path> --assembler-worker`.
+  std::string worker_path;
+  // Per-worker shared buffer for ROM images; larger ROMs go through the pipe.
+  size_t rom_capacity = 16 * 1024 * 1024;
+  // A job running longer than this kills (and replaces) its worker.
+  std::chrono::milliseconds timeout{30000};
+};
+
+// The Asar core keeps its state in globals, so assemblies can't overlap in
+// one process and a crash in the core takes the caller down with it. Each
+// worker is a separate process holding a warm assembler; jobs and results
+// go over pipes in a compact binary form, with ROM images in a shared-memory
+// buffer per worker. A worker that dies or times out is replaced and the job
+// is retried once on the fresh process.
+class AssemblerPool {
+ public:
+  AssemblerPool();
+  ~AssemblerPool();
+  AssemblerPool(const AssemblerPool&) = delete;
+  AssemblerPool& operator=(const AssemblerPool&) = delete;
+
+  bool Start(const AssemblerPoolOptions& options, std::string* error);
+  void Stop();
+  bool running() const { return !workers_.empty(); }
+  int size() const { return static_cast<int>(workers_.size()); }
+  int restarts() const;
+  std::vector<int> worker_pids() const;
+
+  // Thread-safe. Blocks until a worker is free, so up to size() calls run
+  // at once. Falls back to in-process assembly when the pool isn't running.
+  z3dk::AssembleResult Assemble(const z3dk::AssembleOptions& options);
+
+ private:
+  struct Worker;
+
+  Worker* Acquire();
+  void Release(Worker* worker);
+  bool Spawn(Worker* worker, std::string* error);
+  void Reap(Worker* worker, bool force);
+  bool RunJob(Worker* worker, const z3dk::AssembleOptions& options,
+              z3dk::AssembleResult* result, std::string* failure);
+
+  AssemblerPoolOptions options_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  mutable std::mutex mutex_;
+  std::condition_variable idle_;
+  std::mutex in_process_mutex_;
+  int restarts_ = 0;
+};
+
+extern AssemblerPool g_assembler_pool;
+
+// Entry point for `z3lsp --assembler-worker`; returns the exit code.
+int RunAssemblerWorker();
+
+// Path of the running executable, for AssemblerPoolOptions::worker_path.
+std::string CurrentExecutablePath(const char* argv0);
+
+// Wire format. ROM images go into `rom_buffer` when they fit in
+// `rom_capacity` bytes and inline otherwise; pass a null buffer to always
+// inline them.
+std::string EncodeAssembleOptions(const z3dk::AssembleOptions& options,
+                                  uint8_t* rom_buffer, size_t rom_capacity);
+bool DecodeAssembleOptions(std::string_view data, const uint8_t* rom_buffer,
+                           size_t rom_capacity, z3dk::AssembleOptions* options);
+std::string EncodeAssembleResult(const z3dk::AssembleResult& result,
+                                 uint8_t* rom_buffer, size_t rom_capacity);
+bool DecodeAssembleResult(std::string_view data, const uint8_t* rom_buffer,
+                          size_t rom_capacity, z3dk::AssembleResult* result);
+
+}  // namespace z3lsp
+
+#endif  // Z3LSP_ASSEMBLER_POOL_H_
@@ -0,0 +1,135 @@
+#include "bank_usage.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace z3lsp {
+
+BankUsage::Key BankUsage::KeyOf(const z3dk::WrittenBlock& block) {
+  return {block.pc_offset, block.num_bytes, block.snes_offset};
+}
+
+void BankUsage::Update(const std::string& uri,
+                       const std::vector<z3dk::WrittenBlock>& blocks) {
+  std::vector<Key> next;
+  next.reserve(blocks.size());
+  for (const auto& block : blocks) {
+    if (block.pc_offset < 0 || block.num_bytes <= 0) continue;
+    next.push_back(KeyOf(block));
+  }
+  std::sort(next.begin(), next.end());
+  next.erase(std::unique(next.begin(), next.end()), next.end());
+
+  std::vector<Key>& previous = documents_[uri];
+  if (previous == next) return;
+
+  std::vector<Key> removed;
+  std::vector<Key> added;
+  std::set_difference(previous.begin(), previous.end(), next.begin(), next.end(),
+                      std::back_inserter(removed));
+  std::set_difference(next.begin(), next.end(), previous.begin(), previous.end(),
+                      std::back_inserter(added));
+  std::vector<int> dirty;
+  for (const auto& key : removed) Apply(key, -1, &dirty);
+  for (const auto& key : added) Apply(key, 1, &dirty);
+  previous = std::move(next);
+
+  std::sort(dirty.begin(), dirty.end());
+  dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+  for (int bank : dirty) Recompute(bank);
+}
+
+void BankUsage::Remove(const std::string& uri) {
+  auto it = documents_.find(uri);
+  if (it == documents_.end()) return;
+  std::vector<int> dirty;
+  for (const auto& key : it->second) Apply(key, -1, &dirty);
+  documents_.erase(it);
+  std::sort(dirty.begin(), dirty.end());
+  dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+  for (int bank : dirty) Recompute(bank);
+}
+
+void BankUsage::Apply(const Key& key, int delta, std::vector<int>* dirty) {
+  const auto& [pc, size, snes] = key;
+  // a block that runs past the end of a bank counts in every bank it touches
+  int first = pc / kBankSize;
+  int last = (pc + size - 1) / kBankSize;
+  if (static_cast<int>(banks_.size()) <= last) banks_.resize(last + 1);
+  for (int bank = first; bank <= last; ++bank) {
+    auto& blocks = banks_[bank].blocks;
+    int& count = blocks[key];
+    count += delta;
+    if (count <= 0) blocks.erase(key);
+    dirty->push_back(bank);
+  }
+}
+
+void BankUsage::Recompute(int bank) {
+  BankState& state = banks_[bank];
+  BankStats stats;
+  stats.bank = bank;
+  stats.blocks = static_cast<int>(state.blocks.size());
+  stats.free_runs = 0;
+  const int bank_start = bank * kBankSize;
+  const int bank_end = bank_start + kBankSize;
+  // blocks are ordered by start, so one sweep merges the overlaps
+  int covered_to = bank_start;
+  auto add_free = [&stats](int length) {
+    if (length <= 0) return;
+    ++stats.free_runs;
+    stats.largest_free = std::max(stats.largest_free, length);
+  };
+  for (const auto& [key, count] : state.blocks) {
+    int start = std::max(std::get<0>(key), bank_start);
+    int end = std::min(std::get<0>(key) + std::get<1>(key), bank_end);
+    if (end <= covered_to) continue;
+    if (start > covered_to) add_free(start - covered_to);
+    stats.used += end - std::max(start, covered_to);
+    covered_to = end;
+  }
+  add_free(bank_end - covered_to);
+  state.stats = stats;
+}
+
+const BankStats* BankUsage::Bank(int bank) const {
+  if (bank < 0 || bank >= static_cast<int>(banks_.size()) || banks_[bank].blocks.empty()) {
+    return nullptr;
+  }
+  return &banks_[bank].stats;
+}
+
+std::vector<BankStats> BankUsage::Banks() const {
+  std::vector<BankStats> out;
+  for (const auto& state : banks_) {
+    if (!state.blocks.empty()) out.push_back(state.stats);
+  }
+  return out;
+}
+
+std::vector<z3dk::WrittenBlock> BankUsage::Blocks(int bank) const {
+  std::vector<z3dk::WrittenBlock> out;
+  if (bank < 0 || bank >= static_cast<int>(banks_.size())) return out;
+  for (const auto& [key, count] : banks_[bank].blocks) {
+    z3dk::WrittenBlock block;
+    std::tie(block.pc_offset, block.num_bytes, block.snes_offset) = key;
+    out.push_back(block);
+  }
+  return out;
+}
+
+std::vector<z3dk::WrittenBlock> BankUsage::Blocks() const {
+  std::vector<z3dk::WrittenBlock> out;
+  for (int bank = 0; bank < static_cast<int>(banks_.size()); ++bank) {
+    for (const auto& [key, count] : banks_[bank].blocks) {
+      // blocks that span banks are listed from the first one only
+      if (std::get<0>(key) / kBankSize != bank) continue;
+      z3dk::WrittenBlock block;
+      std::tie(block.pc_offset, block.num_bytes, block.snes_offset) = key;
+      out.push_back(block);
+    }
+  }
+  return out;
+}
+
+}  // namespace z3lsp
@@ -0,0 +1,64 @@
+#ifndef Z3LSP_BANK_USAGE_H_
+#define Z3LSP_BANK_USAGE_H_
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "z3dk_core/assembler.h"
+
+namespace z3lsp {
+
+struct BankStats {
+  int bank = 0;
+  // bytes at least one block writes
+  int used = 0;
+  // longest run no block writes
+  int largest_free = 0;
+  // separate free runs, so more means more fragmented
+  int free_runs = 1;
+  int blocks = 0;
+};
+
+// What the open documents write to the ROM, per 32 KiB bank of file offsets.
+// Documents assembled from the same main file write the same blocks, so
+// blocks are counted per writer and only dropped with the last one. Each
+// update only recomputes the banks whose blocks changed, and the stats are
+// stored, so asking for a bank is an index into a vector.
+class BankUsage {
+ public:
+  static constexpr int kBankSize = 0x8000;
+
+  // Replaces what `uri` wrote with `blocks`.
+  void Update(const std::string& uri, const std::vector<z3dk::WrittenBlock>& blocks);
+  void Remove(const std::string& uri);
+
+  // null for a bank nothing writes to
+  const BankStats* Bank(int bank) const;
+  // the banks something writes to, in order
+  std::vector<BankStats> Banks() const;
+  // every distinct block, in file order
+  std::vector<z3dk::WrittenBlock> Blocks() const;
+  std::vector<z3dk::WrittenBlock> Blocks(int bank) const;
+
+ private:
+  using Key = std::tuple<int, int, int>;  // pc, size, snes
+
+  struct BankState {
+    // block -> how many documents write it
+    std::map<Key, int> blocks;
+    BankStats stats;
+  };
+
+  static Key KeyOf(const z3dk::WrittenBlock& block);
+  void Apply(const Key& key, int delta, std::vector<int>* dirty);
+  void Recompute(int bank);
+
+  std::vector<BankState> banks_;
+  std::unordered_map<std::string, std::vector<Key>> documents_;
+};
+
+}  // namespace z3lsp
+
+#endif  // Z3LSP_BANK_USAGE_H_
@@ -1,6 +1,7 @@
 #include "logging.h"
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <cstdlib>
 #include "utils.h"
 
@@ -45,6 +46,9 @@ void Log(const std::string& msg) {
   if (!g_log_enabled) {
     return;
   }
+  // assembler pool threads log worker restarts
+  static std::mutex log_mutex;
+  std::lock_guard<std::mutex> lock(log_mutex);
   const std::string& resolved_path = g_log_path.empty() ? DefaultLogPath() : g_log_path;
   static std::string current_path;
   static std::ofstream log_file;
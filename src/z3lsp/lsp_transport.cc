@@ -1,4 +1,6 @@
 #include "lsp_transport.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <string>
 #include "logging.h"
@@ -6,13 +8,20 @@
 namespace z3lsp {
 
 std::optional<json> ReadMessage() {
+  return ReadMessage(std::cin);
+}
+
+std::optional<json> ReadMessage(std::istream& input) {
   std::string line;
-  int content_length = 0;
-  while (std::getline(std::cin, line)) {
+  long long content_length = 0;
+  while (std::getline(input, line)) {
     if (line.rfind("Content-Length:", 0) == 0) {
-      if (line.size() > 15) {
-        content_length = std::stoi(line.substr(15));
-      }
+      // a malformed length drops the message instead of throwing out of the
+      // server loop
+      const char* begin = line.c_str() + 15;
+      while (*begin == ' ' || *begin == '\t') ++begin;
+      content_length = 0;
+      std::from_chars(begin, line.c_str() + line.size(), content_length);
     } else if (line == "\r" || line.empty()) {
       break;
     }
@@ -22,8 +31,16 @@ std::optional<json> ReadMessage() {
     return std::nullopt;
   }
 
-  std::string payload(content_length, '\0');
-  std::cin.read(payload.data(), content_length);
+  // read in chunks so a bogus length can't allocate more than the stream has
+  std::string payload;
+  char chunk[4096];
+  while (content_length > 0 && input) {
+    std::streamsize want = static_cast<std::streamsize>(
+        std::min<long long>(content_length, sizeof(chunk)));
+    input.read(chunk, want);
+    payload.append(chunk, static_cast<size_t>(input.gcount()));
+    content_length -= input.gcount();
+  }
   try {
     return json::parse(payload);
   } catch (const std::exception& e) {
@@ -1,6 +1,7 @@
 #ifndef Z3LSP_LSP_TRANSPORT_H_
 #define Z3LSP_LSP_TRANSPORT_H_
 
+#include <istream>
 #include <optional>
 #include <nlohmann/json.hpp>
 
@@ -8,7 +9,10 @@ namespace z3lsp {
 
 using json = nlohmann::json;
 
+// Reads one Content-Length framed message from stdin, or from `input`.
+// Returns nullopt for a missing or malformed header or payload.
 std::optional<json> ReadMessage();
+std::optional<json> ReadMessage(std::istream& input);
 void SendMessage(const json& message);
 
 }  // namespace z3lsp
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <fstream>
 #include <iomanip>
+#include <future>
 
 #include "nlohmann/json.hpp"
 #include "z3dk_core/assembler.h"
@@ -19,6 +20,8 @@
 #include "z3dk_core/snes_knowledge_base.h"
 #include "z3dk_core/snes_diagnostics.h"
 
+#include "assembler_pool.h"
+#include "bank_usage.h"
 #include "logging.h"
 #include "utils.h"
 #include "state.h"
@@ -154,9 +157,30 @@ json BuildWorkspaceSymbols(const z3lsp::WorkspaceState& workspace,
   return result;
 }
 
-z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
-                               const z3lsp::WorkspaceState& workspace,
-                               const std::unordered_map<std::string, z3lsp::DocumentState>* open_documents) {
+// Full analysis runs in three steps so the assembly in the middle can be
+// handed to the worker pool while other documents are prepared or finished.
+struct AnalysisPlan {
+  const z3lsp::DocumentState* doc = nullptr;
+  z3lsp::DocumentState updated;
+  // Set when no assembly is needed and `updated` is already final.
+  bool done = false;
+  z3dk::AssembleOptions options;
+  z3dk::Config config;
+  fs::path config_dir;
+  fs::path analysis_root_path;
+  fs::path analysis_root_dir;
+  fs::path doc_path;
+  bool doc_is_root = false;
+  std::vector<std::string> include_paths_for_parent_check;
+  std::vector<z3lsp::DocumentState::SymbolEntry> doc_symbols;
+  std::unordered_set<std::string> known_symbols;
+};
+
+AnalysisPlan PrepareAnalysis(const z3lsp::DocumentState& doc,
+                             const z3lsp::WorkspaceState& workspace,
+                             const std::unordered_map<std::string, z3lsp::DocumentState>* open_documents) {
+  AnalysisPlan plan;
+  plan.doc = &doc;
   z3lsp::DocumentState updated = doc;
 
   z3dk::Config config;
@@ -238,9 +262,12 @@ z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
     updated.defines.clear();
     updated.source_map = z3dk::SourceMap{};
     updated.written_blocks.clear();
+    updated.signatures.Clear();
     updated.BuildLookupMaps();
     updated.needs_analysis = false;
-    return updated;
+    plan.updated = std::move(updated);
+    plan.done = true;
+    return plan;
   }
 
   z3dk::AssembleOptions options;
@@ -274,6 +301,8 @@ z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
   if (options.rom_data.empty() && config.rom_size.has_value() && *config.rom_size > 0) {
     options.rom_data.resize(static_cast<size_t>(*config.rom_size), 0);
   }
+  options.max_include_depth = config.max_include_depth.value_or(0);
+  options.max_macro_depth = config.max_macro_depth.value_or(0);
   if (open_documents) {
     std::unordered_map<std::string, std::string> memory_map;
     for (const auto& entry : *open_documents) {
@@ -293,9 +322,34 @@ z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
     options.memory_files.push_back({doc.path, doc.text});
   }
 
-  z3dk::Assembler assembler;
-  z3dk::AssembleResult result = assembler.Assemble(options);
-  
+  plan.updated = std::move(updated);
+  plan.options = std::move(options);
+  plan.config = std::move(config);
+  plan.config_dir = std::move(config_dir);
+  plan.analysis_root_path = std::move(analysis_root_path);
+  plan.analysis_root_dir = std::move(analysis_root_dir);
+  plan.doc_path = std::move(doc_path);
+  plan.doc_is_root = doc_is_root;
+  plan.include_paths_for_parent_check = std::move(include_paths_for_parent_check);
+  plan.doc_symbols = std::move(doc_symbols);
+  plan.known_symbols = std::move(known_symbols);
+  return plan;
+}
+
+z3lsp::DocumentState FinishAnalysis(AnalysisPlan& plan, const z3dk::AssembleResult& result,
+                                    const z3lsp::WorkspaceState& workspace) {
+  const z3lsp::DocumentState& doc = *plan.doc;
+  z3lsp::DocumentState& updated = plan.updated;
+  const z3dk::Config& config = plan.config;
+  const fs::path& config_dir = plan.config_dir;
+  const fs::path& analysis_root_path = plan.analysis_root_path;
+  const fs::path& analysis_root_dir = plan.analysis_root_dir;
+  const fs::path& doc_path = plan.doc_path;
+  const bool doc_is_root = plan.doc_is_root;
+  const auto& include_paths_for_parent_check = plan.include_paths_for_parent_check;
+  auto& doc_symbols = plan.doc_symbols;
+  auto& known_symbols = plan.known_symbols;
+
   z3dk::LintOptions lint_options;
   lint_options.warn_bank_full_percent = 95;
   if (config.warn_unused_symbols.has_value()) {
@@ -448,6 +502,7 @@ z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
   updated.defines = result.defines;
   updated.source_map = result.source_map;
   updated.written_blocks = result.written_blocks;
+  updated.signatures.Build(result.macros, result.functions);
   updated.symbols = std::move(doc_symbols);
 
   // Include labels and defines from this assembly so missing-label suppression works
@@ -543,7 +598,18 @@ z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
     }
   }
 
-  return updated;
+  return std::move(updated);
+}
+
+z3lsp::DocumentState AnalyzeDocumentFull(const z3lsp::DocumentState& doc,
+                               const z3lsp::WorkspaceState& workspace,
+                               const std::unordered_map<std::string, z3lsp::DocumentState>* open_documents) {
+  AnalysisPlan plan = PrepareAnalysis(doc, workspace, open_documents);
+  if (plan.done) {
+    return std::move(plan.updated);
+  }
+  z3dk::AssembleResult result = z3lsp::g_assembler_pool.Assemble(plan.options);
+  return FinishAnalysis(plan, result, workspace);
 }
 
 std::optional<json> HandleRename(const DocumentState& doc, WorkspaceState& workspace, 
@@ -559,7 +625,7 @@ std::optional<json> HandleRename(const DocumentState& doc, WorkspaceState& works
   auto position = params["position"];
   int line = position.value("line", 0);
   int character = position.value("character", 0);
-  auto token_opt = z3lsp::ExtractTokenAt(doc.text, line, character);
+  auto token_opt = z3lsp::ExtractTokenAt(doc.text, doc.line_starts, line, character);
   if (!token_opt.has_value()) {
     return std::nullopt;
   }
@@ -644,23 +710,13 @@ std::optional<json> HandleDefinition(const DocumentState& doc, const json& param
   auto position = params["position"];
   int line = position.value("line", 0);
   int character = position.value("character", 0);
-  auto token = z3lsp::ExtractTokenAt(doc.text, line, character);
+  auto token = z3lsp::ExtractTokenAt(doc.text, doc.line_starts, line, character);
   if (!token.has_value()) {
     return json(nullptr);
   }
 
   // Check if we are on an incsrc or incbin line
-  std::string line_text;
-  size_t start = 0;
-  for (int i = 0; i < line; ++i) {
-    start = doc.text.find('\n', start);
-    if (start == std::string::npos) break;
-    start++;
-  }
-  if (start != std::string::npos) {
-    size_t end = doc.text.find('\n', start);
-    line_text = doc.text.substr(start, end == std::string::npos ? std::string::npos : end - start);
-  }
+  std::string line_text(doc.LineText(line));
 
   std::string trimmed = z3lsp::Trim(z3lsp::StripAsmComment(line_text));
   std::string include_path;
@@ -728,7 +784,7 @@ std::optional<json> HandleHover(const DocumentState& doc, const WorkspaceState&
   auto position = params["position"];
   int line = position.value("line", 0);
   int character = position.value("character", 0);
-  auto token = z3lsp::ExtractTokenAt(doc.text, line, character);
+  auto token = z3lsp::ExtractTokenAt(doc.text, doc.line_starts, line, character);
   if (!token.has_value()) {
     return json(nullptr);
   }
@@ -901,7 +957,7 @@ json BuildCompletionItems(const DocumentState& doc, const WorkspaceState& worksp
       "db", "dw", "dl", "dd", "dq", "define", "elif", "elseif", "else", "endif",
       "endmacro", "endstruct", "endwhile", "endfor", "error", "fill",
       "fillbyte", "fillword", "freecode", "freedata", "freespace", "hirom",
-      "if", "incbin", "incgfx", "incmsg", "incsrc", "include", "incdir", "lorom", "exlorom",
+      "if", "incbin", "inclz", "incgfx", "incmsg", "incsrc", "include", "incdir", "lorom", "exlorom",
       "exhirom", "macro", "namespace", "org", "pad", "padbyte", "padword",
       "pc2snes", "print", "pullpc", "pushpc", "pushns", "popns", "snes2pc",
       "struct", "table", "undef", "warn", "warning", "while", "for",
@@ -1058,7 +1114,7 @@ json BuildSemanticTokens(const DocumentState& doc) {
         "db", "dw", "dl", "dd", "dq", "define", "elif", "elseif", "else", "endif",
         "endmacro", "endstruct", "endwhile", "endfor", "error", "fill",
         "fillbyte", "fillword", "freecode", "freedata", "freespace", "hirom",
-        "if", "incbin", "incgfx", "incmsg", "incsrc", "include", "incdir", "lorom", "exlorom",
+        "if", "incbin", "inclz", "incgfx", "incmsg", "incsrc", "include", "incdir", "lorom", "exlorom",
         "exhirom", "macro", "namespace", "org", "pad", "padbyte", "padword",
         "pc2snes", "print", "pullpc", "pushpc", "pushns", "popns", "snes2pc",
         "struct", "table", "undef", "warn", "warning", "while", "for",
@@ -1306,12 +1362,26 @@ json BuildSemanticTokens(const DocumentState& doc) {
 }  // namespace
 
 int main(int argc, char** argv) {
-  (void)argc;
-  (void)argv;
+  std::optional<int> cli_workers;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--assembler-worker") {
+      return z3lsp::RunAssemblerWorker();
+    }
+    if (arg.rfind("--workers=", 0) == 0) {
+      cli_workers = std::atoi(arg.c_str() + std::string("--workers=").size());
+    }
+  }
 
   z3lsp::WorkspaceState workspace;
   std::unordered_map<std::string, z3lsp::DocumentState> documents;
   bool shutting_down = false;
+  // What mesen.hotPatch last wrote into the emulator, so the next patch
+  // diffs against it and also reverts bytes the new build no longer writes.
+  std::vector<uint8_t> hot_patch_rom;
+  std::vector<z3dk::WrittenBlock> hot_patch_blocks;
+  // written blocks of the open documents, kept per bank for z3dk.getBankUsage
+  z3lsp::BankUsage bank_usage;
 
   // Debounce settings: delay full analysis until typing pauses
   constexpr auto kDebounceDelay = std::chrono::milliseconds(500);
@@ -1341,11 +1411,11 @@ int main(int argc, char** argv) {
            {{"textDocumentSync", 1},
             {"definitionProvider", true},
             {"hoverProvider", true},
-            {"executeCommandProvider", {{"commands", json::array({"mesen.toggleBreakpoint", "mesen.syncSymbols", "mesen.showCpuState", "mesen.stepInstruction"})}}},
+            {"executeCommandProvider", {{"commands", json::array({"mesen.toggleBreakpoint", "mesen.syncSymbols", "mesen.showCpuState", "mesen.stepInstruction", "mesen.hotPatch"})}}},
             {"completionProvider",
              {{"triggerCharacters", json::array({"!", ".", "@"})}}},
             {"signatureHelpProvider", 
-             {{"triggerCharacters", json::array({"(", ","})}}},
+             {{"triggerCharacters", json::array({"(", ",", " "})}}},
             {"inlayHintProvider", {{"resolveProvider", false}}},
             {"inlayHintProvider", {{"resolveProvider", false}}},
             {"referencesProvider", true},
@@ -1366,6 +1436,18 @@ int main(int argc, char** argv) {
           {"result", capabilities},
       };
       z3lsp::SendMessage(response);
+
+      z3lsp::AssemblerPoolOptions pool_options;
+      if (cli_workers.has_value()) {
+        pool_options.workers = *cli_workers;
+      } else if (workspace.config.has_value() && workspace.config->lsp_workers.has_value()) {
+        pool_options.workers = *workspace.config->lsp_workers;
+      }
+      pool_options.worker_path = z3lsp::CurrentExecutablePath(argv[0]);
+      std::string pool_error;
+      if (!z3lsp::g_assembler_pool.Start(pool_options, &pool_error)) {
+        z3lsp::Log("Assembler pool unavailable, assembling in-process: " + pool_error);
+      }
       continue;
     }
 
@@ -1458,28 +1540,79 @@ int main(int argc, char** argv) {
         } else {
            response["result"] = "Failed to step execution";
         }
+      } else if (command == "mesen.hotPatch") {
+        // arguments: [{"rom": new build, "loaded": ROM the emulator started
+        // with (defaults to the last hot patch), "pause": true}]
+        json opts = (!args.empty() && args[0].is_object()) ? args[0] : json::object();
+        std::vector<uint8_t> built;
+        std::vector<uint8_t> loaded = hot_patch_rom;
+        std::string rom_path = opts.value("rom", std::string());
+        std::string loaded_path = opts.value("loaded", std::string());
+        if (!loaded_path.empty() && !z3lsp::LoadRomData(loaded_path, &loaded)) {
+          loaded.clear();
+        }
+        if (rom_path.empty() || !z3lsp::LoadRomData(rom_path, &built)) {
+          response["result"] = "Hot patch failed: can't read the built ROM";
+        } else if (loaded.empty()) {
+          response["result"] = "Hot patch failed: no loaded ROM to diff against";
+        } else {
+          std::vector<z3dk::WrittenBlock> blocks = hot_patch_blocks;
+          for (const auto& pair : documents) {
+            blocks.insert(blocks.end(), pair.second.written_blocks.begin(),
+                          pair.second.written_blocks.end());
+          }
+          z3lsp::HotPatchOptions patch_options;
+          patch_options.pause = opts.value("pause", true);
+          z3lsp::HotPatchResult patched = z3lsp::g_mesen.HotPatch(loaded, built, blocks, patch_options);
+          if (patched.success) {
+            hot_patch_rom = std::move(built);
+            hot_patch_blocks.clear();
+            for (const auto& pair : documents) {
+              hot_patch_blocks.insert(hot_patch_blocks.end(), pair.second.written_blocks.begin(),
+                                      pair.second.written_blocks.end());
+            }
+            response["result"] = "Patched " + std::to_string(patched.bytes) + " bytes in " +
+                                 std::to_string(patched.ranges) + " ranges";
+          } else {
+            response["result"] = "Hot patch failed: " + patched.error;
+          }
+        }
       } else if (command == "z3dk.getBankUsage") {
-        json blocks = json::array();
-        std::unordered_set<std::string> seen;
-        for (const auto& pair : documents) {
-          if (pair.second.written_blocks.empty()) {
-            continue;
+        // args: [{"format": "blocks"}] for the flat list of distinct blocks,
+        // otherwise per-bank stats, with each bank's blocks if "blocks": true
+        json opts = (!args.empty() && args[0].is_object()) ? args[0] : json::object();
+        auto block_json = [](const z3dk::WrittenBlock& block) {
+          return json{{"snes", block.snes_offset}, {"pc", block.pc_offset}, {"size", block.num_bytes}};
+        };
+        if (opts.value("format", std::string()) == "blocks") {
+          json blocks = json::array();
+          for (const auto& block : bank_usage.Blocks()) {
+            blocks.push_back(block_json(block));
           }
-          for (const auto& block : pair.second.written_blocks) {
-            std::string key = std::to_string(block.snes_offset) + ":" +
-                              std::to_string(block.pc_offset) + ":" +
-                              std::to_string(block.num_bytes);
-            if (!seen.insert(key).second) {
-              continue;
+          response["result"] = blocks;
+        } else {
+          bool with_blocks = opts.value("blocks", false);
+          json banks = json::array();
+          for (const auto& stats : bank_usage.Banks()) {
+            json bank = {
+              {"bank", stats.bank},
+              {"used", stats.used},
+              {"free", z3lsp::BankUsage::kBankSize - stats.used},
+              {"largestFree", stats.largest_free},
+              {"freeRuns", stats.free_runs},
+              {"blockCount", stats.blocks}
+            };
+            if (with_blocks) {
+              json blocks = json::array();
+              for (const auto& block : bank_usage.Blocks(stats.bank)) {
+                blocks.push_back(block_json(block));
+              }
+              bank["blocks"] = std::move(blocks);
             }
-            blocks.push_back({
-              {"snes", block.snes_offset},
-              {"pc", block.pc_offset},
-              {"size", block.num_bytes}
-            });
+            banks.push_back(std::move(bank));
           }
+          response["result"] = {{"bankSize", z3lsp::BankUsage::kBankSize}, {"banks", std::move(banks)}};
         }
-        response["result"] = blocks;
       } else if (command == "mesen.showCpuState") {
         json mesen_cmd = {{"type", "GAMESTATE"}};
         auto result = z3lsp::g_mesen.SendCommand(mesen_cmd);
@@ -1506,94 +1639,71 @@ int main(int argc, char** argv) {
       int line = params["position"]["line"];
       int character = params["position"]["character"];
 
-      if (documents.count(uri)) {
-        const auto& doc = documents[uri];
-        int current_line = 0;
-        size_t offset = 0;
-        
-        while (offset < doc.text.size() && current_line < line) {
-          if (doc.text[offset] == '\n') ++current_line;
-          ++offset;
-        }
-
-        if (current_line == line) {
-          size_t line_end = doc.text.find('\n', offset);
-          if (line_end == std::string::npos) line_end = doc.text.size();
-          std::string line_text = doc.text.substr(offset, line_end - offset);
-          
-          int cursor_col = character;
-          if (cursor_col > static_cast<int>(line_text.size())) cursor_col = static_cast<int>(line_text.size());
-          
-          int balance = 0;
-          int param_index = 0;
-          int p = cursor_col - 1;
-          bool found_start = false;
-
-          while (p >= 0) {
-            char c = line_text[p];
-            if (c == ')') balance++;
-            else if (c == '(') {
-              if (balance > 0) balance--;
-              else {
-                found_start = true;
+      auto doc_it = documents.find(uri);
+      if (doc_it != documents.end()) {
+        const auto& doc = doc_it->second;
+        auto site = z3lsp::FindCallSite(doc.LineText(line), character);
+
+        // Macros the last assembly didn't see (it failed, or the document
+        // isn't reachable from main) still have parsed definitions.
+        std::optional<z3lsp::SignatureInfo> parsed_macro;
+        auto find_macro = [&](const std::string& name) -> const z3lsp::SignatureInfo* {
+          if (const auto* info = doc.signatures.FindMacro(name)) return info;
+          const z3lsp::DocumentState::SymbolEntry* found_symbol = nullptr;
+          for (const auto& sym : doc.symbols) {
+            if (sym.kind == 12 && sym.name == name) {
+              found_symbol = &sym;
+              break;
+            }
+          }
+          auto indexed = workspace.symbol_index.find(name);
+          if (!found_symbol && indexed != workspace.symbol_index.end()) {
+            for (const auto& sym : indexed->second) {
+              if (sym.kind == 12) {
+                found_symbol = &sym;
                 break;
               }
-            } else if (c == ',' && balance == 0) {
-              param_index++;
             }
-            p--;
           }
+          if (!found_symbol) return nullptr;
+          parsed_macro.emplace();
+          parsed_macro->name = found_symbol->name;
+          parsed_macro->parameters = found_symbol->parameters;
+          parsed_macro->documentation = "macro";
+          return &*parsed_macro;
+        };
 
-          if (found_start && p > 0) {
-            std::string prefix = line_text.substr(0, p);
-            size_t name_end = prefix.find_last_not_of(" \t");
-            if (name_end != std::string::npos) {
-              size_t name_start = name_end;
-              while (name_start > 0 && (std::isalnum(prefix[name_start - 1]) || prefix[name_start - 1] == '_' || prefix[name_start - 1] == '+')) {
-                name_start--;
-              }
-              std::string macro_name = prefix.substr(name_start, name_end - name_start + 1);
-              if (macro_name.size() > 1 && macro_name[0] == '+') macro_name = macro_name.substr(1);
-
-              const z3lsp::DocumentState::SymbolEntry* found_symbol = nullptr;
-              
-              for (const auto& sym : doc.symbols) {
-                if (sym.kind == 12 && sym.name == macro_name) {
-                   found_symbol = &sym;
-                   break;
-                }
-              }
-
-              if (!found_symbol && workspace.symbol_index.count(macro_name)) {
-                 const auto& candidates = workspace.symbol_index.at(macro_name);
-                 for (const auto& sym : candidates) {
-                    if (sym.kind == 12) {
-                        found_symbol = &sym;
-                        break;
-                    }
-                 }
-              }
+        const z3lsp::SignatureInfo* info = nullptr;
+        if (site) {
+          switch (site->kind) {
+            case z3lsp::CallSite::Kind::kMacro:
+              info = find_macro(site->name);
+              break;
+            case z3lsp::CallSite::Kind::kFunction:
+              info = doc.signatures.FindFunction(site->name);
+              if (!info) info = find_macro(site->name);
+              break;
+            case z3lsp::CallSite::Kind::kDirective:
+              info = z3lsp::FindDirective(site->name);
+              break;
+          }
+        }
 
-              if (found_symbol && !found_symbol->parameters.empty()) {
-                std::string label = found_symbol->name + "(";
-                for (size_t i = 0; i < found_symbol->parameters.size(); ++i) {
-                  if (i > 0) label += ", ";
-                  label += found_symbol->parameters[i];
-                }
-                label += ")";
-                
-                json signature = {
-                    {"label", label},
-                    {"parameters", json::array()}
-                };
-                for (const auto& param : found_symbol->parameters) {
-                    signature["parameters"].push_back({{"label", param}});
-                }
-                result["signatures"].push_back(signature);
-                result["activeParameter"] = param_index;
-              }
-            }
+        if (info) {
+          int active = info->ActiveParameter(site->argument);
+          json signature = {
+              {"label", info->Label()},
+              {"parameters", json::array()},
+              {"activeParameter", active}
+          };
+          if (!info->documentation.empty()) {
+            signature["documentation"] = info->documentation;
           }
+          for (const auto& param : info->parameters) {
+            signature["parameters"].push_back({{"label", param}});
+          }
+          result["signatures"].push_back(signature);
+          result["activeParameter"] = active;
         }
       }
 
@@ -1621,9 +1731,15 @@ int main(int argc, char** argv) {
 
       if (documents.count(uri)) {
         const auto& doc = documents[uri];
-        int line = 0;
+        // hints never look past the end of their line, so start right at
+        // the first visible one
+        int line = std::max(start_line, 0);
         int col = 0;
-        for (size_t i = 0; i < doc.text.size(); ++i) {
+        size_t first = doc.LineOffset(line);
+        if (first == std::string::npos) {
+          first = doc.text.size();
+        }
+        for (size_t i = first; i < doc.text.size(); ++i) {
              if (doc.text[i] == '\n') {
                  line++;
                  col = 0;
@@ -1781,7 +1897,7 @@ int main(int argc, char** argv) {
       std::string token;
       if (documents.count(uri)) {
           const auto& doc = documents[uri];
-          auto extracted = z3lsp::ExtractTokenAt(doc.text, line, character);
+          auto extracted = z3lsp::ExtractTokenAt(doc.text, doc.line_starts, line, character);
           if (extracted) token = *extracted;
       }
       
@@ -1862,9 +1978,11 @@ int main(int argc, char** argv) {
       doc.uri = text_doc.value("uri", "");
       doc.path = z3lsp::UriToPath(doc.uri);
       doc.text = text_doc.value("text", "");
+      doc.BuildLineIndex();
       doc.version = text_doc.value("version", 0);
       doc = AnalyzeDocumentFull(doc, workspace, &documents);
       documents[doc.uri] = doc;
+      bank_usage.Update(doc.uri, doc.written_blocks);
       PublishDiagnostics(doc);
       continue;
     }
@@ -1880,6 +1998,7 @@ int main(int argc, char** argv) {
       auto changes = params.value("contentChanges", json::array());
       if (!changes.empty()) {
         it->second.text = changes[0].value("text", it->second.text);
+        it->second.BuildLineIndex();
       }
       it->second.version = text_doc.value("version", it->second.version);
 
@@ -1904,12 +2023,41 @@ int main(int argc, char** argv) {
     if (!documents.empty()) {
       auto now = std::chrono::steady_clock::now();
       if (now - last_change_time > kDebounceDelay) {
+        // Prepare every pending document first, let the pool assemble them
+        // side by side, then finish and publish in order.
+        std::vector<std::pair<z3lsp::DocumentState*, z3lsp::AnalysisPlan>> pending;
         for (auto& pair : documents) {
           if (pair.second.needs_analysis) {
-            pair.second = AnalyzeDocumentFull(pair.second, workspace, &documents);
-            PublishDiagnostics(pair.second);
+            pending.emplace_back(&pair.second,
+                                 z3lsp::PrepareAnalysis(pair.second, workspace, &documents));
+          }
+        }
+        std::vector<std::future<z3dk::AssembleResult>> results;
+        for (auto& [doc, plan] : pending) {
+          if (!plan.done) {
+            const z3dk::AssembleOptions* options = &plan.options;
+            results.push_back(std::async(std::launch::async, [options] {
+              return z3lsp::g_assembler_pool.Assemble(*options);
+            }));
           }
         }
+        size_t next_result = 0;
+        std::vector<z3lsp::DocumentState> finished;
+        finished.reserve(pending.size());
+        for (auto& [doc, plan] : pending) {
+          if (plan.done) {
+            finished.push_back(std::move(plan.updated));
+          } else {
+            z3dk::AssembleResult result = results[next_result++].get();
+            finished.push_back(z3lsp::FinishAnalysis(plan, result, workspace));
+          }
+        }
+        // plans point at the documents, so only replace them once all are done
+        for (size_t i = 0; i < pending.size(); ++i) {
+          *pending[i].first = std::move(finished[i]);
+          bank_usage.Update(pending[i].first->uri, pending[i].first->written_blocks);
+          PublishDiagnostics(*pending[i].first);
+        }
       }
     }
 
@@ -1922,6 +2070,7 @@ int main(int argc, char** argv) {
         z3lsp::DocumentState cleared = it->second;
         cleared.diagnostics.clear();
         PublishDiagnostics(cleared);
+        bank_usage.Remove(uri);
         documents.erase(it);
       }
       continue;
@@ -2027,7 +2176,7 @@ int main(int argc, char** argv) {
         auto position = params.value("position", json::object());
         int line = position.value("line", 0);
         int character = position.value("character", 0);
-        auto prefix = z3lsp::ExtractTokenPrefix(it->second.text, line, character);
+        auto prefix = z3lsp::ExtractTokenPrefix(it->second.text, it->second.line_starts, line, character);
         if (prefix.has_value()) {
           response["result"] = BuildCompletionItems(it->second, workspace, *prefix);
         }
@@ -5,15 +5,82 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include "logging.h"
 #include "utils.h"
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 namespace z3lsp {
 
 MesenClient g_mesen;
 
+std::vector<RomPatchRange> DiffRomImages(const std::vector<uint8_t>& loaded,
+                                         const std::vector<uint8_t>& built,
+                                         const std::vector<z3dk::WrittenBlock>& blocks,
+                                         size_t merge_gap,
+                                         size_t max_range) {
+  if (max_range == 0) max_range = std::numeric_limits<size_t>::max();
+
+  // [start, end) spans to compare, sorted and with overlaps merged
+  std::vector<std::pair<size_t, size_t>> spans;
+  if (blocks.empty()) {
+    spans.emplace_back(0, built.size());
+  } else {
+    for (const auto& block : blocks) {
+      if (block.pc_offset < 0 || block.num_bytes <= 0) continue;
+      size_t start = static_cast<size_t>(block.pc_offset);
+      size_t end = std::min(start + static_cast<size_t>(block.num_bytes), built.size());
+      if (start < end) spans.emplace_back(start, end);
+    }
+    std::sort(spans.begin(), spans.end());
+    std::vector<std::pair<size_t, size_t>> merged;
+    for (const auto& span : spans) {
+      if (!merged.empty() && span.first <= merged.back().second) {
+        merged.back().second = std::max(merged.back().second, span.second);
+      } else {
+        merged.push_back(span);
+      }
+    }
+    spans = std::move(merged);
+  }
+
+  std::vector<RomPatchRange> ranges;
+  auto emit = [&](size_t start, size_t end) {
+    for (size_t pos = start; pos < end; pos += std::min(max_range, end - pos)) {
+      RomPatchRange range;
+      range.offset = static_cast<uint32_t>(pos);
+      range.bytes.assign(built.begin() + pos, built.begin() + pos + std::min(max_range, end - pos));
+      ranges.push_back(std::move(range));
+    }
+  };
+  for (const auto& span : spans) {
+    // runs never reach past a span, bytes between blocks aren't ours to write
+    size_t run_start = 0;
+    size_t run_end = 0;
+    bool open = false;
+    for (size_t i = span.first; i < span.second; ++i) {
+      if (i < loaded.size() && loaded[i] == built[i]) continue;
+      if (open && i - run_end <= merge_gap) {
+        run_end = i + 1;
+        continue;
+      }
+      if (open) emit(run_start, run_end);
+      run_start = i;
+      run_end = i + 1;
+      open = true;
+    }
+    if (open) emit(run_start, run_end);
+  }
+  return ranges;
+}
+
 MesenClient::MesenClient()
     : socket_fd_(-1),
       last_connect_failure_(std::chrono::steady_clock::time_point{}) {}
@@ -82,6 +149,7 @@ void MesenClient::Disconnect() {
     socket_fd_ = -1;
   }
   socket_path_.clear();
+  pending_.clear();
 }
 
 bool MesenClient::IsConnected() const { return socket_fd_ >= 0; }
@@ -102,25 +170,55 @@ std::optional<uint8_t> MesenClient::ReadByte(uint32_t addr) {
 
 std::optional<json> MesenClient::SendCommand(const json& cmd) {
   if (!IsConnected()) return std::nullopt;
+  if (!SendAll(cmd.dump() + "\n")) return std::nullopt;
+  return ReadResponse();
+}
 
-  std::string request = cmd.dump() + "\n";
-  if (send(socket_fd_, request.c_str(), request.length(), 0) < 0) {
-    Disconnect();
-    return std::nullopt;
+std::vector<std::optional<json>> MesenClient::SendBatch(const std::vector<json>& cmds) {
+  std::vector<std::optional<json>> replies(cmds.size());
+  if (!IsConnected() || cmds.empty()) return replies;
+
+  std::string request;
+  for (const auto& cmd : cmds) {
+    request += cmd.dump();
+    request += '\n';
+  }
+  if (!SendAll(request)) return replies;
+  for (auto& reply : replies) {
+    reply = ReadResponse();
+    if (!IsConnected()) break;
   }
+  return replies;
+}
 
+bool MesenClient::SendAll(const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(socket_fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      Disconnect();
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+std::optional<json> MesenClient::ReadResponse() {
   char buffer[4096];
-  std::string response;
-  while (response.find('\n') == std::string::npos) {
+  size_t newline;
+  while ((newline = pending_.find('\n')) == std::string::npos) {
     ssize_t received = recv(socket_fd_, buffer, sizeof(buffer), 0);
     if (received <= 0) {
       Disconnect();
       return std::nullopt;
     }
-    response.append(buffer, received);
+    pending_.append(buffer, received);
   }
-  response = response.substr(0, response.find('\n'));
-  
+  std::string response = pending_.substr(0, newline);
+  pending_.erase(0, newline + 1);
+
   try {
     return json::parse(response);
   } catch (const std::exception& e) {
@@ -132,6 +230,72 @@ std::optional<json> MesenClient::SendCommand(const json& cmd) {
   }
 }
 
+HotPatchResult MesenClient::HotPatch(const std::vector<uint8_t>& loaded,
+                                     const std::vector<uint8_t>& built,
+                                     const std::vector<z3dk::WrittenBlock>& blocks,
+                                     const HotPatchOptions& options) {
+  HotPatchResult result;
+  if (loaded.size() != built.size()) {
+    result.error = "ROM size changed, reload the ROM instead";
+    return result;
+  }
+  std::vector<RomPatchRange> ranges =
+      DiffRomImages(loaded, built, blocks, options.merge_gap, options.max_range);
+  result.ranges = ranges.size();
+  for (const auto& range : ranges) {
+    result.bytes += range.bytes.size();
+  }
+  if (ranges.empty()) {
+    result.success = true;
+    return result;
+  }
+  if (!Connect()) {
+    result.error = "Mesen2 is not running";
+    return result;
+  }
+
+  auto succeeded = [](const std::optional<json>& reply) {
+    return reply.has_value() && reply->value("success", false);
+  };
+  if (options.pause && !succeeded(SendCommand(json{{"type", "PAUSE"}}))) {
+    result.error = "Failed to pause emulation";
+    return result;
+  }
+
+  static const char kHex[] = "0123456789ABCDEF";
+  size_t batch_size = std::max<size_t>(options.batch_size, 1);
+  bool written = true;
+  for (size_t first = 0; first < ranges.size() && written; first += batch_size) {
+    std::vector<json> cmds;
+    for (size_t i = first; i < std::min(first + batch_size, ranges.size()); ++i) {
+      std::string hex;
+      hex.reserve(ranges[i].bytes.size() * 2);
+      for (uint8_t byte : ranges[i].bytes) {
+        hex += kHex[byte >> 4];
+        hex += kHex[byte & 0xF];
+      }
+      cmds.push_back({{"type", "WRITEBLOCK"},
+                      {"memtype", "SnesPrgRom"},
+                      {"addr", "0x" + ToHexString(ranges[i].offset, 6)},
+                      {"hex", std::move(hex)}});
+    }
+    for (const auto& reply : SendBatch(cmds)) {
+      written = written && succeeded(reply);
+    }
+  }
+  if (!written) {
+    result.error = "Mesen2 rejected a write";
+  }
+
+  // resume even after a failed write, a paused emulator looks hung
+  if (options.pause && !succeeded(SendCommand(json{{"type", "RESUME"}}))) {
+    if (written) result.error = "Failed to resume emulation";
+    written = false;
+  }
+  result.success = written;
+  return result;
+}
+
 bool MesenClient::Ping() {
   if (!Connect()) return false;
   json cmd = {{"type", "PING"}};
@@ -4,12 +4,46 @@
 #include <string>
 #include <optional>
 #include <chrono>
+#include <vector>
 #include <nlohmann/json.hpp>
+#include "z3dk_core/assembler.h"
 
 namespace z3lsp {
 
 using json = nlohmann::json;
 
+// A run of ROM bytes to write, at a PC (file) offset.
+struct RomPatchRange {
+  uint32_t offset = 0;
+  std::vector<uint8_t> bytes;
+};
+
+// Ranges where `built` differs from `loaded`. Only the bytes covered by
+// `blocks` are compared (all of `built` when it's empty). Changed runs
+// separated by at most `merge_gap` equal bytes become one range, and no
+// range is longer than `max_range`.
+std::vector<RomPatchRange> DiffRomImages(const std::vector<uint8_t>& loaded,
+                                         const std::vector<uint8_t>& built,
+                                         const std::vector<z3dk::WrittenBlock>& blocks,
+                                         size_t merge_gap = 8,
+                                         size_t max_range = 1024);
+
+struct HotPatchOptions {
+  // Pause emulation while writing, so the CPU never runs a half-patched routine.
+  bool pause = true;
+  size_t merge_gap = 8;
+  size_t max_range = 1024;
+  // Writes sent per round trip.
+  size_t batch_size = 32;
+};
+
+struct HotPatchResult {
+  bool success = false;
+  size_t ranges = 0;
+  size_t bytes = 0;
+  std::string error;
+};
+
 class MesenClient {
  public:
   MesenClient();
@@ -22,11 +56,26 @@ class MesenClient {
 
   std::optional<uint8_t> ReadByte(uint32_t addr);
   std::optional<json> SendCommand(const json& cmd);
+  // Sends every command before reading any reply; the replies come back in
+  // order, nullopt for any that failed.
+  std::vector<std::optional<json>> SendBatch(const std::vector<json>& cmds);
+
+  // Writes the bytes of `built` that differ from `loaded` (the ROM the
+  // emulator is running) into its PRG ROM, without a reset. Both images
+  // must be the same size; a ROM that grew has to be reloaded.
+  HotPatchResult HotPatch(const std::vector<uint8_t>& loaded,
+                          const std::vector<uint8_t>& built,
+                          const std::vector<z3dk::WrittenBlock>& blocks,
+                          const HotPatchOptions& options = {});
 
  private:
   std::string FindLatestSocket();
+  bool SendAll(const std::string& data);
+  std::optional<json> ReadResponse();
 
   int socket_fd_;
+  // bytes received past the last reply line
+  std::string pending_;
   std::string socket_path_;
   std::chrono::steady_clock::time_point last_connect_failure_;
 };
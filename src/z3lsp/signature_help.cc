@@ -0,0 +1,349 @@
+#include "signature_help.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace z3lsp {
+namespace {
+
+struct BuiltinEntry {
+  const char* name;
+  // comma separated, "[x]" marks an optional argument
+  const char* parameters;
+  bool variadic;
+  const char* documentation;
+};
+
+// Mirrors builtin_functions in asar_math.cpp.
+constexpr BuiltinEntry kBuiltinFunctions[] = {
+    {"sqrt", "x", false, "Square root."},
+    {"sin", "x", false, "Sine, in radians."},
+    {"cos", "x", false, "Cosine, in radians."},
+    {"tan", "x", false, "Tangent, in radians."},
+    {"asin", "x", false, "Arc sine, in radians."},
+    {"acos", "x", false, "Arc cosine, in radians."},
+    {"atan", "x", false, "Arc tangent, in radians."},
+    {"arcsin", "x", false, "Arc sine, in radians."},
+    {"arccos", "x", false, "Arc cosine, in radians."},
+    {"arctan", "x", false, "Arc tangent, in radians."},
+    {"log", "x", false, "Natural logarithm."},
+    {"log10", "x", false, "Base 10 logarithm."},
+    {"log2", "x", false, "Base 2 logarithm."},
+    {"ceil", "x", false, "Rounds up to an integer."},
+    {"floor", "x", false, "Rounds down to an integer."},
+    {"read1", "address, [default]", false, "Reads a byte from the ROM."},
+    {"read2", "address, [default]", false, "Reads a word from the ROM."},
+    {"read3", "address, [default]", false, "Reads a long from the ROM."},
+    {"read4", "address, [default]", false, "Reads a doubleword from the ROM."},
+    {"canread", "address, length", false, "1 if length bytes at address can be read."},
+    {"canread1", "address", false, "1 if a byte at address can be read."},
+    {"canread2", "address", false, "1 if a word at address can be read."},
+    {"canread3", "address", false, "1 if a long at address can be read."},
+    {"canread4", "address", false, "1 if a doubleword at address can be read."},
+    {"readfile1", "filename, offset, [default]", false, "Reads a byte from a file."},
+    {"readfile2", "filename, offset, [default]", false, "Reads a word from a file."},
+    {"readfile3", "filename, offset, [default]", false, "Reads a long from a file."},
+    {"readfile4", "filename, offset, [default]", false, "Reads a doubleword from a file."},
+    {"canreadfile", "filename, offset, length", false, "1 if length bytes at offset can be read."},
+    {"canreadfile1", "filename, offset", false, "1 if a byte at offset can be read."},
+    {"canreadfile2", "filename, offset", false, "1 if a word at offset can be read."},
+    {"canreadfile3", "filename, offset", false, "1 if a long at offset can be read."},
+    {"canreadfile4", "filename, offset", false, "1 if a doubleword at offset can be read."},
+    {"filesize", "filename", false, "Size of a file in bytes."},
+    {"getfilestatus", "filename", false, "0 if the file exists, 1 if it doesn't, 2 if it can't be read."},
+    {"defined", "name", false, "1 if the define exists."},
+    {"snestopc", "address", false, "Converts a SNES address to a ROM offset."},
+    {"pctosnes", "address", false, "Converts a ROM offset to a SNES address."},
+    {"realbase", "", false, "The current address, ignoring base."},
+    {"pc", "", false, "The current address."},
+    {"max", "a, b", false, "The larger of a and b."},
+    {"min", "a, b", false, "The smaller of a and b."},
+    {"clamp", "value, min, max", false, "value limited to [min, max]."},
+    {"safediv", "dividend, divisor, exception", false, "dividend/divisor, or exception when divisor is 0."},
+    {"select", "statement, true, false", false, "true if statement is nonzero, else false."},
+    {"bank", "address", false, "The bank byte of address."},
+    {"not", "value", false, "1 if value is 0, else 0."},
+    {"equal", "a, b", false, "1 if a == b."},
+    {"notequal", "a, b", false, "1 if a != b."},
+    {"less", "a, b", false, "1 if a < b."},
+    {"lessequal", "a, b", false, "1 if a <= b."},
+    {"greater", "a, b", false, "1 if a > b."},
+    {"greaterequal", "a, b", false, "1 if a >= b."},
+    {"and", "a, b", false, "1 if a and b are both nonzero."},
+    {"or", "a, b", false, "1 if a or b is nonzero."},
+    {"nand", "a, b", false, "0 if a and b are both nonzero."},
+    {"nor", "a, b", false, "1 if a and b are both 0."},
+    {"xor", "a, b", false, "1 if exactly one of a and b is nonzero."},
+    {"round", "number, precision", false, "number rounded to precision decimal places."},
+    {"sizeof", "struct", false, "Size of a struct."},
+    {"objectsize", "struct", false, "Size of a struct's object."},
+    {"datasize", "label", false, "Bytes from label to the next label."},
+    {"stringsequal", "a, b", false, "1 if the strings are equal."},
+    {"stringsequalnocase", "a, b", false, "1 if the strings are equal, ignoring case."},
+    {"char", "string, index", false, "The character at index."},
+    {"stringlength", "string", false, "Length of a string."},
+};
+
+// Directives whose arguments are comma separated. The ones that take
+// words (math, warnings, optimize, ...) gain nothing from a signature.
+constexpr BuiltinEntry kDirectives[] = {
+    {"org", "address", false, "Sets the current address."},
+    {"base", "address", false, "Assembles as if at address, or `base off`."},
+    {"warnpc", "address", false, "Errors if the current address is past address."},
+    {"skip", "bytes", false, "Moves the current address forward."},
+    {"pad", "address", false, "Fills up to address with the pad byte."},
+    {"fill", "bytes", false, "Writes bytes copies of the fill byte."},
+    {"fillbyte", "value", false, "Sets the byte used by fill."},
+    {"fillword", "value", false, "Sets the word used by fill."},
+    {"filllong", "value", false, "Sets the long used by fill."},
+    {"filldword", "value", false, "Sets the doubleword used by fill."},
+    {"padbyte", "value", false, "Sets the byte used by pad."},
+    {"padword", "value", false, "Sets the word used by pad."},
+    {"padlong", "value", false, "Sets the long used by pad."},
+    {"paddword", "value", false, "Sets the doubleword used by pad."},
+    {"db", "value", true, "Writes bytes."},
+    {"dw", "value", true, "Writes words."},
+    {"dl", "value", true, "Writes longs."},
+    {"dd", "value", true, "Writes doublewords."},
+    {"incbin", "file", false, "Inserts a binary file, `file:start-end` for part of it."},
+    {"incsrc", "file", false, "Assembles another source file here."},
+    {"table", "file", false, "Loads a character table for db strings."},
+    {"assert", "condition, message", true, "Errors with message if condition is 0."},
+    {"print", "text", true, "Prints text and values."},
+    {"error", "message", true, "Stops with an error."},
+    {"warn", "message", true, "Prints a warning."},
+    {"rep", "count", false, "Repeats the next instruction."},
+    {"if", "condition", false, "Assembles the block if condition is nonzero."},
+    {"elseif", "condition", false, "Assembles the block if condition is nonzero."},
+    {"while", "condition", false, "Assembles the block while condition is nonzero."},
+    {"namespace", "name", false, "Prefixes following labels with name_, or `namespace off`."},
+    {"struct", "name, address", false, "Starts a struct at address."},
+    {"freespace", "options", true, "Places code in free space."},
+    {"freecode", "options", true, "Places code in free space."},
+    {"freedata", "options", true, "Places data in free space."},
+    {"prot", "label", true, "Protects freespace blocks from autoclean."},
+    {"arch", "name", false, "Switches architecture: 65816, spc700, superfx."},
+};
+
+bool IsNameChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+std::string Lower(std::string_view text) {
+  std::string out(text);
+  std::transform(out.begin(), out.end(), out.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return out;
+}
+
+SignatureInfo FromEntry(const BuiltinEntry& entry, bool directive) {
+  SignatureInfo info;
+  info.name = entry.name;
+  info.variadic = entry.variadic;
+  info.directive = directive;
+  info.documentation = entry.documentation;
+  std::string_view rest = entry.parameters;
+  while (!rest.empty()) {
+    size_t comma = rest.find(',');
+    std::string_view param = rest.substr(0, comma);
+    info.parameters.emplace_back(param);
+    if (comma == std::string_view::npos) break;
+    rest.remove_prefix(comma + 1);
+    while (!rest.empty() && rest.front() == ' ') rest.remove_prefix(1);
+  }
+  return info;
+}
+
+template <size_t N>
+std::unordered_map<std::string, SignatureInfo> BuildTable(const BuiltinEntry (&entries)[N],
+                                                          bool directive) {
+  std::unordered_map<std::string, SignatureInfo> table;
+  for (const auto& entry : entries) {
+    table.emplace(entry.name, FromEntry(entry, directive));
+  }
+  return table;
+}
+
+const std::unordered_map<std::string, SignatureInfo>& BuiltinFunctions() {
+  static const auto table = BuildTable(kBuiltinFunctions, false);
+  return table;
+}
+
+const std::unordered_map<std::string, SignatureInfo>& Directives() {
+  static const auto table = BuildTable(kDirectives, true);
+  return table;
+}
+
+SignatureInfo FromSignature(const z3dk::Signature& sig, const char* kind) {
+  SignatureInfo info;
+  info.name = sig.name;
+  info.parameters = sig.parameters;
+  info.variadic = sig.variadic;
+  info.documentation = kind;
+  if (!sig.filename.empty()) {
+    info.documentation += " defined in " +
+                          std::filesystem::path(sig.filename).filename().string() +
+                          ":" + std::to_string(sig.line);
+  }
+  return info;
+}
+
+template <typename Map>
+const SignatureInfo* Find(const Map& map, std::string_view name) {
+  auto it = map.find(std::string(name));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+std::string SignatureInfo::Label() const {
+  std::string label = name;
+  label += directive ? " " : "(";
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    if (i > 0) label += ", ";
+    label += parameters[i];
+  }
+  if (variadic && !parameters.empty() && parameters.back() != "...") label += ", ...";
+  if (!directive) label += ")";
+  return label;
+}
+
+int SignatureInfo::ActiveParameter(int argument) const {
+  int count = static_cast<int>(parameters.size());
+  if (variadic && count > 0 && argument >= count) return count - 1;
+  return argument;
+}
+
+void SignatureIndex::Build(const std::vector<z3dk::Signature>& macros,
+                           const std::vector<z3dk::Signature>& functions) {
+  Clear();
+  macros_.reserve(macros.size());
+  for (const auto& sig : macros) {
+    macros_.emplace(sig.name, FromSignature(sig, "macro"));
+  }
+  functions_.reserve(functions.size());
+  for (const auto& sig : functions) {
+    functions_.emplace(sig.name, FromSignature(sig, "function"));
+  }
+}
+
+void SignatureIndex::Clear() {
+  macros_.clear();
+  functions_.clear();
+}
+
+const SignatureInfo* SignatureIndex::FindMacro(std::string_view name) const {
+  return Find(macros_, name);
+}
+
+const SignatureInfo* SignatureIndex::FindFunction(std::string_view name) const {
+  if (const SignatureInfo* info = Find(functions_, name)) return info;
+  return FindBuiltinFunction(name);
+}
+
+const SignatureInfo* FindBuiltinFunction(std::string_view name) {
+  return Find(BuiltinFunctions(), name);
+}
+
+const SignatureInfo* FindDirective(std::string_view name) {
+  return Find(Directives(), Lower(name));
+}
+
+std::vector<std::string> BuiltinFunctionNames() {
+  std::vector<std::string> names;
+  for (const auto& entry : kBuiltinFunctions) names.emplace_back(entry.name);
+  return names;
+}
+
+std::optional<CallSite> FindCallSite(std::string_view line, int column) {
+  size_t end = std::min(static_cast<size_t>(std::max(column, 0)), line.size());
+
+  struct OpenParen {
+    size_t name_start;
+    size_t name_end;
+    int commas;
+  };
+  std::vector<OpenParen> open;
+  size_t statement = 0;
+  int commas = 0;
+  char quote = 0;
+  for (size_t i = 0; i < end; ++i) {
+    char c = line[i];
+    if (quote) {
+      if (c == quote) quote = 0;
+      continue;
+    }
+    switch (c) {
+      case '"':
+      case '\'':
+        quote = c;
+        break;
+      case ';':
+        return std::nullopt;
+      case '(': {
+        size_t name_start = i;
+        while (name_start > statement && IsNameChar(line[name_start - 1])) --name_start;
+        open.push_back({name_start, i, 0});
+        break;
+      }
+      case ')':
+        if (!open.empty()) open.pop_back();
+        break;
+      case ',':
+        if (open.empty()) {
+          ++commas;
+        } else {
+          ++open.back().commas;
+        }
+        break;
+      case ':':
+        // `lda #0 : sta $00` starts a new statement, `incbin x.bin:0-4` doesn't
+        if (open.empty() && i > 0 && line[i - 1] == ' ' && i + 1 < line.size() &&
+            line[i + 1] == ' ') {
+          statement = i + 1;
+          commas = 0;
+        }
+        break;
+    }
+  }
+  for (auto it = open.rbegin(); it != open.rend(); ++it) {
+    if (it->name_start == it->name_end ||
+        std::isdigit(static_cast<unsigned char>(line[it->name_start]))) {
+      continue;  // grouping parens
+    }
+    CallSite site;
+    bool macro = it->name_start > 0 && line[it->name_start - 1] == '%';
+    site.kind = macro ? CallSite::Kind::kMacro : CallSite::Kind::kFunction;
+    site.name = std::string(line.substr(it->name_start, it->name_end - it->name_start));
+    site.argument = it->commas;
+    return site;
+  }
+
+  // no open call, try the directive the statement starts with
+  auto skip_space = [&](size_t pos) {
+    while (pos < end && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+    return pos;
+  };
+  size_t word = skip_space(statement);
+  size_t word_end = word;
+  while (word_end < end && line[word_end] != ' ' && line[word_end] != '\t') ++word_end;
+  if (word_end > word && line[word_end - 1] == ':') {
+    word = skip_space(word_end);  // a label before the directive
+    word_end = word;
+    while (word_end < end && IsNameChar(line[word_end])) ++word_end;
+  }
+  // the cursor has to be past the directive and its space
+  if (word_end == word || word_end >= end) return std::nullopt;
+  if (line[word_end] != ' ' && line[word_end] != '\t') return std::nullopt;
+  for (size_t i = word; i < word_end; ++i) {
+    if (!IsNameChar(line[i])) return std::nullopt;
+  }
+  CallSite site;
+  site.kind = CallSite::Kind::kDirective;
+  site.name = std::string(line.substr(word, word_end - word));
+  site.argument = commas;
+  return site;
+}
+
+}  // namespace z3lsp
@@ -0,0 +1,72 @@
+#ifndef Z3LSP_SIGNATURE_HELP_H_
+#define Z3LSP_SIGNATURE_HELP_H_
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "z3dk_core/assembler.h"
+
+namespace z3lsp {
+
+struct SignatureInfo {
+  std::string name;
+  std::vector<std::string> parameters;
+  // the last parameter repeats
+  bool variadic = false;
+  // directives take their arguments without parentheses
+  bool directive = false;
+  std::string documentation;
+
+  std::string Label() const;
+  // the parameter the cursor is in, with everything past the end of a
+  // variadic list mapped onto its last parameter
+  int ActiveParameter(int argument) const;
+};
+
+// Macros and user functions from the last assembly of a document. Built
+// once per analysis so a signature help request is one hash lookup.
+class SignatureIndex {
+ public:
+  void Build(const std::vector<z3dk::Signature>& macros,
+             const std::vector<z3dk::Signature>& functions);
+  void Clear();
+
+  const SignatureInfo* FindMacro(std::string_view name) const;
+  // user functions first, then asar's builtins
+  const SignatureInfo* FindFunction(std::string_view name) const;
+
+  size_t macro_count() const { return macros_.size(); }
+  size_t function_count() const { return functions_.size(); }
+
+ private:
+  std::unordered_map<std::string, SignatureInfo> macros_;
+  std::unordered_map<std::string, SignatureInfo> functions_;
+};
+
+const SignatureInfo* FindBuiltinFunction(std::string_view name);
+// case-insensitive, like asar's directive matching
+const SignatureInfo* FindDirective(std::string_view name);
+std::vector<std::string> BuiltinFunctionNames();
+
+struct CallSite {
+  enum class Kind {
+    kMacro,
+    kFunction,
+    kDirective,
+  };
+  Kind kind = Kind::kFunction;
+  std::string name;
+  // zero-based, counted from the commas before the cursor
+  int argument = 0;
+};
+
+// The call the cursor at `column` is inside: the innermost unclosed
+// `name(` or `%name(`, else the directive starting the statement. Only
+// `line` is scanned, and strings and comments are skipped.
+std::optional<CallSite> FindCallSite(std::string_view line, int column);
+
+}  // namespace z3lsp
+
+#endif  // Z3LSP_SIGNATURE_HELP_H_
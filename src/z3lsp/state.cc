@@ -1,5 +1,7 @@
 #include "state.h"
 
+#include "utils.h"
+
 namespace z3lsp {
 
 void DocumentState::BuildLookupMaps() {
@@ -19,4 +21,27 @@ void DocumentState::BuildLookupMaps() {
   }
 }
 
+void DocumentState::BuildLineIndex() {
+  line_starts = ComputeLineStarts(text);
+}
+
+size_t DocumentState::LineOffset(int line) const {
+  if (line < 0 || static_cast<size_t>(line) >= line_starts.size()) {
+    return std::string::npos;
+  }
+  return line_starts[static_cast<size_t>(line)];
+}
+
+std::string_view DocumentState::LineText(int line) const {
+  size_t start = LineOffset(line);
+  if (start == std::string::npos || start > text.size()) {
+    return {};
+  }
+  size_t end = text.find('\n', start);
+  if (end == std::string::npos) {
+    end = text.size();
+  }
+  return std::string_view(text).substr(start, end - start);
+}
+
 }  // namespace z3lsp
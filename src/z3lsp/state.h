@@ -2,6 +2,7 @@
 #define Z3LSP_STATE_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -12,6 +13,7 @@
 #include "z3dk_core/config.h"
 #include "z3dk_core/assembler.h"
 #include "knowledge.h"
+#include "signature_help.h"
 
 namespace z3lsp {
 
@@ -19,6 +21,9 @@ struct DocumentState {
   std::string uri;
   std::string path;
   std::string text;
+  // Offset of the first byte of each line of `text`. Call BuildLineIndex
+  // whenever `text` changes.
+  std::vector<size_t> line_starts;
   int version = 0;
   std::vector<z3dk::Diagnostic> diagnostics;
   std::vector<z3dk::Label> labels;
@@ -36,6 +41,8 @@ struct DocumentState {
   std::vector<SymbolEntry> symbols;
   z3dk::SourceMap source_map;
   std::vector<z3dk::WrittenBlock> written_blocks;
+  // macros and functions from the last assembly, for signature help
+  SignatureIndex signatures;
 
   // O(1) lookup maps (populated from vectors above)
   std::unordered_map<std::string, const z3dk::Label*> label_map;
@@ -47,6 +54,11 @@ struct DocumentState {
   bool needs_analysis = false;
 
   void BuildLookupMaps();
+  void BuildLineIndex();
+  // Where `line` starts in `text`, npos past the last line.
+  size_t LineOffset(int line) const;
+  // `line` without its newline, empty past the last line.
+  std::string_view LineText(int line) const;
 };
 
 struct WorkspaceState {
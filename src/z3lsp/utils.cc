@@ -135,11 +135,21 @@ bool IsSymbolChar(char c) {
          c == '!' || c == '@';
 }
 
-std::optional<std::string> ExtractTokenAt(const std::string& text, int line,
-                                          int character) {
-  if (line < 0 || character < 0) {
-    return std::nullopt;
-  }
+std::vector<size_t> ComputeLineStarts(std::string_view text) {
+  std::vector<size_t> starts;
+  starts.push_back(0);
+  for (size_t pos = text.find('\n'); pos != std::string_view::npos;
+       pos = text.find('\n', pos + 1)) {
+    starts.push_back(pos + 1);
+  }
+  return starts;
+}
+
+namespace {
+
+// Offset of the start of `line` found by counting newlines, npos if the
+// text has fewer lines.
+size_t ScanLineStart(const std::string& text, int line) {
   int current_line = 0;
   size_t offset = 0;
   while (offset < text.size() && current_line < line) {
@@ -148,10 +158,21 @@ std::optional<std::string> ExtractTokenAt(const std::string& text, int line,
     }
     ++offset;
   }
-  if (current_line != line) {
+  return current_line == line ? offset : std::string::npos;
+}
+
+size_t IndexedLineStart(const std::vector<size_t>& line_starts, int line) {
+  if (line < 0 || static_cast<size_t>(line) >= line_starts.size()) {
+    return std::string::npos;
+  }
+  return line_starts[static_cast<size_t>(line)];
+}
+
+std::optional<std::string> TokenAt(const std::string& text, size_t line_start,
+                                   int character) {
+  if (line_start == std::string::npos || character < 0) {
     return std::nullopt;
   }
-  size_t line_start = offset;
   size_t line_end = text.find('\n', line_start);
   if (line_end == std::string::npos) {
     line_end = text.size();
@@ -178,23 +199,11 @@ std::optional<std::string> ExtractTokenAt(const std::string& text, int line,
   return text.substr(left, right - left);
 }
 
-std::optional<std::string> ExtractTokenPrefix(const std::string& text, int line,
-                                              int character) {
-  if (line < 0 || character < 0) {
+std::optional<std::string> TokenPrefix(const std::string& text, size_t line_start,
+                                       int character) {
+  if (line_start == std::string::npos || character < 0) {
     return std::nullopt;
   }
-  int current_line = 0;
-  size_t offset = 0;
-  while (offset < text.size() && current_line < line) {
-    if (text[offset] == '\n') {
-      ++current_line;
-    }
-    ++offset;
-  }
-  if (current_line != line) {
-    return std::nullopt;
-  }
-  size_t line_start = offset;
   size_t line_end = text.find('\n', line_start);
   if (line_end == std::string::npos) {
     line_end = text.size();
@@ -213,6 +222,36 @@ std::optional<std::string> ExtractTokenPrefix(const std::string& text, int line,
   return text.substr(left, pos - left);
 }
 
+}  // namespace
+
+std::optional<std::string> ExtractTokenAt(const std::string& text, int line,
+                                          int character) {
+  if (line < 0) {
+    return std::nullopt;
+  }
+  return TokenAt(text, ScanLineStart(text, line), character);
+}
+
+std::optional<std::string> ExtractTokenAt(const std::string& text,
+                                          const std::vector<size_t>& line_starts,
+                                          int line, int character) {
+  return TokenAt(text, IndexedLineStart(line_starts, line), character);
+}
+
+std::optional<std::string> ExtractTokenPrefix(const std::string& text, int line,
+                                              int character) {
+  if (line < 0) {
+    return std::nullopt;
+  }
+  return TokenPrefix(text, ScanLineStart(text, line), character);
+}
+
+std::optional<std::string> ExtractTokenPrefix(const std::string& text,
+                                              const std::vector<size_t>& line_starts,
+                                              int line, int character) {
+  return TokenPrefix(text, IndexedLineStart(line_starts, line), character);
+}
+
 bool HasPrefixIgnoreCase(std::string_view text, std::string_view prefix) {
   if (prefix.empty() || text.size() < prefix.size()) {
     return false;
@@ -30,6 +30,15 @@ std::filesystem::path ResolveConfigPath(const std::string& raw,
 bool IsSymbolChar(char c);
 std::optional<std::string> ExtractTokenAt(const std::string& text, int line, int character);
 std::optional<std::string> ExtractTokenPrefix(const std::string& text, int line, int character);
+// Offset of the first byte of every line, for seeking to a line without
+// rescanning the text. The overloads below take this table.
+std::vector<size_t> ComputeLineStarts(std::string_view text);
+std::optional<std::string> ExtractTokenAt(const std::string& text,
+                                          const std::vector<size_t>& line_starts,
+                                          int line, int character);
+std::optional<std::string> ExtractTokenPrefix(const std::string& text,
+                                              const std::vector<size_t>& line_starts,
+                                              int line, int character);
 
 bool HasPrefixIgnoreCase(std::string_view text, std::string_view prefix);
 bool ContainsIgnoreCase(std::string_view text, std::string_view query);
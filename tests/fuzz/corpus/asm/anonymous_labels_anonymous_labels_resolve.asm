@@ -0,0 +1,31 @@
+lorom
+macro wait(n)
+?-
+  DEX
+  BNE ?-
+  BRA ?+
+  NOP
+?+
+?inner:
+  LDA #<n>
+  BEQ ?+
+  BRA ?inner
+?+
+endmacro
+org $008000
+Start:
+-
+  %wait(1)
+  BRA +
+--
+  %wait(2)
++
+  BNE -
+  BNE --
+  JMP ++
+  %wait(3)
+++
+Zed:
+  dw datasize(Start)
+-:
+  BRA -
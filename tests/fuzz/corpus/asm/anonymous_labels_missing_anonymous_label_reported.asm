@@ -0,0 +1,5 @@
+lorom
+org $008000
+  BRA +
+  BRA ++
++
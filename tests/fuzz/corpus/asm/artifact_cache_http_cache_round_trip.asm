@@ -0,0 +1,6 @@
+lorom
+org $008000
+incsrc "routines.asm"
+Table:
+  incbin "table.bin"
+print "built"
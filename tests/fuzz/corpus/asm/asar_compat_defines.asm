@@ -0,0 +1,5 @@
+; Asar compat: !define substitution
+!x = $42
+lorom
+org $8000
+db !x
@@ -0,0 +1,5 @@
+; Asar compat: dw (16-bit little-endian), dl (24-bit)
+lorom
+org $8000
+dw $1234
+dl $123456
@@ -0,0 +1,2 @@
+; Included by incsrc_main.asm
+db $11
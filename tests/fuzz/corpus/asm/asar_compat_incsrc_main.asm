@@ -0,0 +1,4 @@
+; Asar compat: incsrc
+lorom
+org $8000
+incsrc incsrc_inc.asm
@@ -0,0 +1,7 @@
+; Asar compat: labels
+lorom
+org $8000
+main:
+db $00
+.sub:
+db $01
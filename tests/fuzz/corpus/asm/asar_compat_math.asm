@@ -0,0 +1,6 @@
+; Asar compat: math in operands (PEMDAS, + - * /)
+lorom
+org $8000
+db 1+1
+db 2*3
+db (1+2)*3
@@ -0,0 +1,6 @@
+; Asar compat: pad (fill until address)
+lorom
+org $8000
+db $01
+pad $8005
+db $02
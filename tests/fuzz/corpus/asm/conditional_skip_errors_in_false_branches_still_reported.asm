@@ -0,0 +1,14 @@
+lorom
+org $008000
+if 0
+  if 0
+    while 1
+      db $01
+    else
+    endwhile
+  endif
+endif
+if 0
+  while 0
+  endif
+endif
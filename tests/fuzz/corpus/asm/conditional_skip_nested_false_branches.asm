@@ -0,0 +1,56 @@
+lorom
+org $008000
+!on = 1
+if !on == 0
+  db $01
+  if 1
+    db $02
+  elseif !undefined
+    db $03
+  else
+    db $04
+  endif
+  while 1
+    db $05
+  endwhile
+  for i = 0..4 : db $06 : endfor
+  db $07 : if 1 : db $08 : endif
+elseif 0
+  db $09
+elseif !on
+  db $10
+  if 0
+    if 1
+      db $11
+    else
+      db $12
+    endif
+  elseif 0
+    db $13
+  else
+    db $14
+  endif
+else
+  db $15
+endif
+!n = 0
+while !n < 3
+  if !n == 1
+    db $16
+  elseif !n == 2
+    db $17
+  else
+    if 0
+      db $18
+    endif
+    db $19
+  endif
+  !n #= !n+1
+endwhile
+for i = 0..3
+  if !i != 1
+    db $20+!i
+  endif
+endfor
+if 0 : db $23 : endif
+db $24
@@ -0,0 +1,6 @@
+lorom
+org $008000
+if 0
+  if 1
+  endif
+db $01
@@ -0,0 +1,4 @@
+lorom
+org $008000
+Main:
+  RTL
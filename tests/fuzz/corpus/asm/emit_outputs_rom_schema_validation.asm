@@ -0,0 +1,6 @@
+lorom
+org $008000
+Rooms:
+  dw Room0, Room1
+Room0: db $00, $01
+Room1: db $00, $C2
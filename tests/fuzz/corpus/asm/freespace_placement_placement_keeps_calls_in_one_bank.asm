@@ -0,0 +1,25 @@
+lorom
+optimize placement on
+org $008000
+  autoclean JSL RoutineA
+  autoclean JSL RoutineB
+  autoclean JSL HelperA
+  autoclean JSL HelperB
+freecode
+RoutineA:
+  JSL HelperA
+  RTL
+  fill $1800
+freecode
+RoutineB:
+  JSL HelperB
+  RTL
+  fill $1800
+freecode
+HelperA:
+  RTL
+  fill $6000
+freecode
+HelperB:
+  RTS
+  fill $6000
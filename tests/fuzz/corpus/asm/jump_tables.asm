@@ -0,0 +1,58 @@
+lorom
+org $008000
+Reset:
+  SEP #$30
+  LDA $10
+  AND #$03
+  ASL
+  TAX
+  JSR (Modes,X)
+  LDA $11
+  CMP #$03
+  BCS .done
+  ASL
+  TAX
+  JMP (States,X)
+.done
+  RTS
+
+Modes:
+  dw ModeA, ModeB, ModeC, $0000
+
+States:
+  dw StateA, StateB, StateC
+
+ModeA:
+  REP #$20
+  LDA #$1234
+  RTS
+ModeB:
+  LDA #$01
+  RTS
+ModeC:
+  LDA #$02
+  RTS
+StateA:
+  LDA #$03
+  RTS
+StateB:
+  LDA #$04
+  RTS
+StateC:
+  LDA #$05
+  RTS
+
+Unbounded:
+  LDA $12
+  ASL
+  TAX
+  JSR (.table,X)
+  RTS
+.table
+  dw Sub0, Sub1
+Sub0:
+  LDY #$00
+  RTS
+Sub1:
+  LDY #$01
+  RTS
@@ -0,0 +1,7 @@
+lorom
+org $008000
+namespace Inner
+Foo:
+  dw Foo, Missing
+namespace off
+  dw Inner_Foo, .nope
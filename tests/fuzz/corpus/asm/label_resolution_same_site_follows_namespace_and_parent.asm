@@ -0,0 +1,27 @@
+lorom
+org $008000
+macro ref()
+  dw Target
+endmacro
+macro loop_back()
+  BRA .loop
+endmacro
+Target:
+  NOP
+First:
+.loop
+  %loop_back()
+Second:
+  NOP
+.loop
+  %loop_back()
+namespace Inner
+Target:
+  %ref()
+namespace off
+  %ref()
+!i = 0
+while !i < 2
+  dw Second, Second_loop
+  !i #= !i+1
+endwhile
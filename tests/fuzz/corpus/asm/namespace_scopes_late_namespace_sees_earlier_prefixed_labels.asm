@@ -0,0 +1,11 @@
+lorom
+org $008000
+C_D_Early: NOP
+namespace C_D
+  dw Early, Late
+namespace off
+namespace nested on
+namespace C
+namespace D
+  dw Early, Late
+Late: NOP
@@ -0,0 +1,9 @@
+lorom
+org $008000
+Foo: NOP
+A_Flat: NOP
+namespace A
+Foo: NOP
+  dw Foo, Flat, A_Foo
+namespace off
+  dw Foo, A_Foo
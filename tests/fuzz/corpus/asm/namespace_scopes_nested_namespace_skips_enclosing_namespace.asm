@@ -0,0 +1,7 @@
+lorom
+org $008000
+namespace nested on
+namespace A
+Bar: NOP
+namespace B
+  dw Bar
@@ -0,0 +1,12 @@
+lorom
+org $008000
+Foo: NOP
+namespace A
+Foo: NOP
+pushns
+  dw Foo
+namespace B
+Foo: NOP
+  dw Foo
+pullns
+  dw Foo, B_Foo
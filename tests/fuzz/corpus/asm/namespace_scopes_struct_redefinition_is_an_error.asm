@@ -0,0 +1,8 @@
+lorom
+org $008000
+struct Obj $7E0000
+.x: skip 2
+endstruct
+struct Obj $7E0010
+.y: skip 2
+endstruct
@@ -0,0 +1,17 @@
+lorom
+org $008000
+struct Obj $7E0000
+.x: skip 2
+.y: skip 1
+endstruct
+struct Sub extends Obj
+.z: skip 4
+endstruct
+namespace N
+struct Local $7F0000
+.a: skip 3
+endstruct align 4
+  dw Local.a, Obj.y, Obj.Sub.z, Obj[2].y
+  dw sizeof(Local), sizeof(Obj), objectsize(Obj), sizeof(Obj.Sub)
+namespace off
+  dw N_Local.a, sizeof(Local)
@@ -0,0 +1,10 @@
+lorom
+org $008000
+!depth = 5000
+macro down()
+  !depth #= !depth-1
+  if !depth > 0
+    %down()
+  endif
+endmacro
+db $01 : %down() : db $02
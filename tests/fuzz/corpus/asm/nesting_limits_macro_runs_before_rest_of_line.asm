@@ -0,0 +1,9 @@
+lorom
+org $008000
+macro inner()
+  db $02
+endmacro
+macro outer()
+  %inner() : db $03
+endmacro
+db $01 : %outer() : db $04
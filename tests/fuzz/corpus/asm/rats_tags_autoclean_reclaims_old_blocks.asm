@@ -0,0 +1,12 @@
+lorom
+org $008000
+  autoclean JSL RoutineA
+  autoclean JSL RoutineB
+freecode
+RoutineA:
+  RTL
+  fill $10
+freecode
+RoutineB:
+  RTL
+  fill $10
@@ -0,0 +1,17 @@
+lorom
+org $008000
+  autoclean JSL RoutineA
+  autoclean JSL RoutineB
+  autoclean JSL RoutineC
+freecode
+RoutineA:
+  RTL
+  fill $100
+freecode
+RoutineB:
+  RTL
+  fill $2000
+freecode
+RoutineC:
+  RTL
+  fill $40
@@ -0,0 +1,7 @@
+lorom
+org $008000
+  autoclean JSL RoutineA
+freecode
+RoutineA:
+  RTL
+  fill $10
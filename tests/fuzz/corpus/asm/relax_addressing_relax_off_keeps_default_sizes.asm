@@ -0,0 +1,18 @@
+lorom
+optimize relax on
+optimize relax off
+org $008000
+  JML Code
+freecode bank=$10
+Code:
+  LDA Table,x
+  STA Buffer
+  LDA.l Table
+  JMP Code2
+Code2:
+  RTL
+freedata bank=$10
+Table:
+  db 1,2,3,4
+Buffer:
+  db 0
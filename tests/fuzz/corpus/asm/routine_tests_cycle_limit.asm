@@ -0,0 +1,16 @@
+lorom
+MODE = $7E0010
+org $008000
+Broken:
+  LDA #$05
+  STA MODE
+  ; @assert MODE == 6
+  RTL
+
+Spin:
+  ; @test
+  BRA Spin
+
+Typo:
+  ; @assert NoSuchLabel == 1
+  RTL
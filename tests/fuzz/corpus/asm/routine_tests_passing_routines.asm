@@ -0,0 +1,45 @@
+lorom
+MODE = $7E0010
+COUNTER = $7E0020
+org $008000
+Increment:
+  ; @test MODE=$06 A=$1234 m=16
+  SEP #$20
+  LDA MODE
+  INC
+  STA MODE
+  ; @assert MODE == $07
+  ; @assert A == $1207
+  RTL
+
+SumTable:
+  LDX #$00
+  LDA #$00
+  CLC
+.loop
+  ADC Table,x
+  INX
+  CPX #$04
+  BNE .loop
+  STA COUNTER      ; @assert A == 10
+  RTS
+  ; @assert COUNTER == 10 && X == 4
+
+Table:
+  db 1,2,3,4
+
+Multiply:
+  ; @test m=16
+  SEP #$20
+  LDA #$07 : STA $4202
+  LDA #$09 : STA $4203
+  REP #$20
+  LDA $4216
+  ; @assert A == 63 && [$004216].w == 63
+  RTL
+
+Decimal:
+  ; @test A=$0999 m=16
+  SED : CLC : ADC #$0001 : CLD
+  ; @assert A == $1000 && (P & 1) == 0
+  RTS
@@ -0,0 +1,2 @@
+org $008000
+db $9D, $18, $21 ; STA $2118,X
@@ -0,0 +1,2 @@
+INIDISP = $2100
+CGDATA = $2122
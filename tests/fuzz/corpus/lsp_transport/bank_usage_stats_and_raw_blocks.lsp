@@ -0,0 +1,9 @@
+Content-Length: 115
+
+{"jsonrpc": "2.0", "id": 1, "method": "initialize", "params": {"rootUri": "file:///workspace", "capabilities": {}}}Content-Length: 57
+
+{"jsonrpc": "2.0", "method": "initialized", "params": {}}Content-Length: 246
+
+{"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {"textDocument": {"uri": "file:///workspace/Main.asm", "languageId": "asar", "version": 1, "text": "lorom\norg $008000\n  db 1, 2, 3, 4\norg $008010\n  dw 5\norg $018000\n  db 6\n"}}}Content-Length: 128
+
+{"jsonrpc": "2.0", "id": 200, "method": "workspace/executeCommand", "params": {"command": "z3dk.getBankUsage", "arguments": []}}
\ No newline at end of file
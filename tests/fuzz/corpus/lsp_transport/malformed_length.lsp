@@ -0,0 +1,5 @@
+Content-Length: 99999999999
+
+{}Content-Length: abc
+
+{}
\ No newline at end of file
@@ -0,0 +1,7 @@
+Content-Length: 115
+
+{"jsonrpc": "2.0", "id": 1, "method": "initialize", "params": {"rootUri": "file:///workspace", "capabilities": {}}}Content-Length: 57
+
+{"jsonrpc": "2.0", "method": "initialized", "params": {}}Content-Length: 186
+
+{"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {"textDocument": {"uri": "file:///workspace/included.asm", "languageId": "asar", "version": 1, "text": "JSL MainLabel\n"}}}
\ No newline at end of file
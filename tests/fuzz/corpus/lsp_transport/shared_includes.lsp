@@ -0,0 +1,9 @@
+Content-Length: 115
+
+{"jsonrpc": "2.0", "id": 1, "method": "initialize", "params": {"rootUri": "file:///workspace", "capabilities": {}}}Content-Length: 57
+
+{"jsonrpc": "2.0", "method": "initialized", "params": {}}Content-Length: 190
+
+{"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {"textDocument": {"uri": "file:///workspace/shared.asm", "languageId": "asar", "version": 1, "text": "JSL OracleOnlyLabel\n"}}}Content-Length: 181
+
+{"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {"textDocument": {"uri": "file:///workspace/shared_before.asm", "languageId": "asar", "version": 1, "text": "NOP\n"}}}
\ No newline at end of file
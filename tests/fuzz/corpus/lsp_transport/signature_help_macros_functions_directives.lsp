@@ -0,0 +1,9 @@
+Content-Length: 115
+
+{"jsonrpc": "2.0", "id": 1, "method": "initialize", "params": {"rootUri": "file:///workspace", "capabilities": {}}}Content-Length: 57
+
+{"jsonrpc": "2.0", "method": "initialized", "params": {}}Content-Length: 323
+
+{"jsonrpc": "2.0", "method": "textDocument/didOpen", "params": {"textDocument": {"uri": "file:///workspace/Main.asm", "languageId": "asar", "version": 1, "text": "macro Store(value, addr)\n  LDA #<value>\n  STA <addr>\nendmacro\nfunction twice(x) = x*2\norg $008000\n  %Store(twice(1), $00)\n  db clamp(1, 0, 2), 3, 4\n"}}}Content-Length: 178
+
+{"jsonrpc": "2.0", "id": 100, "method": "textDocument/signatureHelp", "params": {"textDocument": {"uri": "file:///workspace/Main.asm"}, "position": {"line": 6, "character": 19}}}
\ No newline at end of file
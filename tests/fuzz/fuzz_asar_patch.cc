@@ -0,0 +1,45 @@
+// asar_patch through the C API: the input is the whole patch, read from a
+// memory file onto a blank 512 KiB ROM.
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "fuzz_budget.h"
+#include "interface-lib.h"
+
+namespace {
+
+// Recursing to the default macro depth with an error at every level takes
+// ~0.7 s and 400k allocations, since each error keeps its call stack.
+constexpr z3dk_fuzz::Budget kBudget = {16 * 1024, 2.0, 2000000};
+constexpr int kRomSize = 0x80000;
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size > kBudget.max_input) return 0;
+  z3dk_fuzz::BudgetScope scope("asar_patch", kBudget);
+
+  static std::vector<char> rom(kRomSize);
+  std::memset(rom.data(), 0, rom.size());
+  int rom_length = kRomSize;
+
+  memoryfile file = {"fuzz.asm", data, size};
+  patchparams params;
+  std::memset(&params, 0, sizeof(params));
+  params.structsize = asar_patchparams_size();
+  params.patchloc = "fuzz.asm";
+  params.romdata = rom.data();
+  params.buflen = static_cast<int>(rom.size());
+  params.romlen = &rom_length;
+  params.memory_files = &file;
+  params.memory_file_count = 1;
+
+  asar_reset();
+  asar_patch(&params);
+  int count = 0;
+  asar_geterrors(&count);
+  asar_getalllabels(&count);
+  asar_getwrittenblocks(&count);
+  return 0;
+}
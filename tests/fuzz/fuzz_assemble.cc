@@ -0,0 +1,37 @@
+// Assembler::Assemble over up to four memory files, split on NUL bytes: the
+// first piece is fuzz.asm, the rest inc1.asm, inc2.asm and inc3.asm, so
+// incsrc and macros spread across files get exercised too.
+#include <cstdint>
+#include <string>
+
+#include "fuzz_budget.h"
+#include "z3dk_core/assembler.h"
+
+namespace {
+
+// Recursing to the default macro depth with an error at every level takes
+// ~0.7 s and 400k allocations, since each error keeps its call stack.
+constexpr z3dk_fuzz::Budget kBudget = {16 * 1024, 2.0, 2000000};
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size > kBudget.max_input) return 0;
+  z3dk_fuzz::BudgetScope scope("assemble", kBudget);
+
+  z3dk::AssembleOptions options;
+  options.patch_path = "fuzz.asm";
+  options.rom_data.assign(0x80000, 0);
+  std::string input(reinterpret_cast<const char*>(data), size);
+  size_t start = 0;
+  for (int index = 0; index < 4 && start <= input.size(); ++index) {
+    size_t end = index == 3 ? input.size() : input.find('\0', start);
+    if (end == std::string::npos) end = input.size();
+    std::string path = index == 0 ? "fuzz.asm" : "inc" + std::to_string(index) + ".asm";
+    options.memory_files.push_back({path, input.substr(start, end - start)});
+    start = end + 1;
+  }
+
+  z3dk::Assembler().Assemble(options);
+  return 0;
+}
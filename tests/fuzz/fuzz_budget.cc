@@ -0,0 +1,119 @@
+#include "fuzz_budget.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || \
+    __has_feature(thread_sanitizer)
+#define Z3DK_FUZZ_SANITIZER_HOOKS 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define Z3DK_FUZZ_SANITIZER_HOOKS 1
+#endif
+
+#if defined(Z3DK_FUZZ_SANITIZER_HOOKS)
+#include <sanitizer/allocator_interface.h>
+#endif
+
+namespace z3dk_fuzz {
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+void CountAllocation() {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+double BudgetScale() {
+  static const double scale = [] {
+    const char* value = std::getenv("Z3DK_FUZZ_BUDGET_SCALE");
+    double parsed = value ? std::atof(value) : 0.0;
+    return parsed > 0.0 ? parsed : 1.0;
+  }();
+  return scale;
+}
+
+#if defined(Z3DK_FUZZ_SANITIZER_HOOKS)
+void OnMalloc(const volatile void*, size_t) { CountAllocation(); }
+void OnFree(const volatile void*) {}
+[[maybe_unused]] const int g_hooks_installed =
+    __sanitizer_install_malloc_and_free_hooks(OnMalloc, OnFree);
+#endif
+
+}  // namespace
+
+uint64_t AllocationCount() {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+BudgetScope::BudgetScope(const char* target, const Budget& budget)
+    : target_(target),
+      budget_(budget),
+      start_(std::chrono::steady_clock::now()),
+      start_allocations_(AllocationCount()) {}
+
+BudgetScope::~BudgetScope() {
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  uint64_t allocations = AllocationCount() - start_allocations_;
+  double max_seconds = budget_.seconds * BudgetScale();
+  double max_allocations = static_cast<double>(budget_.allocations) * BudgetScale();
+  if (seconds <= max_seconds && static_cast<double>(allocations) <= max_allocations) {
+    return;
+  }
+  std::fprintf(stderr,
+               "==z3dk-fuzz== %s: input over budget: %.3f s (budget %.3f s), "
+               "%llu allocations (budget %.0f)\n",
+               target_, seconds, max_seconds, static_cast<unsigned long long>(allocations),
+               max_allocations);
+  std::abort();
+}
+
+}  // namespace z3dk_fuzz
+
+#if !defined(Z3DK_FUZZ_SANITIZER_HOOKS)
+#if defined(__GLIBC__)
+// glibc lets a program replace malloc; forwarding to the __libc_ entry points
+// counts every C and C++ allocation, asar's autoarrays included.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+  z3dk_fuzz::CountAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  z3dk_fuzz::CountAllocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  z3dk_fuzz::CountAllocation();
+  return __libc_realloc(ptr, size);
+}
+}
+#else
+void* operator new(std::size_t size) {
+  z3dk_fuzz::CountAllocation();
+  if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  z3dk_fuzz::CountAllocation();
+  if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+#endif
@@ -0,0 +1,47 @@
+#ifndef Z3DK_FUZZ_BUDGET_H_
+#define Z3DK_FUZZ_BUDGET_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace z3dk_fuzz {
+
+// What one input may cost a target. Inputs are capped at `max_input` bytes,
+// so an input that needs more than `seconds` or `allocations` is growing
+// faster than its size (a quadratic define or macro expansion, say) rather
+// than just being big.
+struct Budget {
+  size_t max_input;
+  double seconds;
+  uint64_t allocations;
+};
+
+// Heap allocations made so far by every thread. Counted through the
+// sanitizer allocator hooks in sanitizer builds, by interposing malloc on
+// glibc, and through operator new elsewhere (which misses C allocations).
+uint64_t AllocationCount();
+
+// Put one at the top of LLVMFuzzerTestOneInput. When the input is done, an
+// input over the budget is reported and the process aborts, so libFuzzer
+// (or the standalone driver) keeps it like a crash. Z3DK_FUZZ_BUDGET_SCALE
+// in the environment multiplies the time and allocation limits, e.g. for
+// slow sanitizer builds.
+class BudgetScope {
+ public:
+  BudgetScope(const char* target, const Budget& budget);
+  ~BudgetScope();
+
+  BudgetScope(const BudgetScope&) = delete;
+  BudgetScope& operator=(const BudgetScope&) = delete;
+
+ private:
+  const char* target_;
+  Budget budget_;
+  std::chrono::steady_clock::time_point start_;
+  uint64_t start_allocations_;
+};
+
+}  // namespace z3dk_fuzz
+
+#endif  // Z3DK_FUZZ_BUDGET_H_
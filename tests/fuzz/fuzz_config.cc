@@ -0,0 +1,21 @@
+// z3dk.toml parsing.
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "fuzz_budget.h"
+#include "z3dk_core/config.h"
+
+namespace {
+
+constexpr z3dk_fuzz::Budget kBudget = {16 * 1024, 0.25, 50000};
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size > kBudget.max_input) return 0;
+  z3dk_fuzz::BudgetScope scope("config", kBudget);
+  std::istringstream input(std::string(reinterpret_cast<const char*>(data), size));
+  z3dk::ParseConfig(input);
+  return 0;
+}
@@ -0,0 +1,35 @@
+// z3disasm's bank listing: the first byte sets the starting M/X widths
+// (bit 5 and bit 4 set = 8 bit, as in P), the rest is bank $00 of a LoROM
+// image. Jump table recovery runs first, as with --jump-tables.
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+#include "analysis.h"
+#include "disassembler.h"
+#include "fuzz_budget.h"
+
+namespace {
+
+constexpr z3dk_fuzz::Budget kBudget = {0x8001, 1.0, 400000};
+// z3disasm's --trace-budget default
+constexpr uint64_t kTraceBudget = 1000000;
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size < 2 || size > kBudget.max_input) return 0;
+  z3dk_fuzz::BudgetScope scope("disasm", kBudget);
+
+  int m_width = (data[0] & 0x20) ? 1 : 2;
+  int x_width = (data[0] & 0x10) ? 1 : 2;
+  std::vector<uint8_t> rom(data + 1, data + size);
+
+  z3disasm::BankAnalysis analysis =
+      z3disasm::AnalyzeBank(rom, 0, m_width, x_width, kTraceBudget);
+  z3disasm::LabelIndex labels;
+  z3disasm::HookMap hooks;
+  std::ostringstream out;
+  z3disasm::DisassembleBank(out, rom, 0, labels, hooks, &analysis, m_width, x_width);
+  return 0;
+}
@@ -0,0 +1,31 @@
+// RunLint with every check on, over whatever the input assembles to. Only
+// the lint pass counts against the budget; fuzz_assemble covers assembling.
+#include <cstdint>
+#include <string>
+
+#include "fuzz_budget.h"
+#include "z3dk_core/assembler.h"
+#include "z3dk_core/lint.h"
+
+namespace {
+
+constexpr z3dk_fuzz::Budget kBudget = {16 * 1024, 0.5, 200000};
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size > kBudget.max_input) return 0;
+
+  z3dk::AssembleOptions options;
+  options.patch_path = "fuzz.asm";
+  options.rom_data.assign(0x80000, 0);
+  options.memory_files.push_back(
+      {options.patch_path, std::string(reinterpret_cast<const char*>(data), size)});
+  z3dk::AssembleResult result = z3dk::Assembler().Assemble(options);
+
+  z3dk::LintOptions lint_options;
+  lint_options.warn_bank_full_percent = 95;
+  z3dk_fuzz::BudgetScope scope("lint", kBudget);
+  z3dk::RunLint(result, lint_options);
+  return 0;
+}
@@ -0,0 +1,25 @@
+// Reads every Content-Length framed message out of the input, the way the
+// z3lsp main loop does from stdin.
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "fuzz_budget.h"
+#include "lsp_transport.h"
+
+namespace {
+
+constexpr z3dk_fuzz::Budget kBudget = {64 * 1024, 0.5, 200000};
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size > kBudget.max_input) return 0;
+  z3dk_fuzz::BudgetScope scope("lsp_transport", kBudget);
+  std::istringstream input(std::string(reinterpret_cast<const char*>(data), size));
+  while (input.good()) {
+    auto message = z3lsp::ReadMessage(input);
+    if (message) message->dump();
+  }
+  return 0;
+}
@@ -0,0 +1,20 @@
+// z3lsp's symbol and include scan of one document.
+#include <cstdint>
+#include <string>
+
+#include "fuzz_budget.h"
+#include "parser.h"
+
+namespace {
+
+constexpr z3dk_fuzz::Budget kBudget = {64 * 1024, 0.5, 200000};
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size > kBudget.max_input) return 0;
+  z3dk_fuzz::BudgetScope scope("parser", kBudget);
+  z3lsp::ParseFileText(std::string(reinterpret_cast<const char*>(data), size),
+                       "file:///fuzz/main.asm");
+  return 0;
+}
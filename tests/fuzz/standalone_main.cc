@@ -0,0 +1,97 @@
+// Runs a fuzz target over files and directories of inputs, for compilers
+// without libFuzzer. Takes the same positional arguments as a libFuzzer
+// binary plus -timeout=N (seconds per input, 0 = none); other -flags are
+// ignored so the same command lines work with both.
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int g_timeout_seconds = 1200;
+
+#if !defined(_WIN32)
+void OnTimeout(int) {
+  static const char kMessage[] = "==z3dk-fuzz== timeout\n";
+  ssize_t ignored = write(STDERR_FILENO, kMessage, sizeof(kMessage) - 1);
+  (void)ignored;
+  std::abort();
+}
+#endif
+
+bool RunInput(const fs::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    std::fprintf(stderr, "cannot read %s\n", path.string().c_str());
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+  std::fprintf(stderr, "Running: %s\n", path.string().c_str());
+#if !defined(_WIN32)
+  alarm(static_cast<unsigned>(g_timeout_seconds));
+#endif
+  auto start = std::chrono::steady_clock::now();
+  LLVMFuzzerTestOneInput(data.data(), data.size());
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+#if !defined(_WIN32)
+  alarm(0);
+#endif
+  std::fprintf(stderr, "Executed %s in %lld ms\n", path.string().c_str(),
+               static_cast<long long>(elapsed.count()));
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<fs::path> inputs;
+  for (int i = 1; i < argc; ++i) {
+    if (argv[i][0] == '-') {
+      if (std::strncmp(argv[i], "-timeout=", 9) == 0) {
+        g_timeout_seconds = std::max(0, std::atoi(argv[i] + 9));
+      }
+      continue;
+    }
+    fs::path path = argv[i];
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) {
+      std::vector<fs::path> files;
+      for (const auto& entry : fs::directory_iterator(path, ec)) {
+        if (entry.is_regular_file()) files.push_back(entry.path());
+      }
+      std::sort(files.begin(), files.end());
+      inputs.insert(inputs.end(), files.begin(), files.end());
+    } else {
+      inputs.push_back(path);
+    }
+  }
+
+#if !defined(_WIN32)
+  std::signal(SIGALRM, OnTimeout);
+#endif
+  bool ok = true;
+  for (const auto& path : inputs) {
+    ok = RunInput(path) && ok;
+  }
+  std::fprintf(stderr, "*** ran %zu inputs\n", inputs.size());
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+"""Shared fixtures for the z3dk tool tests: finding the built binaries and
+assembling a patch in a scratch directory."""
+from __future__ import annotations
+
+import json
+import os
+import pathlib
+import shutil
+import subprocess
+from dataclasses import dataclass
+from typing import Any, Callable
+
+import pytest
+
+REPO_ROOT = pathlib.Path(__file__).resolve().parents[2]
+
+
+def find_tool(env: str, name: str) -> pathlib.Path | None:
+    """Resolve a z3dk binary: env override, then build dirs, then PATH."""
+    exe = os.environ.get(env)
+    if exe:
+        return pathlib.Path(exe)
+    candidates = [
+        REPO_ROOT / "build" / "bin" / name,
+        REPO_ROOT / "build" / "src" / name / name,
+        REPO_ROOT / "build" / "src" / name / "bin" / name,
+    ]
+    for candidate in candidates:
+        if candidate.exists():
+            return candidate
+    return pathlib.Path(shutil.which(name)) if shutil.which(name) else None
+
+
+@pytest.fixture(scope="session")
+def z3asm_path() -> pathlib.Path:
+    exe = find_tool("Z3ASM", "z3asm")
+    if not exe:
+        pytest.skip("z3asm not found (build z3dk or set Z3ASM)")
+    return exe
+
+
+@pytest.fixture(scope="session")
+def z3disasm_path() -> pathlib.Path:
+    exe = find_tool("Z3DISASM", "z3disasm")
+    if not exe:
+        pytest.skip("z3disasm not found (build z3dk or set Z3DISASM)")
+    return exe
+
+
+@dataclass
+class Build:
+    """One z3asm run: the process, the directory it ran in and the ROM after."""
+
+    proc: subprocess.CompletedProcess
+    root: pathlib.Path
+    rom: bytes
+
+    @property
+    def returncode(self) -> int:
+        return self.proc.returncode
+
+    @property
+    def stdout(self) -> str:
+        return self.proc.stdout
+
+    @property
+    def stderr(self) -> str:
+        return self.proc.stderr
+
+    def text(self, name: str) -> str:
+        """An output file's contents, or "" when z3asm didn't write it."""
+        path = self.root / name
+        return path.read_text() if path.exists() else ""
+
+    def json(self, name: str) -> Any:
+        return json.loads((self.root / name).read_text())
+
+
+def run_z3asm(
+    z3asm_path: pathlib.Path,
+    root: pathlib.Path,
+    source: str | None,
+    *args: str,
+    files: dict[str, str | bytes] | None = None,
+    rom_size: int | None = 0x8000,
+) -> Build:
+    """Writes `source` to main.asm and `files` next to it, starts out.sfc as
+    `rom_size` zero bytes (None keeps the ROM already there) and assembles.
+    Z3DK_CACHE is dropped so a developer's cache never leaks into a test."""
+    root.mkdir(parents=True, exist_ok=True)
+    for name, contents in (files or {}).items():
+        path = root / name
+        path.parent.mkdir(parents=True, exist_ok=True)
+        if isinstance(contents, bytes):
+            path.write_bytes(contents)
+        else:
+            path.write_text(contents)
+    if source is not None:
+        (root / "main.asm").write_text(source)
+    rom_path = root / "out.sfc"
+    if rom_size is not None:
+        rom_path.write_bytes(bytes(rom_size))
+    env = dict(os.environ)
+    env.pop("Z3DK_CACHE", None)
+    proc = subprocess.run(
+        [str(z3asm_path), "main.asm", "out.sfc", *args],
+        cwd=root,
+        env=env,
+        capture_output=True,
+        text=True,
+    )
+    rom = rom_path.read_bytes() if rom_path.exists() else b""
+    return Build(proc, root, rom)
+
+
+@pytest.fixture
+def assemble(z3asm_path: pathlib.Path, tmp_path: pathlib.Path) -> Callable[..., Build]:
+    """assemble(source, *args, root=tmp_path, files=None, rom_size=0x8000)"""
+
+    def run(source: str | None, *args: str, root: pathlib.Path | None = None,
+            **kwargs: Any) -> Build:
+        return run_z3asm(z3asm_path, root or tmp_path, source, *args, **kwargs)
+
+    return run
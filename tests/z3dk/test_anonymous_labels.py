@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Tests that +/- and ?+/?- labels resolve and are listed like named labels."""
+from __future__ import annotations
+
+
+SOURCE = "\n".join([
+    "lorom",
+    "macro wait(n)",
+    "?-",
+    "  DEX",
+    "  BNE ?-",
+    "  BRA ?+",
+    "  NOP",
+    "?+",
+    "?inner:",
+    "  LDA #<n>",
+    "  BEQ ?+",
+    "  BRA ?inner",
+    "?+",
+    "endmacro",
+    "org $008000",
+    "Start:",
+    "-",
+    "  %wait(1)",
+    "  BRA +",
+    "--",
+    "  %wait(2)",
+    "+",
+    "  BNE -",
+    "  BNE --",
+    "  JMP ++",
+    "  %wait(3)",
+    "++",
+    "Zed:",
+    "  dw datasize(Start)",
+    "-:",
+    "  BRA -",
+]) + "\n"
+
+
+def test_symbols_list_anonymous_labels_by_name(assemble) -> None:
+    # anonymous labels sort among the named ones, ?inner included
+    result = assemble(SOURCE, "--symbols=nocash", "--symbols-path=out.sym")
+    assert result.returncode == 0, result.stderr
+    assert result.text("out.sym").splitlines()[3:] == [
+        "00008006 :macro_0_inner",
+        "00008000 :macro_0_neg_1_1",
+        "00008006 :macro_0_pos_1_0",
+        "0000800C :macro_0_pos_1_1",
+        "00008014 :macro_1_inner",
+        "0000800E :macro_1_neg_1_1",
+        "00008014 :macro_1_pos_1_0",
+        "0000801A :macro_1_pos_1_1",
+        "00008027 :macro_2_inner",
+        "00008021 :macro_2_neg_1_1",
+        "00008027 :macro_2_pos_1_0",
+        "0000802D :macro_2_pos_1_1",
+        "00008000 :neg_1_1",
+        "0000802F :neg_1_2",
+        "0000800E :neg_2_1",
+        "0000801A :pos_1_0",
+        "0000802D :pos_2_0",
+        "00008000 Start",
+        "0000802D Zed",
+    ]
+
+
+def test_anonymous_labels_resolve(assemble) -> None:
+    result = assemble(SOURCE)
+    assert result.returncode == 0, result.stderr
+    rom = result.rom
+    assert rom[0x1A:0x22] == bytes([0xD0, 0xE4, 0xD0, 0xF0, 0x4C, 0x2D, 0x80, 0xCA])
+    # datasize stops at the next label even if it's anonymous
+    assert rom[0x2D:0x2F] == bytes([0x00, 0x00])
+    assert rom[0x2F:0x31] == bytes([0x80, 0xFE])
+
+
+def test_missing_anonymous_label_reported(assemble) -> None:
+    source = "\n".join([
+        "lorom",
+        "org $008000",
+        "  BRA +",
+        "  BRA ++",
+        "+",
+    ]) + "\n"
+    result = assemble(source)
+    assert result.returncode != 0
+    assert "main.asm:4: error: (Elabel_not_found): Label ':pos_2_0' wasn't found." in result.stderr
+    assert ":pos_1_0" not in result.stderr
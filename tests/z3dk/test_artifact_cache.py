@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Tests for the z3asm artifact cache (--cache, local and HTTP backends)."""
+from __future__ import annotations
+
+import http.server
+import pathlib
+import threading
+
+import pytest
+
+MAIN = (
+    "lorom\n"
+    "org $008000\n"
+    "incsrc \"routines.asm\"\n"
+    "Table:\n"
+    "  incbin \"table.bin\"\n"
+    "print \"built\"\n"
+)
+FILES: dict[str, str | bytes] = {
+    "routines.asm": "Main:\n  LDA #$01\n  RTS\n",
+    "table.bin": bytes([1, 2, 3, 4]),
+}
+
+
+def _build(assemble, *extra: str, fresh: bool = False, **kwargs):
+    """Builds the project, writing its sources first when `fresh`. The output
+    ROM is also the base ROM, so every build starts it over as zeros."""
+    if fresh:
+        kwargs["files"] = FILES
+    result = assemble(MAIN if fresh else None, "--emit=labels.csv", *extra, **kwargs)
+    assert result.returncode == 0, result.stderr
+    return result
+
+
+def _cache_line(output: str) -> str:
+    for line in output.splitlines():
+        if line.startswith("Cache: "):
+            return line
+    raise AssertionError(f"no cache line in output:\n{output}")
+
+
+def test_local_cache_hit_restores_outputs(assemble) -> None:
+    args = ("--cache", "--cache-stats=stats.json", "--symbols=wla")
+    first = _build(assemble, *args, fresh=True)
+    assert _cache_line(first.stdout).startswith("Cache: miss, stored")
+    symbols = first.text("out.sym")
+    labels = first.text("labels.csv")
+
+    (first.root / "out.sym").unlink()
+    (first.root / "labels.csv").unlink()
+    second = _build(assemble, *args)
+    assert _cache_line(second.stdout).startswith("Cache: hit")
+    assert "built" in second.stdout
+    assert second.rom == first.rom
+    assert second.text("out.sym") == symbols
+    assert second.text("labels.csv") == labels
+
+    stats = second.json("stats.json")
+    assert stats["hits"] == 1
+    assert stats["misses"] == 1
+    assert stats["stores"] == 1
+
+
+@pytest.mark.parametrize("changed", ["routines.asm", "table.bin"])
+def test_local_cache_misses_when_input_changes(assemble, changed: str) -> None:
+    _build(assemble, "--cache", fresh=True)
+
+    if changed == "table.bin":
+        edit = {"table.bin": bytes([1, 2, 3, 5])}
+    else:
+        edit = {"routines.asm": "Main:\n  LDA #$02\n  RTS\n"}
+    second = _build(assemble, "--cache", files=edit)
+    assert _cache_line(second.stdout).startswith("Cache: miss")
+
+    if changed == "table.bin":
+        assert second.rom[3:7] == bytes([1, 2, 3, 5])
+    else:
+        assert second.rom[0:3] == bytes([0xA9, 0x02, 0x60])
+
+
+def test_no_cache_overrides_cache(assemble) -> None:
+    result = _build(assemble, "--cache", "--no-cache", fresh=True)
+    assert "Cache: " not in result.stdout
+    assert not (result.root / ".z3dk-cache").exists()
+
+
+class _CacheHandler(http.server.BaseHTTPRequestHandler):
+    store: dict[str, bytes] = {}
+    requests: list[str] = []
+
+    def do_GET(self) -> None:  # noqa: N802
+        self.requests.append("GET")
+        body = self.store.get(self.path)
+        if body is None:
+            self.send_response(404)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+        self.send_response(200)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_PUT(self) -> None:  # noqa: N802
+        self.requests.append("PUT")
+        length = int(self.headers.get("Content-Length", "0"))
+        self.store[self.path] = self.rfile.read(length)
+        self.send_response(201)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def log_message(self, *args) -> None:
+        pass
+
+
+def test_http_cache_round_trip(assemble, tmp_path: pathlib.Path) -> None:
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", 0), _CacheHandler)
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    try:
+        url = f"http://127.0.0.1:{server.server_address[1]}/z3dk"
+        first = _build(assemble, f"--cache={url}", fresh=True, root=tmp_path / "a")
+        assert _cache_line(first.stdout).startswith("Cache: miss, stored")
+        assert _CacheHandler.requests.count("PUT") == 2
+        assert all(path.startswith("/z3dk/") for path in _CacheHandler.store)
+
+        # a fresh checkout elsewhere shares the entry
+        second = _build(assemble, f"--cache={url}", fresh=True, root=tmp_path / "b")
+        assert _cache_line(second.stdout).startswith("Cache: hit")
+        assert second.rom == first.rom
+    finally:
+        server.shutdown()
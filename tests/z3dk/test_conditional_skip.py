@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""Tests that false if/elseif/else/while/for branches assemble the same when skipped."""
+from __future__ import annotations
+
+
+def build(assemble, lines: list[str]):
+    return assemble("\n".join(["lorom", "org $008000", *lines]) + "\n")
+
+
+def test_nested_false_branches(assemble) -> None:
+    result = build(assemble, [
+        "!on = 1",
+        "if !on == 0",
+        "  db $01",
+        "  if 1",
+        "    db $02",
+        "  elseif !undefined",
+        "    db $03",
+        "  else",
+        "    db $04",
+        "  endif",
+        "  while 1",
+        "    db $05",
+        "  endwhile",
+        "  for i = 0..4 : db $06 : endfor",
+        "  db $07 : if 1 : db $08 : endif",
+        "elseif 0",
+        "  db $09",
+        "elseif !on",
+        "  db $10",
+        "  if 0",
+        "    if 1",
+        "      db $11",
+        "    else",
+        "      db $12",
+        "    endif",
+        "  elseif 0",
+        "    db $13",
+        "  else",
+        "    db $14",
+        "  endif",
+        "else",
+        "  db $15",
+        "endif",
+        "!n = 0",
+        "while !n < 3",
+        "  if !n == 1",
+        "    db $16",
+        "  elseif !n == 2",
+        "    db $17",
+        "  else",
+        "    if 0",
+        "      db $18",
+        "    endif",
+        "    db $19",
+        "  endif",
+        "  !n #= !n+1",
+        "endwhile",
+        "for i = 0..3",
+        "  if !i != 1",
+        "    db $20+!i",
+        "  endif",
+        "endfor",
+        "if 0 : db $23 : endif",
+        "db $24",
+    ])
+    assert result.returncode == 0, result.stderr
+    assert result.rom[:8] == bytes([0x10, 0x14, 0x19, 0x16, 0x17, 0x20, 0x22, 0x24])
+
+
+def test_errors_in_false_branches_still_reported(assemble) -> None:
+    # an else in a loop and a mismatched end are errors even where nothing
+    # gets assembled, so those branches can't be skipped over
+    result = build(assemble, [
+        "if 0",
+        "  if 0",
+        "    while 1",
+        "      db $01",
+        "    else",
+        "    endwhile",
+        "  endif",
+        "endif",
+        "if 0",
+        "  while 0",
+        "  endif",
+        "endif",
+    ])
+    assert result.returncode != 0
+    assert "main.asm:7: error: (Eelse_in_while_loop)" in result.stderr
+    assert "main.asm:13: error: (Emisplaced_endif)" in result.stderr
+
+
+def test_unclosed_false_branch(assemble) -> None:
+    result = build(assemble, [
+        "if 0",
+        "  if 1",
+        "  endif",
+        "db $01",
+    ])
+    assert result.returncode != 0
+    assert "(Eunclosed_if)" in result.stderr
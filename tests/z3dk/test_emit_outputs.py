@@ -97,3 +97,218 @@ def test_emit_hooks_and_annotations(z3asm_path: pathlib.Path) -> None:
         assert any(a.get("type") == "abi" for a in ann_list), "missing @abi annotation"
 
         assert sourcemap_path.exists(), "sourcemap.json missing"
+
+
+def test_emit_label_index(assemble) -> None:
+    result = assemble(
+        "lorom\n"
+        "Timer = $7E0010\n"
+        "org $008000\n"
+        "Main:\n"
+        "  JSR Sub\n"
+        "  RTL\n"
+        "Sub:\n"
+        "  incsrc \"sub.asm\"\n",
+        "--emit=labels.csv",
+        "--emit=label_index.json",
+        files={"sub.asm": "  LDA Timer\n  RTS\n"},
+        rom_size=0x80000,
+    )
+    assert result.returncode == 0, result.stderr
+
+    rows = result.text("labels.csv").splitlines()
+    assert rows[0] == "address,label,file,line,used"
+    by_label = {row.split(",")[1]: row.split(",") for row in rows[1:]}
+    assert by_label["Main"][0] == "$00:8000"
+    assert by_label["Main"][3] == "5"
+    assert by_label["Main"][4] == "0"
+    # Sub's first instruction comes from the included file
+    assert by_label["Sub"][0] == "$00:8004"
+    assert pathlib.Path(by_label["Sub"][2]).name == "sub.asm"
+    assert by_label["Sub"][3] == "1"
+    assert by_label["Sub"][4] == "1"
+    # RAM equates have an address but no source location
+    assert by_label["Timer"] == ["$7E:0010", "Timer", "", "", "1"]
+
+    index = result.json("label_index.json")
+    labels = {label["name"]: label for label in index["labels"]}
+    assert [label["name"] for label in index["labels"]] == ["Main", "Sub", "Timer"]
+    assert labels["Main"]["address"] == "0x008000"
+    assert labels["Main"]["line"] == 5
+    assert pathlib.Path(labels["Main"]["file"]).name == "main.asm"
+    assert labels["Sub"]["used"] is True
+    assert "file" not in labels["Timer"]
+
+
+def test_emit_watch_and_incremental_symbols(assemble) -> None:
+    source = (
+        "lorom\n"
+        "GameMode = $7E0010 ; @watch fmt=hex\n"
+        "Health = $7EF36D ; @watch fmt=dec\n"
+        "org $008000\n"
+        "Counter: ; @watch\n"
+        "  LDA GameMode\n"
+        "  RTL\n"
+    )
+    emits = ("--emit=symbols.mlb", "--emit=watch.json", "--emit=game.watch")
+    result = assemble(source, *emits, rom_size=0x80000)
+    assert result.returncode == 0, result.stderr
+    root = result.root
+
+    entries = {entry["label"]: entry for entry in result.json("watch.json")["watches"]}
+    assert entries["GameMode"]["address"] == "0x7E0010"
+    assert entries["GameMode"]["expression"] == "[$7E0010]"
+    assert entries["GameMode"]["format"] == "hex"
+    assert entries["Health"]["format"] == "dec"
+    assert entries["Counter"]["address"] == "0x008000"
+    assert "format" not in entries["Counter"]
+    assert result.text("game.watch").splitlines() == [
+        "$7E0010 GameMode hex",
+        "$7EF36D Health dec",
+        "$008000 Counter",
+    ]
+
+    outputs = [root / "symbols.mlb", root / "watch.json", root / "game.watch"]
+    old = 1_000_000_000
+    for path in outputs:
+        os.utime(path, (old, old))
+
+    # same labels: nothing is rewritten, so emulators don't reload
+    result = assemble(source.replace("  RTL\n", "  RTL ; done\n"), *emits, rom_size=None)
+    assert result.returncode == 0, result.stderr
+    assert all(path.stat().st_mtime == old for path in outputs)
+
+    # a moved label rewrites the symbol and watch files
+    result = assemble(source.replace("org $008000\n", "org $008000\n  NOP\n"), *emits,
+                      rom_size=None)
+    assert result.returncode == 0, result.stderr
+    assert all(path.stat().st_mtime != old for path in outputs)
+    assert "PRG:8001:Counter" in result.text("symbols.mlb")
+
+
+def test_many_emits_publish_whole_files(assemble) -> None:
+    emits = [
+        "diagnostics.json",
+        "sourcemap.json",
+        "symbols.mlb",
+        "lint.json",
+        "hooks.json",
+        "annotations.json",
+        "label_index.json",
+        "watch.json",
+    ]
+    result = assemble(
+        "lorom\n"
+        "org $008000\n"
+        "Main:\n"
+        "  LDA #$01 ; @watch\n"
+        "  JSL Main\n"
+        "  RTL\n",
+        *[f"--emit={name}" for name in emits],
+        rom_size=0x80000,
+    )
+    assert result.returncode == 0, result.stderr
+
+    for name in emits:
+        if name.endswith(".json"):
+            result.json(name)
+    assert "Main" in result.text("symbols.mlb")
+    assert result.rom[:4] == b"\xA9\x01\x22\x00"
+    # every output went through a temp file that was renamed into place
+    assert not [p.name for p in result.root.iterdir() if ".tmp" in p.name]
+
+
+def test_failed_emit_write_is_reported(assemble, tmp_path: pathlib.Path) -> None:
+    missing = tmp_path / "missing" / "lint.json"
+    result = assemble(
+        "lorom\norg $008000\nMain:\n  RTL\n",
+        "--emit=diagnostics.json",
+        f"--emit=lint:{missing}",
+        rom_size=0x80000,
+    )
+    assert result.returncode == 1
+    assert f"Unable to write file: {missing}" in result.stderr
+    assert (result.root / "diagnostics.json").exists()
+
+
+def test_rom_schema_validation(assemble, z3asm_path: pathlib.Path) -> None:
+    schema = {
+        "tables": [{
+            "name": "rooms", "address": "$008000", "count": 2,
+            "entry_pointer": 2, "bank": 0,
+            "fields": [{"offset": 1, "mask": "0xC0", "message": "high bits set"}],
+        }]
+    }
+    result = assemble(
+        "lorom\n"
+        "org $008000\n"
+        "Rooms:\n"
+        "  dw Room0, Room1\n"
+        "Room0: db $00, $01\n"
+        "Room1: db $00, $C2\n",
+        "--emit=validation.json",
+        files={
+            "schema.json": json.dumps(schema),
+            "z3dk.toml": 'rom_schema = "schema.json"\n',
+        },
+        rom_size=0x80000,
+    )
+    root = result.root
+    assert result.returncode == 0, result.stderr
+    assert "main.asm:6: warning: rooms[001]: high bits set ($C2)" in result.stderr
+    assert "ROM validation: 0 errors, 1 warnings" in result.stdout
+    report = result.json("validation.json")
+    assert report["success"] is True
+    assert report["warnings"][0]["line"] == 6
+
+    # the same check as an error fails the build
+    schema["tables"][0]["fields"][0]["severity"] = "error"
+    result = assemble(None, "--emit=validation.json",
+                      files={"schema.json": json.dumps(schema)}, rom_size=None)
+    assert result.returncode == 1
+    assert "main.asm:6: error: rooms[001]: high bits set ($C2)" in result.stderr
+    assert result.json("validation.json")["success"] is False
+
+    # an existing ROM, without assembling; the copier header is skipped
+    (root / "edited.smc").write_bytes(b"\x00" * 0x200 + result.rom)
+    proc = subprocess.run(
+        [str(z3asm_path), "--validate-rom=edited.smc", "--emit=validation.json"],
+        cwd=root, capture_output=True, text=True,
+    )
+    assert proc.returncode == 1
+    assert "error: rooms[001]: high bits set ($C2)" in proc.stderr
+    assert "ROM validation: 1 errors, 0 warnings" in proc.stdout
+    report = result.json("validation.json")
+    assert report["errors"][0]["message"] == "rooms[001]: high bits set ($C2)"
+
+    result = assemble(None, "--emit=validation.json",
+                      files={"schema.json": '{"tables": [{"name": "x"}]}'}, rom_size=None)
+    assert result.returncode == 1
+    assert "needs exactly one of address and pointer" in result.stderr
+
+
+def test_emit_clones(assemble) -> None:
+    body = (
+        "  REP #$20\n"
+        "  LDA $10 : CLC : ADC #$0010 : STA $10\n"
+        "  LDA $12 : SEC : SBC #$0008 : STA $12\n"
+        "  SEP #$20\n"
+        "  RTL\n"
+    )
+    result = assemble(
+        "lorom\n"
+        "org $008000\n"
+        "MoveA:\n" + body +
+        "org $028000\n"
+        "MoveB:\n" + body,
+        "--emit=clones.json",
+        rom_size=0x80000,
+    )
+    assert result.returncode == 0, result.stderr
+    report = result.json("clones.json")
+    assert report["bytes_saved"] == 21
+    [clone] = report["clones"]
+    assert clone["kind"] == "routine"
+    assert clone["exact"] is True
+    assert [site["address"] for site in clone["sites"]] == ["0x008000", "0x028000"]
+    assert [site["line"] for site in clone["sites"]] == [4, 11]
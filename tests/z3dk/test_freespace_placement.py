@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Tests for `optimize placement` (call-locality aware freespace placement)."""
+from __future__ import annotations
+
+# in source order, first-fit puts both routines in the first bank and both
+# helpers after them, so every call crosses a bank
+SOURCE = (
+    "lorom\n"
+    "{options}\n"
+    "org $008000\n"
+    "  autoclean JSL RoutineA\n"
+    "  autoclean JSL RoutineB\n"
+    "  autoclean JSL HelperA\n"
+    "  autoclean JSL HelperB\n"
+    "freecode\n"
+    "RoutineA:\n"
+    "  JSL HelperA\n"
+    "  RTL\n"
+    "  fill $1800\n"
+    "freecode\n"
+    "RoutineB:\n"
+    "  {call_b} HelperB\n"
+    "  RTL\n"
+    "  fill $1800\n"
+    "freecode\n"
+    "HelperA:\n"
+    "  RTL\n"
+    "  fill $6000\n"
+    "freecode\n"
+    "HelperB:\n"
+    "  RTS\n"
+    "  fill $6000\n"
+)
+
+
+def place(assemble, options: str, call_b: str = "JSL"):
+    return assemble(SOURCE.format(options=options, call_b=call_b), rom_size=0x100000)
+
+
+def routine_banks(rom: bytes) -> list[int]:
+    """Banks of RoutineA, RoutineB, HelperA, HelperB (from the jsl table)."""
+    banks = []
+    for i in range(4):
+        target = rom[i * 4 + 1] | rom[i * 4 + 2] << 8 | rom[i * 4 + 3] << 16
+        banks.append((target >> 16) & 0x7F)
+    return banks
+
+
+def test_first_fit_splits_callers_from_callees(assemble) -> None:
+    result = place(assemble, "")
+    assert result.returncode == 0, result.stdout + result.stderr
+    a, b, helper_a, helper_b = routine_banks(result.rom)
+    assert a != helper_a and b != helper_b
+    assert "Freespace placement" not in result.stdout
+
+
+def test_placement_keeps_calls_in_one_bank(assemble) -> None:
+    result = place(assemble, "optimize placement on")
+    assert result.returncode == 0, result.stdout + result.stderr
+    a, b, helper_a, helper_b = routine_banks(result.rom)
+    assert a == helper_a
+    assert b == helper_b
+    assert a != b
+    assert "2 of 2 calls between freespaces stay in one bank (first-fit: about 0)" in result.stdout
+    assert "cross-bank long calls down from about 2 to 0" in result.stdout
+
+
+def test_last_placement_setting_wins(assemble) -> None:
+    result = place(assemble, "optimize placement on\noptimize placement off")
+    assert result.returncode == 0, result.stdout + result.stderr
+    assert "Freespace placement" not in result.stdout
+    a, _, helper_a, _ = routine_banks(result.rom)
+    assert a != helper_a
+
+
+def test_placement_with_relax_allows_jsr_between_freespaces(assemble) -> None:
+    # without a known shared bank a jsr into another freespace can't assemble
+    result = place(assemble, "optimize relax on", call_b="JSR")
+    assert result.returncode != 0
+    assert "Ebad_access_width" in result.stdout + result.stderr
+
+    result = place(assemble, "optimize placement on\noptimize relax on", call_b="JSR")
+    assert result.returncode == 0, result.stdout + result.stderr
+    rom = result.rom
+    target = rom[5] | rom[6] << 8 | rom[7] << 16
+    pc = ((target & 0x7F0000) >> 1) | (target & 0x7FFF)
+    helper = rom[13] | rom[14] << 8 | rom[15] << 16
+    assert rom[pc] == 0x20
+    assert rom[pc + 1] | rom[pc + 2] << 8 == helper & 0xFFFF
+
+
+def test_bad_placement_value(assemble) -> None:
+    result = place(assemble, "optimize placement sometimes")
+    assert result.returncode != 0
+    assert "Ebad_placement_optimize" in result.stdout + result.stderr
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Tests for JMP/JSR (abs,X) jump table recovery in z3disasm and lint."""
+from __future__ import annotations
+
+import pathlib
+import shutil
+import subprocess
+
+import pytest
+
+DISPATCH = (
+    "lorom\n"
+    "org $008000\n"
+    "Reset:\n"
+    "  SEP #$30\n"
+    "  LDA $10\n"
+    "  AND #$03\n"
+    "  ASL\n"
+    "  TAX\n"
+    "  JSR (Modes,X)\n"
+    "  LDA $11\n"
+    "  CMP #$03\n"
+    "  BCS .done\n"
+    "  ASL\n"
+    "  TAX\n"
+    "  JMP (States,X)\n"
+    ".done\n"
+    "  RTS\n"
+    "\n"
+    "Modes:\n"
+    "  dw ModeA, ModeB, ModeC, $0000\n"
+    "\n"
+    "States:\n"
+    "  dw StateA, StateB, StateC\n"
+    "\n"
+    "ModeA:\n"
+    "  REP #$20\n"
+    "  LDA #$1234\n"
+    "  RTS\n"
+    "ModeB:\n"
+    "  LDA #$01\n"
+    "  RTS\n"
+    "ModeC:\n"
+    "  LDA #$02\n"
+    "  RTS\n"
+    "StateA:\n"
+    "  LDA #$03\n"
+    "  RTS\n"
+    "StateB:\n"
+    "  LDA #$04\n"
+    "  RTS\n"
+    "StateC:\n"
+    "  LDA #$05\n"
+    "  RTS\n"
+    "\n"
+    "Unbounded:\n"
+    "  LDA $12\n"
+    "  ASL\n"
+    "  TAX\n"
+    "  JSR (.table,X)\n"
+    "  RTS\n"
+    ".table\n"
+    "  dw Sub0, Sub1\n"
+    "Sub0:\n"
+    "  LDY #$00\n"
+    "  RTS\n"
+    "Sub1:\n"
+    "  LDY #$01\n"
+    "  RTS\n"
+)
+
+
+@pytest.fixture
+def assembled(assemble):
+    result = assemble(DISPATCH, "--emit=lint.json", rom_size=0x80000)
+    assert result.returncode == 0, result.stdout + result.stderr
+    return result
+
+
+def disassemble(z3disasm_path: pathlib.Path, root: pathlib.Path, *args: str) -> list[str]:
+    out_dir = root / "disasm"
+    shutil.rmtree(out_dir, ignore_errors=True)
+    result = subprocess.run(
+        [str(z3disasm_path), "--rom", str(root / "out.sfc"), "--out", str(out_dir),
+         "--bank-start", "0", "--bank-end", "0", *args],
+        capture_output=True,
+        text=True,
+    )
+    assert result.returncode == 0, result.stdout + result.stderr
+    return [line.strip() for line in (out_dir / "bank_00.asm").read_text().splitlines()]
+
+
+def test_bounded_tables_are_emitted_as_dw(z3disasm_path: pathlib.Path, assembled) -> None:
+    lines = disassemble(z3disasm_path, assembled.root)
+    assert "JSR (JumpTable_008017,X)" in lines
+    assert "JMP (JumpTable_00801F,X)" in lines
+
+    start = lines.index("JumpTable_008017:")
+    # AND #$03 : ASL bounds X to 6, so the table has exactly four entries
+    assert lines[start + 2:start + 6] == [
+        "dw Code_008025", "dw Code_00802B", "dw Code_00802E", "dw $0000"]
+    assert lines[start + 6] == "JumpTable_00801F:"
+    # CMP #$03 : BCS bounds A to 2 before the ASL
+    assert lines[start + 8:start + 11] == [
+        "dw Code_008031", "dw Code_008034", "dw Code_008037"]
+    assert lines[start + 11] == "Code_008025:"
+
+
+def test_entries_decode_as_code(z3disasm_path: pathlib.Path, assembled) -> None:
+    lines = disassemble(z3disasm_path, assembled.root)
+    entry = lines.index("Code_008025:")
+    assert lines[entry + 1:entry + 4] == ["REP #$20", "LDA #$1234", "RTS"]
+    entry = lines.index("Code_008037:")
+    assert lines[entry + 1:entry + 3] == ["LDA #$05", "RTS"]
+
+
+def test_unbounded_table_stops_at_code(z3disasm_path: pathlib.Path, assembled) -> None:
+    lines = disassemble(z3disasm_path, assembled.root)
+    start = lines.index("JumpTable_008042:")
+    assert "unbounded index" in lines[start + 1]
+    assert lines[start + 2:start + 5] == ["dw Code_008046", "dw Code_008049", "Code_008046:"]
+    assert lines[start + 5] == "LDY #$00"
+
+
+def test_no_jump_tables_flag(z3disasm_path: pathlib.Path, assembled) -> None:
+    lines = disassemble(z3disasm_path, assembled.root, "--no-jump-tables")
+    assert not any(line.startswith("JumpTable_") for line in lines)
+    assert not any(line.startswith("dw ") for line in lines)
+
+
+def test_lint_flags_entries_outside_rom(assembled) -> None:
+    report = assembled.json("lint.json")
+    messages = [warning["message"] for warning in report["warnings"]]
+    table_warnings = [m for m in messages if m.startswith("Jump table")]
+    assert len(table_warnings) == 1
+    assert "entry 3 points outside ROM ($0000)" in table_warnings[0]
+    # table bytes aren't decoded, so the tables don't trip width warnings
+    assert not any("unknown state" in m for m in messages)
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Tests that cached label references resolve like a fresh lookup."""
+from __future__ import annotations
+
+
+def test_same_site_follows_namespace_and_parent(assemble) -> None:
+    # one macro line resolves under two parents and two namespaces
+    source = "\n".join([
+        "lorom",
+        "org $008000",
+        "macro ref()",
+        "  dw Target",
+        "endmacro",
+        "macro loop_back()",
+        "  BRA .loop",
+        "endmacro",
+        "Target:",
+        "  NOP",
+        "First:",
+        ".loop",
+        "  %loop_back()",
+        "Second:",
+        "  NOP",
+        ".loop",
+        "  %loop_back()",
+        "namespace Inner",
+        "Target:",
+        "  %ref()",
+        "namespace off",
+        "  %ref()",
+        "!i = 0",
+        "while !i < 2",
+        "  dw Second, Second_loop",
+        "  !i #= !i+1",
+        "endwhile",
+    ]) + "\n"
+    result = assemble(source)
+    assert result.returncode == 0, result.stderr
+    assert result.rom[:18] == bytes([
+        0xEA, 0x80, 0xFE,  # First: NOP, BRA First_loop
+        0xEA, 0x80, 0xFE,  # Second: NOP, BRA Second_loop
+        0x06, 0x80,        # Inner_Target
+        0x00, 0x80,        # Target
+        0x03, 0x80, 0x04, 0x80,
+        0x03, 0x80, 0x04, 0x80,
+    ])
+
+
+def test_missing_labels_still_reported(assemble) -> None:
+    source = "\n".join([
+        "lorom",
+        "org $008000",
+        "namespace Inner",
+        "Foo:",
+        "  dw Foo, Missing",
+        "namespace off",
+        "  dw Inner_Foo, .nope",
+    ]) + "\n"
+    result = assemble(source)
+    assert result.returncode != 0
+    assert "main.asm:5: error: (Elabel_not_found): Label 'Missing' wasn't found." in result.stderr
+    assert "main.asm:7: error: (Elabel_not_found): Label 'Foo_nope' wasn't found." in result.stderr
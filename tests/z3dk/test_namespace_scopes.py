@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Tests that pin down how labels and structs resolve across namespaces."""
+from __future__ import annotations
+
+import struct
+
+
+def build(assemble, lines: list[str]):
+    return assemble("\n".join(["lorom", "org $008000", *lines]) + "\n")
+
+
+def words(rom: bytes, offset: int, count: int) -> list[int]:
+    return list(struct.unpack_from(f"<{count}H", rom, offset))
+
+
+def test_namespace_label_shadows_global(assemble) -> None:
+    result = build(assemble, [
+        "Foo: NOP",          # $8000
+        "A_Flat: NOP",       # $8001
+        "namespace A",
+        "Foo: NOP",          # $8002, A_Foo
+        "  dw Foo, Flat, A_Foo",
+        "namespace off",
+        "  dw Foo, A_Foo",
+    ])
+    assert result.returncode == 0, result.stderr
+    # A_Flat defined outside the namespace is still Flat inside it, and a
+    # qualified A_Foo falls back to the global name
+    assert words(result.rom, 3, 3) == [0x8002, 0x8001, 0x8002]
+    assert words(result.rom, 9, 2) == [0x8000, 0x8002]
+
+
+def test_nested_namespace_skips_enclosing_namespace(assemble) -> None:
+    result = build(assemble, [
+        "namespace nested on",
+        "namespace A",
+        "Bar: NOP",
+        "namespace B",
+        "  dw Bar",
+    ])
+    # only the current namespace and the global scope are searched
+    assert result.returncode != 0
+    assert "Label 'Bar' wasn't found" in result.stdout + result.stderr
+
+    result = build(assemble, [
+        "Foo: NOP",          # $8000
+        "namespace nested on",
+        "namespace A",
+        "Bar: NOP",          # $8001, A_Bar
+        "namespace B",
+        "Baz: NOP",          # $8002, A_B_Baz
+        "  dw Baz, Foo, A_Bar",
+        "namespace off",
+        "  dw Bar",
+        "namespace off",
+        "  dw A_B_Baz",
+    ])
+    assert result.returncode == 0, result.stderr
+    assert words(result.rom, 3, 5) == [0x8002, 0x8000, 0x8001, 0x8001, 0x8002]
+
+
+def test_pushns_and_pullns_restore_scope(assemble) -> None:
+    result = build(assemble, [
+        "Foo: NOP",          # $8000
+        "namespace A",
+        "Foo: NOP",          # $8001, A_Foo
+        "pushns",
+        "  dw Foo",
+        "namespace B",
+        "Foo: NOP",          # $8004, B_Foo
+        "  dw Foo",
+        "pullns",
+        "  dw Foo, B_Foo",
+    ])
+    assert result.returncode == 0, result.stderr
+    assert words(result.rom, 2, 1) == [0x8000]
+    assert words(result.rom, 5, 3) == [0x8004, 0x8001, 0x8004]
+
+
+def test_late_namespace_sees_earlier_prefixed_labels(assemble) -> None:
+    # the namespace is first entered after its labels were defined by their
+    # flat names, and a label defined later in it is found too
+    result = build(assemble, [
+        "C_D_Early: NOP",    # $8000
+        "namespace C_D",
+        "  dw Early, Late",
+        "namespace off",
+        "namespace nested on",
+        "namespace C",
+        "namespace D",
+        "  dw Early, Late",
+        "Late: NOP",         # $8009, C_D_Late
+    ])
+    assert result.returncode == 0, result.stderr
+    assert words(result.rom, 1, 4) == [0x8000, 0x8009, 0x8000, 0x8009]
+
+
+def test_structs_are_global_and_members_follow_namespace(assemble) -> None:
+    result = build(assemble, [
+        "struct Obj $7E0000",
+        ".x: skip 2",
+        ".y: skip 1",
+        "endstruct",
+        "struct Sub extends Obj",
+        ".z: skip 4",
+        "endstruct",
+        "namespace N",
+        "struct Local $7F0000",
+        ".a: skip 3",
+        "endstruct align 4",
+        "  dw Local.a, Obj.y, Obj.Sub.z, Obj[2].y",
+        "  dw sizeof(Local), sizeof(Obj), objectsize(Obj), sizeof(Obj.Sub)",
+        "namespace off",
+        "  dw N_Local.a, sizeof(Local)",
+    ])
+    assert result.returncode == 0, result.stderr
+    # the struct's labels get the namespace, its size doesn't, and Obj[2]
+    # steps by the object size that includes Sub
+    assert words(result.rom, 0, 4) == [0x0000, 0x0002, 0x0003, 0x0010]
+    assert words(result.rom, 8, 4) == [0x0004, 0x0003, 0x0007, 0x0004]
+    assert words(result.rom, 16, 2) == [0x0000, 0x0004]
+
+
+def test_struct_redefinition_is_an_error(assemble) -> None:
+    result = build(assemble, [
+        "struct Obj $7E0000",
+        ".x: skip 2",
+        "endstruct",
+        "struct Obj $7E0010",
+        ".y: skip 2",
+        "endstruct",
+    ])
+    assert result.returncode != 0
+    assert "Obj" in result.stdout + result.stderr
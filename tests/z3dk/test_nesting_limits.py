@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Tests for incsrc/macro nesting, which runs on a heap frame stack with configurable limits."""
+from __future__ import annotations
+
+
+def recursive_macro(depth: int) -> dict[str, str]:
+    return {"main.asm": "\n".join([
+        "lorom",
+        "org $008000",
+        f"!depth = {depth}",
+        "macro down()",
+        "  !depth #= !depth-1",
+        "  if !depth > 0",
+        "    %down()",
+        "  endif",
+        "endmacro",
+        "db $01 : %down() : db $02",
+        "",
+    ])}
+
+
+def include_chain(depth: int) -> dict[str, str]:
+    files = {"main.asm": "lorom\norg $008000\nincsrc \"f0.asm\"\ndb $02\n"}
+    for i in range(depth):
+        files[f"f{i}.asm"] = f"incsrc \"f{i + 1}.asm\"\n"
+    files[f"f{depth}.asm"] = "db $01\n"
+    return files
+
+
+def test_macro_runs_before_rest_of_line(assemble) -> None:
+    result = assemble("\n".join([
+        "lorom",
+        "org $008000",
+        "macro inner()",
+        "  db $02",
+        "endmacro",
+        "macro outer()",
+        "  %inner() : db $03",
+        "endmacro",
+        "db $01 : %outer() : db $04",
+        "",
+    ]))
+    assert result.returncode == 0, result.stderr
+    assert result.rom[:4] == b"\x01\x02\x03\x04"
+
+
+def test_macro_depth_default_limit(assemble) -> None:
+    result = assemble(None, files=recursive_macro(600))
+    assert result.returncode != 0
+    assert "Recursion limit reached" in result.stderr
+
+
+def test_macro_depth_raised(assemble) -> None:
+    result = assemble(None, "--max-macro-depth=6000", files=recursive_macro(5000))
+    assert result.returncode == 0, result.stderr
+    assert result.rom[:2] == b"\x01\x02"
+
+
+def test_macro_depth_lowered(assemble) -> None:
+    result = assemble(None, "--max-macro-depth=4", files=recursive_macro(5))
+    assert result.returncode != 0
+    assert "Recursion limit reached" in result.stderr
+    result = assemble(None, "--max-macro-depth=4", files=recursive_macro(4))
+    assert result.returncode == 0, result.stderr
+
+
+def test_include_depth(assemble) -> None:
+    result = assemble(None, files=include_chain(600))
+    assert result.returncode != 0
+    assert "Recursion limit reached" in result.stderr
+
+    result = assemble(None, "--max-include-depth=3000", files=include_chain(2000))
+    assert result.returncode == 0, result.stderr
+    assert result.rom[:2] == b"\x01\x02"
+
+
+def test_limits_from_config(assemble) -> None:
+    files = recursive_macro(3)
+    files["z3dk.toml"] = "max_macro_depth = 2\n"
+    result = assemble(None, files=files)
+    assert result.returncode != 0
+    assert "Recursion limit reached" in result.stderr
+
+
+def test_limit_error_points_at_the_call(assemble) -> None:
+    # the error is reported on the macro call or incsrc that went one level
+    # too deep, not on a line inside it
+    result = assemble(None, "--max-macro-depth=4", files=recursive_macro(10))
+    assert result.returncode != 0
+    assert "main.asm:7: error: (Erecursion_limit): Recursion limit reached." in result.stderr
+    assert "in block: [%down()]" in result.stderr
+
+    result = assemble(None, "--max-include-depth=4", files=include_chain(10))
+    assert result.returncode != 0
+    assert "f2.asm:1: error: (Erecursion_limit): Recursion limit reached." in result.stderr
+    assert "in block: [incsrc \"f3.asm\"]" in result.stderr
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Tests for RATS tag tracking across repeated autoclean/freespace patches."""
+from __future__ import annotations
+
+
+def make_patch(routines: dict[str, int]) -> str:
+    lines = ["lorom", "org $008000"]
+    lines += [f"  autoclean JSL {name}" for name in routines]
+    for name, size in routines.items():
+        lines += ["freecode", f"{name}:", "  RTL", f"  fill ${size:X}"]
+    return "\n".join(lines) + "\n"
+
+
+def apply(assemble, source: str, rom_size: int | None = None, **kwargs) -> bytes:
+    """Patches out.sfc in place; `rom_size` starts a fresh ROM first."""
+    result = assemble(source, rom_size=rom_size, **kwargs)
+    assert result.returncode == 0, result.stderr
+    return result.rom
+
+
+def rats_tags(rom: bytes) -> list[int]:
+    tags = []
+    pos = rom.find(b"STAR")
+    while pos >= 0:
+        if rom[pos + 4] ^ rom[pos + 6] == 0xFF and rom[pos + 5] ^ rom[pos + 7] == 0xFF:
+            tags.append(pos)
+        pos = rom.find(b"STAR", pos + 1)
+    return tags
+
+
+def test_reapplying_a_patch_is_stable(assemble) -> None:
+    source = make_patch({"RoutineA": 0x100, "RoutineB": 0x2000, "RoutineC": 0x40})
+    first = apply(assemble, source, rom_size=0x100000)
+    second = apply(assemble, source)
+    assert first == second
+    assert len(rats_tags(first)) == 3
+
+
+def test_autoclean_reclaims_old_blocks(assemble) -> None:
+    apply(assemble, make_patch({"RoutineA": 0x2000, "RoutineB": 0x2000}), rom_size=0x100000)
+    # a smaller patch over the old one removes both old tags and lands
+    # where the old blocks were, instead of further into the rom
+    rom = apply(assemble, make_patch({"RoutineA": 0x10, "RoutineB": 0x10}))
+    tags = rats_tags(rom)
+    assert len(tags) == 2
+    fresh = apply(assemble, make_patch({"RoutineA": 0x10, "RoutineB": 0x10}), rom_size=0x100000)
+    assert rats_tags(fresh) == tags
+
+
+def test_tag_bytes_in_code_are_not_freespace(assemble) -> None:
+    rom = bytearray(0x100000)
+    # a foreign tag protecting $100 bytes right where freespace would go
+    rom[0x80000:0x80008] = b"STAR" + bytes([0xFF, 0x00, 0x00, 0xFF])
+    out = apply(assemble, make_patch({"RoutineA": 0x10}), files={"out.sfc": bytes(rom)})
+    tags = rats_tags(out)
+    assert 0x80000 in tags
+    ours = [tag for tag in tags if tag != 0x80000]
+    assert len(ours) == 1
+    assert ours[0] >= 0x80000 + 8 + 0x100
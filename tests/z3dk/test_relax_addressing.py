@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Tests for `optimize relax` (addressing relaxation after freespace placement)."""
+from __future__ import annotations
+
+SOURCE = (
+    "lorom\n"
+    "{relax}\n"
+    "org $008000\n"
+    "  JML Code\n"
+    "freecode bank=$10\n"
+    "Code:\n"
+    "  LDA Table,x\n"
+    "  STA Buffer\n"
+    "  LDA.l Table\n"
+    "  JMP Code2\n"
+    "Code2:\n"
+    "  RTL\n"
+    "freedata bank=$10\n"
+    "Table:\n"
+    "  db 1,2,3,4\n"
+    "Buffer:\n"
+    "  db 0\n"
+)
+
+
+def code_bytes(rom: bytes) -> bytes:
+    # the JML operand at $008000 points at Code
+    target = rom[1] | rom[2] << 8 | rom[3] << 16
+    assert (target >> 16) & 0x7F == 0x10
+    pc = ((target & 0x7F0000) >> 1) | (target & 0x7FFF)
+    return rom[pc:pc + 16]
+
+
+def build(assemble, relax: str):
+    result = assemble(SOURCE.format(relax=relax), rom_size=0x100000)
+    assert result.returncode == 0, result.stderr
+    return result
+
+
+def test_relax_shortens_same_bank_freespace_refs(assemble) -> None:
+    plain = build(assemble, "")
+    relaxed = build(assemble, "optimize relax on")
+
+    before = code_bytes(plain.rom)
+    after = code_bytes(relaxed.rom)
+    # LDA long,x / STA long without relaxation
+    assert before[0] == 0xBF and before[4] == 0x8F
+    # LDA abs,x / STA abs once both freespaces are known to share a bank
+    assert after[0] == 0xBD and after[3] == 0x8D
+    # explicit .l is never touched
+    assert after[6] == 0xAF
+
+    assert "Addressing relaxation" not in plain.stdout
+    assert "shortened 2 operands" in relaxed.stdout
+    assert "saved 2 bytes and 2 cycles" in relaxed.stdout
+
+
+def test_relax_off_keeps_default_sizes(assemble) -> None:
+    plain = build(assemble, "")
+    toggled = build(assemble, "optimize relax on\noptimize relax off")
+    assert code_bytes(plain.rom) == code_bytes(toggled.rom)
+    assert "shortened 0 operands" in toggled.stdout
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Tests for headless @assert routine tests (--run-tests / --emit=tests.json)."""
+from __future__ import annotations
+
+PASSING = (
+    "lorom\n"
+    "MODE = $7E0010\n"
+    "COUNTER = $7E0020\n"
+    "org $008000\n"
+    "Increment:\n"
+    "  ; @test MODE=$06 A=$1234 m=16\n"
+    "  SEP #$20\n"
+    "  LDA MODE\n"
+    "  INC\n"
+    "  STA MODE\n"
+    "  ; @assert MODE == $07\n"
+    "  ; @assert A == $1207\n"
+    "  RTL\n"
+    "\n"
+    "SumTable:\n"
+    "  LDX #$00\n"
+    "  LDA #$00\n"
+    "  CLC\n"
+    ".loop\n"
+    "  ADC Table,x\n"
+    "  INX\n"
+    "  CPX #$04\n"
+    "  BNE .loop\n"
+    "  STA COUNTER      ; @assert A == 10\n"
+    "  RTS\n"
+    "  ; @assert COUNTER == 10 && X == 4\n"
+    "\n"
+    "Table:\n"
+    "  db 1,2,3,4\n"
+    "\n"
+    "Multiply:\n"
+    "  ; @test m=16\n"
+    "  SEP #$20\n"
+    "  LDA #$07 : STA $4202\n"
+    "  LDA #$09 : STA $4203\n"
+    "  REP #$20\n"
+    "  LDA $4216\n"
+    "  ; @assert A == 63 && [$004216].w == 63\n"
+    "  RTL\n"
+    "\n"
+    "Decimal:\n"
+    "  ; @test A=$0999 m=16\n"
+    "  SED : CLC : ADC #$0001 : CLD\n"
+    "  ; @assert A == $1000 && (P & 1) == 0\n"
+    "  RTS\n"
+)
+
+FAILING = (
+    "lorom\n"
+    "MODE = $7E0010\n"
+    "org $008000\n"
+    "Broken:\n"
+    "  LDA #$05\n"
+    "  STA MODE\n"
+    "  ; @assert MODE == 6\n"
+    "  RTL\n"
+    "\n"
+    "Spin:\n"
+    "  ; @test\n"
+    "  BRA Spin\n"
+    "\n"
+    "Typo:\n"
+    "  ; @assert NoSuchLabel == 1\n"
+    "  RTL\n"
+)
+
+
+def run_tests(assemble, asm: str, *args: str):
+    result = assemble(asm, "--emit=tests.json", *args, rom_size=0x80000)
+    return result, result.json("tests.json")
+
+
+def test_passing_routines(assemble) -> None:
+    result, report = run_tests(assemble, PASSING)
+    assert result.returncode == 0, result.stdout + result.stderr
+    assert "Routine tests: 4 passed, 0 failed" in result.stdout
+    assert report["passed"] == 4 and report["failed"] == 0
+    by_name = {test["name"]: test for test in report["tests"]}
+    # Table has no annotations, so it isn't a test
+    assert set(by_name) == {"Increment", "SumTable", "Multiply", "Decimal"}
+    for test in report["tests"]:
+        assert test["stop"] == "returned"
+        assert test["asserts_unreached"] == 0
+    assert by_name["SumTable"]["asserts_checked"] == 2
+    assert by_name["SumTable"]["instructions"] == 21
+    assert by_name["Increment"]["address"] == "0x008000"
+
+
+def test_failures_are_reported(assemble) -> None:
+    result, report = run_tests(assemble, FAILING, "--test-max-instructions=500")
+    assert result.returncode == 1
+    by_name = {test["name"]: test for test in report["tests"]}
+
+    broken = by_name["Broken"]
+    assert not broken["passed"]
+    assert broken["failures"][0]["line"] == 7
+    assert "MODE == 6 (left $05, right $06)" in broken["failures"][0]["message"]
+
+    spin = by_name["Spin"]
+    assert spin["stop"] == "instruction_limit"
+    assert spin["instructions"] == 500
+
+    typo = by_name["Typo"]
+    assert typo["stop"] == "setup_error"
+    assert "unknown label 'NoSuchLabel'" in typo["failures"][0]["message"]
+    assert "main.asm:7: error: Broken: assert failed" in result.stderr
+
+
+def test_cycle_limit(assemble) -> None:
+    _, report = run_tests(assemble, FAILING, "--test-max-cycles=100")
+    spin = {test["name"]: test for test in report["tests"]}["Spin"]
+    assert spin["stop"] == "cycle_limit"
+    assert 100 <= spin["cycles"] < 110
+
+
+def test_parallel_runs_match_serial(assemble) -> None:
+    lines = ["lorom", "org $008000"]
+    for i in range(400):
+        lines += [
+            f"R{i}:",
+            f"  ; @test A={i % 200}",
+            "  CLC",
+            "  ADC #$01",
+            f"  ; @assert A == {i % 200 + 1}",
+            "  RTL",
+        ]
+    asm = "\n".join(lines) + "\n"
+    serial_result, serial = run_tests(assemble, asm, "--test-jobs=1")
+    parallel_result, parallel = run_tests(assemble, asm, "--test-jobs=8")
+    assert serial_result.returncode == 0 and parallel_result.returncode == 0
+    assert serial["passed"] == 400
+    assert serial == parallel
@@ -314,6 +314,137 @@ def test_diagnostic_path_included_file():
             client.close()
 
 
+
+def _signature_help(client: LspClient, uri: str, line: int, character: int, request_id: int):
+    client.send({
+        'jsonrpc': '2.0',
+        'id': request_id,
+        'method': 'textDocument/signatureHelp',
+        'params': {
+            'textDocument': {'uri': uri},
+            'position': {'line': line, 'character': character},
+        }
+    })
+    end_time = time.time() + 4.0
+    while time.time() < end_time:
+        message = client.read_message(timeout=0.5)
+        if message and message.get('id') == request_id:
+            return message['result']
+    raise TimeoutError('No signatureHelp response from z3lsp')
+
+
+def test_signature_help_macros_functions_directives():
+    """signatureHelp answers from the assembled macros, user functions and builtin tables."""
+    z3lsp = find_z3lsp()
+    with tempfile.TemporaryDirectory() as tmpdir:
+        root = pathlib.Path(tmpdir)
+        text = (
+            'macro Store(value, addr)\n'
+            '  LDA #<value>\n'
+            '  STA <addr>\n'
+            'endmacro\n'
+            'function twice(x) = x*2\n'
+            'org $008000\n'
+            '  %Store(twice(1), $00)\n'
+            '  db clamp(1, 0, 2), 3, 4\n'
+        )
+        write_file(root / 'Main.asm', text)
+
+        client = LspClient(z3lsp)
+        try:
+            _init_lsp_client(client, root.as_uri())
+            uri = (root / 'Main.asm').as_uri()
+            client.send({
+                'jsonrpc': '2.0',
+                'method': 'textDocument/didOpen',
+                'params': {
+                    'textDocument': {'uri': uri, 'languageId': 'asar', 'version': 1, 'text': text}
+                }
+            })
+            client.wait_for_diagnostics(uri)
+
+            cases = [
+                # (line, character, label, active parameter)
+                (6, 19, 'Store(value, addr)', 1),
+                (6, 15, 'twice(x)', 0),
+                (7, 16, 'clamp(value, min, max)', 2),
+                (7, 23, 'db value, ...', 0),
+            ]
+            for request_id, (line, character, label, active) in enumerate(cases, start=100):
+                result = _signature_help(client, uri, line, character, request_id)
+                assert result['signatures'], f'No signature at {line}:{character}'
+                assert result['signatures'][0]['label'] == label
+                assert result['activeParameter'] == active, (label, result)
+        finally:
+            client.close()
+
+
+
+def _execute_command(client: LspClient, command: str, arguments: list, request_id: int):
+    client.send({
+        'jsonrpc': '2.0',
+        'id': request_id,
+        'method': 'workspace/executeCommand',
+        'params': {'command': command, 'arguments': arguments}
+    })
+    end_time = time.time() + 4.0
+    while time.time() < end_time:
+        message = client.read_message(timeout=0.5)
+        if message and message.get('id') == request_id:
+            return message['result']
+    raise TimeoutError(f'No {command} response from z3lsp')
+
+
+def test_bank_usage_stats_and_raw_blocks():
+    """getBankUsage reports per-bank occupancy, and the raw block list on request."""
+    z3lsp = find_z3lsp()
+    with tempfile.TemporaryDirectory() as tmpdir:
+        root = pathlib.Path(tmpdir)
+        text = (
+            'lorom\n'
+            'org $008000\n'
+            '  db 1, 2, 3, 4\n'
+            'org $008010\n'
+            '  dw 5\n'
+            'org $018000\n'
+            '  db 6\n'
+        )
+        write_file(root / 'Main.asm', text)
+
+        client = LspClient(z3lsp)
+        try:
+            _init_lsp_client(client, root.as_uri())
+            uri = (root / 'Main.asm').as_uri()
+            client.send({
+                'jsonrpc': '2.0',
+                'method': 'textDocument/didOpen',
+                'params': {
+                    'textDocument': {'uri': uri, 'languageId': 'asar', 'version': 1, 'text': text}
+                }
+            })
+            client.wait_for_diagnostics(uri)
+
+            usage = _execute_command(client, 'z3dk.getBankUsage', [], 200)
+            assert usage['bankSize'] == 0x8000
+            banks = {bank['bank']: bank for bank in usage['banks']}
+            assert sorted(banks) == [0, 1]
+            # the header checksum at $7FDC is written too
+            assert banks[0]['used'] == 4 + 2 + 4
+            assert banks[0]['freeRuns'] == 3
+            assert banks[0]['largestFree'] == 0x7FDC - 0x12
+            assert banks[1]['used'] == 1
+            assert 'blocks' not in banks[0]
+
+            detailed = _execute_command(client, 'z3dk.getBankUsage', [{'blocks': True}], 201)
+            assert [b['pc'] for b in detailed['banks'][0]['blocks']] == [0x0000, 0x0010, 0x7FDC]
+
+            raw = _execute_command(client, 'z3dk.getBankUsage', [{'format': 'blocks'}], 202)
+            assert [(b['pc'], b['snes'] & 0x7FFFFF, b['size']) for b in raw] == [
+                (0x0000, 0x008000, 4), (0x0010, 0x008010, 2), (0x7FDC, 0x00FFDC, 4),
+                (0x8000, 0x018000, 1)]
+        finally:
+            client.close()
+
 if __name__ == '__main__':
     try:
         run()
@@ -0,0 +1,75 @@
+// Create a simple test runner since we don't have GTest
+#include <cstdlib>
+#include <iostream>
+#include "address-map.h"
+#include "cpu65816.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+constexpr mapper_t kMappers[] = {invalid_mapper, lorom, hirom, sa1rom, bigsa1rom,
+                                 sfxrom, exlorom, exhirom, norom};
+
+// Every SNES address and every ROM offset up to 16 MiB (plus a stretch past
+// it) translates exactly like the branchy reference functions.
+void CheckMapper(mapper_t mapper, const int sa1banks[8]) {
+    address_map map;
+    build_address_map(map, mapper, sa1banks);
+    for (int addr = -2; addr <= 0x1000001; ++addr) {
+        if (map.snestopc(addr) != snestopc_slow(addr, mapper, sa1banks)) {
+            std::cerr << "mapper " << mapper << " snes " << std::hex << addr << std::endl;
+        }
+        ASSERT_EQ(map.snestopc(addr), snestopc_slow(addr, mapper, sa1banks));
+    }
+    for (int pc = -2; pc < 0x1000000 + 0x100000; ++pc) {
+        if (map.pctosnes(pc) != pctosnes_slow(pc, mapper, sa1banks)) {
+            std::cerr << "mapper " << mapper << " pc " << std::hex << pc << std::endl;
+        }
+        ASSERT_EQ(map.pctosnes(pc), pctosnes_slow(pc, mapper, sa1banks));
+    }
+    for (int pc : {0x7FFFFFF, 0x7FFFFFFF}) {
+        ASSERT_EQ(map.pctosnes(pc), pctosnes_slow(pc, mapper, sa1banks));
+    }
+}
+
+void TestAllMappersMatchReference() {
+    const int default_banks[8] = {0 << 20, 1 << 20, -1, -1, 2 << 20, 3 << 20, -1, -1};
+    for (mapper_t mapper : kMappers) {
+        CheckMapper(mapper, default_banks);
+    }
+    // remapped and aliased SA-1 banks ("sa1rom 7,3,3,0")
+    const int custom_banks[8] = {7 << 20, 3 << 20, -1, -1, 3 << 20, 0 << 20, -1, -1};
+    CheckMapper(sa1rom, custom_banks);
+}
+
+void TestCoreSharesTables() {
+    ASSERT_EQ(z3dk::SnesToRomOffset(0x008000, z3dk::RomMapper::kLoRom), 0);
+    ASSERT_EQ(z3dk::SnesToRomOffset(0x7E0000, z3dk::RomMapper::kLoRom), -1);
+    ASSERT_EQ(z3dk::SnesToRomOffset(0xC01234, z3dk::RomMapper::kHiRom), 0x1234);
+    ASSERT_EQ(z3dk::SnesToRomOffset(0x1000000, z3dk::RomMapper::kNoRom), -1);
+    ASSERT_EQ(z3dk::RomOffsetToSnes(0x8000, z3dk::RomMapper::kLoRom), 0x818000);
+    ASSERT_EQ(z3dk::RomOffsetToSnes(0x400000, z3dk::RomMapper::kLoRom), -1);
+    ASSERT_EQ(z3dk::SnesToRomOffset(0x008000, z3dk::RomMapper::kInvalid), -1);
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3dk address map tests..." << std::endl;
+    TestAllMappersMatchReference();
+    TestCoreSharesTables();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
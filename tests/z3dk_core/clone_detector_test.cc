@@ -0,0 +1,135 @@
+// Create a simple test runner since we don't have GTest
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "assembler.h"
+#include "clone_detector.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+constexpr const char* kPatchPath = "/virtual/clones.asm";
+
+// Same body in two banks, each using a helper and table in its own bank.
+std::string RoutineBody(const std::string& helper, const std::string& table) {
+    return "  PHB : PHK : PLB\n"
+           "  LDA $10 : ASL : TAX\n"
+           "  LDA " + table + ",X : STA $00\n"
+           "  JSR " + helper + "\n"
+           "  LDA #$05 : STA $2100\n"
+           "  PLB\n"
+           "  RTL\n";
+}
+
+z3dk::AssembleResult Assemble(const std::string& source) {
+    z3dk::AssembleOptions options;
+    options.patch_path = kPatchPath;
+    options.rom_data.assign(0x20000, 0);
+    options.memory_files.push_back({options.patch_path, source});
+    return z3dk::Assembler().Assemble(options);
+}
+
+void TestRoutinesAcrossBanks() {
+    std::string source = "lorom\n"
+                         "org $008000\n"
+                         "First:\n" + RoutineBody("Helper", "Table") +
+                         "Helper: RTS\n"
+                         "Table: dw $0000\n"
+                         "org $018000\n"
+                         "  NOP\n"
+                         "Second:\n" + RoutineBody("Helper2", "Table2") +
+                         "Helper2: RTS\n"
+                         "Table2: dw $0000\n";
+    z3dk::AssembleResult result = Assemble(source);
+    ASSERT_TRUE(result.success);
+
+    z3dk::CloneReport report = z3dk::FindClones(result);
+    ASSERT_EQ(report.groups.size(), 1u);
+    const z3dk::CloneGroup& group = report.groups[0];
+    ASSERT_TRUE(group.kind == z3dk::CloneKind::kRoutine);
+    // the JSR and table operands point into different banks
+    ASSERT_TRUE(!group.exact);
+    ASSERT_EQ(group.instructions, 13);
+    ASSERT_EQ(group.bytes, 22);
+    ASSERT_EQ(group.bytes_saved, 22);
+    ASSERT_EQ(group.sites.size(), 2u);
+    ASSERT_EQ(group.sites[0].address, 0x008000u);
+    ASSERT_EQ(group.sites[0].filename, kPatchPath);
+    ASSERT_EQ(group.sites[0].line, 4);
+    ASSERT_EQ(group.sites[1].address, 0x018001u);
+    ASSERT_EQ(report.bytes_saved, 22);
+
+    std::string json = z3dk::ClonesToJson(report);
+    ASSERT_TRUE(json.find("\"kind\":\"routine\"") != std::string::npos);
+    ASSERT_TRUE(json.find("\"address\":\"0x018001\"") != std::string::npos);
+}
+
+void TestTailsAndFragments() {
+    // the same exit in two routines, and a run of stores without an exit
+    std::string stores = "  LDA #$01 : STA $10 : LDA #$02 : STA $11\n"
+                         "  LDA #$03 : STA $12 : LDA #$04 : STA $13\n";
+    std::string exit = "  PHD : PHB : LDA #$80 : STA $2100 : STZ $420C\n"
+                       "  STZ $420B : SEP #$30 : PLB : PLD : RTL\n";
+    std::string source = "lorom\n"
+                         "org $008000\n"
+                         "Up: INX\n" + exit +
+                         "Down: INY\n" + exit +
+                         "Stores:\n" + stores + "  INX\n" + stores + "  RTS\n";
+    z3dk::AssembleResult result = Assemble(source);
+    ASSERT_TRUE(result.success);
+
+    z3dk::CloneReport report = z3dk::FindClones(result);
+    ASSERT_EQ(report.groups.size(), 2u);
+    // 16 byte fragment: (2 copies - 1) * 16 - RTS - 2 JSRs
+    const z3dk::CloneGroup& fragment = report.groups[1];
+    ASSERT_TRUE(fragment.kind == z3dk::CloneKind::kFragment);
+    ASSERT_TRUE(fragment.exact);
+    ASSERT_EQ(fragment.bytes, 16);
+    ASSERT_EQ(fragment.bytes_saved, 9);
+    // 18 byte tail: the second copy becomes a JMP
+    const z3dk::CloneGroup& tail = report.groups[0];
+    ASSERT_TRUE(tail.kind == z3dk::CloneKind::kTail);
+    ASSERT_EQ(tail.bytes, 18);
+    ASSERT_EQ(tail.bytes_saved, 15);
+    ASSERT_EQ(tail.sites[0].address, 0x008001u);
+    ASSERT_EQ(tail.sites[1].address, 0x008014u);
+
+    // raising the floor drops both
+    z3dk::CloneOptions options;
+    options.min_bytes = 19;
+    ASSERT_TRUE(z3dk::FindClones(result, options).groups.empty());
+}
+
+void TestFillIsNotCode() {
+    std::string source = "lorom\norg $008000\n";
+    for (int i = 0; i < 64; ++i) {
+        source += "  NOP\n";
+    }
+    source += "  RTS\n";
+    z3dk::AssembleResult result = Assemble(source);
+    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(z3dk::FindClones(result).groups.empty());
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3dk clone detector tests..." << std::endl;
+    TestRoutinesAcrossBanks();
+    TestTailsAndFragments();
+    TestFillIsNotCode();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Create a simple test runner since we don't have GTest
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "assembler.h"
+#include "opcode_table.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+using z3dk::AddrMode;
+
+// Canonical Asar syntax for an addressing mode. Width modifiers pin the
+// operand size so the assembler can't pick a shorter form.
+std::string Instruction(const z3dk::OpcodeInfo& info) {
+    std::string mn = info.mnemonic;
+    switch (info.mode) {
+        case AddrMode::kImplied: return mn;
+        case AddrMode::kImmediate8: return mn + " #$12";
+        case AddrMode::kImmediate16: return mn + ".w #$1234";
+        case AddrMode::kImmediateM:
+        case AddrMode::kImmediateX: return mn + ".b #$12";
+        case AddrMode::kRelative8: return mn + " $00";
+        case AddrMode::kRelative16: return mn + " $0000";
+        case AddrMode::kDirectPage: return mn + ".b $12";
+        case AddrMode::kDirectPageX: return mn + ".b $12,x";
+        case AddrMode::kDirectPageY: return mn + ".b $12,y";
+        case AddrMode::kDirectPageIndirect: return mn + ".b ($12)";
+        case AddrMode::kDirectPageIndexedIndirect: return mn + ".b ($12,x)";
+        case AddrMode::kDirectPageIndirectIndexedY: return mn + ".b ($12),y";
+        case AddrMode::kDirectPageIndirectLong: return mn + ".b [$12]";
+        case AddrMode::kDirectPageIndirectLongY: return mn + ".b [$12],y";
+        case AddrMode::kStackRelative: return mn + " $12,s";
+        case AddrMode::kStackRelativeIndirectY: return mn + " ($12,s),y";
+        case AddrMode::kAbsolute: return mn + ".w $1234";
+        case AddrMode::kAbsoluteX: return mn + ".w $1234,x";
+        case AddrMode::kAbsoluteY: return mn + ".w $1234,y";
+        case AddrMode::kAbsoluteLong: return mn + ".l $123456";
+        case AddrMode::kAbsoluteLongX: return mn + ".l $123456,x";
+        case AddrMode::kAbsoluteIndirect: return mn + ".w ($1234)";
+        case AddrMode::kAbsoluteIndexedIndirect: return mn + ".w ($1234,x)";
+        case AddrMode::kAbsoluteIndirectLong: return mn + ".w [$1234]";
+        case AddrMode::kBlockMove: return mn + " $12,$34";
+    }
+    return mn;
+}
+
+z3dk::AssembleResult AssembleLines(const std::string& lines) {
+    z3dk::AssembleOptions options;
+    options.patch_path = "/virtual/opcodes.asm";
+    options.rom_data.assign(0x8000, 0);
+    options.memory_files.push_back({options.patch_path, "lorom\norg $008000\n" + lines});
+    return z3dk::Assembler().Assemble(options);
+}
+
+// Every opcode, written the way the decoder names it, assembles back to the
+// same opcode with the operand size the decoder expects.
+void TestAllOpcodesRoundTrip() {
+    std::string source;
+    for (int op = 0; op < 256; ++op) {
+        source += Instruction(z3dk::GetOpcodeInfo(static_cast<uint8_t>(op))) + "\n";
+    }
+    z3dk::AssembleResult result = AssembleLines(source);
+    for (const auto& diag : result.diagnostics) {
+        std::cerr << diag.line << ": " << diag.message << std::endl;
+    }
+    ASSERT_TRUE(result.success);
+
+    size_t pc = 0;
+    for (int op = 0; op < 256; ++op) {
+        const z3dk::OpcodeInfo& info = z3dk::GetOpcodeInfo(static_cast<uint8_t>(op));
+        ASSERT_TRUE(pc < result.rom_data.size());
+        if (result.rom_data[pc] != op) {
+            std::cerr << Instruction(info) << " assembled to opcode "
+                      << static_cast<int>(result.rom_data[pc]) << std::endl;
+        }
+        ASSERT_EQ(static_cast<int>(result.rom_data[pc]), op);
+        pc += 1 + z3dk::OperandSizeBytes(info.mode, 1, 1);
+    }
+}
+
+void TestJmpLongIndirectAlias() {
+    z3dk::AssembleResult result = AssembleLines("JMP [$1234]\n");
+    ASSERT_TRUE(result.success);
+    ASSERT_EQ(static_cast<int>(result.rom_data[0]), 0xDC);
+}
+
+// Modes the table has no opcode for are rejected instead of borrowing a
+// neighbouring encoding.
+void TestMissingModesAreErrors() {
+    ASSERT_TRUE(!AssembleLines("STA #$12\n").success);
+    ASSERT_TRUE(!AssembleLines("STX.w $1234,y\n").success);
+    ASSERT_TRUE(!AssembleLines("STY.w $1234,x\n").success);
+    ASSERT_TRUE(!AssembleLines("LDA.l $123456,y\n").success);
+}
+
+// A width the operand kind has no encoding for at all is one clean error
+// from the final pass; the earlier passes size it as the only width there is.
+void TestImpossibleWidthIsOneError() {
+    for (const char* line : {"LDA.w ($12),y\n", "LDA.w [$12]\n", "LDA.l ($12,s),y\n"}) {
+        z3dk::AssembleResult result = AssembleLines(std::string(line) + "NOP\n");
+        ASSERT_TRUE(!result.success);
+        int errors = 0;
+        for (const auto& diag : result.diagnostics) {
+            if (diag.severity == z3dk::DiagnosticSeverity::kError) {
+                ++errors;
+                ASSERT_TRUE(diag.message.find("can accept only 8-bit arguments") != std::string::npos);
+                ASSERT_EQ(diag.line, 2);  // zero-based, like asar reports it
+            }
+        }
+        ASSERT_EQ(errors, 1);
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3dk opcode round-trip tests..." << std::endl;
+    TestAllOpcodesRoundTrip();
+    TestJmpLongIndirectAlias();
+    TestMissingModesAreErrors();
+    TestImpossibleWidthIsOneError();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
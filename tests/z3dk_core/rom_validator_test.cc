@@ -0,0 +1,193 @@
+// Create a simple test runner since we don't have GTest
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "assembler.h"
+#include "rom_validator.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+constexpr const char* kPatchPath = "/virtual/tables.asm";
+
+// Line numbers below are what the diagnostics should point at.
+constexpr const char* kSource =
+    "lorom\n"                                       // 1
+    "org $008000\n"                                 // 2
+    "  dl Headers\n"                                // 3
+    "org $018000\n"                                 // 4
+    "Headers:\n"                                    // 5
+    "  dw Room0, Room1\n"                           // 6
+    "Room0: db $00, $01, $00\n"                     // 7
+    "Room1: db $00, $C1, $03\n"                     // 8
+    "Objects:\n"                                    // 9
+    "  dw Obj0, Obj1\n"                             // 10
+    "  dl $7E2000\n"                                // 11
+    "Obj0: db $11, $22, $33, $FF, $FF, $F0, $FF\n"  // 12
+    "  db $44, $55, $FF, $FF\n"                     // 13
+    "Obj1: db $11, $22, $33, $FF, $FF\n"            // 14
+    "  db $44, $55, $66, $77, $88, $99\n"           // 15
+    "Tiles:\n"                                      // 16
+    "  db $01, $02, $03, $04\n"                     // 17
+    "  db $FF, $FF, $FF, $FF\n"                     // 18
+    "  db $00, $00, $00, $01\n";                    // 19
+
+z3dk::AssembleResult AssembleTables() {
+    z3dk::AssembleOptions options;
+    options.patch_path = kPatchPath;
+    options.rom_data.assign(0x10000, 0);
+    options.memory_files.push_back({options.patch_path, kSource});
+    return z3dk::Assembler().Assemble(options);
+}
+
+constexpr const char* kSchema = R"({
+  "tables": [
+    {"name": "headers", "pointer": "$008000", "count": 2, "entry_pointer": 2,
+     "bank": 1, "record_size": 3,
+     "fields": [{"offset": 1, "mask": "0xC0", "message": "palette high bits"}]},
+    {"name": "objects", "address": "$01800A", "count": 2, "entry_pointer": 2,
+     "bank": "$01",
+     "stream": {"element_size": 3, "terminator": ["$FF", "$FF"], "terminators": 2,
+                "markers": [{"bytes": ["$F0", "$FF"], "element_size": 2}],
+                "max_bytes": 16}},
+    {"name": "far", "address": "$01800E", "count": 1, "entry_pointer": 3,
+     "min_bank": 0, "max_bank": "$3F"},
+    {"name": "tiles", "address": "$018027", "size": 12, "stride": 4,
+     "warn_blank": true},
+    {"name": "padding", "address": "$018033", "size": "0x400", "stride": 4,
+     "warn_blank": true}
+  ]
+})";
+
+void TestParseErrors() {
+    z3dk::RomSchema schema;
+    std::string error;
+    ASSERT_TRUE(!z3dk::ParseRomSchema("{", &schema, &error));
+    ASSERT_TRUE(!z3dk::ParseRomSchema(R"({"tables": [{"name": "t", "adress": 1}]})",
+                                      &schema, &error));
+    ASSERT_EQ(error, "t: unknown key 'adress'");
+    ASSERT_TRUE(!z3dk::ParseRomSchema(
+        R"({"tables": [{"name": "t", "address": 1, "pointer": 2}]})", &schema, &error));
+    ASSERT_TRUE(!z3dk::ParseRomSchema(
+        R"({"tables": [{"name": "t", "address": 1, "entry_pointer": 2}]})", &schema,
+        &error));
+    ASSERT_TRUE(!z3dk::ParseRomSchema(
+        R"({"tables": [{"name": "t", "address": "$12G"}]})", &schema, &error));
+
+    ASSERT_TRUE(z3dk::ParseRomSchema(kSchema, &schema, &error));
+    ASSERT_EQ(schema.tables.size(), 5u);
+    ASSERT_TRUE(schema.tables[0].indirect);
+    ASSERT_EQ(schema.tables[0].stride, 2);
+    ASSERT_EQ(schema.tables[0].fields[0].mask, 0xC0);
+    ASSERT_EQ(schema.tables[3].count, 3);
+    ASSERT_EQ(schema.tables[4].count, 0x100);
+    ASSERT_EQ(schema.tables[1].stream->markers[0].element_size, 2);
+}
+
+void TestValidate() {
+    z3dk::AssembleResult result = AssembleTables();
+    ASSERT_TRUE(result.success);
+    z3dk::RomSchema schema;
+    std::string error;
+    ASSERT_TRUE(z3dk::ParseRomSchema(kSchema, &schema, &error));
+
+    std::vector<z3dk::Diagnostic> diagnostics = z3dk::ValidateRom(result, schema);
+    ASSERT_EQ(diagnostics.size(), 5u);
+
+    ASSERT_EQ(diagnostics[0].message, "headers[001]: palette high bits ($C1)");
+    ASSERT_TRUE(diagnostics[0].severity == z3dk::DiagnosticSeverity::kWarning);
+    ASSERT_EQ(diagnostics[0].filename, kPatchPath);
+    ASSERT_EQ(diagnostics[0].line, 8);
+
+    // Obj0 switches to 2 byte elements after $F0FF and ends on its second
+    // terminator; Obj1 runs into max_bytes first
+    ASSERT_EQ(diagnostics[1].message,
+              "objects[001]: no terminator within 16 bytes (1 of 2 found)");
+    ASSERT_EQ(diagnostics[1].line, 14);
+
+    ASSERT_EQ(diagnostics[2].message, "far[000]: points to $7E2000, outside banks $00-$3F");
+    ASSERT_TRUE(diagnostics[2].severity == z3dk::DiagnosticSeverity::kError);
+    ASSERT_EQ(diagnostics[2].line, 11);
+
+    ASSERT_EQ(diagnostics[3].message, "tiles: 1 blank entries (001)");
+    ASSERT_EQ(diagnostics[3].line, 17);
+
+    // nothing assembled the padding, so there's no line to point at
+    ASSERT_EQ(diagnostics[4].message,
+              "padding: 256 blank entries (000, 001, 002, 003, 004, 005, 006, 007, "
+              "008, 009, ...)");
+    ASSERT_TRUE(diagnostics[4].filename.empty());
+}
+
+void TestOrderDoesNotDependOnJobs() {
+    z3dk::AssembleResult result = AssembleTables();
+    z3dk::RomSchema schema;
+    std::string error;
+    ASSERT_TRUE(z3dk::ParseRomSchema(kSchema, &schema, &error));
+    // every entry of a long table gets a finding, across many chunks
+    z3dk::RomTableSchema words;
+    words.name = "words";
+    words.address = 0x018100;
+    words.count = 1000;
+    words.stride = 2;
+    words.entry_pointer = 2;
+    words.bank = 0x7E;
+    words.max_bank = 0x3F;
+    schema.tables.push_back(words);
+
+    z3dk::RomValidateOptions serial;
+    serial.jobs = 1;
+    z3dk::RomValidateOptions parallel;
+    parallel.jobs = 8;
+    std::vector<z3dk::Diagnostic> expected = z3dk::ValidateRom(result, schema, serial);
+    ASSERT_EQ(expected.size(), 1005u);
+    ASSERT_EQ(expected[1004].message, "words[3E7]: points to $7E0000, outside banks $00-$3F");
+    for (int run = 0; run < 4; ++run) {
+        std::vector<z3dk::Diagnostic> actual = z3dk::ValidateRom(result, schema, parallel);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            ASSERT_EQ(actual[i].message, expected[i].message);
+            ASSERT_EQ(actual[i].line, expected[i].line);
+        }
+    }
+}
+
+void TestBadTableAddress() {
+    z3dk::AssembleResult result = AssembleTables();
+    z3dk::RomSchema schema;
+    std::string error;
+    ASSERT_TRUE(z3dk::ParseRomSchema(
+        R"({"tables": [{"name": "wram", "address": "$7E0000", "count": 1},
+                       {"name": "long", "address": "$01FFF0", "count": 8, "stride": 4}]})",
+        &schema, &error));
+    std::vector<z3dk::Diagnostic> diagnostics = z3dk::ValidateRom(result, schema);
+    ASSERT_EQ(diagnostics.size(), 2u);
+    ASSERT_EQ(diagnostics[0].message, "wram: table address $7E0000 is not in the ROM");
+    ASSERT_EQ(diagnostics[1].message,
+              "long: table runs past the end of the ROM (8 entries of 4 bytes)");
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3dk ROM validator tests..." << std::endl;
+    TestParseErrors();
+    TestValidate();
+    TestOrderDoesNotDependOnJobs();
+    TestBadTableAddress();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
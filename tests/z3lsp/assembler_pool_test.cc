@@ -0,0 +1,196 @@
+// Create a simple test runner since we don't have GTest
+#include <signal.h>
+#include <unistd.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "assembler_pool.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+std::string g_self;
+
+z3dk::AssembleOptions MakeOptions(const std::string& name, int value) {
+    z3dk::AssembleOptions options;
+    options.patch_path = "/virtual/" + name + ".asm";
+    options.rom_data.assign(0x8000, 0);
+    options.memory_files.push_back(
+        {options.patch_path,
+         "lorom\norg $008000\n" + name + ":\n  LDA #$" + std::to_string(value) + "\n  RTS\n"});
+    return options;
+}
+
+const z3dk::Label* FindLabel(const z3dk::AssembleResult& result, const std::string& name) {
+    for (const auto& label : result.labels) {
+        if (label.name == name) {
+            return &label;
+        }
+    }
+    return nullptr;
+}
+
+void TestCodecRoundTrip() {
+    z3dk::AssembleOptions options = MakeOptions("Codec", 12);
+    options.include_paths = {"a", "b"};
+    options.defines = {{"x", "1"}, {"y", ""}};
+    options.inject_snes_registers = true;
+
+    std::vector<uint8_t> buffer(0x10000);
+    for (uint8_t* rom : {buffer.data(), static_cast<uint8_t*>(nullptr)}) {
+        std::string encoded = z3lsp::EncodeAssembleOptions(options, rom, buffer.size());
+        z3dk::AssembleOptions decoded;
+        ASSERT_TRUE(z3lsp::DecodeAssembleOptions(encoded, rom, buffer.size(), &decoded));
+        ASSERT_EQ(decoded.patch_path, options.patch_path);
+        ASSERT_TRUE(decoded.rom_data == options.rom_data);
+        ASSERT_TRUE(decoded.include_paths == options.include_paths);
+        ASSERT_TRUE(decoded.defines == options.defines);
+        ASSERT_EQ(decoded.memory_files.size(), 1u);
+        ASSERT_EQ(decoded.memory_files[0].contents, options.memory_files[0].contents);
+        ASSERT_TRUE(decoded.inject_snes_registers);
+        ASSERT_TRUE(decoded.generate_checksum);
+
+        // truncated frames are rejected, not misread
+        z3dk::AssembleOptions truncated;
+        ASSERT_TRUE(!z3lsp::DecodeAssembleOptions(
+            std::string_view(encoded).substr(0, encoded.size() - 1), rom, buffer.size(),
+            &truncated));
+    }
+}
+
+void TestPoolMatchesInProcess() {
+    z3dk::AssembleOptions options = MakeOptions("Direct", 34);
+    options.memory_files[0].contents +=
+        "macro Store(value, addr)\n  LDA #<value>\n  STA <addr>\nendmacro\n"
+        "function twice(x) = x*2\n";
+    z3dk::AssembleResult expected = z3dk::Assembler().Assemble(options);
+
+    z3lsp::AssemblerPool pool;
+    z3lsp::AssemblerPoolOptions pool_options;
+    pool_options.workers = 1;
+    pool_options.worker_path = g_self;
+    std::string error;
+    ASSERT_TRUE(pool.Start(pool_options, &error));
+    z3dk::AssembleResult actual = pool.Assemble(options);
+
+    ASSERT_EQ(actual.success, expected.success);
+    ASSERT_EQ(actual.labels.size(), expected.labels.size());
+    ASSERT_TRUE(actual.rom_data == expected.rom_data);
+    ASSERT_EQ(actual.written_blocks.size(), expected.written_blocks.size());
+    ASSERT_EQ(actual.source_map.entries.size(), expected.source_map.entries.size());
+    ASSERT_EQ(actual.wla_symbols, expected.wla_symbols);
+    ASSERT_EQ(actual.macros.size(), 1u);
+    ASSERT_EQ(actual.macros[0].name, expected.macros[0].name);
+    ASSERT_TRUE(actual.macros[0].parameters == expected.macros[0].parameters);
+    ASSERT_EQ(actual.macros[0].line, expected.macros[0].line);
+    ASSERT_EQ(actual.functions.size(), expected.functions.size());
+}
+
+void TestConcurrentJobs() {
+    z3lsp::AssemblerPool pool;
+    z3lsp::AssemblerPoolOptions pool_options;
+    pool_options.workers = 3;
+    pool_options.worker_path = g_self;
+    std::string error;
+    ASSERT_TRUE(pool.Start(pool_options, &error));
+
+    std::vector<z3dk::AssembleResult> results(6);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i] {
+            results[i] = pool.Assemble(MakeOptions("Job" + std::to_string(i), 10 + static_cast<int>(i)));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        ASSERT_TRUE(results[i].success);
+        const z3dk::Label* label = FindLabel(results[i], "Job" + std::to_string(i));
+        ASSERT_TRUE(label != nullptr);
+        ASSERT_EQ(label->address, 0x008000u);
+        // each job saw its own source: LDA #$1i
+        ASSERT_EQ(results[i].rom_data[1], 0x10 + i);
+    }
+    ASSERT_EQ(pool.restarts(), 0);
+}
+
+void TestCrashedWorkerIsReplaced() {
+    z3lsp::AssemblerPool pool;
+    z3lsp::AssemblerPoolOptions pool_options;
+    pool_options.workers = 1;
+    pool_options.worker_path = g_self;
+    std::string error;
+    ASSERT_TRUE(pool.Start(pool_options, &error));
+    ASSERT_TRUE(pool.Assemble(MakeOptions("Before", 1)).success);
+
+    int pid = pool.worker_pids()[0];
+    ASSERT_TRUE(pid > 0);
+    kill(pid, SIGKILL);
+    usleep(20000);
+
+    z3dk::AssembleResult result = pool.Assemble(MakeOptions("After", 2));
+    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(FindLabel(result, "After") != nullptr);
+    ASSERT_EQ(pool.restarts(), 1);
+    ASSERT_TRUE(pool.worker_pids()[0] != pid);
+}
+
+void TestHungWorkerTimesOut() {
+    z3lsp::AssemblerPool pool;
+    z3lsp::AssemblerPoolOptions pool_options;
+    pool_options.workers = 1;
+    pool_options.worker_path = g_self;
+    pool_options.timeout = std::chrono::milliseconds(300);
+    std::string error;
+    ASSERT_TRUE(pool.Start(pool_options, &error));
+
+    // a stopped worker never answers
+    int pid = pool.worker_pids()[0];
+    kill(pid, SIGSTOP);
+    z3dk::AssembleResult result = pool.Assemble(MakeOptions("Hung", 3));
+    // the retry runs on a fresh worker
+    ASSERT_TRUE(result.success);
+    ASSERT_EQ(pool.restarts(), 1);
+}
+
+void TestStoppedPoolAssemblesInProcess() {
+    z3lsp::AssemblerPool pool;
+    ASSERT_TRUE(!pool.running());
+    z3dk::AssembleResult result = pool.Assemble(MakeOptions("Local", 5));
+    ASSERT_TRUE(result.success);
+    ASSERT_TRUE(FindLabel(result, "Local") != nullptr);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--assembler-worker") {
+        return z3lsp::RunAssemblerWorker();
+    }
+    g_self = z3lsp::CurrentExecutablePath(argv[0]);
+
+    std::cout << "Running z3lsp assembler pool tests..." << std::endl;
+    TestCodecRoundTrip();
+    TestPoolMatchesInProcess();
+    TestConcurrentJobs();
+    TestCrashedWorkerIsReplaced();
+    TestHungWorkerTimesOut();
+    TestStoppedPoolAssemblesInProcess();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Create a simple test runner since we don't have GTest
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bank_usage.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+z3dk::WrittenBlock Block(int pc, int size) {
+    z3dk::WrittenBlock block;
+    block.pc_offset = pc;
+    block.snes_offset = 0x808000 + (pc / 0x8000) * 0x10000 + pc % 0x8000;
+    block.num_bytes = size;
+    return block;
+}
+
+void TestStats() {
+    z3lsp::BankUsage usage;
+    ASSERT_TRUE(usage.Bank(0) == nullptr);
+
+    // overlapping blocks count once, and the gaps are the free runs
+    usage.Update("a", {Block(0x0000, 0x100), Block(0x0080, 0x100), Block(0x1000, 0x10)});
+    const z3lsp::BankStats* bank = usage.Bank(0);
+    ASSERT_TRUE(bank != nullptr);
+    ASSERT_EQ(bank->used, 0x190);
+    ASSERT_EQ(bank->blocks, 3);
+    ASSERT_EQ(bank->free_runs, 2);
+    ASSERT_EQ(bank->largest_free, 0x8000 - 0x1010);
+
+    // a block across the end of a bank counts in both
+    usage.Update("b", {Block(0xFFF0, 0x20)});
+    ASSERT_EQ(usage.Bank(1)->used, 0x10);
+    ASSERT_EQ(usage.Bank(1)->largest_free, 0x7FF0);
+    ASSERT_EQ(usage.Bank(2)->used, 0x10);
+    ASSERT_EQ(usage.Bank(2)->free_runs, 1);
+    ASSERT_EQ(usage.Banks().size(), 3u);
+    ASSERT_EQ(usage.Blocks().size(), 4u);
+    ASSERT_EQ(usage.Blocks(2).size(), 1u);
+
+    // a full bank has nothing free
+    usage.Update("c", {Block(0x18000, 0x8000)});
+    ASSERT_EQ(usage.Bank(3)->used, 0x8000);
+    ASSERT_EQ(usage.Bank(3)->free_runs, 0);
+    ASSERT_EQ(usage.Bank(3)->largest_free, 0);
+}
+
+void TestDocumentsShareBlocks() {
+    z3lsp::BankUsage usage;
+    // two documents assembled from the same main write the same blocks
+    std::vector<z3dk::WrittenBlock> blocks = {Block(0x0000, 0x40), Block(0x0100, 0x40)};
+    usage.Update("main", blocks);
+    usage.Update("include", blocks);
+    ASSERT_EQ(usage.Bank(0)->used, 0x80);
+    ASSERT_EQ(usage.Blocks().size(), 2u);
+
+    usage.Remove("main");
+    ASSERT_EQ(usage.Bank(0)->used, 0x80);
+
+    // only the delta changes
+    usage.Update("include", {Block(0x0000, 0x40), Block(0x0200, 0x80)});
+    ASSERT_EQ(usage.Bank(0)->used, 0xC0);
+    ASSERT_EQ(usage.Bank(0)->free_runs, 2);
+    ASSERT_EQ(usage.Bank(0)->largest_free, 0x8000 - 0x280);
+
+    usage.Update("include", {});
+    ASSERT_TRUE(usage.Bank(0) == nullptr);
+    ASSERT_TRUE(usage.Banks().empty());
+    usage.Remove("missing");
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3lsp bank usage tests..." << std::endl;
+    TestStats();
+    TestDocumentsShareBlocks();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,238 @@
+// Create a simple test runner since we don't have GTest
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mesen_client.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+namespace {
+
+// Stands in for the Mesen2 socket: answers each command line with a
+// success reply (or a failure for WRITEBLOCKs once `fail_writes` is set)
+// and records what it was sent.
+class FakeMesen {
+ public:
+    explicit FakeMesen(const std::string& path) : path_(path) {
+        unlink(path_.c_str());
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+        ASSERT_TRUE(bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        ASSERT_TRUE(listen(listen_fd_, 1) == 0);
+        thread_ = std::thread([this] { Serve(); });
+    }
+
+    ~FakeMesen() {
+        shutdown(listen_fd_, SHUT_RDWR);
+        close(listen_fd_);
+        thread_.join();
+        unlink(path_.c_str());
+    }
+
+    std::vector<z3lsp::json> commands() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return commands_;
+    }
+
+    std::atomic<bool> fail_writes{false};
+
+ private:
+    void Serve() {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) return;
+        std::string pending;
+        char buffer[4096];
+        ssize_t received;
+        while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            pending.append(buffer, received);
+            size_t newline;
+            while ((newline = pending.find('\n')) != std::string::npos) {
+                z3lsp::json cmd = z3lsp::json::parse(pending.substr(0, newline));
+                pending.erase(0, newline + 1);
+                bool ok = !(fail_writes && cmd["type"] == "WRITEBLOCK");
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    commands_.push_back(cmd);
+                }
+                std::string reply = z3lsp::json{{"success", ok}}.dump() + "\n";
+                send(fd, reply.data(), reply.size(), 0);
+            }
+        }
+        close(fd);
+    }
+
+    std::string path_;
+    int listen_fd_ = -1;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<z3lsp::json> commands_;
+};
+
+std::string SocketPath(const char* name) {
+    return "/tmp/z3lsp-test-" + std::to_string(getpid()) + "-" + name + ".sock";
+}
+
+void TestDiffMergesNearbyChanges() {
+    std::vector<uint8_t> loaded(0x100, 0);
+    std::vector<uint8_t> built = loaded;
+    built[0x10] = 1;
+    built[0x13] = 2;  // 2 equal bytes away: same range
+    built[0x40] = 3;  // far away: its own range
+
+    auto ranges = z3lsp::DiffRomImages(loaded, built, {}, 4);
+    ASSERT_EQ(ranges.size(), 2u);
+    ASSERT_EQ(ranges[0].offset, 0x10u);
+    ASSERT_EQ(ranges[0].bytes.size(), 4u);
+    ASSERT_EQ(ranges[0].bytes[3], 2);
+    ASSERT_EQ(ranges[1].offset, 0x40u);
+    ASSERT_EQ(ranges[1].bytes.size(), 1u);
+
+    // no gap allowed: three ranges
+    ASSERT_EQ(z3lsp::DiffRomImages(loaded, built, {}, 0).size(), 3u);
+    // identical images need no writes
+    ASSERT_TRUE(z3lsp::DiffRomImages(loaded, loaded, {}).empty());
+}
+
+void TestDiffStaysInsideBlocks() {
+    std::vector<uint8_t> loaded(0x100, 0);
+    std::vector<uint8_t> built = loaded;
+    built[0x20] = 1;
+    built[0x21] = 1;
+    built[0x80] = 1;  // not written by the build (say, a checksum byte)
+
+    z3dk::WrittenBlock block;
+    block.pc_offset = 0x18;
+    block.num_bytes = 0x10;
+    auto ranges = z3lsp::DiffRomImages(loaded, built, {block});
+    ASSERT_EQ(ranges.size(), 1u);
+    ASSERT_EQ(ranges[0].offset, 0x20u);
+    ASSERT_EQ(ranges[0].bytes.size(), 2u);
+
+    // overlapping blocks don't duplicate writes, runs never cross a block end
+    z3dk::WrittenBlock overlap = block;
+    overlap.pc_offset = 0x1C;
+    z3dk::WrittenBlock second;
+    second.pc_offset = 0x30;
+    second.num_bytes = 4;
+    built[0x2B] = 1;
+    built[0x2E] = 1;  // between the blocks, left alone
+    built[0x30] = 1;
+    ranges = z3lsp::DiffRomImages(loaded, built, {overlap, block, second}, 16);
+    ASSERT_EQ(ranges.size(), 2u);
+    ASSERT_EQ(ranges[0].offset, 0x20u);
+    ASSERT_EQ(ranges[0].bytes.size(), 12u);
+    ASSERT_EQ(ranges[1].offset, 0x30u);
+}
+
+void TestDiffSplitsLongRanges() {
+    std::vector<uint8_t> loaded(0x1000, 0);
+    std::vector<uint8_t> built(0x1000, 0xEA);
+    auto ranges = z3lsp::DiffRomImages(loaded, built, {}, 8, 0x400);
+    ASSERT_EQ(ranges.size(), 4u);
+    ASSERT_EQ(ranges[3].offset, 0xC00u);
+    ASSERT_EQ(ranges[3].bytes.size(), 0x400u);
+}
+
+void TestHotPatchPausesWritesAndResumes() {
+    std::string path = SocketPath("patch");
+    FakeMesen server(path);
+    setenv("MESEN2_SOCKET_PATH", path.c_str(), 1);
+
+    std::vector<uint8_t> loaded(0x8000, 0);
+    std::vector<uint8_t> built = loaded;
+    built[0x1234] = 0xA9;
+    built[0x1235] = 0x0F;
+    built[0x4000] = 0x60;
+
+    z3lsp::MesenClient client;
+    z3lsp::HotPatchOptions options;
+    options.batch_size = 1;
+    z3lsp::HotPatchResult result = client.HotPatch(loaded, built, {}, options);
+    ASSERT_TRUE(result.success);
+    ASSERT_EQ(result.ranges, 2u);
+    ASSERT_EQ(result.bytes, 3u);
+
+    auto commands = server.commands();
+    ASSERT_EQ(commands.size(), 4u);
+    ASSERT_EQ(commands[0]["type"], "PAUSE");
+    ASSERT_EQ(commands[1]["type"], "WRITEBLOCK");
+    ASSERT_EQ(commands[1]["memtype"], "SnesPrgRom");
+    ASSERT_EQ(commands[1]["addr"], "0x001234");
+    ASSERT_EQ(commands[1]["hex"], "A90F");
+    ASSERT_EQ(commands[2]["addr"], "0x004000");
+    ASSERT_EQ(commands[2]["hex"], "60");
+    ASSERT_EQ(commands[3]["type"], "RESUME");
+
+    // without pause, and with nothing to do, nothing else is sent
+    options.pause = false;
+    options.batch_size = 32;
+    ASSERT_TRUE(client.HotPatch(built, built, {}, options).success);
+    ASSERT_TRUE(client.HotPatch(loaded, built, {}, options).success);
+    commands = server.commands();
+    ASSERT_EQ(commands.size(), 6u);
+    ASSERT_EQ(commands[4]["type"], "WRITEBLOCK");
+    ASSERT_EQ(commands[5]["type"], "WRITEBLOCK");
+}
+
+void TestHotPatchResumesAfterRejectedWrite() {
+    std::string path = SocketPath("reject");
+    FakeMesen server(path);
+    server.fail_writes = true;
+    setenv("MESEN2_SOCKET_PATH", path.c_str(), 1);
+
+    std::vector<uint8_t> loaded(0x100, 0);
+    std::vector<uint8_t> built = loaded;
+    built[0x10] = 1;
+
+    z3lsp::MesenClient client;
+    z3lsp::HotPatchResult result = client.HotPatch(loaded, built, {});
+    ASSERT_TRUE(!result.success);
+    ASSERT_TRUE(!result.error.empty());
+    auto commands = server.commands();
+    ASSERT_EQ(commands.size(), 3u);
+    ASSERT_EQ(commands[2]["type"], "RESUME");
+}
+
+void TestHotPatchRefusesResizedRom() {
+    z3lsp::MesenClient client;
+    std::vector<uint8_t> loaded(0x100, 0);
+    std::vector<uint8_t> built(0x200, 0);
+    z3lsp::HotPatchResult result = client.HotPatch(loaded, built, {});
+    ASSERT_TRUE(!result.success);
+    ASSERT_TRUE(!client.IsConnected());
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3lsp Mesen client tests..." << std::endl;
+    TestDiffMergesNearbyChanges();
+    TestDiffStaysInsideBlocks();
+    TestDiffSplitsLongRanges();
+    TestHotPatchPausesWritesAndResumes();
+    TestHotPatchResumesAfterRejectedWrite();
+    TestHotPatchRefusesResizedRom();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
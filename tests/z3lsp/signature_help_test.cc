@@ -0,0 +1,154 @@
+// Create a simple test runner since we don't have GTest
+#include <iostream>
+#include <string>
+#include <vector>
+#include "assembler.h"
+#include "assocarr.h"
+#include "signature_help.h"
+
+#define ASSERT_TRUE(a) \
+    if (!(a)) { \
+        std::cerr << "Assertion failed: " << #a << std::endl; \
+        std::exit(1); \
+    }
+
+#define ASSERT_EQ(a, b) \
+    if ((a) != (b)) { \
+        std::cerr << "Assertion failed: " << #a << " == " << #b \
+                  << " (" << (a) << " vs " << (b) << ")" << std::endl; \
+        std::exit(1); \
+    }
+
+extern assocarr<double (*)()> builtin_functions;
+
+namespace {
+
+using Kind = z3lsp::CallSite::Kind;
+
+z3lsp::CallSite SiteAtEnd(const std::string& line) {
+    auto site = z3lsp::FindCallSite(line, static_cast<int>(line.size()));
+    if (!site) {
+        std::cerr << "No call site in: " << line << std::endl;
+        std::exit(1);
+    }
+    return *site;
+}
+
+void TestCallSites() {
+    auto site = SiteAtEnd("  %Store(1, ");
+    ASSERT_TRUE(site.kind == Kind::kMacro);
+    ASSERT_EQ(site.name, "Store");
+    ASSERT_EQ(site.argument, 1);
+
+    // closed calls and grouping parens don't hide the enclosing one
+    site = SiteAtEnd("  LDA #max(read1($008000, 2), ");
+    ASSERT_TRUE(site.kind == Kind::kFunction);
+    ASSERT_EQ(site.name, "max");
+    ASSERT_EQ(site.argument, 1);
+    site = SiteAtEnd("  LDA #max(read1($008000, ");
+    ASSERT_EQ(site.name, "read1");
+    ASSERT_EQ(site.argument, 1);
+    site = SiteAtEnd("  %Store((1+2");
+    ASSERT_EQ(site.name, "Store");
+    ASSERT_EQ(site.argument, 0);
+
+    // commas in strings aren't separators
+    site = SiteAtEnd("  db \"a,b\", ',', ");
+    ASSERT_TRUE(site.kind == Kind::kDirective);
+    ASSERT_EQ(site.name, "db");
+    ASSERT_EQ(site.argument, 2);
+    site = SiteAtEnd("  %Store(\"(,\", ");
+    ASSERT_EQ(site.name, "Store");
+    ASSERT_EQ(site.argument, 1);
+
+    // labels and `:` statement separators are skipped
+    site = SiteAtEnd("Main: org ");
+    ASSERT_EQ(site.name, "org");
+    site = SiteAtEnd("  LDA #0 : assert pc() < $8100, ");
+    ASSERT_EQ(site.name, "assert");
+    ASSERT_EQ(site.argument, 1);
+
+    // only up to the cursor counts
+    std::string line = "  %Store(1, 2)";
+    site = *z3lsp::FindCallSite(line, 10);
+    ASSERT_EQ(site.name, "Store");
+    ASSERT_EQ(site.argument, 0);
+
+    ASSERT_TRUE(!z3lsp::FindCallSite("  db 1 ; note(a, ", 17));
+    ASSERT_TRUE(!z3lsp::FindCallSite("  org", 5));
+    ASSERT_TRUE(!z3lsp::FindCallSite("", 0));
+}
+
+void TestBuiltins() {
+    // every function asar knows has a signature
+    std::vector<std::string> missing;
+    builtin_functions.each([&missing](const char* name, double (*)()) {
+        if (!z3lsp::FindBuiltinFunction(name)) missing.push_back(name);
+    });
+    for (const auto& name : missing) {
+        std::cerr << "No signature for builtin " << name << std::endl;
+    }
+    ASSERT_TRUE(missing.empty());
+
+    const z3lsp::SignatureInfo* clamp = z3lsp::FindBuiltinFunction("clamp");
+    ASSERT_TRUE(clamp != nullptr);
+    ASSERT_EQ(clamp->Label(), "clamp(value, min, max)");
+    ASSERT_EQ(clamp->ActiveParameter(2), 2);
+
+    const z3lsp::SignatureInfo* db = z3lsp::FindDirective("DB");
+    ASSERT_TRUE(db != nullptr);
+    ASSERT_EQ(db->Label(), "db value, ...");
+    ASSERT_EQ(db->ActiveParameter(5), 0);
+    ASSERT_TRUE(z3lsp::FindDirective("lda") == nullptr);
+}
+
+void TestIndexFromAssembly() {
+    z3dk::AssembleOptions options;
+    options.patch_path = "/virtual/signatures.asm";
+    options.rom_data.assign(0x8000, 0);
+    options.memory_files.push_back(
+        {options.patch_path,
+         "lorom\n"
+         "macro Store(value, addr)\n  LDA #<value>\n  STA <addr>\nendmacro\n"
+         "macro Log(level, ...)\nendmacro\n"
+         "function twice(x) = x*2\n"
+         "org $008000\n  %Store(twice(2), $00)\n"});
+    z3dk::AssembleResult result = z3dk::Assembler().Assemble(options);
+    ASSERT_TRUE(result.success);
+
+    z3lsp::SignatureIndex index;
+    index.Build(result.macros, result.functions);
+    ASSERT_EQ(index.macro_count(), 2u);
+    ASSERT_EQ(index.function_count(), 1u);
+
+    const z3lsp::SignatureInfo* store = index.FindMacro("Store");
+    ASSERT_TRUE(store != nullptr);
+    ASSERT_EQ(store->Label(), "Store(value, addr)");
+    ASSERT_TRUE(store->documentation.find("signatures.asm:2") != std::string::npos);
+
+    const z3lsp::SignatureInfo* log = index.FindMacro("Log");
+    ASSERT_TRUE(log != nullptr && log->variadic);
+    ASSERT_EQ(log->Label(), "Log(level, ...)");
+    ASSERT_EQ(log->ActiveParameter(4), 1);
+
+    const z3lsp::SignatureInfo* twice = index.FindFunction("twice");
+    ASSERT_TRUE(twice != nullptr);
+    ASSERT_EQ(twice->Label(), "twice(x)");
+    ASSERT_TRUE(index.FindFunction("select") != nullptr);
+    ASSERT_TRUE(index.FindMacro("twice") == nullptr);
+
+    index.Clear();
+    ASSERT_TRUE(index.FindMacro("Store") == nullptr);
+    ASSERT_TRUE(index.FindFunction("select") != nullptr);
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Running z3lsp signature help tests..." << std::endl;
+    TestCallSites();
+    TestBuiltins();
+    TestIndexFromAssembly();
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -19,10 +19,12 @@
 
 // Forward declarations
 void TestFindReferences();
+void TestLineIndexMatchesScan();
 
 int main() {
     std::cout << "Running z3lsp utils tests..." << std::endl;
     TestFindReferences();
+    TestLineIndexMatchesScan();
     std::cout << "All tests passed!" << std::endl;
     return 0;
 }
@@ -68,3 +70,24 @@ Label:
     // Line 6: dw Label
     ASSERT_EQ(refs[2].line, 6);
 }
+
+void TestLineIndexMatchesScan() {
+    std::string text = "Main:\n  JSL Sub_Routine\n\n  LDA.w !define\r\n.loop: BRA .loop\n";
+    std::vector<size_t> starts = z3lsp::ComputeLineStarts(text);
+    ASSERT_EQ(starts.size(), 6);
+    ASSERT_EQ(starts[1], 6);
+    ASSERT_EQ(starts[5], text.size());
+
+    // every position, including ones past the end of a line or the text
+    for (int line = -1; line <= 7; ++line) {
+        for (int character = -1; character <= 20; ++character) {
+            ASSERT_TRUE(z3lsp::ExtractTokenAt(text, starts, line, character) ==
+                        z3lsp::ExtractTokenAt(text, line, character));
+            ASSERT_TRUE(z3lsp::ExtractTokenPrefix(text, starts, line, character) ==
+                        z3lsp::ExtractTokenPrefix(text, line, character));
+        }
+    }
+    ASSERT_EQ(*z3lsp::ExtractTokenAt(text, starts, 1, 8), "Sub_Routine");
+
+    ASSERT_EQ(z3lsp::ComputeLineStarts("").size(), 1);
+}